@@ -528,7 +528,7 @@ int main()
     particleDeltaUniformData.Free(vk);
 
     FreeModel(vk, model);
-    vkDestroySampler(vk.m_LogicalDevice, imageSampler, nullptr);
+    textures::FreeImageSampler(vk, imageSampler);
     vkDestroyImageView(vk.m_LogicalDevice, imageView, nullptr);
     vkDestroyImage(vk.m_LogicalDevice, textureImage, nullptr);
     vkFreeMemory(vk.m_LogicalDevice, textureMemory, nullptr);
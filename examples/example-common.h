@@ -6,6 +6,17 @@
 #include "assimp/postprocess.h"
 #include "assimp/scene.h"
 #include "lvk/lvk.h"
+#include "lvk/Culling.h"
+#include "lvk/GeometryPool.h"
+#include "lvk/Lod.h"
+#include "lvk/MeshFile.h"
+#include "lvk/MeshProcessing.h"
+#include "lvk/TextureFile.h"
+#include "lvk/TextureLoader.h"
+#include "lvk/TextureStreaming.h"
+#include "lvk/ThreadPool.h"
+#include <algorithm>
+#include <numeric>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -63,11 +74,24 @@ struct MeshEx
 
     uint32_t m_IndexCount;
     uint32_t m_MaterialIndex;
+    VkIndexType m_IndexType = VK_INDEX_TYPE_UINT32;
+
+    // index ranges of each level, relative to the mesh's first index. m_IndexCount is LOD0's count,
+    // empty when the mesh was uploaded without a chain
+    lvk::Vector<lvk::lod::LodLevel> m_Lods;
+
+    // set when the mesh lives in a shared pool, m_VertexBuffer / m_IndexBuffer are then the pool's
+    lvk::GeometryPool*  m_Pool = nullptr;
+    lvk::PooledMesh     m_PoolRange;
 };
 
 struct MaterialEx
 {
     lvk::Texture m_Diffuse;
+    // set when m_Diffuse is owned by a TextureStreamer, its image and view then change as levels stream
+    uint32_t m_StreamHandle = lvk::TextureStreamer::k_InvalidHandle;
+    // false when m_Diffuse is a copy of Texture::g_DefaultTexture, which is shared and freed by lvk
+    bool m_OwnsDiffuse = true;
 };
 
 struct Model
@@ -168,6 +192,11 @@ static lvk::String AssimpToSTD(aiString str) {
 
 void FreeMesh(lvk::VkState & vk, MeshEx& m)
 {
+    if (m.m_Pool != nullptr)
+    {
+        m.m_Pool->FreeMesh(m.m_PoolRange);
+        return;
+    }
     vkDestroyBuffer(vk.m_LogicalDevice, m.m_VertexBuffer, nullptr);
     vmaFreeMemory(vk.m_Allocator, m.m_VertexBufferMemory);
     vkDestroyBuffer(vk.m_LogicalDevice, m.m_IndexBuffer, nullptr);
@@ -182,158 +211,328 @@ void FreeModel(lvk::VkState & vk, Model& model)
     }
 }
 
-void ProcessMesh(lvk::VkState & vk, Model& model, aiMesh* mesh, aiNode* node, const aiScene* scene) {
-    using namespace lvk;
-    bool hasPositions = mesh->HasPositions();
-    bool hasUVs = mesh->HasTextureCoords(0);
-    bool hasIndices = mesh->HasFaces();
-
-    Vector<VertexDataPosUv> verts;
-    if (hasPositions && hasUVs) {
-        for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-            VertexDataPosUv vert {};
-            vert.Position = AssimpToGLM(mesh->mVertices[i]);
-            vert.UV = glm::vec2(mesh->mTextureCoords[0][i].x, 1.0f - mesh->mTextureCoords[0][i].y);
-            verts.push_back(vert);
-        }
+// m.m_PoolRange must already be allocated from pool
+void BindPoolRange(MeshEx& m, lvk::GeometryPool& pool)
+{
+    m.m_Pool = &pool;
+    m.m_VertexBuffer = pool.m_VertexBuffer;
+    m.m_IndexBuffer = pool.m_IndexBuffer;
+    m.m_VertexBufferMemory = VK_NULL_HANDLE;
+    m.m_IndexBufferMemory = VK_NULL_HANDLE;
+    m.m_IndexType = pool.m_IndexType;
+}
 
+// uploads into pool when there is room, otherwise into buffers owned by the mesh
+template<typename _Ty>
+void UploadMesh(lvk::VkState & vk, MeshEx& m, const lvk::Vector<_Ty>& verts, const lvk::Vector<uint32_t>& indices, lvk::GeometryPool* pool)
+{
+    if (pool != nullptr && pool->AddMesh(vk, verts, indices, m.m_PoolRange))
+    {
+        BindPoolRange(m, *pool);
     }
-    Vector<uint32_t> indices;
-    if (hasIndices) {
-        for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-            aiFace currentFace = mesh->mFaces[i];
-            if (currentFace.mNumIndices != 3) {
-                spdlog::error("Attempting to import a mesh with non triangular face structure! cannot load this mesh.");
-                return;
-            }
-            for (unsigned int index = 0; index < mesh->mFaces[i].mNumIndices; index++) {
-                indices.push_back(static_cast<uint32_t>(mesh->mFaces[i].mIndices[index]));
-            }
-        }
+    else
+    {
+        lvk::buffers::CreateVertexBuffer<_Ty>(vk, verts, m.m_VertexBuffer, m.m_VertexBufferMemory);
+        lvk::buffers::CreateIndexBuffer(vk, indices, static_cast<uint32_t>(verts.size()), m.m_IndexBuffer, m.m_IndexBufferMemory, m.m_IndexType);
     }
-    AABB aabb = { {mesh->mAABB.mMin.x, mesh->mAABB.mMin.y, mesh->mAABB.mMin.z},
-                    {mesh->mAABB.mMax.x, mesh->mAABB.mMax.y, mesh->mAABB.mMax.z} };
-    MeshEx m{};
-    buffers::CreateVertexBuffer<VertexDataPosUv>(vk, verts, m.m_VertexBuffer, m.m_VertexBufferMemory);
-    buffers::CreateIndexBuffer(vk, indices, m.m_IndexBuffer, m.m_IndexBufferMemory);
     m.m_IndexCount = static_cast<uint32_t>(indices.size());
-    m.m_AABB = aabb;
-    model.m_Meshes.push_back(m);
 }
 
-AABB TransformAABB(AABB& in, glm::mat4& m)
+// cpu side mesh, built and optimized on worker threads before it is uploaded
+template<typename _Ty>
+struct ImportedMesh
 {
-    float scalingFactor = m[0][0] * m[0][0] + m[0][1] * m[0][1] + m[0][2] * m[0][2];
-    float f = 1.0f / scalingFactor;
-    glm::mat3 rotationMatrix =
-    {
-        {m[0][0] * f, m[0][1] * f, m[0][2] * f},
-        {m[1][0] * f, m[1][1] * f, m[1][2] * f},
-        {m[2][0] * f, m[2][1] * f, m[2][2] * f}
-    };
+    lvk::Vector<_Ty>        m_Vertices;
+    lvk::Vector<uint32_t>   m_Indices;
+    AABB                    m_AABB;
+    lvk::Vector<lvk::lod::LodLevel> m_Lods;
+    uint32_t                m_MaterialIndex = 0;
+    bool                    m_Valid = false;
+};
 
-    glm::vec3 translation = { m[0][3],m[1][3], m[2][3] };
-    AABB ret;
-    ret.m_Min = glm::vec3(0.0f);
-    ret.m_Max = glm::vec3(0.0f);
+static bool BuildIndices(aiMesh* mesh, lvk::Vector<uint32_t>& indices) {
+    if (!mesh->HasFaces()) {
+        return true;
+    }
+    indices.reserve(mesh->mNumFaces * 3);
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+        aiFace currentFace = mesh->mFaces[i];
+        if (currentFace.mNumIndices != 3) {
+            spdlog::error("Attempting to import a mesh with non triangular face structure! cannot load this mesh.");
+            return false;
+        }
+        for (unsigned int index = 0; index < mesh->mFaces[i].mNumIndices; index++) {
+            indices.push_back(static_cast<uint32_t>(mesh->mFaces[i].mIndices[index]));
+        }
+    }
+    return true;
+}
 
-    for (int i = 0; i < 3; i++)
-    {
-        for (int j = 0; j < 3; j++)
-        {
-            auto a = rotationMatrix[i][j] * in.m_Min[j];
-            auto b = rotationMatrix[i][j] * in.m_Max[j];
+static AABB BuildAABB(aiMesh* mesh) {
+    return { {mesh->mAABB.mMin.x, mesh->mAABB.mMin.y, mesh->mAABB.mMin.z},
+             {mesh->mAABB.mMax.x, mesh->mAABB.mMax.y, mesh->mAABB.mMax.z} };
+}
+
+bool BuildMesh(aiMesh* mesh, ImportedMesh<lvk::VertexDataPosUv>& imported) {
+    using namespace lvk;
+    bool hasPositions = mesh->HasPositions();
+    bool hasUVs = mesh->HasTextureCoords(0);
 
-            ret.m_Min[i] += a < b ? a : b;
-            ret.m_Max[i] += a < b ? b : a;
+    if (hasPositions && hasUVs) {
+        imported.m_Vertices.reserve(mesh->mNumVertices);
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+            VertexDataPosUv vert {};
+            vert.Position = AssimpToGLM(mesh->mVertices[i]);
+            vert.UV = glm::vec2(mesh->mTextureCoords[0][i].x, 1.0f - mesh->mTextureCoords[0][i].y);
+            imported.m_Vertices.push_back(vert);
         }
     }
-
-    return ret;
+    imported.m_AABB = BuildAABB(mesh);
+    imported.m_MaterialIndex = mesh->mMaterialIndex;
+    return BuildIndices(mesh, imported.m_Indices);
 }
 
-void ProcessMeshWithNormals(lvk::VkState & vk, Model& model, aiMesh* mesh, aiNode* node, const aiScene* scene) {
+bool BuildMesh(aiMesh* mesh, ImportedMesh<lvk::VertexDataPosNormalUv>& imported) {
     using namespace lvk;
     bool hasPositions = mesh->HasPositions();
     bool hasUVs = mesh->HasTextureCoords(0);
     bool hasNormals = mesh->HasNormals();
-    bool hasIndices = mesh->HasFaces();
-
-    Vector<aiMaterialProperty*> properties;
-    aiMaterial* meshMaterial = scene->mMaterials[mesh->mMaterialIndex];
 
-    for (unsigned int i = 0; i < meshMaterial->mNumProperties; i++)
-    {
-        aiMaterialProperty* prop = meshMaterial->mProperties[i];
-        properties.push_back(prop);
-    }
-    Vector<VertexDataPosNormalUv> verts;
     if (hasPositions && hasUVs && hasNormals) {
+        imported.m_Vertices.reserve(mesh->mNumVertices);
         for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
             VertexDataPosNormalUv vert{};
             vert.Position = AssimpToGLM(mesh->mVertices[i]);
             vert.UV = glm::vec2(mesh->mTextureCoords[0][i].x, 1.0f - mesh->mTextureCoords[0][i].y);
             vert.Normal = AssimpToGLM(mesh->mNormals[i]);
-            verts.push_back(vert);
+            imported.m_Vertices.push_back(vert);
         }
+    }
+    imported.m_AABB = BuildAABB(mesh);
+    imported.m_MaterialIndex = mesh->mMaterialIndex;
+    return BuildIndices(mesh, imported.m_Indices);
+}
+
+AABB TransformAABB(const AABB& in, const glm::mat4& m)
+{
+    AABB ret;
+    lvk::culling::TransformAABB(in.m_Min, in.m_Max, m, ret.m_Min, ret.m_Max);
+    return ret;
+}
 
+void CollectMeshes(aiNode* node, const aiScene* scene, lvk::Vector<aiMesh*>& meshes) {
+    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+        meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
     }
-    Vector<uint32_t> indices;
-    if (hasIndices) {
-        for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-            aiFace currentFace = mesh->mFaces[i];
-            if (currentFace.mNumIndices != 3) {
-                spdlog::error("Attempting to import a mesh with non triangular face structure! cannot load this mesh.");
-                return;
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        CollectMeshes(node->mChildren[i], scene, meshes);
+    }
+}
+
+// Model import runs as a pipeline on the default thread pool :
+//
+//  parse   : assimp reads the scene on the loading thread
+//  convert : one task per mesh builds, optimises and appends the LOD chain of its vertices / indices
+//  decode  : one task per diffuse texture decodes the image file and streams its pixels into a
+//            lvk::TextureUploadBatch, unless a prebuilt .ktx2 / .dds sits next to the image
+//  upload  : the loading thread, it takes finished work off an ImportEvent queue as it completes.
+//            the meshes go to the pool in one batched copy as soon as the last one is ready, while
+//            images may still be decoding, and every texture is uploaded with one submission at the end
+struct ImportEvent
+{
+    enum class Stage
+    {
+        Mesh,
+        Image
+    };
+
+    Stage       m_Stage;
+    uint32_t    m_Index;
+};
+
+// decodes every non empty path into batch, batchIndices[i] is set once an Image event with index i was
+// pushed and stays -1 when the file failed to decode
+void DecodeImagesAsync(const lvk::Vector<lvk::String>& paths, lvk::TextureUploadBatch& batch, lvk::Vector<int32_t>& batchIndices, lvk::WorkQueue<ImportEvent>& events, uint32_t& pendingEvents)
+{
+    batchIndices.assign(paths.size(), -1);
+    for (uint32_t i = 0; i < paths.size(); i++) {
+        if (paths[i].empty()) {
+            continue;
+        }
+        pendingEvents++;
+        lvk::ThreadPool::Default().Submit([&paths, &batch, &batchIndices, &events, i]() {
+            lvk::textures::DecodedImage image;
+            if (lvk::textures::DecodeImage(paths[i], image)) {
+                batchIndices[i] = static_cast<int32_t>(batch.Add(image.m_Pixels, image.m_Width, image.m_Height, VK_FORMAT_R8G8B8A8_UNORM));
+                lvk::textures::FreeDecodedImage(image);
             }
-            for (unsigned int index = 0; index < mesh->mFaces[i].mNumIndices; index++) {
-                indices.push_back(static_cast<uint32_t>(mesh->mFaces[i].mIndices[index]));
+            events.Push({ ImportEvent::Stage::Image, i });
+        });
+    }
+}
+
+// opens the .ktx2 or .dds next to each image, when the device can sample it the image's path is cleared
+// so it is not decoded. the containers hold block compressed levels with their mip chain already built
+void OpenPrebuiltTextures(lvk::VkState & vk, lvk::Vector<lvk::String>& paths, lvk::Vector<lvk::TextureFile>& files)
+{
+    files.resize(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (paths[i].empty()) {
+            continue;
+        }
+        lvk::String stem = paths[i].substr(0, paths[i].find_last_of('.'));
+        for (const char* extension : { ".ktx2", ".dds" }) {
+            if (files[i].Open(stem + extension) && files[i].IsSupported(vk)) {
+                paths[i].clear();
+                break;
             }
+            files[i].Close();
         }
     }
-    AABB aabb = { {mesh->mAABB.mMin.x, mesh->mAABB.mMin.y, mesh->mAABB.mMin.z},
-                {mesh->mAABB.mMax.x, mesh->mAABB.mMax.y, mesh->mAABB.mMax.z} };
+}
 
-    MeshEx m{};
-    buffers::CreateVertexBuffer<VertexDataPosNormalUv>(vk, verts, m.m_VertexBuffer, m.m_VertexBufferMemory);
-    buffers::CreateIndexBuffer(vk, indices, m.m_IndexBuffer, m.m_IndexBufferMemory);
-    m.m_IndexCount = static_cast<uint32_t>(indices.size());
-    m.m_MaterialIndex = mesh->mMaterialIndex;
-    m.m_AABB = aabb;
-    model.m_Meshes.push_back(m);
+// with a streamer the files are handed over to it and only their mip tails are uploaded here,
+// streamHandles gets the handle of each, k_InvalidHandle for textures uploaded whole
+lvk::Vector<lvk::Optional<lvk::Texture>> UploadPrebuiltTextures(lvk::VkState & vk, lvk::Vector<lvk::TextureFile>& files, lvk::TextureStreamer* streamer, lvk::Vector<uint32_t>& streamHandles)
+{
+    lvk::Vector<lvk::Optional<lvk::Texture>> textures(files.size());
+    streamHandles.assign(files.size(), lvk::TextureStreamer::k_InvalidHandle);
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!files[i].IsOpen()) {
+            continue;
+        }
+        if (streamer != nullptr) {
+            streamHandles[i] = streamer->Add(vk, std::move(files[i]));
+            if (streamHandles[i] != lvk::TextureStreamer::k_InvalidHandle) {
+                textures[i] = streamer->GetTexture(streamHandles[i]);
+                continue;
+            }
+        }
+        textures[i] = lvk::textures::LoadTextureFile(vk, files[i]);
+        files[i].Close();
+    }
+    return textures;
 }
 
-void ProcessNode(lvk::VkState & vk, Model& model, aiNode* node, const aiScene* scene, bool withNormals = false) {
+// upload stage of the decoded images, adds one material per path given to DecodeImagesAsync.
+// prebuilt textures take precedence, images that failed to decode fall back to the default texture
+void UploadMaterials(lvk::VkState & vk, Model& model, const lvk::Vector<lvk::Optional<lvk::Texture>>& prebuilt, const lvk::Vector<uint32_t>& streamHandles, lvk::TextureUploadBatch& batch, const lvk::Vector<int32_t>& batchIndices)
+{
+    lvk::Vector<lvk::Texture> uploaded;
+    batch.Upload(vk, uploaded);
+    for (size_t i = 0; i < batchIndices.size(); i++) {
+        if (prebuilt[i].has_value()) {
+            model.m_Materials.push_back({ *prebuilt[i], streamHandles[i] });
+        }
+        else if (batchIndices[i] >= 0) {
+            model.m_Materials.push_back({ uploaded[batchIndices[i]] });
+        }
+        else {
+            model.m_Materials.push_back({ *lvk::Texture::g_DefaultTexture, lvk::TextureStreamer::k_InvalidHandle, false });
+        }
+    }
+}
 
-    if (node->mNumMeshes > 0) {
-        for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-            unsigned int sceneIndex = node->mMeshes[i];
-            aiMesh* mesh = scene->mMeshes[sceneIndex];
-            if (withNormals)
-            {
-                ProcessMeshWithNormals(vk, model, mesh, node, scene);
-            }
-            else
-            {
-                ProcessMesh(vk, model, mesh, node, scene);
+// convert stage, meshes are submitted largest first so the longest conversions do not start last
+template<typename _Ty>
+void ConvertMeshesAsync(const lvk::Vector<aiMesh*>& meshes, lvk::Vector<ImportedMesh<_Ty>>& imported, lvk::WorkQueue<ImportEvent>& events, uint32_t& pendingEvents)
+{
+    imported.resize(meshes.size());
+    lvk::Vector<uint32_t> order(meshes.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&meshes](uint32_t a, uint32_t b) { return meshes[a]->mNumFaces > meshes[b]->mNumFaces; });
+
+    for (uint32_t i : order) {
+        pendingEvents++;
+        lvk::ThreadPool::Default().Submit([&meshes, &imported, &events, i]() {
+            imported[i].m_Valid = BuildMesh(meshes[i], imported[i]);
+            if (imported[i].m_Valid) {
+                lvk::mesh_processing::OptimizeMesh(imported[i].m_Vertices, imported[i].m_Indices);
+                lvk::lod::BuildLodChain(imported[i].m_Vertices, imported[i].m_Indices, imported[i].m_Lods);
             }
+            events.Push({ ImportEvent::Stage::Mesh, i });
+        });
+    }
+}
+
+// upload stage of the converted meshes, in scene order. everything that fits in pool is copied
+// through one staging buffer and one submission, the rest gets buffers of its own
+template<typename _Ty>
+void UploadMeshes(lvk::VkState & vk, Model& model, const lvk::Vector<ImportedMesh<_Ty>>& imported, lvk::GeometryPool* pool)
+{
+    bool pooled = pool != nullptr && pool->m_VertexStride == sizeof(_Ty);
+    if (pool != nullptr && !pooled) {
+        spdlog::error("UploadMeshes : vertex size {} does not match the pool's stride of {}", sizeof(_Ty), pool->m_VertexStride);
+    }
+
+    lvk::Vector<lvk::PoolUpload> uploads;
+    for (const ImportedMesh<_Ty>& mesh : imported) {
+        if (!mesh.m_Valid) {
+            continue;
+        }
+        MeshEx m{};
+        uint32_t vertexCount = static_cast<uint32_t>(mesh.m_Vertices.size());
+        uint32_t indexCount = static_cast<uint32_t>(mesh.m_Indices.size());
+        if (pooled && pool->Allocate(vertexCount, indexCount, m.m_PoolRange)) {
+            BindPoolRange(m, *pool);
+            m.m_IndexCount = indexCount;
+            uploads.push_back({ m.m_PoolRange, mesh.m_Vertices.data(), mesh.m_Indices.data(), sizeof(uint32_t) });
         }
+        else {
+            UploadMesh<_Ty>(vk, m, mesh.m_Vertices, mesh.m_Indices, nullptr);
+        }
+        m.m_MaterialIndex = mesh.m_MaterialIndex;
+        m.m_AABB = mesh.m_AABB;
+        m.m_Lods = mesh.m_Lods;
+        m.m_IndexCount = mesh.m_Lods.empty() ? m.m_IndexCount : mesh.m_Lods[0].m_IndexCount;
+        model.m_Meshes.push_back(m);
     }
 
-    if (node->mNumChildren == 0) {
-        return;
+    if (!uploads.empty()) {
+        pool->UploadBatch(vk, uploads);
     }
+}
 
-    for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        ProcessNode(vk, model, node->mChildren[i], scene);
+// runs the convert, decode and upload stages for a parsed scene. texturePaths holds one path per
+// material of the model, textures are added to model in that order
+template<typename _Ty>
+void ImportModel(lvk::VkState & vk, Model& model, const lvk::Vector<aiMesh*>& meshes, const lvk::Vector<lvk::String>& texturePaths, lvk::GeometryPool* pool, lvk::TextureStreamer* streamer) {
+    lvk::WorkQueue<ImportEvent> events;
+    uint32_t pendingEvents = 0;
+
+    // decodes start with a file read, so they go to the pool ahead of the cpu bound conversions
+    lvk::Vector<lvk::String> decodePaths = texturePaths;
+    lvk::Vector<lvk::TextureFile> prebuiltFiles;
+    OpenPrebuiltTextures(vk, decodePaths, prebuiltFiles);
+    lvk::TextureUploadBatch textureBatch;
+    lvk::Vector<int32_t> batchIndices;
+    DecodeImagesAsync(decodePaths, textureBatch, batchIndices, events, pendingEvents);
+
+    lvk::Vector<ImportedMesh<_Ty>> imported;
+    ConvertMeshesAsync(meshes, imported, events, pendingEvents);
+
+    lvk::Vector<uint32_t> streamHandles;
+    lvk::Vector<lvk::Optional<lvk::Texture>> prebuilt = UploadPrebuiltTextures(vk, prebuiltFiles, streamer, streamHandles);
+
+    uint32_t pendingMeshes = static_cast<uint32_t>(meshes.size());
+    for (; pendingEvents > 0; pendingEvents--) {
+        ImportEvent event = events.Pop();
+        if (event.m_Stage == ImportEvent::Stage::Mesh && --pendingMeshes == 0) {
+            UploadMeshes(vk, model, imported, pool);
+        }
     }
+
+    UploadMaterials(vk, model, prebuilt, streamHandles, textureBatch, batchIndices);
 }
 
-void LoadModelAssimp(lvk::VkState & vk, Model& model, const lvk::String& path, bool withNormals = false)
+// pool must match the vertex layout, VertexDataPosNormalUv withNormals and VertexDataPosUv otherwise.
+// with a streamer, materials that have a prebuilt .ktx2 / .dds stream their mips through it
+void LoadModelAssimp(lvk::VkState & vk, Model& model, const lvk::String& path, bool withNormals = false, lvk::GeometryPool* pool = nullptr, lvk::TextureStreamer* streamer = nullptr)
 {
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(path.c_str(),
         aiProcess_Triangulate |
+        aiProcess_JoinIdenticalVertices |
         aiProcess_CalcTangentSpace |
         aiProcess_OptimizeMeshes |
         aiProcess_GenSmoothNormals |
@@ -347,9 +546,12 @@ void LoadModelAssimp(lvk::VkState & vk, Model& model, const lvk::String& path, b
         spdlog::error("AssimpModelAssetFactory : Failed to load asset at path : {}", path);
         return;
     }
-    ProcessNode(vk, model, scene->mRootNode, scene, withNormals);
+    lvk::Vector<aiMesh*> meshes;
+    CollectMeshes(scene->mRootNode, scene, meshes);
 
+    // only materials with a diffuse texture become model materials
     lvk::String directory = path.substr(0, path.find_last_of('/') + 1);
+    lvk::Vector<lvk::String> texturePaths;
     for (unsigned int i = 0; i < scene->mNumMaterials; i++)
     {
         aiMaterial* meshMaterial = scene->mMaterials[i];
@@ -360,11 +562,125 @@ void LoadModelAssimp(lvk::VkState & vk, Model& model, const lvk::String& path, b
         {
             aiString resultPath;
             aiGetMaterialTexture(meshMaterial, aiTextureType_DIFFUSE, 0, &resultPath);
-            lvk::String finalPath = directory + lvk::String(resultPath.C_Str());
-            lvk::Texture texture = lvk::Texture::CreateTexture(vk, finalPath, VK_FORMAT_R8G8B8A8_UNORM);
-            model.m_Materials.push_back({ texture });
+            texturePaths.push_back(directory + lvk::String(resultPath.C_Str()));
+        }
+    }
+
+    if (withNormals)
+    {
+        ImportModel<lvk::VertexDataPosNormalUv>(vk, model, meshes, texturePaths, pool, streamer);
+    }
+    else
+    {
+        ImportModel<lvk::VertexDataPosUv>(vk, model, meshes, texturePaths, pool, streamer);
+    }
+}
+
+// gives a cooked mesh that does not fit in the pool buffers of its own, like UploadMeshes does for
+// imported ones. 16 bit indices are widened here and narrowed again by CreateIndexBuffer
+void UploadCookedMesh(lvk::VkState & vk, MeshEx& m, const lvk::MeshFile& file, const lvk::mesh_file::MeshRecord& record)
+{
+    const uint8_t* vertexData = static_cast<const uint8_t*>(file.GetVertexData(record));
+    lvk::Vector<uint8_t> vertices(vertexData, vertexData + size_t{ record.m_VertexCount } * file.GetHeader().m_VertexStride);
+
+    lvk::Vector<uint32_t> indices(record.m_IndexCount);
+    if (record.m_IndexSize == sizeof(uint16_t))
+    {
+        const uint16_t* indexData = static_cast<const uint16_t*>(file.GetIndexData(record));
+        std::copy(indexData, indexData + record.m_IndexCount, indices.begin());
+    }
+    else
+    {
+        memcpy(indices.data(), file.GetIndexData(record), size_t{ record.m_IndexCount } * sizeof(uint32_t));
+    }
+
+    lvk::buffers::CreateVertexBuffer<uint8_t>(vk, vertices, m.m_VertexBuffer, m.m_VertexBufferMemory);
+    lvk::buffers::CreateIndexBuffer(vk, indices, record.m_VertexCount, m.m_IndexBuffer, m.m_IndexBufferMemory, m.m_IndexType);
+}
+
+// loads a .lvkm written by tools/mesh-cook into pool, the streams are copied from the file's mapping
+// straight into one staging buffer, meshes the pool has no room for get buffers of their own. fills model like LoadModelAssimp, returns false when the file is
+// missing, stale or cooked for another vertex layout so the caller can fall back to the source model
+bool LoadModelCooked(lvk::VkState & vk, Model& model, const lvk::String& path, lvk::GeometryPool& pool, lvk::TextureStreamer* streamer = nullptr)
+{
+    lvk::MeshFile file;
+    if (!file.Open(path))
+    {
+        return false;
+    }
+    if (file.GetHeader().m_VertexStride != pool.m_VertexStride)
+    {
+        spdlog::error("LoadModelCooked : {} has {} byte vertices, the pool expects {}", path, file.GetHeader().m_VertexStride, pool.m_VertexStride);
+        return false;
+    }
+
+    // textures decode on the pool while the mesh streams are copied out of the mapping
+    lvk::String directory = path.substr(0, path.find_last_of('/') + 1);
+    lvk::Vector<lvk::String> texturePaths;
+    for (uint32_t i = 0; i < file.GetMaterialCount(); i++)
+    {
+        lvk::String diffusePath = file.GetDiffusePath(i);
+        if (!diffusePath.empty())
+        {
+            texturePaths.push_back(directory + diffusePath);
+        }
+    }
+    lvk::WorkQueue<ImportEvent> events;
+    uint32_t pendingEvents = 0;
+    lvk::Vector<lvk::TextureFile> prebuiltFiles;
+    OpenPrebuiltTextures(vk, texturePaths, prebuiltFiles);
+    lvk::TextureUploadBatch textureBatch;
+    lvk::Vector<int32_t> batchIndices;
+    DecodeImagesAsync(texturePaths, textureBatch, batchIndices, events, pendingEvents);
+
+    lvk::Vector<lvk::PoolUpload> uploads;
+    uploads.reserve(file.GetMeshCount());
+    for (uint32_t i = 0; i < file.GetMeshCount(); i++)
+    {
+        const lvk::mesh_file::MeshRecord& record = file.GetMesh(i);
+        MeshEx m{};
+        if (pool.Allocate(record.m_VertexCount, record.m_IndexCount, m.m_PoolRange))
+        {
+            BindPoolRange(m, pool);
+            uploads.push_back({ m.m_PoolRange, file.GetVertexData(record), file.GetIndexData(record), record.m_IndexSize });
+        }
+        else
+        {
+            UploadCookedMesh(vk, m, file, record);
         }
+
+        const lvk::lod::LodLevel* lods = file.GetLods(record);
+        m.m_Lods.assign(lods, lods + record.m_LodCount);
+        m.m_IndexCount = m.m_Lods.empty() ? record.m_IndexCount : m.m_Lods[0].m_IndexCount;
+        m.m_MaterialIndex = record.m_MaterialIndex;
+        m.m_AABB = { { record.m_AABBMin[0], record.m_AABBMin[1], record.m_AABBMin[2] },
+                     { record.m_AABBMax[0], record.m_AABBMax[1], record.m_AABBMax[2] } };
+        model.m_Meshes.push_back(m);
+    }
+    if (!uploads.empty())
+    {
+        pool.UploadBatch(vk, uploads);
     }
+    lvk::Vector<uint32_t> streamHandles;
+    lvk::Vector<lvk::Optional<lvk::Texture>> prebuilt = UploadPrebuiltTextures(vk, prebuiltFiles, streamer, streamHandles);
+
+    for (; pendingEvents > 0; pendingEvents--)
+    {
+        events.Pop();
+    }
+    UploadMaterials(vk, model, prebuilt, streamHandles, textureBatch, batchIndices);
+    return true;
+}
+
+// prefers the cooked .lvkm next to path when there is a pool to load it into, assimp otherwise
+void LoadModel(lvk::VkState & vk, Model& model, const lvk::String& path, bool withNormals = false, lvk::GeometryPool* pool = nullptr, lvk::TextureStreamer* streamer = nullptr)
+{
+    lvk::String cookedPath = path.substr(0, path.find_last_of('.')) + ".lvkm";
+    if (pool != nullptr && LoadModelCooked(vk, model, cookedPath, *pool, streamer))
+    {
+        return;
+    }
+    LoadModelAssimp(vk, model, path, withNormals, pool, streamer);
 }
 
 MeshEx BuildScreenSpaceQuad(lvk::VkState & vk, lvk::Vector <lvk::VertexDataPosUv > & verts, lvk::Vector<uint32_t>& indices)
@@ -372,11 +688,13 @@ MeshEx BuildScreenSpaceQuad(lvk::VkState & vk, lvk::Vector <lvk::VertexDataPosUv
     VkBuffer vertexBuffer;
     VmaAllocation vertexBufferMemory;
     VkBuffer indexBuffer;
-    VmaAllocation indexBufferMemory;
-    lvk::buffers::CreateVertexBuffer<lvk::VertexDataPosUv>(vk, verts, vertexBuffer, vertexBufferMemory);
-    lvk::buffers::CreateIndexBuffer(vk, indices, indexBuffer, indexBufferMemory);
+    MeshEx m{};
+    lvk::buffers::CreateVertexBuffer<lvk::VertexDataPosUv>(vk, verts, m.m_VertexBuffer, m.m_VertexBufferMemory);
+    lvk::buffers::CreateIndexBuffer(vk, indices, static_cast<uint32_t>(verts.size()), m.m_IndexBuffer, m.m_IndexBufferMemory, m.m_IndexType);
+    m.m_IndexCount = static_cast<uint32_t>(indices.size());
+    m.m_OBB = glm::mat4(1.0f);
 
-    return MeshEx{ vertexBuffer, vertexBufferMemory, indexBuffer, indexBufferMemory, {}, 6 };
+    return m;
 }
 
 
@@ -391,8 +709,18 @@ struct RenderItem
 
 struct RenderModel
 {
+    // a streamed view swap waiting for a frame that may still have been in flight when it arrived
+    struct PendingRebind
+    {
+        uint32_t        m_ItemIndex;
+        lvk::String     m_SamplerName;
+        VkImageView     m_ImageView;
+        VkSampler       m_Sampler;
+    };
+
     Model m_Original;
     lvk::Vector<RenderItem> m_RenderItems;
+    lvk::Array<lvk::Vector<PendingRebind>, MAX_FRAMES_IN_FLIGHT> m_PendingRebinds;
     void Free(lvk::VkState & vk)
     {
         for (auto& item : m_RenderItems)
@@ -403,10 +731,79 @@ struct RenderModel
 
         for (auto& mat : m_Original.m_Materials)
         {
-            mat.m_Diffuse.Free(vk);
+            if (mat.m_StreamHandle == lvk::TextureStreamer::k_InvalidHandle && mat.m_OwnsDiffuse)
+            {
+                mat.m_Diffuse.Free(vk);
+            }
         }
         m_RenderItems.clear();
     }
+
+    // TextureStreamer::ViewChangedFn body, points every item using the streamed texture at its new view.
+    // only frameIndex's descriptor sets are rewritten, its fence has been waited on. the other frames'
+    // sets are queued and rewritten by ApplyPendingRebinds when they come around
+    void RebindStreamedTexture(lvk::VkState & vk, uint32_t frameIndex, uint32_t handle, const lvk::Texture& texture, const lvk::String& samplerName)
+    {
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_RenderItems.size()); i++)
+        {
+            RenderItem& item = m_RenderItems[i];
+            MaterialEx& material = m_Original.m_Materials[item.m_Mesh.m_MaterialIndex];
+            if (material.m_StreamHandle != handle)
+            {
+                continue;
+            }
+
+            material.m_Diffuse = texture;
+            item.m_Material.SetSampler(vk, frameIndex, samplerName, texture.m_ImageView, texture.m_Sampler);
+
+            for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++)
+            {
+                if (frame == frameIndex)
+                {
+                    continue;
+                }
+
+                // a newer view replaces one still queued, the older image may already be retired
+                lvk::Vector<PendingRebind>& pending = m_PendingRebinds[frame];
+                auto queued = std::find_if(pending.begin(), pending.end(), [&](const PendingRebind& rebind) {
+                    return rebind.m_ItemIndex == i && rebind.m_SamplerName == samplerName;
+                });
+                if (queued != pending.end())
+                {
+                    queued->m_ImageView = texture.m_ImageView;
+                    queued->m_Sampler = texture.m_Sampler;
+                }
+                else
+                {
+                    pending.push_back({ i, samplerName, texture.m_ImageView, texture.m_Sampler });
+                }
+            }
+        }
+    }
+
+    // call once frameIndex's fence has been waited on, before anything records with its descriptor sets
+    void ApplyPendingRebinds(lvk::VkState & vk, uint32_t frameIndex)
+    {
+        for (const PendingRebind& rebind : m_PendingRebinds[frameIndex])
+        {
+            m_RenderItems[rebind.m_ItemIndex].m_Material.SetSampler(vk, frameIndex, rebind.m_SamplerName, rebind.m_ImageView, rebind.m_Sampler);
+        }
+        m_PendingRebinds[frameIndex].clear();
+    }
+
+    // asks for the resolution each visible item covers on screen, model is the transform its bounds are in
+    void RequestStreamedTextures(lvk::TextureStreamer& streamer, const lvk::Vector<uint32_t>& visibleItems, const lvk::lod::LodSelector& selector, const glm::mat4& model)
+    {
+        for (uint32_t visible : visibleItems)
+        {
+            const MeshEx& mesh = m_RenderItems[visible].m_Mesh;
+            uint32_t handle = m_Original.m_Materials[mesh.m_MaterialIndex].m_StreamHandle;
+            if (handle != lvk::TextureStreamer::k_InvalidHandle)
+            {
+                streamer.Request(handle, selector.ProjectedSize(mesh.m_AABB.m_Min, mesh.m_AABB.m_Max, model));
+            }
+        }
+    }
 };
 
 struct Camera
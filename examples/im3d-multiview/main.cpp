@@ -82,9 +82,10 @@ ViewData CreateView(VkState & vk, LvkIm3dState im3dState, ShaderProgram gbufferP
 
     VkBuffer indexBuffer;
     VmaAllocation indexAlloc;
-    buffers::CreateIndexBuffer(vk, screenQuadIndices, indexBuffer, indexAlloc);
+    VkIndexType indexType;
+    buffers::CreateIndexBuffer(vk, screenQuadIndices, static_cast<uint32_t>(screenQuadVerts.size()), indexBuffer, indexAlloc, indexType);
 
-    Mesh screenQuad{ vertBuffer, vertAlloc, indexBuffer, indexAlloc, 6 };
+    Mesh screenQuad{ vertBuffer, vertAlloc, indexBuffer, indexAlloc, 6, indexType };
 
     return { gbuffer, finalImage, lightPassMat, gbufferPipeline, pipeline, gbufferPipelineLayout, lightPassPipelineLayout, im3dViewState , {1920, 1080}, {},  screenQuad };
 }
@@ -251,7 +252,7 @@ void RecordCommandBuffersV2(VkState & vk, Vector<ViewData*> views, RenderModel&
                     VkDeviceSize sizes[] = { 0 };
 
                     vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, sizes);
-                    vkCmdBindIndexBuffer(commandBuffer, mesh.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                    vkCmdBindIndexBuffer(commandBuffer, mesh.m_IndexBuffer, 0, mesh.m_IndexType);
                     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, view->m_GBufferPipelineLayout, 0, 1, &model.m_RenderItems[i].m_Material.m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
                     vkCmdDrawIndexed(commandBuffer, mesh.m_IndexCount, 1, 0, 0, 0);
                 }
@@ -297,7 +298,7 @@ void RecordCommandBuffersV2(VkState & vk, Vector<ViewData*> views, RenderModel&
             vkCmdPushConstants(commandBuffer, view->m_LightPassPipelineLayour, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PCViewData), &pcData);
             VkDeviceSize sizes[] = { 0 };
             vkCmdBindVertexBuffers(commandBuffer, 0, 1, &view->m_ViewQuad.m_VertexBuffer, sizes);
-            vkCmdBindIndexBuffer(commandBuffer, view->m_ViewQuad.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(commandBuffer, view->m_ViewQuad.m_IndexBuffer, 0, view->m_ViewQuad.m_IndexType);
             vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, view->m_LightPassPipelineLayour, 0, 1, &view->m_LightPassMaterial.m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
             vkCmdDrawIndexed(commandBuffer, view->m_ViewQuad.m_IndexCount, 1, 0, 0, 0);
 
@@ -59,7 +59,7 @@ void RecordCommandBuffersV2(VkState & vk,
 
 
                 vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, sizes);
-                vkCmdBindIndexBuffer(commandBuffer, mesh.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                vkCmdBindIndexBuffer(commandBuffer, mesh.m_IndexBuffer, 0, mesh.m_IndexType);
                 vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gbufferPipelineLayout, 0, 1, &model.m_RenderItems[i].m_Material.m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
                 vkCmdDrawIndexed(commandBuffer, mesh.m_IndexCount, 1, 0, 0, 0);
             }
@@ -101,7 +101,7 @@ void RecordCommandBuffersV2(VkState & vk,
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
         VkDeviceSize sizes[] = { 0 };
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, &screenQuad.m_VertexBuffer, sizes);
-        vkCmdBindIndexBuffer(commandBuffer, screenQuad.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        vkCmdBindIndexBuffer(commandBuffer, screenQuad.m_IndexBuffer, 0, screenQuad.m_IndexType);
         vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPassPipelineLayout, 0, 1, &lightPassMaterial.m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
         vkCmdDrawIndexed(commandBuffer, screenQuad.m_IndexCount, 1, 0, 0, 0);
 
@@ -319,11 +319,11 @@ int main() {
         {
             auto& mesh = item.m_Mesh;
 
-            mesh.m_AABB = TransformAABB(mesh.m_AABB, g_Transform.to_mat4());
+            AABB worldAABB = TransformAABB(mesh.m_AABB, g_Transform.to_mat4());
             Im3d::SetSize(0.3f);
             Im3d::DrawAlignedBox(
-                { mesh.m_AABB.m_Min.x, mesh.m_AABB.m_Min.y, mesh.m_AABB.m_Min.z },
-                { mesh.m_AABB.m_Max.x, mesh.m_AABB.m_Max.y, mesh.m_AABB.m_Max.z }
+                { worldAABB.m_Min.x, worldAABB.m_Min.y, worldAABB.m_Min.z },
+                { worldAABB.m_Max.x, worldAABB.m_Max.y, worldAABB.m_Max.z }
             );
         }
         */
@@ -63,7 +63,7 @@ void RecordCommandBuffersV2(VkState & vk,
 
 
                 vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, sizes);
-                vkCmdBindIndexBuffer(commandBuffer, mesh.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                vkCmdBindIndexBuffer(commandBuffer, mesh.m_IndexBuffer, 0, mesh.m_IndexType);
                 vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gbufferPipelineLayout, 0, 1, &model.m_RenderItems[i].m_Material.m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
                 vkCmdDrawIndexed(commandBuffer, mesh.m_IndexCount, 1, 0, 0, 0);
             }
@@ -104,7 +104,7 @@ void RecordCommandBuffersV2(VkState & vk,
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
         VkDeviceSize sizes[] = { 0 };
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, &screenQuad.m_VertexBuffer, sizes);
-        vkCmdBindIndexBuffer(commandBuffer, screenQuad.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        vkCmdBindIndexBuffer(commandBuffer, screenQuad.m_IndexBuffer, 0, screenQuad.m_IndexType);
         vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPassPipelineLayout, 0, 1, &lightPassMaterial.m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
         vkCmdDrawIndexed(commandBuffer, screenQuad.m_IndexCount, 1, 0, 0, 0);
         vkCmdEndRenderPass(commandBuffer);
@@ -1,6 +1,14 @@
 #include "example-common.h"
 #include "lvk/Material.h"
 #include "lvk/Shader.h"
+#include "lvk/Culling.h"
+#include "lvk/Lod.h"
+#include "lvk/UniformRing.h"
+#include "lvk/Submission.h"
+#include "lvk/ClusteredLighting.h"
+#include "lvk/GpuCulling.h"
+#include "lvk/DepthPyramid.h"
+#include "lights_deferred_shaders.h"
 
 #include <algorithm>
 using namespace lvk;
@@ -8,6 +16,10 @@ using namespace lvk;
 #define NUM_LIGHTS 512
 using DeferredLightData = FrameLightDataT<NUM_LIGHTS>;
 
+// the example's lights are handed to ClusteredLighting as is
+static_assert(sizeof(PointLight) == sizeof(ClusterPointLight), "PointLight must match ClusterPointLight");
+static_assert(sizeof(SpotLight) == sizeof(ClusterSpotLight), "SpotLight must match ClusterSpotLight");
+
 class FramebufferEx {
 public:
     Vector<Texture> m_Attachments;
@@ -63,12 +75,32 @@ struct TransformEx {
 
 static TransformEx g_Transform; 
 
+// looks at the origin, UpdateCamera derives View / Proj once per frame and everything else reads them
+static Camera g_Camera{ glm::vec3(20.0f, 20.0f, 20.0f), glm::vec3(0.0f), 45.0f, 0.1f, 1000.0f };
+
+void UpdateCamera(VkState & vk)
+{
+    g_Camera.View = glm::lookAt(g_Camera.Position, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    if (vk.m_SwapChainImageExtent.width > 0 || vk.m_SwapChainImageExtent.height)
+    {
+        g_Camera.Proj = glm::perspective(glm::radians(g_Camera.FOV), vk.m_SwapChainImageExtent.width / (float)vk.m_SwapChainImageExtent.height, g_Camera.Near, g_Camera.Far);
+        g_Camera.Proj[1][1] *= -1;
+    }
+}
+
 void RecordCommandBuffersV2(VkState & vk,
-    VkPipeline& gbufferPipeline , VkPipelineLayout& gbufferPipelineLayout, VkRenderPass gbufferRenderPass, Vector<VkDescriptorSet>& gbufferDescriptorSets, Vector<VkFramebuffer>& gbufferFramebuffers,
-    VkPipeline& lightingPassPipeline, VkPipelineLayout& lightingPassPipelineLayout, VkRenderPass lightingPassRenderPass, Vector<VkDescriptorSet>& lightingPassDescriptorSets, Vector<VkFramebuffer>& lightingPassFramebuffers,
-    RenderModel& model, MeshEx& screenQuad)
+    VkPipeline& gbufferPipeline , VkPipelineLayout& gbufferPipelineLayout, VkRenderPass gbufferRenderPass, Vector<VkFramebuffer>& gbufferFramebuffers,
+    VkPipeline& lightingPassPipeline, VkPipelineLayout& lightingPassPipelineLayout, VkRenderPass lightingPassRenderPass, Material& lightingPassMaterial, Vector<VkFramebuffer>& lightingPassFramebuffers,
+    ClusteredLighting& clusteredLighting, GpuCulling& gpuCulling, DepthPyramid& depthPyramid, const culling::Frustum& frustum,
+    RenderModel& model, Vector<uint32_t>& itemUniformOffsets, MeshEx& screenQuad)
 {
     lvk::commands::RecordGraphicsCommands(vk, [&](VkCommandBuffer& commandBuffer, uint32_t frameIndex) {
+        // writes the indirect draws of every render item, culled ones draw nothing
+        gpuCulling.Dispatch(commandBuffer, vk.m_CurrentFrameIndex, frustum);
+
+        // bins the lights for the lighting pass, outside of any render pass
+        clusteredLighting.Dispatch(commandBuffer, vk.m_CurrentFrameIndex);
+
         // push to example
         {
             std::array<VkClearValue, 4> clearValues{};
@@ -80,7 +112,8 @@ void RecordCommandBuffersV2(VkState & vk,
             VkRenderPassBeginInfo renderPassInfo{};
             renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
             renderPassInfo.renderPass = gbufferRenderPass;
-            renderPassInfo.framebuffer = gbufferFramebuffers[frameIndex];
+            // the gbuffer is per frame in flight like the lighting pass material sampling it
+            renderPassInfo.framebuffer = gbufferFramebuffers[vk.m_CurrentFrameIndex];
             renderPassInfo.renderArea.offset = { 0,0 };
             renderPassInfo.renderArea.extent = vk.m_SwapChainImageExtent;
 
@@ -106,19 +139,33 @@ void RecordCommandBuffersV2(VkState & vk,
             vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
             vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-            for (int i = 0; i < model.m_RenderItems.size(); i++)
+            // pooled meshes share buffers, only rebind when a mesh has its own
+            VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(model.m_RenderItems.size()); i++)
             {
+                if (itemUniformOffsets[i] == UINT32_MAX)
+                {
+                    continue;
+                }
                 MeshEx& mesh = model.m_RenderItems[i].m_Mesh;
-                VkBuffer vertexBuffers[]{ mesh.m_VertexBuffer };
-                VkDeviceSize sizes[] = { 0 };
+                if (mesh.m_VertexBuffer != boundVertexBuffer)
+                {
+                    VkBuffer vertexBuffers[]{ mesh.m_VertexBuffer };
+                    VkDeviceSize sizes[] = { 0 };
 
+                    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, sizes);
+                    vkCmdBindIndexBuffer(commandBuffer, mesh.m_IndexBuffer, 0, mesh.m_IndexType);
+                    boundVertexBuffer = mesh.m_VertexBuffer;
+                }
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gbufferPipelineLayout, 0, 1, &model.m_RenderItems[i].m_Material.m_DescriptorSets[0].m_Sets[vk.m_CurrentFrameIndex], 1, &itemUniformOffsets[i]);
 
-                vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, sizes);
-                vkCmdBindIndexBuffer(commandBuffer, mesh.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gbufferPipelineLayout, 0, 1, &model.m_RenderItems[i].m_Material.m_DescriptorSets[0].m_Sets[vk.m_CurrentFrameIndex], 0, nullptr);
-                vkCmdDrawIndexed(commandBuffer, mesh.m_IndexCount, 1, 0, 0, 0);
+                // each item is its own draw group, its instance sits at slot i
+                gpuCulling.DrawGroup(commandBuffer, vk.m_CurrentFrameIndex, i, 1);
             }
             vkCmdEndRenderPass(commandBuffer);
+
+            // occlusion input for the next frame's cull
+            depthPyramid.Build(commandBuffer, vk.m_CurrentFrameIndex);
         }
 
         // push to example
@@ -156,189 +203,47 @@ void RecordCommandBuffersV2(VkState & vk,
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
         VkDeviceSize sizes[] = { 0 };
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, &screenQuad.m_VertexBuffer, sizes);
-        vkCmdBindIndexBuffer(commandBuffer, screenQuad.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPassPipelineLayout, 0, 1, &lightingPassDescriptorSets[frameIndex], 0, nullptr);
+        vkCmdBindIndexBuffer(commandBuffer, screenQuad.m_IndexBuffer, 0, screenQuad.m_IndexType);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPassPipelineLayout, 0, 1, &lightingPassMaterial.m_DescriptorSets[0].m_Sets[vk.m_CurrentFrameIndex], 0, nullptr);
         vkCmdDrawIndexed(commandBuffer, screenQuad.m_IndexCount, 1, 0, 0, 0);
         vkCmdEndRenderPass(commandBuffer);
         });
 }
 
-void UpdateUniformBuffer(VkState & vk, ShaderBufferFrameData& itemMvp, ShaderBufferFrameData lightsData, DeferredLightData& lightDataCpu)
+// shadow writes only, FlushUniforms uploads whatever changed once the frame's fence has been waited on
+void UpdateUniformBuffer(VkState & vk, Material& lightingPassMaterial, DeferredLightData& lightDataCpu)
 {
-    static auto startTime = std::chrono::high_resolution_clock::now();
+    lightingPassMaterial.SetMember("ubo.model", g_Transform.to_mat4());
+    lightingPassMaterial.SetMember("ubo.view", g_Camera.View);
+    lightingPassMaterial.SetMember("ubo.proj", g_Camera.Proj);
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-
-    MvpData ubo{};
-    ubo.Model = g_Transform.to_mat4();
-
-    ubo.View = glm::lookAt(glm::vec3(20.0f, 20.0f, 20.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    if (vk.m_SwapChainImageExtent.width > 0 || vk.m_SwapChainImageExtent.height)
-    {
-        ubo.Proj = glm::perspective(glm::radians(45.0f), vk.m_SwapChainImageExtent.width / (float)vk.m_SwapChainImageExtent.height, 0.1f, 1000.0f);
-        ubo.Proj[1][1] *= -1;
-    }
-    itemMvp.Set(vk.m_CurrentFrameIndex, ubo);
-
-
-    lightsData.Set(vk.m_CurrentFrameIndex, lightDataCpu);
+    // point and spot lights go through ClusteredLighting
+    lightingPassMaterial.SetMember("lightUbo.u_DirectionalLight", lightDataCpu.m_DirectionalLight);
+    lightingPassMaterial.SetMember("lightUbo.u_DirLightActive", lightDataCpu.m_DirectionalLightActive);
 }
 
-void UpdateUniformBufferMat(VkState & vk, Material& itemMat, ShaderBufferFrameData lightsData, DeferredLightData& lightDataCpu)
+lights_deferred::UniformBufferObject BuildItemUniforms()
 {
-    static auto startTime = std::chrono::high_resolution_clock::now();
-
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-
-    MvpData ubo{};
-    ubo.Model = g_Transform.to_mat4();
-
-    ubo.View = glm::lookAt(glm::vec3(20.0f, 20.0f, 20.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    if (vk.m_SwapChainImageExtent.width > 0 || vk.m_SwapChainImageExtent.height)
-    {
-        ubo.Proj = glm::perspective(glm::radians(45.0f), vk.m_SwapChainImageExtent.width / (float)vk.m_SwapChainImageExtent.height, 0.1f, 1000.0f);
-        ubo.Proj[1][1] *= -1;
-    }
-    itemMat.SetBuffer(vk.m_CurrentFrameIndex, 0, 0, ubo);
-
-
-    lightsData.Set(vk.m_CurrentFrameIndex, lightDataCpu);
+    lights_deferred::UniformBufferObject ubo{};
+    ubo.model = g_Transform.to_mat4();
+    ubo.view = g_Camera.View;
+    ubo.proj = g_Camera.Proj;
+    return ubo;
 }
 
-void CreateGBufferDescriptorSets(VkState & vk, VkDescriptorSetLayout& descriptorSetLayout, VkImageView& textureImageView, VkSampler& textureSampler, Vector<VkDescriptorSet>& descriptorSets, ShaderBufferFrameData& mvpUniformData)
+void SetLightingPassAttachments(VkState & vk, Material& lightingPassMaterial, FramebufferSetEx& gbuffers)
 {
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = vk.m_DescriptorSetAllocator.GetPool(vk.m_LogicalDevice);
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-    allocInfo.pSetLayouts = layouts.data();
-
-    descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
-    VK_CHECK(vkAllocateDescriptorSets(vk.m_LogicalDevice, &allocInfo, descriptorSets.data()));
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        VkDescriptorBufferInfo mvpBufferInfo{};
-        mvpBufferInfo.buffer = mvpUniformData.m_UniformBuffers[i].m_GpuBuffer;
-        mvpBufferInfo.offset = 0;
-        mvpBufferInfo.range = sizeof(MvpData);
-
-        VkDescriptorImageInfo imageInfo{};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = textureImageView;
-        imageInfo.sampler = textureSampler;
-
-        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
-
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = descriptorSets[i];
-        descriptorWrites[0].dstBinding = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo = &mvpBufferInfo;
-
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = descriptorSets[i];
-        descriptorWrites[1].dstBinding = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pImageInfo = &imageInfo;
-
-
-        vkUpdateDescriptorSets(vk.m_LogicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-    }
-
-}
-
-void CreateLightingPassDescriptorSets(
-    VkState & vk, VkDescriptorSetLayout& descriptorSetLayout, FramebufferSetEx gbuffers, Vector<VkDescriptorSet>& descriptorSets, ShaderBufferFrameData& mvpUniformData, ShaderBufferFrameData& lightsUniformData)
-{
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = vk.m_DescriptorSetAllocator.GetPool(vk.m_LogicalDevice);
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-    allocInfo.pSetLayouts = layouts.data();
-
-    descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
-    VK_CHECK(vkAllocateDescriptorSets(vk.m_LogicalDevice, &allocInfo, descriptorSets.data()));
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        VkDescriptorBufferInfo mvpBufferInfo{};
-        mvpBufferInfo.buffer = mvpUniformData.m_UniformBuffers[i].m_GpuBuffer;
-        mvpBufferInfo.offset = 0;
-        mvpBufferInfo.range = sizeof(MvpData);
-
-        VkDescriptorImageInfo positionBufferInfo{};
-        positionBufferInfo.imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
-        positionBufferInfo.imageView = gbuffers.m_Framebuffers[i].m_Attachments[1].m_ImageView;
-        positionBufferInfo.sampler = gbuffers.m_Framebuffers[i].m_Attachments[1].m_Sampler;
-
-        VkDescriptorImageInfo normalBufferInfo{};
-        normalBufferInfo.imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
-        normalBufferInfo.imageView = gbuffers.m_Framebuffers[i].m_Attachments[2].m_ImageView;
-        normalBufferInfo.sampler = gbuffers.m_Framebuffers[i].m_Attachments[2].m_Sampler;
-
-        VkDescriptorImageInfo colourBufferInfo{};
-        colourBufferInfo.imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
-        colourBufferInfo.imageView = gbuffers.m_Framebuffers[i].m_Attachments[0].m_ImageView;
-        colourBufferInfo.sampler = gbuffers.m_Framebuffers[i].m_Attachments[0].m_Sampler;
-
-        VkDescriptorBufferInfo lightBufferInfo{};
-        lightBufferInfo.buffer = lightsUniformData.m_UniformBuffers[i].m_GpuBuffer;
-        lightBufferInfo.offset = 0;
-        lightBufferInfo.range = sizeof(DeferredLightData);
-
-        std::array<VkWriteDescriptorSet, 5> descriptorWrites{};
-
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = descriptorSets[i];
-        descriptorWrites[0].dstBinding = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo = &mvpBufferInfo;
-
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = descriptorSets[i];
-        descriptorWrites[1].dstBinding = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pImageInfo = &positionBufferInfo;
-
-        descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[2].dstSet = descriptorSets[i];
-        descriptorWrites[2].dstBinding = 2;
-        descriptorWrites[2].dstArrayElement = 0;
-        descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[2].descriptorCount = 1;
-        descriptorWrites[2].pImageInfo = &normalBufferInfo;
-
-        descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[3].dstSet = descriptorSets[i];
-        descriptorWrites[3].dstBinding = 3;
-        descriptorWrites[3].dstArrayElement = 0;
-        descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[3].descriptorCount = 1;
-        descriptorWrites[3].pImageInfo = &colourBufferInfo;
-
-        descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[4].dstSet = descriptorSets[i];
-        descriptorWrites[4].dstBinding = 4;
-        descriptorWrites[4].dstArrayElement = 0;
-        descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[4].descriptorCount = 1;
-        descriptorWrites[4].pBufferInfo = &lightBufferInfo;
-
-
-        vkUpdateDescriptorSets(vk.m_LogicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    // position, normal and colour are sampled while still in their attachment layout
+    const char* samplerNames[] = { "colourBufferSampler", "positionBufferSampler", "normalBufferSampler" };
+    for (uint32_t attachment = 0; attachment < 3; attachment++)
+    {
+        Array<VkImageView, MAX_FRAMES_IN_FLIGHT> views{};
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            views[i] = gbuffers.m_Framebuffers[i].m_Attachments[attachment].m_ImageView;
+        }
+        lightingPassMaterial.SetSampler(vk, samplerNames[attachment], views, gbuffers.m_Framebuffers[0].m_Attachments[attachment].m_Sampler, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL);
     }
-
 }
 
 void CreateGBufferRenderPass(VkState & vk, VkRenderPass& renderPass)
@@ -365,7 +270,8 @@ void CreateGBufferRenderPass(VkState & vk, VkRenderPass& renderPass)
     depthAttachmentDescription.format = lvk::utils::FindDepthFormat(vk);
     depthAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;;
     depthAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    // kept for the depth pyramid built after the pass
+    depthAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     depthAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     depthAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depthAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -374,10 +280,10 @@ void CreateGBufferRenderPass(VkState & vk, VkRenderPass& renderPass)
     lvk::render_passes::CreateRenderPass(vk, renderPass, colourAttachmentDescriptions, resolveAttachmentDescriptions, true, depthAttachmentDescription, VK_ATTACHMENT_LOAD_OP_CLEAR);
 }
 
-RenderModel CreateRenderModelGbuffer(VkState & vk, const String& modelPath, ShaderProgram& shader)
+RenderModel CreateRenderModelGbuffer(VkState & vk, const String& modelPath, ShaderProgram& shader, UniformRing& itemUniforms, GeometryPool* pool, TextureStreamer* streamer)
 {
     Model model;
-    LoadModelAssimp(vk, model, modelPath, true);
+    LoadModel(vk, model, modelPath, true, pool, streamer);
 
     RenderModel renderModel{};
     renderModel.m_Original = model;
@@ -387,6 +293,7 @@ RenderModel CreateRenderModelGbuffer(VkState & vk, const String& modelPath, Shad
         int materialIndex = std::min(mesh.m_MaterialIndex, (uint32_t)model.m_Materials.size() - 1);
         item.m_Mesh = mesh;
         item.m_Material = Material::Create(vk, shader);
+        item.m_Material.SetDynamicUniformRing(vk, "ubo", itemUniforms);
 
         MaterialEx& material = model.m_Materials[mesh.m_MaterialIndex];
         item.m_Material.SetSampler(vk, "texSampler", material.m_Diffuse.m_ImageView, material.m_Diffuse.m_Sampler);
@@ -405,6 +312,8 @@ void OnImGui(VkState & vk, DeferredLightData& lightDataCpu)
         ImGui::DragFloat3("Position", &g_Transform.position[0]);
         ImGui::DragFloat3("Euler Rotation", & g_Transform.rotation[0]);
         ImGui::DragFloat3("Scale", & g_Transform.scale[0]);
+        ImGui::Separator();
+        ImGui::DragFloat3("Cam Position", &g_Camera.Position[0]);
     }
     ImGui::End();
 
@@ -465,19 +374,20 @@ int main()
     bool enableMSAA = false;
 
 
-    ShaderBufferFrameData mvpUniformData;
-    ShaderBufferFrameData lightsUniformData;
-
     DeferredLightData lightDataCpu{};
 
     FillExampleLightData(lightDataCpu);
-    Vector<VkDescriptorSet>     lightPassDescriptorSets;
-    Vector<VkDescriptorSet>     gbufferDescriptorSets;
 
-    ShaderProgram gbufferProg = ShaderProgram::CreateGraphicsFromSourcePath(
-        vk, "shaders/gbuffer.vert", "shaders/gbuffer.frag");
-    ShaderProgram lightPassProg = ShaderProgram::CreateGraphicsFromSourcePath(
-        vk, "shaders/lights.vert", "shaders/lights.frag");
+    // per item transforms are bump allocated from a UniformRing and bound with a dynamic offset
+    ShaderStage gbufferVert = ShaderStage::CreateFromSourcePath(vk, "shaders/gbuffer.vert", ShaderStageType::Vertex);
+    ShaderStage gbufferFrag = ShaderStage::CreateFromSourcePath(vk, "shaders/gbuffer.frag", ShaderStageType::Fragment);
+    gbufferVert.SetDynamicUniformBuffer("ubo");
+    ShaderProgram gbufferProg = ShaderProgram::CreateGraphics(vk, gbufferVert, gbufferFrag);
+    // lights.frag gets the cluster buffers and lookups inserted at set 0, bindings 5 onwards
+    ShaderStage lightPassVert = ShaderStage::CreateFromSourcePath(vk, "shaders/lights.vert", ShaderStageType::Vertex);
+    ShaderStage lightPassFrag = ShaderStage::CreateFromSource(vk,
+        ClusteredLighting::InsertShadingGLSL(utils::LoadStringFromPath("shaders/lights.frag"), 0, 5), ShaderStageType::Fragment);
+    ShaderProgram lightPassProg = ShaderProgram::CreateGraphics(vk, lightPassVert, lightPassFrag);
 
     VkRenderPass gbufferRenderPass;
     CreateGBufferRenderPass(vk, gbufferRenderPass);
@@ -531,18 +441,50 @@ int main()
     // create vertex and index buffer
     Model model;
     LoadModelAssimp(vk, model, "assets/viking_room.obj", true);
-    RenderModel m = CreateRenderModelGbuffer(vk, "assets/sponza/sponza.gltf", gbufferProg);
+    GeometryPool geometryPool = GeometryPool::Create<VertexDataPosNormalUv>(vk, 1 << 20, 1 << 22, VK_INDEX_TYPE_UINT16);
+
+    // materials with a cooked .ktx2 next to their source start at the mip tail and stream up from there
+    UniformRing itemUniforms = UniformRing::Create(vk, 1 << 20, sizeof(lights_deferred::UniformBufferObject));
+
+    RenderModel m;
+    TextureStreamer textureStreamer;
+    textureStreamer.Init({}, [&](uint32_t handle, const Texture& streamed) {
+        m.RebindStreamedTexture(vk, vk.m_CurrentFrameIndex, handle, streamed, "texSampler");
+    });
+    m = CreateRenderModelGbuffer(vk, "assets/Sponza/Sponza.gltf", gbufferProg, itemUniforms, &geometryPool, &textureStreamer);
+
+    // the gpu pass culls what is drawn, the cpu one only decides which textures to stream in.
+    // every item shares g_Transform, so the local bounds are culled against a model space frustum
+    culling::BoundsSoA itemBounds;
+    for (auto& item : m.m_RenderItems)
+    {
+        itemBounds.Add(item.m_Mesh.m_AABB.m_Min, item.m_Mesh.m_AABB.m_Max);
+    }
+    Vector<uint32_t> visibleItems;
 
-    MeshEx screenQuad = BuildScreenSpaceQuad(vk, g_ScreenSpaceQuadVertexData, g_ScreenSpaceQuadIndexData);
+    uint32_t itemCount = static_cast<uint32_t>(m.m_RenderItems.size());
+    // depth is attachment 3 of every gbuffer
+    Array<VkImage, MAX_FRAMES_IN_FLIGHT> depthImages{};
+    Array<VkImageView, MAX_FRAMES_IN_FLIGHT> depthViews{};
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        depthImages[i] = gbufferSet.m_Framebuffers[i].m_Attachments[3].m_Image;
+        depthViews[i] = gbufferSet.m_Framebuffers[i].m_Attachments[3].m_ImageView;
+    }
+    DepthPyramid depthPyramid = DepthPyramid::Create(vk, vk.m_SwapChainImageExtent, utils::FindDepthFormat(vk), depthImages, depthViews);
+    GpuCulling gpuCulling = GpuCulling::Create(vk, itemCount, &depthPyramid);
+    // the view projection the last built pyramid was rendered with, zero until the first frame
+    glm::mat4 previousViewProj(0.0f);
+    Vector<GpuCulling::Instance> itemInstances(itemCount);
+    Vector<uint32_t> itemUniformOffsets(itemCount);
 
-    Texture texture = Texture::CreateTexture(vk, "assets/viking_room.png", VK_FORMAT_R8G8B8A8_UNORM);
+    MeshEx screenQuad = BuildScreenSpaceQuad(vk, g_ScreenSpaceQuadVertexData, g_ScreenSpaceQuadIndexData);
 
-    // Shader too probably
-    buffers::CreateUniformBuffers<FrameLightDataT<NUM_LIGHTS>>(vk, lightsUniformData);
-    buffers::CreateUniformBuffers<MvpData>(vk, mvpUniformData);
+    Material lightPassMaterial = Material::Create(vk, lightPassProg);
+    SetLightingPassAttachments(vk, lightPassMaterial, gbufferSet);
 
-    CreateGBufferDescriptorSets(vk, gbufferProg.m_DescriptorSetLayout, texture.m_ImageView, texture.m_Sampler, gbufferDescriptorSets, mvpUniformData);
-    CreateLightingPassDescriptorSets(vk, lightPassProg.m_DescriptorSetLayout, gbufferSet, lightPassDescriptorSets, mvpUniformData, lightsUniformData);
+    ClusteredLighting clusteredLighting = ClusteredLighting::Create(vk, NUM_LIGHTS, NUM_LIGHTS);
+    clusteredLighting.BindShadingBuffers(vk, lightPassMaterial);
 
     Vector<VkFramebuffer> gbufferFramebuffers{ gbufferSet.m_Framebuffers[0].m_FB, gbufferSet.m_Framebuffers[1].m_FB };
 
@@ -550,30 +492,80 @@ int main()
     {
         vk.m_Backend->PreFrame(vk);
 
-        for (auto& item : m.m_RenderItems)
+        // the ring slice for this frame is reused, wait until its last submission has retired
+        submission::WaitForFrame(vk);
+        itemUniforms.BeginFrame(vk.m_CurrentFrameIndex);
+
+        UpdateCamera(vk);
+        lights_deferred::UniformBufferObject itemUbo = BuildItemUniforms();
+
+        culling::Frustum frustum = culling::Frustum::FromViewProj(itemUbo.proj * itemUbo.view * itemUbo.model);
+        culling::CullAABBs(frustum, itemBounds, visibleItems);
+
+        lod::LodSelector lodSelector = lod::LodSelector::Create(g_Camera.Position, glm::radians(g_Camera.FOV),
+            static_cast<float>(vk.m_SwapChainImageExtent.height));
+
+        // every item shares g_Transform today, each still gets its own block so per item transforms only change the push
+        for (uint32_t i = 0; i < itemCount; i++)
         {
-            UpdateUniformBufferMat(vk, item.m_Material, lightsUniformData, lightDataCpu);
+            MeshEx& mesh = m.m_RenderItems[i].m_Mesh;
+            GpuCulling::Instance& instance = itemInstances[i];
+            instance.m_Model = itemUbo.model;
+            instance.m_BoundsCentre = glm::vec4((mesh.m_AABB.m_Min + mesh.m_AABB.m_Max) * 0.5f, 0.0f);
+            instance.m_BoundsExtent = glm::vec4((mesh.m_AABB.m_Max - mesh.m_AABB.m_Min) * 0.5f, 0.0f);
+            instance.m_IndexCount = mesh.m_IndexCount;
+            instance.m_FirstIndex = mesh.m_PoolRange.m_FirstIndex;
+            instance.m_VertexOffset = mesh.m_PoolRange.m_VertexOffset;
+            instance.m_DrawFirst = i;
+            if (!mesh.m_Lods.empty())
+            {
+                const lod::LodLevel& level = mesh.m_Lods[lodSelector.Select(mesh.m_Lods, mesh.m_AABB.m_Min, mesh.m_AABB.m_Max, itemUbo.model)];
+                instance.m_FirstIndex += level.m_FirstIndex;
+                instance.m_IndexCount = level.m_IndexCount;
+            }
+
+            itemUniformOffsets[i] = itemUniforms.Push(itemUbo);
         }
+        gpuCulling.SetInstances(vk, vk.m_CurrentFrameIndex, itemInstances.data(), itemCount);
+        culling::Frustum worldFrustum = culling::Frustum::FromViewProj(itemUbo.proj * itemUbo.view);
+        gpuCulling.SetOcclusionViewProj(vk, vk.m_CurrentFrameIndex, previousViewProj);
+        previousViewProj = itemUbo.proj * itemUbo.view;
+
+        // views the streamer swapped while this frame was in flight, then this frame's own swaps
+        m.ApplyPendingRebinds(vk, vk.m_CurrentFrameIndex);
+        m.RequestStreamedTextures(textureStreamer, visibleItems, lodSelector, itemUbo.model);
+        textureStreamer.Update(vk);
+
+        UpdateUniformBuffer(vk, lightPassMaterial, lightDataCpu);
 
-        UpdateUniformBuffer(vk, mvpUniformData, lightsUniformData, lightDataCpu);
+        clusteredLighting.SetLights(vk, vk.m_CurrentFrameIndex,
+            reinterpret_cast<const ClusterPointLight*>(lightDataCpu.m_PointLights.data()), NUM_LIGHTS,
+            reinterpret_cast<const ClusterSpotLight*>(lightDataCpu.m_SpotLights.data()), NUM_LIGHTS);
+        clusteredLighting.Update(vk, vk.m_CurrentFrameIndex, itemUbo.view, itemUbo.proj, vk.m_SwapChainImageExtent, g_Camera.Near, g_Camera.Far);
+        lightPassMaterial.FlushUniforms(vk.m_CurrentFrameIndex);
 
         RecordCommandBuffersV2(vk, 
-            gbufferPipeline, gbufferPipelineLayout, gbufferRenderPass,  gbufferDescriptorSets, gbufferFramebuffers, 
-            pipeline, lightPassPipelineLayout, vk.m_SwapchainImageRenderPass, lightPassDescriptorSets, vk.m_SwapChainFramebuffers,
-            m, screenQuad);
+            gbufferPipeline, gbufferPipelineLayout, gbufferRenderPass, gbufferFramebuffers, 
+            pipeline, lightPassPipelineLayout, vk.m_SwapchainImageRenderPass, lightPassMaterial, vk.m_SwapChainFramebuffers,
+            clusteredLighting, gpuCulling, depthPyramid, worldFrustum, m, itemUniformOffsets, screenQuad);
 
         OnImGui(vk, lightDataCpu);
 
         vk.m_Backend->PostFrame(vk);
     }
 
-    mvpUniformData.Free(vk);
-    lightsUniformData.Free(vk);
+    lightPassMaterial.Free(vk);
+    clusteredLighting.Free(vk);
+    gpuCulling.Free(vk);
+    depthPyramid.Free(vk);
 
     FreeModel(vk, model);
     FreeMesh(vk, screenQuad);
+    m.Free(vk);
+    textureStreamer.Free(vk);
+    geometryPool.Free(vk);
+    itemUniforms.Free(vk);
 
-    texture.Free(vk);
     gbufferSet.Free(vk);
 
     vkDestroyRenderPass(vk.m_LogicalDevice, gbufferRenderPass, nullptr);
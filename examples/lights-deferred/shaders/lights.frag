@@ -1,6 +1,8 @@
 #version 450
 
-#define MAX_NUM_EACH_LIGHTS 512
+// the cluster buffers and the ClusterPointLight / ClusterSpotLight structs are inserted after the
+// #version line by ClusteredLighting::InsertShadingGLSL (set 0, bindings 5 - 9), so this only
+// compiles at runtime through lvk and is not part of the reflected shaders
 
 #define ATTENUATION_CONSTANT 1.0
 #define ATTENUATION_LINEAR_CONSTANT 4.5
@@ -13,21 +15,6 @@ struct DirectionalLight
     vec4 Colour;
 };
 
-struct PointLight
-{
-    vec4 PositionRadius;
-    vec4 Ambient;
-    vec4 Colour;
-};
-
-struct SpotLight
-{
-    vec4 PositionRadius;
-    vec4 DirectionAngle;
-    vec4 Ambient;
-    vec4 Colour;
-};
-
 layout(location = 0) in vec2 UV;
 
 layout(location = 0) out vec4 outColor;
@@ -44,12 +31,7 @@ layout(binding = 3) uniform sampler2D colourBufferSampler;
 
 layout(binding = 4) uniform UniformLightObject{
     DirectionalLight    u_DirectionalLight;
-    PointLight          u_PointLights[MAX_NUM_EACH_LIGHTS];
-    SpotLight           u_SpotLights[MAX_NUM_EACH_LIGHTS];
-
     uint                u_DirLightActive;
-    uint                u_PointLightsActive;
-    uint                u_SpotLightsActive;
 } lightUbo;
 
 
@@ -75,10 +57,10 @@ vec3 BlinnPhong_Directional(vec3 normal, vec3 materialAmbient, vec3 materialDiff
     return (ambient + diffuse + spec);
 }
 
-vec3 BlinnPhong_Point(int lightIdx, vec3 position, vec3 normal, vec3 materialAmbient, vec3 materialDiffuse, vec3 materialSpecular, float shininess)
+vec3 BlinnPhong_Point(ClusterPointLight light, vec3 position, vec3 normal, vec3 materialAmbient, vec3 materialDiffuse, vec3 materialSpecular, float shininess)
 {
-    vec3    ambient    = lightUbo.u_PointLights[lightIdx].Ambient.xyz * materialAmbient;
-    vec3    plDir      = lightUbo.u_PointLights[lightIdx].PositionRadius.xyz - position;
+    vec3    ambient    = light.Ambient.xyz * materialAmbient;
+    vec3    plDir      = light.PositionRadius.xyz - position;
     vec3    s          = normalize(plDir);
     float   sDotN      = max(dot(s, normal), 0.0);
     vec3    diffuse    = materialDiffuse * sDotN;
@@ -90,7 +72,7 @@ vec3 BlinnPhong_Point(int lightIdx, vec3 position, vec3 normal, vec3 materialAmb
         vec3 h = normalize(v + s);
         spec =  materialSpecular * pow(max(dot(h, normal), 0.0), shininess);
     }
-    float range     = lightUbo.u_PointLights[lightIdx].PositionRadius.w;
+    float range     = light.PositionRadius.w;
 
     float attenuation = BlinnPhong_Attenuation(range, length(plDir));
 
@@ -98,33 +80,33 @@ vec3 BlinnPhong_Point(int lightIdx, vec3 position, vec3 normal, vec3 materialAmb
     diffuse     *= attenuation;
     spec        *= attenuation;
 
-    return (ambient + lightUbo.u_PointLights[lightIdx].Colour.xyz * (diffuse + spec));
+    return (ambient + light.Colour.xyz * (diffuse + spec));
 }
 
-vec3 BlinnPhong_Spot(int lightIdx, vec3 position, vec3 normal, vec3 materialAmbient, vec3 materialDiffuse, vec3 materialSpecular, float shininess)
+vec3 BlinnPhong_Spot(ClusterSpotLight light, vec3 position, vec3 normal, vec3 materialAmbient, vec3 materialDiffuse, vec3 materialSpecular, float shininess)
 {
-    vec3    slDir      = lightUbo.u_SpotLights[lightIdx].PositionRadius.xyz - position;
+    vec3    slDir      = light.PositionRadius.xyz - position;
     vec3    s          = normalize(slDir);
 
-    float cosAngle     = dot(-s, normalize(lightUbo.u_SpotLights[lightIdx].DirectionAngle.xyz));
+    float cosAngle     = dot(-s, normalize(light.DirectionAngle.xyz));
     float angle        = acos(cosAngle);
-    float   theta      = dot(slDir, normalize(-lightUbo.u_SpotLights[lightIdx].DirectionAngle.xyz));
+    float   theta      = dot(slDir, normalize(-light.DirectionAngle.xyz));
 
-    if (angle < lightUbo.u_SpotLights[lightIdx].DirectionAngle.w)
+    if (angle < light.DirectionAngle.w)
     {
-        vec3 ambient    = lightUbo.u_SpotLights[lightIdx].Ambient.xyz * materialAmbient;
+        vec3 ambient    = light.Ambient.xyz * materialAmbient;
 
         vec3    norm    = normalize(normal);
         float   diff    = max(dot(norm, slDir), 0.0);
-        vec3    diffuse = lightUbo.u_SpotLights[lightIdx].Colour.xyz * diff * materialDiffuse;
+        vec3    diffuse = light.Colour.xyz * diff * materialDiffuse;
 
         vec3    viewPos = vec3(ubo.view[3][0], ubo.view[3][1], ubo.view[3][2]);
         vec3    viewDir = normalize(viewPos - position);
         vec3    reflectDir = reflect(-slDir, norm);
         float   spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
-        vec3    specular = lightUbo.u_SpotLights[lightIdx].Colour.xyz * spec * materialSpecular;
+        vec3    specular = light.Colour.xyz * spec * materialSpecular;
 
-        float   range     = lightUbo.u_SpotLights[lightIdx].PositionRadius.w;
+        float   range     = light.PositionRadius.w;
         float   attenuation = BlinnPhong_Attenuation(range, length(slDir));
 
         diffuse     *= attenuation;
@@ -135,7 +117,7 @@ vec3 BlinnPhong_Spot(int lightIdx, vec3 position, vec3 normal, vec3 materialAmbi
     }
     else
     {
-        return lightUbo.u_SpotLights[lightIdx].Ambient.xyz * materialAmbient;
+        return light.Ambient.xyz * materialAmbient;
     }
 }
 
@@ -147,16 +129,16 @@ void main() {
 
     vec3 lightColour = BlinnPhong_Directional(normal, vec3(0.0f), textureColour.xyz, vec3(0.0f), 0.0f);
 
-    for (int i = 0; i < 16; i++)
+    // only the lights binned into this fragment's cluster
+    uvec4 cluster = Cluster_Get(gl_FragCoord.xy, position);
+    for (uint i = cluster.x; i < cluster.x + cluster.y; i++)
     {
-        //lightColour
-        lightColour += BlinnPhong_Point(i, position, normal, vec3(0.0f), textureColour.xyz, vec3(0.0f), 0.0f);
+        lightColour += BlinnPhong_Point(Cluster_PointLight(i), position, normal, vec3(0.0f), textureColour.xyz, vec3(0.0f), 0.0f);
     }
 
-    for (int i = 0; i < 16; i++)
+    for (uint i = cluster.z; i < cluster.z + cluster.w; i++)
     {
-        //lightColour
-        lightColour += BlinnPhong_Spot(i, position, normal, vec3(0.0f), textureColour.xyz, vec3(0.0f), 0.0f);
+        lightColour += BlinnPhong_Spot(Cluster_SpotLight(i), position, normal, vec3(0.0f), textureColour.xyz, vec3(0.0f), 0.0f);
     }
 
     outColor = vec4(lightColour, 1.0);
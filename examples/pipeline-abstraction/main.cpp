@@ -187,7 +187,7 @@ pipelines::PipelineT<VkRecordCommandCallback> CreateViewPipeline(VkState & vk, L
                 vkCmdPushConstants(commandBuffer, lightPassPipelineData->m_PipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PCViewData), &pcData);
                 VkDeviceSize sizes[] = { 0 };
                 vkCmdBindVertexBuffers(commandBuffer, 0, 1, &screenQuad.m_VertexBuffer, sizes);
-                vkCmdBindIndexBuffer(commandBuffer, screenQuad.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                vkCmdBindIndexBuffer(commandBuffer, screenQuad.m_IndexBuffer, 0, screenQuad.m_IndexType);
                 vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lightPassPipelineData->m_PipelineLayout, 0, 1, &lightPassMat->m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
                 vkCmdDrawIndexed(commandBuffer, screenQuad.m_IndexCount, 1, 0, 0, 0);
                 DrawIm3d(vk, commandBuffer, frameIndex, im3dState, *im3dViewState, view.m_Camera.Proj * view.m_Camera.View, viewExtent.width, viewExtent.height);
@@ -219,9 +219,10 @@ ViewData CreateView(VkState & vk, LvkIm3dState im3dState, ShaderProgram gbufferP
 
     VkBuffer indexBuffer;
     VmaAllocation indexAlloc;
-    buffers::CreateIndexBuffer(vk, screenQuadIndices, indexBuffer, indexAlloc);
+    VkIndexType indexType;
+    buffers::CreateIndexBuffer(vk, screenQuadIndices, static_cast<uint32_t>(screenQuadVerts.size()), indexBuffer, indexAlloc, indexType);
 
-    Mesh screenQuad{ vertBuffer, vertAlloc, indexBuffer, indexAlloc, 6 };
+    Mesh screenQuad{ vertBuffer, vertAlloc, indexBuffer, indexAlloc, 6, indexType };
 
     return { pipeline, {{}, {1920, 1080}}, screenQuad };
 }
@@ -8,9 +8,21 @@ namespace buffers {
 void CreateBuffer(VkState &vk, VkDeviceSize size, VkBufferUsageFlags usage,
                      VkMemoryPropertyFlags properties, VkBuffer &buffer,
                      VmaAllocation &allocation);
-void CopyBuffer(VkState &vk, VkBuffer &src, VkBuffer &dst, VkDeviceSize size);
+void CopyBuffer(VkState &vk, VkBuffer &src, VkBuffer &dst, VkDeviceSize size,
+                VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
 void CreateIndexBuffer(VkState &vk, Vector<uint32_t> indices, VkBuffer &buffer,
                        VmaAllocation &deviceMemory);
+// picks 16 bit indices when vertexCount allows it, the type to bind with is
+// returned through indexType
+void CreateIndexBuffer(VkState &vk, const Vector<uint32_t> &indices,
+                       uint32_t vertexCount, VkBuffer &buffer,
+                       VmaAllocation &deviceMemory, VkIndexType &indexType);
+
+// VK_INDEX_TYPE_UINT16 when every index into vertexCount vertices fits in 16 bits
+VkIndexType SelectIndexType(uint32_t vertexCount);
+uint32_t GetIndexSize(VkIndexType indexType);
+void NarrowIndices(const uint32_t *indices, size_t indexCount,
+                   Vector<uint16_t> &narrowed);
 
 template <typename _Ty>
 void CreateUniformBuffers(VkState &vk, Vector<VkBuffer> &uniformBuffersFrames,
@@ -0,0 +1,91 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "lvk/Material.h"
+#include "lvk/Shader.h"
+
+namespace lvk
+{
+    // gpu layouts of the lights consumed by the cluster pass, these match the
+    // PointLight / SpotLight structs the examples already upload.
+    struct ClusterPointLight
+    {
+        glm::vec4 m_PositionRadius;
+        glm::vec4 m_Ambient;
+        glm::vec4 m_Colour;
+    };
+
+    struct ClusterSpotLight
+    {
+        glm::vec4 m_PositionRadius;
+        glm::vec4 m_DirectionAngle;
+        glm::vec4 m_Ambient;
+        glm::vec4 m_Colour;
+    };
+
+    // Bins point and spot light volumes into a view space froxel grid (screen tiles x exponential
+    // depth slices) with a compute pass and writes a compact light index list per cluster.
+    // Shading then only visits the lights overlapping the fragment's cluster.
+    //
+    // per frame :
+    //  SetLights -> Update -> Dispatch (before the lighting render pass, in the same command buffer)
+    // the lighting shader declares the cluster buffers with InsertShadingGLSL and its
+    // material is pointed at them once with BindShadingBuffers.
+    class ClusteredLighting
+    {
+    public:
+        // std430 mirror of the ClusterParams block
+        struct Params
+        {
+            glm::mat4   m_View;
+            glm::mat4   m_InverseProj;
+            glm::uvec4  m_GridSize;     // xyz : cluster counts, w : index list capacity
+            glm::vec4   m_DepthParams;  // x : near, y : far, z : slice scale, w : slice bias
+            glm::vec4   m_ScreenSize;   // xy : render extent
+            glm::uvec4  m_LightCounts;  // x : point lights, y : spot lights
+        };
+
+        static constexpr uint32_t k_ClustersPerWorkgroup = 64;
+
+        ShaderProgram       m_Program;
+        Material            m_Material;
+        VkPipeline          m_Pipeline          = VK_NULL_HANDLE;
+        VkPipelineLayout    m_PipelineLayout    = VK_NULL_HANDLE;
+
+        Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>       m_GridBuffers;
+        Array<VmaAllocation, MAX_FRAMES_IN_FLIGHT>  m_GridAllocations;
+        Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>       m_IndexBuffers;
+        Array<VmaAllocation, MAX_FRAMES_IN_FLIGHT>  m_IndexAllocations;
+        // host copy of each frame's index list counter, used to report overflow
+        Array<MappedBuffer, MAX_FRAMES_IN_FLIGHT>   m_CountReadback;
+
+        Params      m_Params{};
+        uint32_t    m_MaxPointLights    = 0;
+        uint32_t    m_MaxSpotLights     = 0;
+        // light indices the last read back frame could not fit in the index list
+        uint32_t    m_DroppedIndices    = 0;
+
+        static ClusteredLighting Create(VkState& vk, uint32_t maxPointLights, uint32_t maxSpotLights,
+            uint32_t gridX = 16, uint32_t gridY = 9, uint32_t gridZ = 24, uint32_t averageLightsPerCluster = 32);
+
+        // light counts are clamped to the capacities given to Create.
+        // call after frameIndex's fence wait, it also reports index list overflow from that frame's last dispatch
+        void SetLights(VkState& vk, uint32_t frameIndex, const ClusterPointLight* pointLights, uint32_t pointLightCount,
+            const ClusterSpotLight* spotLights, uint32_t spotLightCount);
+
+        // proj is the matrix used for rendering (including the vulkan y flip)
+        void Update(VkState& vk, uint32_t frameIndex, const glm::mat4& view, const glm::mat4& proj, VkExtent2D extent, float zNear, float zFar);
+
+        // records the cull dispatch and the barriers making the results visible to fragment shaders
+        void Dispatch(VkCommandBuffer& commandBuffer, uint32_t frameIndex);
+
+        // points a material built from a shader using InsertShadingGLSL at this frame's cluster buffers
+        bool BindShadingBuffers(VkState& vk, Material& material);
+
+        // inserts the cluster buffer declarations and lookup helpers after the #version line of source
+        static String InsertShadingGLSL(const String& source, uint32_t set, uint32_t firstBinding);
+
+        uint32_t GetClusterCount() const { return m_Params.m_GridSize.x * m_Params.m_GridSize.y * m_Params.m_GridSize.z; }
+
+        void Free(VkState& vk);
+    };
+}
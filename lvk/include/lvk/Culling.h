@@ -0,0 +1,70 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "Alias.h"
+
+namespace lvk
+{
+    class ThreadPool;
+
+namespace culling
+{
+    // planes are stored as (normal, distance) with the normal pointing into the frustum,
+    // a point p is inside a plane when dot(normal, p) + distance >= 0
+    struct Frustum
+    {
+        enum Plane { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+        Array<glm::vec4, PlaneCount> m_Planes;
+
+        // extracts normalised planes from a projection * view matrix using vulkan's 0..1 depth range.
+        // passing proj * view * model gives planes in that model's space, so its local bounds
+        // can be culled without transforming them.
+        static Frustum FromViewProj(const glm::mat4& viewProj);
+    };
+
+    // Axis aligned bounds stored as centre / half extent streams, one float array per component,
+    // so the cull kernels can load 4 (SSE, NEON) or 8 (AVX) boxes with a single instruction.
+    class BoundsSoA
+    {
+    public:
+        Vector<float> m_CenterX;
+        Vector<float> m_CenterY;
+        Vector<float> m_CenterZ;
+        Vector<float> m_ExtentX;
+        Vector<float> m_ExtentY;
+        Vector<float> m_ExtentZ;
+
+        // returns the index of the new box
+        uint32_t Add(const glm::vec3& min, const glm::vec3& max);
+        void Set(uint32_t index, const glm::vec3& min, const glm::vec3& max);
+
+        void Resize(uint32_t count);
+        void Reserve(uint32_t count);
+        void Clear();
+
+        uint32_t Size() const { return static_cast<uint32_t>(m_CenterX.size()); }
+    };
+
+    // Arvo's method : the bounds of a transformed box have centre M * c and half extent |M| * e
+    // (absolute upper 3x3), as tight as transforming all 8 corners for a fraction of the work.
+    void TransformAABB(const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& transform, glm::vec3& worldMin, glm::vec3& worldMax);
+
+    // world[i] = transforms[i] * local[i] for i in [first, first + count), world must already hold that range.
+    // 4 boxes are transformed at a time on SSE / NEON targets.
+    void TransformAABBs(const BoundsSoA& local, const glm::mat4* transforms, uint32_t first, uint32_t count, BoundsSoA& world);
+
+    // resizes world to match local and transforms every box, large sets are split across pool when given
+    void TransformAABBs(const BoundsSoA& local, const glm::mat4* transforms, BoundsSoA& world, ThreadPool* pool = nullptr);
+
+    // tests boxes [first, first + count) and writes the indices of the ones intersecting the frustum,
+    // in ascending order, to outIndices which must have room for count entries.
+    // returns the number of visible boxes. ranges are independent, so large sets can be split across threads.
+    uint32_t CullAABBs(const Frustum& frustum, const BoundsSoA& bounds, uint32_t first, uint32_t count, uint32_t* outIndices);
+
+    // culls every box in bounds, visibleIndices is resized to the visible count
+    uint32_t CullAABBs(const Frustum& frustum, const BoundsSoA& bounds, Vector<uint32_t>& visibleIndices);
+
+    // name of the kernel selected at compile time ("AVX", "SSE", "NEON" or "Scalar")
+    const char* GetCullKernelName();
+}
+}
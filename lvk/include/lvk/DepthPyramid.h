@@ -0,0 +1,54 @@
+#pragma once
+#include "lvk/Framebuffer.h"
+#include "lvk/Shader.h"
+
+namespace lvk
+{
+    // Hierarchical depth (Hi-Z) pyramid built from a depth attachment in a single compute dispatch.
+    // Every texel holds the farthest depth of the area it covers, so an object whose nearest depth is
+    // behind the pyramid value over its screen footprint is hidden. Mip 0 is the largest power of two
+    // that fits in the depth attachment.
+    //
+    // Each workgroup reduces a 32x32 tile down to mip 5 in shared memory. The last workgroup to
+    // finish, found with a global atomic counter, reduces the remaining mips. Record Build after
+    // the pass that writes the depth, the result is read by the next frame's culling : pass the pyramid to
+    // GpuCulling::Create(vk, maxInstances, &pyramid) and give it the view projection it was built with
+    // through GpuCulling::SetOcclusionViewProj.
+    class DepthPyramid
+    {
+    public:
+        static constexpr uint32_t k_MaxMips = 16;
+        static constexpr uint32_t k_TileSize = 32;
+
+        ShaderProgram       m_Program;
+        VkPipeline          m_Pipeline          = VK_NULL_HANDLE;
+        VkPipelineLayout    m_PipelineLayout    = VK_NULL_HANDLE;
+
+        Array<VkImage, MAX_FRAMES_IN_FLIGHT>                        m_Images;
+        Array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT>                 m_Memory;
+        Array<VkImageView, MAX_FRAMES_IN_FLIGHT>                    m_ImageViews;
+        Array<Array<VkImageView, k_MaxMips>, MAX_FRAMES_IN_FLIGHT>  m_MipViews;
+        Array<VkDescriptorSet, MAX_FRAMES_IN_FLIGHT>                m_DescriptorSets;
+        Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>                       m_CounterBuffers;
+        Array<VmaAllocation, MAX_FRAMES_IN_FLIGHT>                  m_CounterAllocations;
+        VkSampler                                                   m_Sampler = VK_NULL_HANDLE;
+
+        Array<VkImage, MAX_FRAMES_IN_FLIGHT>    m_DepthImages;
+        VkImageAspectFlags                      m_DepthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        VkExtent2D                              m_DepthExtent{};
+        VkExtent2D                              m_BaseExtent{};
+        uint32_t                                m_MipCount = 0;
+
+        // depthViews must be sampleable (created with VK_IMAGE_USAGE_SAMPLED_BIT)
+        static DepthPyramid Create(VkState& vk, VkExtent2D depthExtent, VkFormat depthFormat,
+            const Array<VkImage, MAX_FRAMES_IN_FLIGHT>& depthImages, const Array<VkImageView, MAX_FRAMES_IN_FLIGHT>& depthViews);
+
+        // uses the framebuffer's first depth attachment
+        static DepthPyramid Create(VkState& vk, Framebuffer& framebuffer);
+
+        // expects frameIndex's depth in VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL and leaves it there
+        void Build(VkCommandBuffer& commandBuffer, uint32_t frameIndex);
+
+        void Free(VkState& vk);
+    };
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "lvk/Structs.h"
+#include "lvk/Macros.h"
+#include "spdlog/spdlog.h"
+#include <map>
+
+namespace lvk
+{
+    // First fit free list over a range of elements. Free blocks are kept sorted by offset
+    // and merged with their neighbours when released, so the range does not fragment
+    // into blocks smaller than what was allocated.
+    class FreeListAllocator
+    {
+    public:
+        void Init(uint32_t capacity);
+
+        // returns false when no free block is large enough
+        bool Allocate(uint32_t count, uint32_t& offset);
+        void Free(uint32_t offset, uint32_t count);
+
+        uint32_t GetCapacity() const { return m_Capacity; }
+        uint32_t GetFreeCount() const { return m_FreeCount; }
+        uint32_t GetLargestFreeBlock() const;
+
+    private:
+        std::map<uint32_t, uint32_t>    m_FreeBlocks;   // offset -> count
+        uint32_t                        m_Capacity  = 0;
+        uint32_t                        m_FreeCount = 0;
+    };
+
+    // A mesh's range within a GeometryPool. Indices are relative to the mesh's first vertex,
+    // vkCmdDrawIndexed adds m_VertexOffset.
+    struct PooledMesh
+    {
+        int32_t     m_VertexOffset  = 0;
+        uint32_t    m_VertexCount   = 0;
+        uint32_t    m_FirstIndex    = 0;
+        uint32_t    m_IndexCount    = 0;
+    };
+
+    // one mesh of a GeometryPool::UploadBatch. the pointers are only read during the call and may point
+    // straight into a mapped file, m_IndexSize is the size of the source indices (2 or 4 bytes)
+    struct PoolUpload
+    {
+        PooledMesh      m_Mesh;
+        const void*     m_Vertices  = nullptr;
+        const void*     m_Indices   = nullptr;
+        uint32_t        m_IndexSize = sizeof(uint32_t);
+    };
+
+    // Device local vertex and index arenas shared by every mesh of one vertex layout.
+    // Meshes are sub-allocated ranges, so a pass binds the pool once and draws each mesh with
+    // firstIndex / vertexOffset, which is also the layout indirect draws need (see GpuCulling).
+    // Indices are relative to each mesh, so a 16 bit pool can hold any number of meshes of up
+    // to 65535 vertices each.
+    class GeometryPool
+    {
+    public:
+        VkBuffer            m_VertexBuffer          = VK_NULL_HANDLE;
+        VmaAllocation       m_VertexBufferMemory    = VK_NULL_HANDLE;
+        VkBuffer            m_IndexBuffer           = VK_NULL_HANDLE;
+        VmaAllocation       m_IndexBufferMemory     = VK_NULL_HANDLE;
+        uint32_t            m_VertexStride          = 0;
+        VkIndexType         m_IndexType             = VK_INDEX_TYPE_UINT32;
+
+        FreeListAllocator   m_VertexAllocator;
+        FreeListAllocator   m_IndexAllocator;
+
+        static GeometryPool Create(VkState& vk, uint32_t vertexStride, uint32_t maxVertices, uint32_t maxIndices, VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+
+        template<typename _Ty>
+        static GeometryPool Create(VkState& vk, uint32_t maxVertices, uint32_t maxIndices, VkIndexType indexType = VK_INDEX_TYPE_UINT32)
+        {
+            return Create(vk, static_cast<uint32_t>(sizeof(_Ty)), maxVertices, maxIndices, indexType);
+        }
+
+        // reserves ranges without writing them, returns false if either arena is full
+        // or a 16 bit pool is given a mesh with too many vertices
+        bool Allocate(uint32_t vertexCount, uint32_t indexCount, PooledMesh& mesh);
+
+        // copies a mesh's data into its ranges through one staging buffer and one submission,
+        // indices are narrowed for 16 bit pools
+        void Upload(VkState& vk, const PooledMesh& mesh, const void* vertices, const uint32_t* indices);
+
+        // Upload for any number of allocated meshes, still one staging buffer and one submission.
+        // indices are converted to the pool's index type while they are written to staging memory
+        void UploadBatch(VkState& vk, const Vector<PoolUpload>& uploads);
+
+        // Allocate + Upload
+        bool AddMesh(VkState& vk, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, PooledMesh& mesh);
+
+        template<typename _Ty>
+        bool AddMesh(VkState& vk, const Vector<_Ty>& vertices, const Vector<uint32_t>& indices, PooledMesh& mesh)
+        {
+            if (sizeof(_Ty) != m_VertexStride)
+            {
+                spdlog::error("GeometryPool : vertex size {} does not match the pool's stride of {}", sizeof(_Ty), m_VertexStride);
+                return false;
+            }
+            return AddMesh(vk, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()), mesh);
+        }
+
+        // the caller must make sure no frame in flight still draws the mesh
+        void FreeMesh(PooledMesh& mesh);
+
+        void Bind(VkCommandBuffer& commandBuffer);
+        static void Draw(VkCommandBuffer& commandBuffer, const PooledMesh& mesh, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+        void Free(VkState& vk);
+    };
+}
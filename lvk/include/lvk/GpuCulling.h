@@ -0,0 +1,89 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "lvk/Culling.h"
+#include "lvk/Material.h"
+#include "lvk/Shader.h"
+
+namespace lvk
+{
+    class DepthPyramid;
+
+    // Frustum culls instances in a compute pass and writes one VkDrawIndexedIndirectCommand per
+    // visible instance, so recording the scene costs a single indirect draw however many instances it has.
+    // All instances draw from the same vertex / index buffers, bound by the caller before Draw.
+    // firstInstance is the instance's index, vertex shaders read their transform with
+    // cullInstances.instances[gl_InstanceIndex] (see InsertInstanceGLSL).
+    //
+    // per frame :
+    //  SetInstances -> Dispatch (outside a render pass) -> Draw (inside it, same command buffer)
+    //
+    // with drawIndirectCount the visible commands are compacted and their count read on the gpu,
+    // otherwise every instance keeps its slot and culled ones get an instanceCount of 0.
+    //
+    // instances that need their own bindings (a material's descriptor set, a mesh's buffers) are split
+    // into draw groups : a contiguous run of instances sharing m_DrawFirst, the index of the run's first
+    // instance, drawn with DrawGroup(first, count) after binding them. the default of 0 everywhere is
+    // a single group, which is what Draw records.
+    //
+    // created with a DepthPyramid, instances that pass the frustum test are also tested against the
+    // previous frame's pyramid, using the view projection that frame was rendered with (SetOcclusionViewProj).
+    class GpuCulling
+    {
+    public:
+        // std430 mirror of CullInstance
+        struct Instance
+        {
+            glm::mat4   m_Model;
+            glm::vec4   m_BoundsCentre;     // local space, w unused
+            glm::vec4   m_BoundsExtent;     // local space half size, w unused
+            uint32_t    m_IndexCount;
+            uint32_t    m_FirstIndex;
+            int32_t     m_VertexOffset;
+            uint32_t    m_DrawFirst     = 0;    // first instance of this instance's draw group
+        };
+
+        static constexpr uint32_t k_InstancesPerWorkgroup = 64;
+
+        ShaderProgram       m_Program;
+        Material            m_Material;
+        VkPipeline          m_Pipeline          = VK_NULL_HANDLE;
+        VkPipelineLayout    m_PipelineLayout    = VK_NULL_HANDLE;
+
+        Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>       m_DrawCommandBuffers;
+        Array<VmaAllocation, MAX_FRAMES_IN_FLIGHT>  m_DrawCommandAllocations;
+        Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>       m_DrawCountBuffers;
+        Array<VmaAllocation, MAX_FRAMES_IN_FLIGHT>  m_DrawCountAllocations;
+        Array<uint32_t, MAX_FRAMES_IN_FLIGHT>       m_InstanceCounts{};
+
+        uint32_t    m_MaxInstances  = 0;
+        bool        m_UseDrawCount  = false;
+        bool        m_UseMultiDraw  = false;
+        bool        m_UseOcclusion  = false;
+        glm::vec4   m_PyramidInfo{};    // base width, base height, mip count
+
+        static GpuCulling Create(VkState& vk, uint32_t maxInstances, DepthPyramid* depthPyramid = nullptr);
+
+        // instance counts above the capacity given to Create are clamped
+        void SetInstances(VkState& vk, uint32_t frameIndex, const Instance* instances, uint32_t instanceCount);
+
+        // frustum is in the space of the instance transforms (world space for Frustum::FromViewProj(proj * view))
+        void Dispatch(VkCommandBuffer& commandBuffer, uint32_t frameIndex, const culling::Frustum& frustum);
+
+        // draws every instance as one group
+        void Draw(VkCommandBuffer& commandBuffer, uint32_t frameIndex);
+
+        // draws the group starting at firstInstance, instanceCount is the size of the group
+        void DrawGroup(VkCommandBuffer& commandBuffer, uint32_t frameIndex, uint32_t firstInstance, uint32_t instanceCount);
+
+        // viewProj is the previous frame's, the one its depth pyramid was built with. does nothing without occlusion
+        void SetOcclusionViewProj(VkState& vk, uint32_t frameIndex, const glm::mat4& viewProj);
+
+        // points a material built from a shader using InsertInstanceGLSL at this frame's instance buffer
+        bool BindInstanceBuffer(VkState& vk, Material& material);
+
+        // inserts the cullInstances declaration after the #version line of source
+        static String InsertInstanceGLSL(const String& source, uint32_t set, uint32_t binding);
+
+        void Free(VkState& vk);
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "Alias.h"
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+
+namespace lvk
+{
+    // Level of detail for indexed triangle lists.
+    //
+    //  SimplifyMesh    : quadric error edge collapse (Garland & Heckbert 1997) that only rewrites indices,
+    //                    every level keeps drawing from the mesh's original vertex buffer
+    //  BuildLodChain   : appends successively coarser levels to a mesh's index buffer, each one a range
+    //                    that can be drawn with the same vertex offset
+    //  LodSelector     : picks the coarsest level whose error covers less than a pixel budget on screen
+    //
+    // vertices sharing a position are treated as one, split normals and uv seams survive as long as
+    // the importer welded identical vertices. open borders only collapse along themselves.
+    namespace lod
+    {
+        static constexpr uint32_t k_MaxLodLevels = 5;
+
+        struct LodLevel
+        {
+            uint32_t    m_FirstIndex = 0;
+            uint32_t    m_IndexCount = 0;
+            float       m_Error = 0.0f;     // geometric deviation from LOD0, in the mesh's local units
+        };
+
+        // positions is a float3 per vertex, positionStride bytes apart. collapses stop once the output
+        // reaches targetIndexCount or the next collapse would move the surface by more than targetError.
+        // returns the largest deviation introduced, in the same units as the positions
+        float SimplifyMesh(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+            size_t vertexCount, size_t targetIndexCount, float targetError, Vector<uint32_t>& outIndices);
+
+        // indices holds LOD0 on entry and is left untouched up to its original size, each further level is
+        // appended behind it, vertex cache optimised, targeting reductionRatio of the level before.
+        // the chain ends early when a level no longer shrinks, at most maxLevels levels including
+        // LOD0, levels[0] always describes LOD0
+        void BuildLodChain(Vector<uint32_t>& indices, const float* positions, size_t positionStride, size_t vertexCount,
+            Vector<LodLevel>& levels, uint32_t maxLevels = k_MaxLodLevels, float reductionRatio = 0.5f);
+
+        // for the lvk::VertexData* types, or anything with a glm::vec3 Position member
+        template<typename _Ty>
+        void BuildLodChain(const Vector<_Ty>& vertices, Vector<uint32_t>& indices, Vector<LodLevel>& levels,
+            uint32_t maxLevels = k_MaxLodLevels, float reductionRatio = 0.5f)
+        {
+            const float* positions = reinterpret_cast<const float*>(reinterpret_cast<const char*>(vertices.data()) + offsetof(_Ty, Position));
+            BuildLodChain(indices, positions, sizeof(_Ty), vertices.size(), levels, maxLevels, reductionRatio);
+        }
+
+        struct LodSelector
+        {
+            glm::vec3   m_CameraPosition{ 0.0f };
+            float       m_ProjectionScale = 1.0f;   // pixels covered by one unit at distance one
+            float       m_MaxPixelError = 1.0f;
+
+            // fovY in radians, as given to glm::perspective
+            static LodSelector Create(const glm::vec3& cameraPosition, float fovY, float viewportHeight, float maxPixelError = 1.0f);
+
+            // localMin / localMax are the mesh's bounds before model is applied, e.g. MeshEx::m_AABB.
+            // returns an index into levels, 0 when the camera is inside the bounds
+            uint32_t Select(const Vector<LodLevel>& levels, const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& model) const;
+
+            // pixels the bounds' sphere spans across at its nearest point, FLT_MAX when the camera is inside.
+            // drives texture streaming requests (TextureStreamer::Request)
+            float ProjectedSize(const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& model) const;
+        };
+    }
+}
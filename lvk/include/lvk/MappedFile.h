@@ -0,0 +1,36 @@
+#pragma once
+#include "Alias.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace lvk
+{
+    // Read only view of a whole file through the OS's memory mapping, pages are read on first touch.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        ~MappedFile();
+
+        bool Open(const String& path);
+        void Close();
+
+        const uint8_t*  GetData() const { return m_Data; }
+        size_t          GetSize() const { return m_Size; }
+        bool            IsOpen() const { return m_Data != nullptr; }
+
+    private:
+        const uint8_t*  m_Data = nullptr;
+        size_t          m_Size = 0;
+#ifdef _WIN32
+        void*           m_FileHandle = nullptr;
+        void*           m_MappingHandle = nullptr;
+#else
+        int             m_Descriptor = -1;
+#endif
+    };
+}
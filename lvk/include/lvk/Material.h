@@ -4,6 +4,7 @@
 namespace lvk
 {
     struct ShaderProgram;
+    class UniformRing;
     class Material
     {
     public:
@@ -19,6 +20,54 @@ namespace lvk
             uint32_t m_BindingNumber;
             uint32_t m_BufferSize;
             ShaderBufferFrameData m_Buffer;
+            uint32_t m_BufferIndex;
+        };
+
+        // cpu copy of a uniform block, written by SetMember and flushed per frame.
+        // one dirty bit per 16 byte granule, tracked separately for each frame in flight
+        // so a value written once reaches every frame's buffer as that frame is flushed.
+        struct UniformShadow
+        {
+            Vector<uint8_t>                                 m_Data;
+            Array<Vector<uint64_t>, MAX_FRAMES_IN_FLIGHT>   m_DirtyGranules;
+        };
+
+        static constexpr uint32_t k_UniformGranuleSize = 16;
+
+        // dynamic uniform buffers own no memory, they are backed by a UniformRing
+        // and the offset is supplied when the descriptor set is bound.
+        struct DynamicBufferBindingData
+        {
+            uint32_t m_SetNumber;
+            uint32_t m_BindingNumber;
+            uint32_t m_BufferSize;
+        };
+
+        enum class StorageBufferMemory
+        {
+            // one persistently mapped buffer per frame in flight, written from the cpu
+            HostVisible,
+            // one device local buffer per frame in flight, written by the gpu or from the cpu
+            // through a mapped staging buffer that RecordStorageUploads copies in
+            DeviceLocal
+        };
+
+        struct StorageBufferBindingData
+        {
+            uint32_t            m_SetNumber;
+            uint32_t            m_BindingNumber;
+            uint32_t            m_FixedSize;        // bytes before the runtime array
+            uint32_t            m_ElementStride;    // runtime array stride, 0 if the block has none
+            VkDeviceSize        m_Size;
+            StorageBufferMemory m_Memory;
+            bool                m_Owned;
+            Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>       m_Buffers;
+            Array<VmaAllocation, MAX_FRAMES_IN_FLIGHT>  m_Allocations;
+            Array<void*, MAX_FRAMES_IN_FLIGHT>          m_MappedAddrs;      // host visible buffer or device local staging
+            Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>       m_StagingBuffers;
+            Array<VmaAllocation, MAX_FRAMES_IN_FLIGHT>  m_StagingAllocations;
+            Array<VkDeviceSize, MAX_FRAMES_IN_FLIGHT>   m_DirtyBegin;       // staged bytes not yet recorded, empty when begin >= end
+            Array<VkDeviceSize, MAX_FRAMES_IN_FLIGHT>   m_DirtyEnd;
         };
 
         struct SamplerBindingData
@@ -38,6 +87,17 @@ namespace lvk
             uint32_t    m_BufferIndex;
         };
 
+        // resolved once from a member name, lets hot paths skip the string lookups.
+        // only valid for the material it was resolved from.
+        struct MemberHandle
+        {
+            uint32_t    m_BufferIndex   = UINT32_MAX;
+            uint32_t    m_Offset        = 0;
+            uint32_t    m_Size          = 0;
+
+            bool IsValid() const { return m_BufferIndex != UINT32_MAX; }
+        };
+
         struct FrameDescriptorSets
         {
             Array<VkDescriptorSet, MAX_FRAMES_IN_FLIGHT> m_Sets;
@@ -55,75 +115,172 @@ namespace lvk
 
         Vector<PushConstantBlock>                       m_PushConstants;
         HashMap<uint64_t, ShaderBufferBindingData>      m_UniformBuffers;
+        HashMap<String, DynamicBufferBindingData>       m_DynamicUniformBuffers;
+        HashMap<String, StorageBufferBindingData>       m_StorageBuffers;
         HashMap<String, SamplerBindingData>             m_Samplers;
         HashMap<String, ShaderAccessorData>             m_UniformBufferAccessors;
+        Vector<Array<uint8_t*, MAX_FRAMES_IN_FLIGHT>>   m_MappedUniformBuffers;
+        Vector<UniformShadow>                           m_UniformShadows;
 
         static Material Create(VkState & vk, ShaderProgram& shader);
 
+        // writes straight into frameIndex's buffer, the other frames pick the change up on their next FlushUniforms
         template<typename _Ty>
         bool SetBuffer(uint32_t frameIndex, uint32_t set, uint32_t binding, const _Ty& value)
         {
-            Material::SetBinding sb = {};
-            sb.m_Set = set;
-            sb.m_Binding = binding;
-
-            m_UniformBuffers[sb.m_Data].m_Buffer.Set(frameIndex, value);
-
-            return true;
+            return WriteBufferRange(frameIndex, set, binding, 0, &value, sizeof(_Ty));
         }
 
         template<typename _Ty>
         bool SetBuffer(uint32_t frameIndex, uint32_t set, uint32_t binding, _Ty* start, uint32_t count)
         {
-            Material::SetBinding sb = {};
-            sb.m_Set = set;
-            sb.m_Binding = binding;
-
-            m_UniformBuffers[sb.m_Data].m_Buffer.SetMemory(frameIndex, start, count);
-
-            return true;
+            return WriteBufferRange(frameIndex, set, binding, 0, start, count);
         }
 
-
         template<typename _Ty>
         bool SetBufferArrayElement(uint32_t frameIndex, uint32_t set, uint32_t binding, uint32_t index, const _Ty& value, uint32_t innerElementOffset = 0)
         {
             // size of each element
             static constexpr size_t _type_size = sizeof(_Ty);
-            Material::SetBinding sb = {};
-            uint64_t offset = (_type_size * index) + innerElementOffset;
-            m_UniformBuffers[sb.m_Data].m_Buffer.Set(frameIndex, value, offset);
+            uint32_t offset = static_cast<uint32_t>(_type_size * index) + innerElementOffset;
+            return WriteBufferRange(frameIndex, set, binding, offset, &value, _type_size);
         }
 
-        template<typename _Ty>
-        bool SetMember(const String& name, const _Ty& value)
+        bool WriteBufferRange(uint32_t frameIndex, uint32_t set, uint32_t binding, uint32_t offset, const void* data, uint32_t size);
+
+        // typed access for blocks generated by tools/reflect-gen, _Block carries its own
+        // k_Set, k_Binding and k_Size so layout mismatches are caught at compile time.
+        template<typename _Block>
+        bool SetBlock(uint32_t frameIndex, const _Block& block)
         {
-            static constexpr size_t _type_size = sizeof(_Ty);
-            if (m_UniformBufferAccessors.find(name) == m_UniformBufferAccessors.end())
+            static_assert(!_Block::k_IsStorageBuffer, "SetBlock : _Block is a storage buffer");
+            static_assert(sizeof(_Block) == _Block::k_Size, "SetBlock : _Block does not match its reflected size");
+            return WriteBufferRange(frameIndex, _Block::k_Set, _Block::k_Binding, 0, &block, _Block::k_Size);
+        }
+
+        template<typename _Block>
+        bool SetBlock(const _Block& block)
+        {
+            _Block* shadow = GetBlockShadow<_Block>();
+            if (shadow == nullptr)
             {
                 return false;
             }
 
-            ShaderAccessorData& data = m_UniformBufferAccessors.at(name);
+            if (memcmp(shadow, &block, _Block::k_Size) != 0)
+            {
+                memcpy(shadow, &block, _Block::k_Size);
+                MarkUniformRangeDirty(FindUniformBufferIndex(_Block::k_Set, _Block::k_Binding), 0, _Block::k_Size);
+            }
+            return true;
+        }
+
+        // direct stores into the shadow copy, marks the whole block for the next FlushUniforms
+        template<typename _Block>
+        _Block* EditBlock()
+        {
+            _Block* shadow = GetBlockShadow<_Block>();
+            if (shadow != nullptr)
+            {
+                MarkUniformRangeDirty(FindUniformBufferIndex(_Block::k_Set, _Block::k_Binding), 0, _Block::k_Size);
+            }
+            return shadow;
+        }
+
+        template<typename _Block>
+        _Block* GetBlockShadow()
+        {
+            static_assert(!_Block::k_IsStorageBuffer, "GetBlockShadow : _Block is a storage buffer");
+            static_assert(sizeof(_Block) == _Block::k_Size, "GetBlockShadow : _Block does not match its reflected size");
 
-            if (_type_size != data.m_ExpectedSize)
+            uint32_t bufferIndex = FindUniformBufferIndex(_Block::k_Set, _Block::k_Binding);
+            if (bufferIndex == UINT32_MAX || m_UniformShadows[bufferIndex].m_Data.size() != _Block::k_Size)
+            {
+                return nullptr;
+            }
+            return reinterpret_cast<_Block*>(m_UniformShadows[bufferIndex].m_Data.data());
+        }
+
+        uint32_t FindUniformBufferIndex(uint32_t set, uint32_t binding) const;
+
+        MemberHandle ResolveMember(const String& name) const;
+
+        // SetMember, SetBlock(block) and EditBlock only write the cpu shadow, nothing reaches the
+        // gpu until FlushUniforms(vk.m_CurrentFrameIndex) runs for the frame being recorded.
+        template<typename _Ty>
+        bool SetMember(const String& name, const _Ty& value)
+        {
+            return SetMember(ResolveMember(name), value);
+        }
+
+        template<typename _Ty>
+        bool SetMember(const MemberHandle& handle, const _Ty& value)
+        {
+            static constexpr size_t _type_size = sizeof(_Ty);
+            if (!handle.IsValid() || _type_size != handle.m_Size)
             {
                 return false;
             }
 
-            for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+            // only touches the shadow copy, FlushUniforms uploads it
+            uint8_t* shadow = m_UniformShadows[handle.m_BufferIndex].m_Data.data() + handle.m_Offset;
+            if (memcmp(shadow, &value, _type_size) == 0)
             {
-                // update uniform buffer
-                m_UniformBuffers[data.m_BufferIndex].m_Buffer.Set(i, value, data.m_Offset);
+                return true;
             }
 
+            memcpy(shadow, &value, _type_size);
+            MarkUniformRangeDirty(handle.m_BufferIndex, handle.m_Offset, handle.m_Size);
             return true;
         }
 
+        void MarkUniformRangeDirty(uint32_t bufferIndex, uint32_t offset, uint32_t size);
+
+        // copies the dirty ranges of every uniform block into frameIndex's buffers.
+        // call once per frame after the frame fence has been waited on and before submission.
+        void FlushUniforms(uint32_t frameIndex);
+
         bool SetSampler(VkState & vk, const String& name, const VkImageView& imageView, const VkSampler& sampler, bool isAttachment = false);
         bool SetSampler(VkState & vk, const String& name, Texture& texture);
+        // only rewrites frameIndex's set, for swapping images while the other frames may still be in flight
+        bool SetSampler(VkState & vk, uint32_t frameIndex, const String& name, const VkImageView& imageView, const VkSampler& sampler);
+        // one image per frame in flight, for images written by an earlier pass each frame
+        bool SetSampler(VkState & vk, const String& name, const Array<VkImageView, MAX_FRAMES_IN_FLIGHT>& imageViews, const VkSampler& sampler, VkImageLayout imageLayout);
         bool SetColourAttachment(VkState & vk, const String& name, Framebuffer& framebuffer, uint32_t colourAttachmentIndex);
         bool SetDepthAttachment(VkState & vk, const String& name, Framebuffer& framebuffer);
+        bool SetDynamicUniformRing(VkState & vk, const String& name, UniformRing& ring);
+
+        // storage buffers with a runtime sized array are not allocated by Create, size them here.
+        // elementCount is ignored for blocks without a runtime array.
+        bool CreateStorageBuffer(VkState & vk, const String& name, uint32_t elementCount, StorageBufferMemory memory = StorageBufferMemory::HostVisible);
+
+        // bind buffers owned elsewhere (e.g. written by a compute pass), the material will not free them
+        bool SetStorageBuffer(VkState & vk, const String& name, VkBuffer buffer, VkDeviceSize size);
+        bool SetStorageBuffer(VkState & vk, const String& name, const Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>& frameBuffers, VkDeviceSize size);
+
+        // host visible buffers are written directly, device local ones are staged for frameIndex
+        // and only reach the gpu once RecordStorageUploads has run for that frame
+        bool WriteStorageBuffer(VkState & vk, uint32_t frameIndex, const String& name, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+
+        template<typename _Ty>
+        bool SetStorageBufferElements(VkState & vk, uint32_t frameIndex, const String& name, const _Ty* elements, uint32_t count, uint32_t firstElement = 0)
+        {
+            auto it = m_StorageBuffers.find(name);
+            if (it == m_StorageBuffers.end() || it->second.m_ElementStride != sizeof(_Ty))
+            {
+                return false;
+            }
+
+            const StorageBufferBindingData& ssbo = it->second;
+            VkDeviceSize offset = ssbo.m_FixedSize + VkDeviceSize{ firstElement } * ssbo.m_ElementStride;
+            return WriteStorageBuffer(vk, frameIndex, name, elements, VkDeviceSize{ count } * sizeof(_Ty), offset);
+        }
+
+        VkBuffer GetStorageBuffer(const String& name, uint32_t frameIndex) const;
+
+        // records the staged device local writes for frameIndex followed by a transfer -> shader read barrier.
+        // call it outside of a render pass, before anything in the command buffer reads the buffers.
+        void RecordStorageUploads(VkCommandBuffer commandBuffer, uint32_t frameIndex);
 
         
         void Free(VkState & vk);
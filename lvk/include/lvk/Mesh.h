@@ -158,6 +158,134 @@ namespace lvk
 
     };
 
+    // Packed counterparts of the fp32 vertex formats, converted with lvk::vertex_packing.
+    // Positions are snorm16 within the mesh's bounds and need the QuantizationParams dequantize
+    // matrix applied before the model matrix, normals are octahedral snorm16x2 (decode with
+    // vertex_packing::GetUnpackGLSL) and UVs are fp16. Attribute locations match the fp32 formats.
+    //
+    // 12 bytes, VertexDataPosUv is 20
+    struct VertexDataPackedPosUv
+    {
+        int16_t     Position[4];    // xyz snorm16, w unused
+        uint16_t    UV[2];          // fp16
+
+        static VkVertexInputBindingDescription GetBindingDescription() {
+            VkVertexInputBindingDescription bindingDescription{};
+
+            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            bindingDescription.stride = sizeof(VertexDataPackedPosUv);
+            bindingDescription.binding = 0;
+
+            return bindingDescription;
+        }
+
+        static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() {
+            std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+            attributeDescriptions.resize(2);
+
+            attributeDescriptions[0].binding = 0;
+            attributeDescriptions[0].location = 0;
+            attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+            attributeDescriptions[0].offset = offsetof(VertexDataPackedPosUv, Position);
+
+            attributeDescriptions[1].binding = 0;
+            attributeDescriptions[1].location = 1;
+            attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+            attributeDescriptions[1].offset = offsetof(VertexDataPackedPosUv, UV);
+
+            return attributeDescriptions;
+        }
+
+        static VertexDescription GetVertexDescription();
+    };
+
+    // 16 bytes, VertexDataPosColUv is 32
+    struct VertexDataPackedPosColUv
+    {
+        int16_t     Position[4];    // xyz snorm16, w unused
+        uint8_t     Colour[4];      // rgb unorm8, a unused
+        uint16_t    UV[2];          // fp16
+
+        static VkVertexInputBindingDescription GetBindingDescription() {
+            VkVertexInputBindingDescription bindingDescription{};
+
+            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            bindingDescription.stride = sizeof(VertexDataPackedPosColUv);
+            bindingDescription.binding = 0;
+
+            return bindingDescription;
+        }
+
+        static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() {
+            std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+            attributeDescriptions.resize(3);
+
+            attributeDescriptions[0].binding = 0;
+            attributeDescriptions[0].location = 0;
+            attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+            attributeDescriptions[0].offset = offsetof(VertexDataPackedPosColUv, Position);
+
+            attributeDescriptions[1].binding = 0;
+            attributeDescriptions[1].location = 1;
+            attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+            attributeDescriptions[1].offset = offsetof(VertexDataPackedPosColUv, Colour);
+
+            attributeDescriptions[2].binding = 0;
+            attributeDescriptions[2].location = 2;
+            attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+            attributeDescriptions[2].offset = offsetof(VertexDataPackedPosColUv, UV);
+
+            return attributeDescriptions;
+        }
+
+        static VertexDescription GetVertexDescription();
+    };
+
+    // 16 bytes, VertexDataPosNormalUv is 32
+    struct VertexDataPackedPosNormalUv
+    {
+        int16_t     Position[4];    // xyz snorm16, w unused
+        int16_t     Normal[2];      // octahedral snorm16
+        uint16_t    UV[2];          // fp16
+
+        static VkVertexInputBindingDescription GetBindingDescription() {
+            VkVertexInputBindingDescription bindingDescription{};
+
+            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            bindingDescription.stride = sizeof(VertexDataPackedPosNormalUv);
+            bindingDescription.binding = 0;
+
+            return bindingDescription;
+        }
+
+        static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() {
+            std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+            attributeDescriptions.resize(3);
+
+            attributeDescriptions[0].binding = 0;
+            attributeDescriptions[0].location = 0;
+            attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+            attributeDescriptions[0].offset = offsetof(VertexDataPackedPosNormalUv, Position);
+
+            attributeDescriptions[1].binding = 0;
+            attributeDescriptions[1].location = 1;
+            attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+            attributeDescriptions[1].offset = offsetof(VertexDataPackedPosNormalUv, Normal);
+
+            attributeDescriptions[2].binding = 0;
+            attributeDescriptions[2].location = 2;
+            attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+            attributeDescriptions[2].offset = offsetof(VertexDataPackedPosNormalUv, UV);
+
+            return attributeDescriptions;
+        }
+
+        static VertexDescription GetVertexDescription();
+    };
+
     class Mesh
     {
       public:
@@ -167,6 +295,7 @@ namespace lvk
         VmaAllocation m_IndexBufferMemory;
 
         uint32_t m_IndexCount = 0;
+        VkIndexType m_IndexType = VK_INDEX_TYPE_UINT32;
 
         void Free(VkState & vk);
 
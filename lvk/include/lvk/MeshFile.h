@@ -0,0 +1,117 @@
+#pragma once
+#include "Alias.h"
+#include "lvk/Lod.h"
+#include "lvk/MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace lvk
+{
+    // Cooked mesh container (.lvkm), written offline by tools/mesh-cook.
+    //
+    //  header | mesh table | lod table | material table | string table | vertex / index streams
+    //
+    // every stream is 16 byte aligned and stored exactly as the GPU reads it, interleaved vertices of one
+    // layout and 16 or 32 bit indices with the LOD chain appended, so loading is a copy from the mapping
+    // into staging memory. offsets are from the start of the file, all values little endian.
+    namespace mesh_file
+    {
+        static constexpr uint32_t k_Magic   = 0x4D4B564C;   // "LVKM"
+        static constexpr uint32_t k_Version = 1;
+        static constexpr uint64_t k_StreamAlignment = 16;
+
+        enum class VertexLayout : uint32_t
+        {
+            PosUv       = 0,    // lvk::VertexDataPosUv
+            PosNormalUv = 1     // lvk::VertexDataPosNormalUv
+        };
+
+        uint32_t GetVertexStride(VertexLayout layout);
+
+        struct Header
+        {
+            uint32_t    m_Magic;
+            uint32_t    m_Version;
+            uint32_t    m_VertexLayout;
+            uint32_t    m_VertexStride;
+            uint32_t    m_MeshCount;
+            uint32_t    m_LodCount;
+            uint32_t    m_MaterialCount;
+            uint32_t    m_StringTableSize;
+            uint64_t    m_MeshTableOffset;
+            uint64_t    m_LodTableOffset;
+            uint64_t    m_MaterialTableOffset;
+            uint64_t    m_StringTableOffset;
+        };
+        static_assert(sizeof(Header) == 64, "mesh_file::Header layout changed, bump k_Version");
+
+        struct MeshRecord
+        {
+            uint64_t    m_VertexDataOffset;
+            uint64_t    m_IndexDataOffset;
+            uint32_t    m_VertexCount;
+            uint32_t    m_IndexCount;       // every LOD level
+            uint32_t    m_IndexSize;        // 2 or 4 bytes
+            uint32_t    m_MaterialIndex;
+            uint32_t    m_FirstLod;         // into the lod table, ranges are relative to the mesh's first index
+            uint32_t    m_LodCount;
+            float       m_AABBMin[3];
+            float       m_AABBMax[3];
+        };
+        static_assert(sizeof(MeshRecord) == 64, "mesh_file::MeshRecord layout changed, bump k_Version");
+
+        struct MaterialRecord
+        {
+            uint32_t    m_DiffusePathOffset;    // into the string table, relative to the file's directory
+            uint32_t    m_DiffusePathLength;    // 0 when the material has no diffuse texture
+        };
+
+        static_assert(sizeof(lod::LodLevel) == 12, "lod::LodLevel is stored as is in the lod table");
+
+        // cpu side input of Write, indices are narrowed to 16 bits when the vertex count allows
+        struct CookedMesh
+        {
+            Vector<uint8_t>         m_Vertices;
+            Vector<uint32_t>        m_Indices;
+            Vector<lod::LodLevel>   m_Lods;
+            uint32_t                m_VertexCount = 0;
+            uint32_t                m_MaterialIndex = 0;
+            float                   m_AABBMin[3]{};
+            float                   m_AABBMax[3]{};
+        };
+
+        bool Write(const String& path, VertexLayout layout, const Vector<CookedMesh>& meshes, const Vector<String>& diffusePaths);
+    }
+
+    // a mapped .lvkm, every pointer stays valid until Close. Open checks the header and that every
+    // table and stream lies inside the file, so a truncated or stale file is rejected up front
+    class MeshFile
+    {
+    public:
+        bool Open(const String& path);
+        void Close();
+
+        const mesh_file::Header&        GetHeader() const { return *m_Header; }
+        mesh_file::VertexLayout         GetVertexLayout() const { return static_cast<mesh_file::VertexLayout>(m_Header->m_VertexLayout); }
+        uint32_t                        GetMeshCount() const { return m_Header->m_MeshCount; }
+        uint32_t                        GetMaterialCount() const { return m_Header->m_MaterialCount; }
+        const mesh_file::MeshRecord&    GetMesh(uint32_t index) const { return m_Meshes[index]; }
+
+        const void*             GetVertexData(const mesh_file::MeshRecord& mesh) const { return m_File.GetData() + mesh.m_VertexDataOffset; }
+        const void*             GetIndexData(const mesh_file::MeshRecord& mesh) const { return m_File.GetData() + mesh.m_IndexDataOffset; }
+        const lod::LodLevel*    GetLods(const mesh_file::MeshRecord& mesh) const { return m_Lods + mesh.m_FirstLod; }
+
+        // empty when the material has no diffuse texture
+        String GetDiffusePath(uint32_t materialIndex) const;
+
+    private:
+        bool Validate(const String& path) const;
+
+        MappedFile                          m_File;
+        const mesh_file::Header*            m_Header = nullptr;
+        const mesh_file::MeshRecord*        m_Meshes = nullptr;
+        const lod::LodLevel*                m_Lods = nullptr;
+        const mesh_file::MaterialRecord*    m_Materials = nullptr;
+        const char*                         m_Strings = nullptr;
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Alias.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace lvk
+{
+    // Index and vertex reordering for indexed triangle lists, run once at import.
+    //
+    //  OptimizeVertexCache : Tipsify (Sander et al. 2007), orders triangles so their vertices are
+    //                        still in the post-transform cache when reused
+    //  OptimizeOverdraw    : sorts the clusters found by OptimizeVertexCache so outward facing
+    //                        ones come first, keeping the order inside each cluster
+    //  OptimizeVertexFetch : renumbers vertices in order of first use so fetches walk memory linearly
+    //
+    // all functions are thread safe for different meshes.
+    namespace mesh_processing
+    {
+        static constexpr uint32_t k_VertexCacheSize = 16;
+
+        // clusters, when given, receives the first triangle of each run that ended on a dead end
+        void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount,
+            Vector<uint32_t>* clusters = nullptr, uint32_t cacheSize = k_VertexCacheSize);
+
+        // positions is a float3 per vertex, positionStride bytes apart
+        void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const Vector<uint32_t>& clusters,
+            const float* positions, size_t positionStride, size_t vertexCount);
+
+        // rewrites indices and fills vertexOrder with the source vertex of each output vertex.
+        // unreferenced vertices are dropped, returns the output vertex count
+        size_t OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, Vector<uint32_t>& vertexOrder);
+
+        // average cache miss ratio, transformed vertices per triangle through a FIFO cache
+        float CalculateACMR(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = k_VertexCacheSize);
+
+        // all three passes in order, vertices are left untouched, apply vertexOrder with RemapVertices
+        void OptimizeMesh(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+            size_t vertexCount, Vector<uint32_t>& vertexOrder);
+
+        template<typename _Ty>
+        void RemapVertices(Vector<_Ty>& vertices, const Vector<uint32_t>& vertexOrder)
+        {
+            Vector<_Ty> remapped(vertexOrder.size());
+            for (size_t i = 0; i < vertexOrder.size(); i++)
+            {
+                remapped[i] = vertices[vertexOrder[i]];
+            }
+            vertices.swap(remapped);
+        }
+
+        // for the lvk::VertexData* types, or anything with a glm::vec3 Position member
+        template<typename _Ty>
+        void OptimizeMesh(Vector<_Ty>& vertices, Vector<uint32_t>& indices)
+        {
+            if (vertices.empty() || indices.empty())
+            {
+                return;
+            }
+
+            Vector<uint32_t> vertexOrder;
+            const float* positions = reinterpret_cast<const float*>(reinterpret_cast<const char*>(vertices.data()) + offsetof(_Ty, Position));
+            OptimizeMesh(indices.data(), indices.size(), positions, sizeof(_Ty), vertices.size(), vertexOrder);
+            RemapVertices(vertices, vertexOrder);
+        }
+    }
+}
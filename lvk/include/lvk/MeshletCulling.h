@@ -0,0 +1,99 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "lvk/Material.h"
+#include "lvk/Meshlets.h"
+#include "lvk/Shader.h"
+
+namespace lvk
+{
+    // Culls a MeshletMesh cluster by cluster, against the frustum and against its normal cone (backfaces).
+    // Two ways to draw what is left :
+    //
+    //  mesh shaders (m_UseMeshShader) :
+    //      CreateTaskStage culls 32 meshlets per task workgroup and hands the visible ones to a mesh shader
+    //      written by the caller with InsertMeshShaderGLSL. Build the program with ShaderProgram::CreateMesh,
+    //      the pipeline with pipelines::CreateMeshPipeline and bind this mesh's buffers with BindMeshletBuffers.
+    //      per frame : SetView -> (bind pipeline, descriptor sets) -> DrawMeshTasks
+    //
+    //  compute fallback :
+    //      Dispatch writes the triangles of visible meshlets to an index buffer and fills an indexed indirect
+    //      command, Draw binds that index buffer and draws it with the caller's pipeline and vertex buffer.
+    //      per frame : SetView -> Dispatch (outside a render pass) -> Draw (inside it, same command buffer)
+    //
+    // one transform per frame. culling runs in the mesh's local space, the cone test assumes the
+    // transform has uniform scale and a perspective camera.
+    class MeshletCulling
+    {
+    public:
+        // std430 mirror of Meshlet in the GLSL
+        struct GpuMeshlet
+        {
+            glm::vec4   m_Sphere;       // centre, radius
+            glm::vec4   m_ConeApex;     // apex, cutoff
+            glm::vec4   m_ConeAxis;     // axis, w unused
+            uint32_t    m_VertexOffset;
+            uint32_t    m_TriangleOffset;
+            uint32_t    m_VertexCount;
+            uint32_t    m_TriangleCount;
+        };
+
+        // matches local_size_x of the task shader and the payload's array
+        static constexpr uint32_t k_MeshletsPerTaskWorkgroup = 32;
+
+        ShaderProgram       m_Program;
+        Material            m_Material;
+        VkPipeline          m_Pipeline          = VK_NULL_HANDLE;
+        VkPipelineLayout    m_PipelineLayout    = VK_NULL_HANDLE;
+
+        VkBuffer        m_MeshletBuffer             = VK_NULL_HANDLE;
+        VmaAllocation   m_MeshletAllocation         = VK_NULL_HANDLE;
+        VkBuffer        m_VertexMapBuffer           = VK_NULL_HANDLE;
+        VmaAllocation   m_VertexMapAllocation       = VK_NULL_HANDLE;
+        VkBuffer        m_TriangleBuffer            = VK_NULL_HANDLE;
+        VmaAllocation   m_TriangleAllocation        = VK_NULL_HANDLE;
+        VkDeviceSize    m_MeshletBufferSize         = 0;
+        VkDeviceSize    m_VertexMapSize             = 0;
+        VkDeviceSize    m_TriangleBufferSize        = 0;
+
+        Array<MappedBuffer, MAX_FRAMES_IN_FLIGHT>   m_ViewBuffers{};
+
+        // compute fallback only
+        Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>       m_IndexBuffers{};
+        Array<VmaAllocation, MAX_FRAMES_IN_FLIGHT>  m_IndexAllocations{};
+        Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>       m_DrawCommandBuffers{};
+        Array<VmaAllocation, MAX_FRAMES_IN_FLIGHT>  m_DrawCommandAllocations{};
+
+        uint32_t    m_MeshletCount      = 0;
+        uint32_t    m_TriangleCount     = 0;
+        int32_t     m_VertexOffset      = 0;
+        bool        m_UseMeshShader     = false;
+
+        // vertexOffset is added to every expanded index, for meshes living in a GeometryPool.
+        // the mesh shader path is taken when the device supports it, unless allowMeshShader is false
+        static MeshletCulling Create(VkState& vk, const meshlets::MeshletMesh& mesh, int32_t vertexOffset = 0, bool allowMeshShader = true);
+
+        // viewProj * model is culled against, cameraPosition is in world space
+        void SetView(uint32_t frameIndex, const glm::mat4& viewProj, const glm::mat4& model, const glm::vec3& cameraPosition);
+
+        // compute fallback
+        void Dispatch(VkCommandBuffer& commandBuffer, uint32_t frameIndex);
+        void Draw(VkCommandBuffer& commandBuffer, uint32_t frameIndex);
+
+        // mesh shader path
+        void DrawMeshTasks(VkCommandBuffer& commandBuffer);
+
+        // points a material built from InsertMeshShaderGLSL / CreateTaskStage at this mesh's buffers
+        bool BindMeshletBuffers(VkState& vk, Material& material);
+
+        // the culling task shader, its buffers use bindings [firstBinding, firstBinding + 4) of set
+        static ShaderStage CreateTaskStage(VkState& vk, uint32_t set = 0, uint32_t firstBinding = 0);
+
+        // inserts the meshlet buffers, the task payload and the GL_EXT_mesh_shader extension after the
+        // #version line of a mesh shader. the shader reads its meshlet with
+        //   meshletData.meshlets[meshletPayload.meshletIndices[gl_WorkGroupID.x]]
+        // and Meshlet_GetVertex / Meshlet_GetTriangle, see MeshletCulling.cpp for the declarations
+        static String InsertMeshShaderGLSL(const String& source, uint32_t set = 0, uint32_t firstBinding = 0);
+
+        void Free(VkState& vk);
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "Alias.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace lvk
+{
+    // Splits an indexed triangle list into small clusters (meshlets) that can be culled and drawn on their own,
+    // either by a task / mesh shader pair or by MeshletCulling's compute expansion into an index buffer.
+    // the builder grows each meshlet from triangles sharing its vertices, so running
+    // mesh_processing::OptimizeVertexCache on the indices first gives tighter clusters.
+    namespace meshlets
+    {
+        // the limits most hardware favours for mesh shader outputs, 124 keeps the triangle bytes in 4 byte words
+        static constexpr uint32_t k_MaxVertices     = 64;
+        static constexpr uint32_t k_MaxTriangles    = 124;
+
+        struct Meshlet
+        {
+            uint32_t    m_VertexOffset;     // first entry in MeshletMesh::m_Vertices
+            uint32_t    m_TriangleOffset;   // first byte in MeshletMesh::m_Triangles
+            uint32_t    m_VertexCount;
+            uint32_t    m_TriangleCount;
+        };
+
+        // bounding sphere and normal cone, in the mesh's local space.
+        // every triangle faces away from a camera at p when dot(normalize(m_ConeApex - p), m_ConeAxis) >= m_ConeCutoff,
+        // m_ConeCutoff is above 1 when the normals spread too far for the test to ever pass.
+        struct MeshletBounds
+        {
+            glm::vec3   m_Centre{ 0.0f };
+            float       m_Radius = 0.0f;
+            glm::vec3   m_ConeApex{ 0.0f };
+            glm::vec3   m_ConeAxis{ 0.0f };
+            float       m_ConeCutoff = 2.0f;
+        };
+
+        struct MeshletMesh
+        {
+            Vector<Meshlet>         m_Meshlets;
+            Vector<MeshletBounds>   m_Bounds;
+            Vector<uint32_t>        m_Vertices;     // meshlet local vertex -> mesh vertex
+            Vector<uint8_t>         m_Triangles;    // 3 meshlet local vertices per triangle, padded to a multiple of 4 bytes
+
+            uint32_t GetTriangleCount() const;
+        };
+
+        // positions is a float3 per vertex, positionStride bytes apart.
+        // maxVertices is capped at 256 so local indices fit a byte, returns false on invalid input
+        bool BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+            size_t vertexCount, MeshletMesh& mesh, uint32_t maxVertices = k_MaxVertices, uint32_t maxTriangles = k_MaxTriangles);
+
+        // for the lvk::VertexData* types, or anything with a glm::vec3 Position member
+        template<typename _Ty>
+        bool BuildMeshlets(const Vector<_Ty>& vertices, const Vector<uint32_t>& indices, MeshletMesh& mesh,
+            uint32_t maxVertices = k_MaxVertices, uint32_t maxTriangles = k_MaxTriangles)
+        {
+            const float* positions = reinterpret_cast<const float*>(reinterpret_cast<const char*>(vertices.data()) + offsetof(_Ty, Position));
+            return BuildMeshlets(indices.data(), indices.size(), positions, sizeof(_Ty), vertices.size(), mesh, maxVertices, maxTriangles);
+        }
+    }
+}
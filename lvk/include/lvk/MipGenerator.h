@@ -0,0 +1,83 @@
+#pragma once
+#include "lvk/Shader.h"
+
+namespace lvk
+{
+    // Builds mip chains with compute instead of vkCmdBlitImage, for formats that cannot be blitted with a
+    // linear filter and for render targets (bloom, SSR, HZB inputs) whose chain is rebuilt every frame.
+    //
+    // Each dispatch reads one level and writes up to k_MipsPerDispatch levels below it : every thread of a
+    // 16x16 workgroup produces one texel of the first level from the source's exact footprint, the levels
+    // after it are halved in shared memory. An odd sized level cannot be halved inside a tile, so the chain
+    // starts a new dispatch there, power of two images take one dispatch per four levels.
+    //
+    // the image needs VK_IMAGE_USAGE_STORAGE_BIT. sRGB formats are written through their UNORM alias, so
+    // they also need VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT, and are filtered in linear light
+    class MipGenerator
+    {
+    public:
+        static constexpr uint32_t k_MipsPerDispatch = 4;
+        static constexpr uint32_t k_TileSize = 16;          // first level texels per workgroup side
+        static constexpr uint32_t k_MaxChainSets = 256;     // descriptor sets the generator's pool holds
+
+        enum Flags : uint32_t
+        {
+            None        = 0,
+            Srgb        = 1 << 0,   // texels are sRGB encoded whatever the format says, filter in linear light
+            NormalMap   = 1 << 1,   // xyz is a unit vector, renormalised after filtering. UNORM formats store it * 0.5 + 0.5
+        };
+
+        struct Dispatch
+        {
+            uint32_t        m_SourceMip;
+            uint32_t        m_MipCount;     // levels written, m_SourceMip + 1 onwards
+            VkDescriptorSet m_DescriptorSet;
+        };
+
+        // an image's chain bound to the generator, create once per image and record whenever level 0 changes
+        struct Chain
+        {
+            VkImage             m_Image = VK_NULL_HANDLE;
+            VkExtent2D          m_Extent{};
+            uint32_t            m_MipCount = 0;
+            uint32_t            m_Flags = None;
+            VkFormat            m_StorageFormat = VK_FORMAT_UNDEFINED;
+            Vector<VkImageView> m_MipViews;
+            Vector<Dispatch>    m_Dispatches;
+        };
+
+        VkDescriptorPool    m_DescriptorPool = VK_NULL_HANDLE;
+
+        static MipGenerator Create(VkState& vk);
+
+        // created on first use and freed by init::CleanupVulkan, backs the GenerateMips fallback
+        static MipGenerator& Default(VkState& vk);
+        static void FreeDefault(VkState& vk);
+
+        // format, or its UNORM alias for sRGB formats, has a GLSL storage qualifier and VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT
+        static bool Supports(VkState& vk, VkFormat format);
+        // the format the levels are written as, format itself unless it is sRGB
+        static VkFormat GetStorageFormat(VkFormat format);
+
+        // extent and mipCount describe the image's single layer, flags is a combination of Flags
+        bool CreateChain(VkState& vk, VkImage image, VkFormat format, VkExtent2D extent, uint32_t mipCount, uint32_t flags, Chain& chain);
+        void FreeChain(VkState& vk, Chain& chain);
+
+        // level 0 is in oldLayout and written, the other levels' contents are discarded. every level is in
+        // newLayout on exit, visible to fragment and compute shader reads
+        void Record(VkCommandBuffer commandBuffer, const Chain& chain, VkImageLayout oldLayout, VkImageLayout newLayout) const;
+
+        void Free(VkState& vk);
+
+    private:
+        struct Pipeline
+        {
+            ShaderProgram       m_Program;
+            VkPipeline          m_Pipeline = VK_NULL_HANDLE;
+            VkPipelineLayout    m_PipelineLayout = VK_NULL_HANDLE;
+        };
+
+        // GLSL needs the storage format in the shader, one pipeline per format used
+        HashMap<VkFormat, Pipeline> m_Pipelines;
+    };
+}
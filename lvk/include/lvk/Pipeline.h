@@ -24,6 +24,18 @@ namespace pipelines{
         VkPipelineLayout& pipelineLayout,
         uint32_t colorAttachmentCount = 1);
 
+    // task / mesh / fragment program from ShaderProgram::CreateMesh, returns VK_NULL_HANDLE
+    // when the device has no mesh shader support (VkState::m_DeviceFeatures.m_MeshShader)
+    VkPipeline                          CreateMeshPipeline(
+        VkState& vk,
+        ShaderProgram& shader,
+        RasterizationState & rasterState,
+        RasterPipelineState& pipelineState,
+        VkRenderPass& pipelineRenderPass,
+        VkExtent2D resolution,
+        VkPipelineLayout& pipelineLayout,
+        uint32_t colorAttachmentCount = 1);
+
     struct VkPipelineData
     {
         VkPipelineData(VkPipeline pipeline, VkPipelineLayout layout)
@@ -0,0 +1,39 @@
+#pragma once
+#include "Alias.h"
+#include "vulkan/vulkan.h"
+#include <mutex>
+
+namespace lvk
+{
+    // Shares VkSampler objects between everything created with the same VkSamplerCreateInfo. most
+    // textures and attachments sample identically, and drivers cap the live sampler count
+    // (maxSamplerAllocationCount, often 4000), so each distinct description is created once and ref counted.
+    // create infos with a pNext chain are not compared and always get a sampler of their own
+    class SamplerCache
+    {
+    public:
+        // a sampler matching info, created on first use. pair every Acquire with a Release
+        VkSampler Acquire(VkDevice device, const VkSamplerCreateInfo& info);
+        // destroys the sampler once nothing holds it anymore
+        void Release(VkDevice device, VkSampler sampler);
+        // destroys every sampler, whether released or not
+        void Free(VkDevice device);
+
+        uint32_t GetSamplerCount() const;
+
+    private:
+        struct Entry
+        {
+            VkSamplerCreateInfo m_Info;
+            VkSampler           m_Sampler;
+            uint32_t            m_RefCount;
+        };
+
+        static size_t Hash(const VkSamplerCreateInfo& info);
+        static bool Equal(const VkSamplerCreateInfo& a, const VkSamplerCreateInfo& b);
+
+        mutable std::mutex                  m_Mutex;
+        HashMap<size_t, Vector<Entry>>      m_Buckets;          // by Hash(info), collisions share a bucket
+        HashMap<VkSampler, size_t>          m_SamplerHashes;    // cached samplers only
+    };
+}
@@ -18,6 +18,11 @@ namespace lvk
         Vector<DescriptorSetLayoutData> m_LayoutDatas;
         ShaderStageType m_Type;
 
+        // GLSL has no notion of dynamic uniform buffers, so flag a reflected uniform block as
+        // VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC before building the ShaderProgram.
+        // must be called on every stage that references the block.
+        bool SetDynamicUniformBuffer(const String& bindingName);
+
         static ShaderStage CreateFromBinary(VkState & vk, Vector<unsigned char>& binary, const ShaderStageType& type)
         {
             auto stageLayoutDatas = descriptor::ReflectDescriptorSetLayouts(vk, binary);
@@ -89,6 +94,9 @@ namespace lvk
 
         static ShaderProgram CreateCompute(VkState & vk, ShaderStage& compute);
 
+        // VK_EXT_mesh_shader program, build its pipeline with pipelines::CreateMeshPipeline
+        static ShaderProgram CreateMesh(VkState & vk, ShaderStage& task, ShaderStage& mesh, ShaderStage& frag);
+
         static ShaderProgram CreateComputeFromBinaryPath(VkState& vk, const String& comp_path)
         {
             ShaderStage comp = ShaderStage::CreateFromBinaryPath(vk, comp_path, ShaderStageType::Compute);
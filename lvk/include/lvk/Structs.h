@@ -5,6 +5,7 @@
 #include "ThirdParty/VulkanMemoryAllocator.h"
 #include "Alias.h"
 #include "lvk/DescriptorSetAllocator.h"
+#include "lvk/SamplerCache.h"
 
 
 namespace lvk {
@@ -13,7 +14,9 @@ namespace lvk {
 
   enum class ShaderBindingType {
     UniformBuffer,
+    DynamicUniformBuffer,
     ShaderStorageBuffer,
+    StorageImage,
     PushConstants,
     Sampler
   };
@@ -59,6 +62,8 @@ namespace lvk {
     uint32_t m_ExpectedBufferSize;
     ShaderBindingType m_BufferType;
     Vector<ShaderBufferMember> m_Members;
+    // storage buffers only, stride of a trailing runtime sized array, 0 if there is none
+    uint32_t m_RuntimeArrayStride;
   };
 
   struct DescriptorSetLayoutData {
@@ -118,7 +123,7 @@ namespace lvk {
   };
 
 
-  enum class ShaderStageType { Vertex, Fragment, Compute };
+  enum class ShaderStageType { Vertex, Fragment, Compute, Task, Mesh };
 
   enum QueueFamilyType {
     GraphicsAndCompute = VK_QUEUE_GRAPHICS_BIT,
@@ -133,6 +138,18 @@ namespace lvk {
     bool IsComplete();
   };
 
+  // optional device features, filled in by init::CreateLogicalDevice and enabled when supported
+  struct DeviceFeatureSupport {
+    bool m_DrawIndirectCount          = false;
+    bool m_MultiDrawIndirect          = false;
+    bool m_DrawIndirectFirstInstance  = false;
+    // VK_EXT_mesh_shader with task and mesh shaders
+    bool m_MeshShader                 = false;
+    // block compressed formats that can be sampled, BC1-7 on desktop and ASTC LDR on mobile
+    bool m_TextureCompressionBC       = false;
+    bool m_TextureCompressionASTC     = false;
+  };
+
   struct SwapChainSupportDetais {
     VkSurfaceCapabilitiesKHR    m_Capabilities;
     Vector<VkSurfaceFormatKHR>  m_SupportedFormats;
@@ -173,6 +190,7 @@ namespace lvk {
     VkCommandPool                   m_GraphicsComputeQueueCommandPool;
     VmaAllocator                    m_Allocator;
     DescriptorSetAllocator          m_DescriptorSetAllocator;
+    SamplerCache                    m_SamplerCache;
 
     Vector<VkSemaphore>             m_ImageAvailableSemaphores;
     Vector<VkSemaphore>             m_RenderFinishedSemaphores;
@@ -181,6 +199,7 @@ namespace lvk {
     Vector<VkFence>                 m_ImagesInFlightFences;
     Vector<VkFence>                 m_ComputeInFlightFences;
     QueueFamilyIndices              m_QueueFamilyIndices;
+    DeviceFeatureSupport            m_DeviceFeatures;
 
     VkQueue                         m_GraphicsQueue = VK_NULL_HANDLE;
     VkQueue                         m_ComputeQueue = VK_NULL_HANDLE;
@@ -5,6 +5,9 @@
 namespace lvk {
 namespace submission
 {
+  // blocks until the last submission of vk.m_CurrentFrameIndex has retired, that frame's buffers and
+  // descriptor sets can be rewritten after it. SubmitFrame waits on the same fence before submitting
+  void                                WaitForFrame(VkState& vk);
   void                                SubmitFrame(VkState& vk);
   void                                RenderImGui(VkState& vk);
 
@@ -6,14 +6,52 @@
 namespace lvk
 {
     namespace textures {
-    void  CreateImage(VkState& vk, uint32_t width, uint32_t height, uint32_t numMips, VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t depth = 1);
-    void  CreateImageView(VkState& vk, VkImage& image, VkFormat format, uint32_t numMips, VkImageAspectFlags aspectFlags, VkImageView& imageView, VkImageViewType imageViewType= VK_IMAGE_VIEW_TYPE_2D);
+    // depth > 1 creates a 3D image, arrayLayers > 1 a layered 2D one
+    void  CreateImage(VkState& vk, uint32_t width, uint32_t height, uint32_t numMips, VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t depth = 1, uint32_t arrayLayers = 1, VkImageCreateFlags flags = 0);
+    void  CreateImageView(VkState& vk, VkImage& image, VkFormat format, uint32_t numMips, VkImageAspectFlags aspectFlags, VkImageView& imageView, VkImageViewType imageViewType= VK_IMAGE_VIEW_TYPE_2D, uint32_t layerCount = 1);
+    // samplers come from vk.m_SamplerCache and are shared by identical descriptions, release them with
+    // FreeImageSampler rather than vkDestroySampler
     void  CreateImageSampler(VkState& vk, VkImageView& imageView, uint32_t numMips, VkFilter filterMode, VkSamplerAddressMode addressMode, VkSampler& sampler);
+    void  FreeImageSampler(VkState& vk, VkSampler sampler);
     void  CreateFramebuffer(VkState& vk, Vector<VkImageView>& attachments, VkRenderPass renderPass, VkExtent2D extent, VkFramebuffer& framebuffer);
     void  CreateTexture(VkState& vk, const String& path, VkFormat format, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips = nullptr);
+    // rgba8 pixels decoded from an image file by stb_image. decoding touches no shared state, so worker
+    // threads can decode while the loading thread uploads, release with FreeDecodedImage
+    struct DecodedImage
+    {
+        unsigned char*  m_Pixels = nullptr;
+        uint32_t        m_Width = 0;
+        uint32_t        m_Height = 0;
+    };
+    bool  DecodeImage(const String& path, DecodedImage& image);
+    void  FreeDecodedImage(DecodedImage& image);
+    void  CreateTextureFromPixels(VkState& vk, const unsigned char* pixels, uint32_t width, uint32_t height, VkFormat format, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips = nullptr);
     void  CreateTextureFromMemory(VkState& vk, unsigned char* tex_data, uint32_t dataSize, VkFormat format, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips = nullptr);
+    // tex_data decodes to the extent.depth slices stacked vertically, i.e. extent.width x (extent.height * extent.depth)
     void  CreateTexture3DFromMemory(VkState& vk, unsigned char* tex_data, VkExtent3D extent, uint32_t dataSize, VkFormat format, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips = nullptr);
     void  CopyBufferToImage(VkState& vk, VkBuffer& src, VkImage& image,  uint32_t width, uint32_t height);
+
+    // one image to fill from a staging buffer, level 0 of every layer tightly packed from m_StagingOffset
+    struct ImageUpload
+    {
+        VkImage         m_Image = VK_NULL_HANDLE;
+        VkExtent3D      m_Extent = { 1, 1, 1 };     // depth > 1 for 3D images
+        uint32_t        m_LayerCount = 1;
+        uint32_t        m_MipCount = 1;
+        VkBuffer        m_Staging = VK_NULL_HANDLE;
+        VkDeviceSize    m_StagingOffset = 0;
+    };
+    bool  SupportsLinearBlit(VkState& vk, VkFormat format);
+    uint32_t GetMipCount(VkExtent3D extent);
+    // records everything that takes the images from UNDEFINED to sampleable : level 0 copies, the blit
+    // mip chains and their layout transitions, batched so each step is one barrier across all images.
+    // every level of every image is SHADER_READ_ONLY_OPTIMAL afterwards
+    void  RecordImageUploads(VkCommandBuffer cmd, const Vector<ImageUpload>& uploads, VkFilter mipFilter = VK_FILTER_LINEAR);
+    // every level in TRANSFER_DST_OPTIMAL with level 0 written on entry, SHADER_READ_ONLY_OPTIMAL on exit.
+    // the m_Staging fields are unused
+    void  RecordGenerateMips(VkCommandBuffer cmd, const Vector<ImageUpload>& images, VkFilter filterMethod);
+    // RecordGenerateMips in its own submission for a single 2D image. formats without linear blit support
+    // fall back to MipGenerator::Default, the image then needs VK_IMAGE_USAGE_STORAGE_BIT
     void  GenerateMips(VkState& vk, VkImage image, VkFormat format, uint32_t imageWidth, uint32_t imageHeight, uint32_t numMips, VkFilter filterMethod);
     void  TransitionImageLayout(VkState& vk, VkImage image, VkFormat format, uint32_t numMips, VkImageLayout oldLayout, VkImageLayout newLayout);
     }
@@ -116,6 +154,26 @@ namespace lvk
             return Texture(image, imageView, memory, sampler, format, VK_SAMPLE_COUNT_1_BIT, imguiTextureHandle);
         }
 
+        // pixels is width * height rgba8, e.g. a textures::DecodedImage
+        static Texture CreateTextureFromPixels(lvk::VkState & vk, const unsigned char* pixels, uint32_t width, uint32_t height, VkFormat format, VkFilter samplerFilter = VK_FILTER_LINEAR, VkSamplerAddressMode samplerAddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT)
+        {
+            VkImage image;
+            VkImageView imageView;
+            VkDeviceMemory memory;
+            uint32_t mipLevels;
+            lvk::textures::CreateTextureFromPixels(vk, pixels, width, height, format, image, imageView, memory, &mipLevels);
+            VkSampler sampler;
+            textures::CreateImageSampler(vk, imageView, mipLevels, samplerFilter, samplerAddressMode, sampler);
+
+            VkDescriptorSet imguiTextureHandle = VK_NULL_HANDLE;
+            if (vk.m_UseImGui)
+            {
+                imguiTextureHandle = ImGui_ImplVulkan_AddTexture(sampler, imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
+
+            return Texture(image, imageView, memory, sampler, format, VK_SAMPLE_COUNT_1_BIT, imguiTextureHandle);
+        }
+
         static Texture CreateTextureFromMemory(lvk::VkState & vk, unsigned char* tex_data, uint32_t length, VkFormat format, VkFilter samplerFilter = VK_FILTER_LINEAR, VkSamplerAddressMode samplerAddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT)
         {
             VkImage image;
@@ -0,0 +1,95 @@
+#pragma once
+#include "Alias.h"
+#include "lvk/MappedFile.h"
+#include "lvk/Texture.h"
+#include "volk.h"
+#include <cstdint>
+
+namespace lvk
+{
+    // Pre-built texture containers, KTX2 and DDS, holding block compressed (BC1-7, ASTC) or plain
+    // rgba8 images together with their whole mip chain. levels are uploaded exactly as stored, so there
+    // is no decode and no runtime mip generation, and BC / ASTC stay 4-8x smaller in GPU memory.
+    //
+    // only single 2D images are read, arrays, cube maps and volumes are rejected, as are supercompressed
+    // (zstd / basis) KTX2 files which would need transcoding first
+    namespace texture_file
+    {
+        enum class Container
+        {
+            Unknown,
+            Ktx2,
+            Dds
+        };
+
+        // texel block dimensions and size, 1x1 for uncompressed formats
+        struct FormatInfo
+        {
+            uint32_t    m_BlockWidth = 1;
+            uint32_t    m_BlockHeight = 1;
+            uint32_t    m_BlockBytes = 0;
+        };
+
+        // false for formats the loader does not know
+        bool GetFormatInfo(VkFormat format, FormatInfo& info);
+
+        bool IsAstc(VkFormat format);
+
+        // bytes of one level of the given size, 0 for unknown formats
+        uint64_t GetLevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+        Container DetectContainer(const uint8_t* data, size_t size);
+
+        struct MipLevel
+        {
+            uint64_t    m_Offset;       // from the start of the file
+            uint64_t    m_Size;
+            uint32_t    m_Width;
+            uint32_t    m_Height;
+        };
+    }
+
+    // a mapped .ktx2 / .dds, level data points into the mapping and stays valid until Close
+    class TextureFile
+    {
+    public:
+        bool Open(const String& path);
+        void Close();
+
+        // the device has the compression feature for the format and can sample it with optimal tiling
+        bool IsSupported(VkState& vk) const;
+
+        bool IsOpen() const { return m_File.IsOpen(); }
+
+        VkFormat                            GetFormat() const { return m_Format; }
+        uint32_t                            GetWidth() const { return m_Width; }
+        uint32_t                            GetHeight() const { return m_Height; }
+        uint32_t                            GetMipCount() const { return static_cast<uint32_t>(m_Mips.size()); }
+        const texture_file::MipLevel&       GetMip(uint32_t level) const { return m_Mips[level]; }
+        const uint8_t*                      GetMipData(uint32_t level) const { return m_File.GetData() + m_Mips[level].m_Offset; }
+
+    private:
+        bool ParseKtx2(const String& path);
+        bool ParseDds(const String& path);
+        bool ValidateMips(const String& path);
+
+        MappedFile                      m_File;
+        VkFormat                        m_Format = VK_FORMAT_UNDEFINED;
+        uint32_t                        m_Width = 0;
+        uint32_t                        m_Height = 0;
+        Vector<texture_file::MipLevel>  m_Mips;
+    };
+
+    namespace textures
+    {
+        // copies every level of file into a new image with one multi region vkCmdCopyBufferToImage,
+        // returns false when the device cannot sample the file's format
+        bool CreateTextureFromFile(VkState& vk, const TextureFile& file, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips = nullptr);
+
+        // CreateTextureFromFile with a sampler over the stored mips, empty when the format is unsupported
+        Optional<Texture> LoadTextureFile(VkState& vk, const TextureFile& file, VkFilter samplerFilter = VK_FILTER_LINEAR, VkSamplerAddressMode samplerAddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+
+        // also empty when the file is missing or malformed, so the caller can fall back to the source image
+        Optional<Texture> LoadTextureFile(VkState& vk, const String& path, VkFilter samplerFilter = VK_FILTER_LINEAR, VkSamplerAddressMode samplerAddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "lvk/Texture.h"
+#include <mutex>
+
+namespace lvk
+{
+    // Uploads any number of rgba8 textures through one staging buffer and one submission, every copy,
+    // mip chain blit and layout transition is recorded into a single command buffer.
+    // Add can be called from several threads at once, so decode tasks hand their pixels over as soon
+    // as they finish and free them straight away instead of holding every decoded image until upload.
+    class TextureUploadBatch
+    {
+    public:
+        // pixels are width * height rgba8 and are copied, format must have 4 byte texels, e.g.
+        // VK_FORMAT_R8G8B8A8_UNORM or _SRGB. returns the texture's index in Upload's output
+        uint32_t Add(const unsigned char* pixels, uint32_t width, uint32_t height, VkFormat format, bool generateMips = true);
+        // layerCount layers of extent, each tightly packed after the last. extent.depth > 1 makes a 3D
+        // image, layerCount > 1 a 2D array, the view type follows
+        uint32_t Add(const unsigned char* pixels, VkExtent3D extent, uint32_t layerCount, VkFormat format, bool generateMips = true);
+
+        // creates every image with a view and a sampler, appends them to textures in index order
+        // and empties the batch
+        void Upload(VkState& vk, Vector<Texture>& textures, VkFilter samplerFilter = VK_FILTER_LINEAR, VkSamplerAddressMode samplerAddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+
+    private:
+        struct Entry
+        {
+            VkDeviceSize    m_Offset;
+            VkExtent3D      m_Extent;
+            uint32_t        m_LayerCount;
+            VkFormat        m_Format;
+            bool            m_GenerateMips;
+        };
+
+        Vector<Entry>   m_Entries;
+        Vector<uint8_t> m_Pixels;
+        std::mutex      m_Mutex;
+    };
+
+    namespace textures
+    {
+        // decodes every file concurrently on ThreadPool::Default, streaming the pixels into one
+        // TextureUploadBatch, so the cost is roughly the decode time over the core count plus one upload.
+        // appends one texture per path, files that fail to decode get a copy of Texture::g_DefaultTexture
+        // which must not be freed through it
+        void LoadTextures(VkState& vk, const Vector<String>& paths, VkFormat format, Vector<Texture>& textures, VkFilter samplerFilter = VK_FILTER_LINEAR, VkSamplerAddressMode samplerAddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "lvk/TextureFile.h"
+#include <functional>
+#include <future>
+
+namespace lvk
+{
+    // Mip level residency for pre-built textures (TextureFile, e.g. lvk-texture-cook's .ktx2 output).
+    // Add only uploads the mip tail, so a scene can be drawn as soon as its textures are added, and each
+    // Update then streams higher levels in, the largest shortfall against what was requested first, and
+    // evicts levels nothing asked for when resident memory would go over budget.
+    //
+    // a texture's image only ever holds its resident levels. moving the top level creates a new image,
+    // copies the levels both share image to image and any new ones from a staging buffer, then swaps the
+    // texture's image and view and reports it through the ViewChangedFn, the old image is destroyed
+    // MAX_FRAMES_IN_FLIGHT updates later. the staging copy out of the mapped file, i.e. the disk reads,
+    // runs on ThreadPool::Default and the copies are submitted with a fence that Update polls, so no
+    // frame waits on a transfer. there is no dedicated transfer queue, transfers go to the graphics queue
+    class TextureStreamer
+    {
+    public:
+        struct Config
+        {
+            VkDeviceSize    m_MemoryBudget          = 256ull << 20;     // bytes of resident levels, all textures
+            VkDeviceSize    m_UploadBytesPerUpdate  = 16ull << 20;      // new level data started per Update
+            uint32_t        m_TailSize              = 128;              // levels this size and smaller stay resident
+        };
+
+        // called from Update once a texture's image and view were replaced, rebind texture wherever it is
+        // sampled. streamed textures have no ImGui handle, their view changes
+        using ViewChangedFn = std::function<void(uint32_t handle, const Texture& texture)>;
+
+        static constexpr uint32_t k_InvalidHandle = UINT32_MAX;
+
+        void Init(const Config& config, ViewChangedFn onViewChanged);
+
+        // opens path and creates the texture with its tail levels, which are uploaded by the next Update.
+        // returns k_InvalidHandle when the file cannot be opened or the device cannot sample its format
+        uint32_t Add(VkState& vk, const String& path, VkFilter samplerFilter = VK_FILTER_LINEAR, VkSamplerAddressMode samplerAddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+        // takes over an already open file, which stays open for as long as the texture streams
+        uint32_t Add(VkState& vk, TextureFile&& file, VkFilter samplerFilter = VK_FILTER_LINEAR, VkSamplerAddressMode samplerAddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+
+        // asks for enough resolution to cover pixels screen pixels along the texture's larger side, e.g.
+        // lod::LodSelector::ProjectedSize of the object scaled by how often its uvs repeat. requests last
+        // one Update and the largest one wins, textures without a request may be evicted down to the tail
+        void Request(uint32_t handle, float pixels);
+
+        // once per frame, before recording commands that sample streamed textures
+        void Update(VkState& vk);
+
+        // image and view are valid until the next ViewChangedFn call for handle
+        const Texture&  GetTexture(uint32_t handle) const { return m_Textures[handle].m_Texture; }
+        // file level held in image level 0
+        uint32_t        GetResidentMip(uint32_t handle) const { return m_Textures[handle].m_ResidentMip; }
+        VkDeviceSize    GetResidentBytes() const { return m_ResidentBytes; }
+        uint32_t        GetTextureCount() const { return static_cast<uint32_t>(m_Textures.size()); }
+
+        // waits for in flight transfers and destroys every texture
+        void Free(VkState& vk);
+
+    private:
+        struct StreamedTexture
+        {
+            TextureFile     m_File;
+            Texture         m_Texture;
+            uint32_t        m_ResidentMip = 0;
+            uint32_t        m_TailMip = 0;
+            uint32_t        m_RequestedMip = 0;
+            float           m_RequestedPixels = 0.0f;
+            uint64_t        m_LastRequest = 0;          // update index
+            bool            m_Busy = false;             // a residency change is in flight
+        };
+
+        // one residency change, from the texture's current image to m_NewImage holding m_NewMip and below
+        struct Transfer
+        {
+            uint32_t                    m_Handle = 0;
+            uint32_t                    m_NewMip = 0;
+            VkImage                     m_NewImage = VK_NULL_HANDLE;
+            VkImageView                 m_NewImageView = VK_NULL_HANDLE;
+            VkDeviceMemory              m_NewMemory = VK_NULL_HANDLE;
+            VkBuffer                    m_Staging = VK_NULL_HANDLE;
+            VmaAllocation               m_StagingMemory = VK_NULL_HANDLE;
+            Vector<VkBufferImageCopy>   m_Regions;
+            std::future<void>           m_Fill;         // staging writes, valid while they run
+            VkCommandBuffer             m_CommandBuffer = VK_NULL_HANDLE;
+            VkFence                     m_Fence = VK_NULL_HANDLE;
+        };
+
+        struct RetiredImage
+        {
+            VkImage         m_Image;
+            VkImageView     m_ImageView;
+            VkDeviceMemory  m_Memory;
+            uint64_t        m_RetiredAt;                // update index
+        };
+
+        VkDeviceSize GetLevelBytes(const StreamedTexture& texture, uint32_t firstMip, uint32_t endMip) const;
+        void CreateLevels(VkState& vk, const StreamedTexture& texture, uint32_t topMip, Transfer& transfer);
+        void BeginTransfer(VkState& vk, uint32_t handle, uint32_t newMip);
+        void SubmitTransfer(VkState& vk, Transfer& transfer);
+        void CompleteTransfer(VkState& vk, Transfer& transfer);
+        void FlushTails(VkState& vk);
+        void ReleaseRetired(VkState& vk, bool all);
+        bool Evict(VkState& vk, VkDeviceSize bytesNeeded);
+        void StartUploads(VkState& vk);
+
+        Config                  m_Config;
+        ViewChangedFn           m_OnViewChanged;
+        Vector<StreamedTexture> m_Textures;
+        Vector<Transfer>        m_Transfers;
+        Vector<Transfer>        m_TailTransfers;        // recorded and waited on together by FlushTails
+        Vector<RetiredImage>    m_Retired;
+        VkDeviceSize            m_ResidentBytes = 0;
+        uint64_t                m_UpdateIndex = 0;
+    };
+}
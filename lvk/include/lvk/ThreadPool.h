@@ -0,0 +1,96 @@
+#pragma once
+#include "Alias.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace lvk
+{
+    // Unbounded multi producer / multi consumer queue, connects the stages of a pipeline.
+    // producers on worker threads Push results as they finish, a consumer Pops them in completion order.
+    template<typename _Ty>
+    class WorkQueue
+    {
+    public:
+        // notifies while holding the lock, so a consumer that pops the last item it waits for can
+        // destroy the queue without racing the producer
+        void Push(_Ty item)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Items.push(std::move(item));
+            m_Condition.notify_one();
+        }
+
+        // blocks until an item is available
+        _Ty Pop()
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return !m_Items.empty(); });
+            _Ty item = std::move(m_Items.front());
+            m_Items.pop();
+            return item;
+        }
+
+        bool TryPop(_Ty& item)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Items.empty())
+            {
+                return false;
+            }
+            item = std::move(m_Items.front());
+            m_Items.pop();
+            return true;
+        }
+
+    private:
+        std::queue<_Ty>         m_Items;
+        std::mutex              m_Mutex;
+        std::condition_variable m_Condition;
+    };
+
+    // Fixed set of worker threads draining a shared task queue.
+    // ParallelFor splits a range into batches and blocks until all of them have run,
+    // the calling thread works on batches too so a pool with no workers degrades to a plain loop.
+    class ThreadPool
+    {
+    public:
+        // threadCount 0 uses hardware_concurrency - 1 workers (the caller is the remaining thread)
+        explicit ThreadPool(uint32_t threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // shared pool, created on first use
+        static ThreadPool& Default();
+
+        uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+        template<typename _Fn>
+        auto Submit(_Fn&& fn) -> std::future<decltype(fn())>
+        {
+            using _Result = decltype(fn());
+            auto task = std::make_shared<std::packaged_task<_Result()>>(std::forward<_Fn>(fn));
+            std::future<_Result> result = task->get_future();
+            Enqueue([task]() { (*task)(); });
+            return result;
+        }
+
+        // calls fn(begin, end) over [0, count) in batches of at least minBatchSize elements
+        void ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& fn);
+
+    private:
+        void Enqueue(std::function<void()> task);
+        void WorkerLoop();
+
+        Vector<std::thread>                 m_Workers;
+        std::queue<std::function<void()>>   m_Tasks;
+        std::mutex                          m_Mutex;
+        std::condition_variable             m_Condition;
+        bool                                m_Stopping = false;
+    };
+}
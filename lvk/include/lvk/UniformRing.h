@@ -0,0 +1,56 @@
+#pragma once
+#include "lvk/Structs.h"
+#include "lvk/Macros.h"
+#include <type_traits>
+
+namespace lvk
+{
+    // Per frame linear allocator for transient uniform data.
+    // Each frame in flight owns one persistently mapped buffer, per draw data is
+    // bump allocated into it and bound with a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+    // offset, so every object can share a single descriptor.
+    // The head is reset by BeginFrame, call it once the frame's previous submission
+    // has retired (after the frame fence has been waited on).
+    class UniformRing
+    {
+    public:
+        Array<MappedBuffer, MAX_FRAMES_IN_FLIGHT>   m_FrameBuffers;
+
+        VkDeviceSize    m_Capacity      = 0;
+        VkDeviceSize    m_Alignment     = 0;
+        VkDeviceSize    m_Head          = 0;
+        uint32_t        m_MaxRange      = 0;
+        uint32_t        m_FrameIndex    = 0;
+
+        // capacityPerFrame : bytes reserved for each frame in flight
+        // maxRange         : descriptor range, the largest block bound through this ring
+        static UniformRing Create(VkState& vk, VkDeviceSize capacityPerFrame, uint32_t maxRange);
+
+        void BeginFrame(uint32_t frameIndex);
+
+        // returns false when the ring is exhausted for this frame
+        bool Allocate(uint32_t size, uint32_t& dynamicOffset, void*& mappedAddr);
+
+        // copies value into the ring and returns the dynamic offset to bind it with,
+        // UINT32_MAX if the ring is exhausted
+        template<typename _Ty>
+        uint32_t Push(const _Ty& value)
+        {
+            static_assert(std::is_trivially_copyable<_Ty>::value, "UniformRing : pushed types must be trivially copyable");
+            constexpr uint32_t _ty_size = static_cast<uint32_t>(sizeof(_Ty));
+
+            uint32_t dynamicOffset = 0;
+            void* addr = nullptr;
+            if (!Allocate(_ty_size, dynamicOffset, addr))
+            {
+                return UINT32_MAX;
+            }
+            memcpy(addr, &value, _ty_size);
+            return dynamicOffset;
+        }
+
+        VkDescriptorBufferInfo GetDescriptorBufferInfo(uint32_t frameIndex) const;
+
+        void Free(VkState& vk);
+    };
+}
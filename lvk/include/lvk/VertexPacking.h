@@ -0,0 +1,61 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "lvk/Mesh.h"
+
+namespace lvk
+{
+    // Conversion from the fp32 vertex formats to their packed counterparts (VertexDataPacked*).
+    namespace vertex_packing
+    {
+        // positions are stored as snorm16 over the mesh's bounds : position = decoded * m_Scale + m_Offset
+        struct QuantizationParams
+        {
+            glm::vec3 m_Offset{ 0.0f };
+            glm::vec3 m_Scale{ 1.0f };
+
+            // apply before the model matrix, model * GetDequantizeMatrix()
+            glm::mat4 GetDequantizeMatrix() const;
+        };
+
+        QuantizationParams CalculateQuantization(const glm::vec3& min, const glm::vec3& max);
+
+        template<typename _Ty>
+        QuantizationParams CalculateQuantization(const Vector<_Ty>& vertices)
+        {
+            if (vertices.empty())
+            {
+                return QuantizationParams{};
+            }
+
+            glm::vec3 min = vertices[0].Position;
+            glm::vec3 max = vertices[0].Position;
+            for (const _Ty& vertex : vertices)
+            {
+                min = glm::min(min, vertex.Position);
+                max = glm::max(max, vertex.Position);
+            }
+            return CalculateQuantization(min, max);
+        }
+
+        void        PackPosition(const glm::vec3& position, const QuantizationParams& params, int16_t packed[4]);
+        glm::vec3   UnpackPosition(const int16_t packed[4], const QuantizationParams& params);
+
+        // octahedral encoding, picks the snorm16 rounding with the smallest angular error
+        void        PackNormal(const glm::vec3& normal, int16_t packed[2]);
+        glm::vec3   UnpackNormal(const int16_t packed[2]);
+
+        uint16_t    PackHalf(float value);
+        float       UnpackHalf(uint16_t value);
+
+        // quantization is calculated from the vertices' bounds and returned
+        QuantizationParams PackVertices(const Vector<VertexDataPosUv>& vertices, Vector<VertexDataPackedPosUv>& packed);
+        QuantizationParams PackVertices(const Vector<VertexDataPosColUv>& vertices, Vector<VertexDataPackedPosColUv>& packed);
+        QuantizationParams PackVertices(const Vector<VertexDataPosNormalUv>& vertices, Vector<VertexDataPackedPosNormalUv>& packed);
+
+        // vec3 Unpack_OctNormal(vec2 encoded), for the snorm normal attribute of VertexDataPackedPosNormalUv
+        const char* GetUnpackGLSL();
+
+        // inserts GetUnpackGLSL after the #version line of source
+        String InsertUnpackGLSL(const String& source);
+    }
+}
@@ -17,7 +17,7 @@ void CreateBuffer(VkState& vk, VkDeviceSize size, VkBufferUsageFlags usage, VkMe
   allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
   allocInfo.requiredFlags = properties;
 
-  if (properties && VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+  if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
   {
     // if we access members of the array non sequentially,
     // we may need to request random access instead of sequential
@@ -28,33 +28,31 @@ void CreateBuffer(VkState& vk, VkDeviceSize size, VkBufferUsageFlags usage, VkMe
   VK_CHECK(vmaCreateBuffer(vk.m_Allocator, &bufferInfo, &allocInfo, &buffer, &allocation, nullptr));
 }
 
-void CopyBuffer(VkState& vk, VkBuffer& src, VkBuffer& dst, VkDeviceSize size)
+void CopyBuffer(VkState& vk, VkBuffer& src, VkBuffer& dst, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
 {
   // create a new command buffer to record the buffer copy
   VkCommandBuffer commandBuffer = commands::BeginSingleTimeCommands(vk);
 
   // record copy command
   VkBufferCopy copyRegion{};
-  copyRegion.srcOffset = 0; // Optional
-  copyRegion.dstOffset = 0; // Optional
+  copyRegion.srcOffset = srcOffset;
+  copyRegion.dstOffset = dstOffset;
   copyRegion.size = size;
   vkCmdCopyBuffer(commandBuffer, src, dst, 1, &copyRegion);
   commands::EndSingleTimeCommands(vk, commandBuffer);
 }
 
-void CreateIndexBuffer(VkState& vk, std::vector<uint32_t> indices, VkBuffer& buffer, VmaAllocation& deviceMemory)
+static void create_index_buffer(VkState& vk, const void* indices, VkDeviceSize bufferSize, VkBuffer& buffer, VmaAllocation& deviceMemory)
 {
-  VkDeviceSize bufferSize = sizeof(uint32_t) * indices.size();
-
-  // create a CPU side buffer to dump vertex data into
+  // create a CPU side buffer to dump index data into
   VkBuffer stagingBuffer;
   VmaAllocation stagingBufferMemory;
   CreateBuffer(vk, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
 
-  // dump vert data
+  // dump index data
   void* data;
   vmaMapMemory(vk.m_Allocator, stagingBufferMemory, &data);
-  memcpy(data, indices.data(), bufferSize);
+  memcpy(data, indices, bufferSize);
   vmaUnmapMemory(vk.m_Allocator, stagingBufferMemory);
 
   // create GPU side buffer
@@ -69,6 +67,45 @@ void CreateIndexBuffer(VkState& vk, std::vector<uint32_t> indices, VkBuffer& buf
   vmaFreeMemory(vk.m_Allocator, stagingBufferMemory);
 }
 
+void CreateIndexBuffer(VkState& vk, std::vector<uint32_t> indices, VkBuffer& buffer, VmaAllocation& deviceMemory)
+{
+  create_index_buffer(vk, indices.data(), sizeof(uint32_t) * indices.size(), buffer, deviceMemory);
+}
+
+void CreateIndexBuffer(VkState& vk, const Vector<uint32_t>& indices, uint32_t vertexCount, VkBuffer& buffer, VmaAllocation& deviceMemory, VkIndexType& indexType)
+{
+  indexType = SelectIndexType(vertexCount);
+  if (indexType == VK_INDEX_TYPE_UINT32)
+  {
+    create_index_buffer(vk, indices.data(), sizeof(uint32_t) * indices.size(), buffer, deviceMemory);
+    return;
+  }
+
+  Vector<uint16_t> narrowed;
+  NarrowIndices(indices.data(), indices.size(), narrowed);
+  create_index_buffer(vk, narrowed.data(), sizeof(uint16_t) * narrowed.size(), buffer, deviceMemory);
+}
+
+VkIndexType SelectIndexType(uint32_t vertexCount)
+{
+  // 0xFFFF is left out, it is the primitive restart index for 16 bit indices
+  return vertexCount <= UINT16_MAX ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+uint32_t GetIndexSize(VkIndexType indexType)
+{
+  return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+void NarrowIndices(const uint32_t* indices, size_t indexCount, Vector<uint16_t>& narrowed)
+{
+  narrowed.resize(indexCount);
+  for (size_t i = 0; i < indexCount; i++)
+  {
+    narrowed[i] = static_cast<uint16_t>(indices[i]);
+  }
+}
+
 void CreateMappedBuffer(VkState& vk, MappedBuffer& buf, VkBufferUsageFlags bufferUsage, VkMemoryPropertyFlags memoryProperties, uint32_t size)
 {
   CreateBuffer(vk,VkDeviceSize{ size }, bufferUsage, memoryProperties, buf.m_GpuBuffer, buf.m_GpuMemory);
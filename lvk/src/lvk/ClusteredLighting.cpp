@@ -0,0 +1,422 @@
+#include "lvk/ClusteredLighting.h"
+#include "lvk/Buffer.h"
+#include "lvk/Pipeline.h"
+#include "spdlog/spdlog.h"
+#include "volk.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const char* k_ClusterStructsGLSL = R"(
+struct ClusterPointLight
+{
+    vec4 PositionRadius;
+    vec4 Ambient;
+    vec4 Colour;
+};
+
+struct ClusterSpotLight
+{
+    vec4 PositionRadius;
+    vec4 DirectionAngle;
+    vec4 Ambient;
+    vec4 Colour;
+};
+)";
+
+static const char* k_ClusterCullGLSL = R"(
+layout(local_size_x = 64) in;
+
+shared vec4 s_LightSpheres[64];
+
+// point on the ray through ndc at view depth 1
+vec3 Cluster_CornerRay(vec2 ndc)
+{
+    vec4 p = clusterParams.inverseProj * vec4(ndc, 0.5, 1.0);
+    p.xyz /= p.w;
+    return p.xyz / -p.z;
+}
+
+float Cluster_SliceDepth(uint slice)
+{
+    float n = clusterParams.depthParams.x;
+    float f = clusterParams.depthParams.y;
+    return n * pow(f / n, float(slice) / float(clusterParams.gridSize.z));
+}
+
+bool Cluster_SphereIntersectsAABB(vec4 sphere, vec3 aabbMin, vec3 aabbMax)
+{
+    vec3 closest = clamp(sphere.xyz, aabbMin, aabbMax);
+    vec3 d = closest - sphere.xyz;
+    return dot(d, d) <= sphere.w * sphere.w;
+}
+
+// tests every point (or spot) light against the cluster, streaming the view space spheres through
+// shared memory a workgroup batch at a time. with write set the overlapping indices are stored from
+// writeOffset on, as far as the index list capacity allows. returns the overlap count either way.
+// spot lights are tested with the bounding sphere of their range
+uint Cluster_CullLights(bool spots, bool active, vec3 aabbMin, vec3 aabbMax, bool write, uint writeOffset)
+{
+    uint totalLights = spots ? clusterParams.lightCounts.y : clusterParams.lightCounts.x;
+    uint capacity = clusterParams.gridSize.w;
+    uint count = 0u;
+    for (uint base = 0u; base < totalLights; base += 64u)
+    {
+        uint lightIndex = base + gl_LocalInvocationIndex;
+        if (lightIndex < totalLights)
+        {
+            vec4 pr = spots ? clusterSpotLights.lights[lightIndex].PositionRadius : clusterPointLights.lights[lightIndex].PositionRadius;
+            s_LightSpheres[gl_LocalInvocationIndex] = vec4((clusterParams.view * vec4(pr.xyz, 1.0)).xyz, pr.w);
+        }
+        barrier();
+
+        uint batch = min(64u, totalLights - base);
+        for (uint i = 0u; active && i < batch; i++)
+        {
+            if (Cluster_SphereIntersectsAABB(s_LightSpheres[i], aabbMin, aabbMax))
+            {
+                if (write && writeOffset + count < capacity)
+                {
+                    clusterLightIndices.indices[writeOffset + count] = base + i;
+                }
+                count++;
+            }
+        }
+        barrier();
+    }
+    return count;
+}
+
+void main()
+{
+    uvec3 grid = clusterParams.gridSize.xyz;
+    uint clusterCount = grid.x * grid.y * grid.z;
+    uint clusterIndex = gl_GlobalInvocationID.x;
+    bool active = clusterIndex < clusterCount;
+
+    vec3 aabbMin = vec3(0.0);
+    vec3 aabbMax = vec3(0.0);
+    if (active)
+    {
+        uint x = clusterIndex % grid.x;
+        uint y = (clusterIndex / grid.x) % grid.y;
+        uint z = clusterIndex / (grid.x * grid.y);
+
+        vec2 tileMin = vec2(x, y) / vec2(grid.xy) * 2.0 - 1.0;
+        vec2 tileMax = vec2(x + 1, y + 1) / vec2(grid.xy) * 2.0 - 1.0;
+        float nearDepth = Cluster_SliceDepth(z);
+        float farDepth = Cluster_SliceDepth(z + 1);
+
+        vec3 rays[4];
+        rays[0] = Cluster_CornerRay(tileMin);
+        rays[1] = Cluster_CornerRay(vec2(tileMax.x, tileMin.y));
+        rays[2] = Cluster_CornerRay(vec2(tileMin.x, tileMax.y));
+        rays[3] = Cluster_CornerRay(tileMax);
+
+        aabbMin = vec3(1e30);
+        aabbMax = vec3(-1e30);
+        for (int i = 0; i < 4; i++)
+        {
+            vec3 pn = rays[i] * nearDepth;
+            vec3 pf = rays[i] * farDepth;
+            aabbMin = min(aabbMin, min(pn, pf));
+            aabbMax = max(aabbMax, max(pn, pf));
+        }
+    }
+
+    // the first pass only counts so the cluster's range can be reserved, the second writes the indices
+    // straight into it. nothing is held per invocation, so there is no per cluster light limit
+    uint pointCount = Cluster_CullLights(false, active, aabbMin, aabbMax, false, 0u);
+    uint spotCount = Cluster_CullLights(true, active, aabbMin, aabbMax, false, 0u);
+
+    // count keeps growing past the capacity, the host reads the total back to report the overflow
+    uint offset = 0u;
+    if (active)
+    {
+        offset = atomicAdd(clusterLightIndices.count, pointCount + spotCount);
+    }
+
+    Cluster_CullLights(false, active, aabbMin, aabbMax, true, offset);
+    Cluster_CullLights(true, active, aabbMin, aabbMax, true, offset + pointCount);
+
+    if (!active)
+    {
+        return;
+    }
+
+    // a cluster straddling the end of the index list keeps the lights that fit
+    uint capacity = clusterParams.gridSize.w;
+    uint pointsStored = min(pointCount, capacity - min(offset, capacity));
+    uint spotsStored = min(spotCount, capacity - min(offset + pointCount, capacity));
+    clusterGrid.clusters[clusterIndex] = uvec4(offset, pointsStored, offset + pointCount, spotsStored);
+}
+)";
+
+static const char* k_ClusterShadingGLSL = R"(
+float Cluster_ViewDepth(vec3 worldPosition)
+{
+    return -(clusterParams.view * vec4(worldPosition, 1.0)).z;
+}
+
+uint Cluster_Index(vec2 fragCoord, float viewDepth)
+{
+    uvec3 grid = clusterParams.gridSize.xyz;
+    float slice = log(max(viewDepth, 1e-4)) * clusterParams.depthParams.z + clusterParams.depthParams.w;
+    uint z = uint(clamp(slice, 0.0, float(grid.z - 1)));
+    uvec2 tile = min(uvec2(fragCoord / clusterParams.screenSize.xy * vec2(grid.xy)), grid.xy - 1u);
+    return tile.x + tile.y * grid.x + z * grid.x * grid.y;
+}
+
+// x : first point light, y : point light count, z : first spot light, w : spot light count
+// iterate with for (uint i = c.x; i < c.x + c.y; i++) Cluster_PointLight(i)
+uvec4 Cluster_Get(vec2 fragCoord, vec3 worldPosition)
+{
+    return clusterGrid.clusters[Cluster_Index(fragCoord, Cluster_ViewDepth(worldPosition))];
+}
+
+ClusterPointLight Cluster_PointLight(uint i)
+{
+    return clusterPointLights.lights[clusterLightIndices.indices[i]];
+}
+
+ClusterSpotLight Cluster_SpotLight(uint i)
+{
+    return clusterSpotLights.lights[clusterLightIndices.indices[i]];
+}
+)";
+
+static lvk::String cluster_buffers_glsl(uint32_t set, uint32_t firstBinding, bool shading)
+{
+    auto layout = [&](uint32_t offset) {
+        return "layout(std430, set = " + std::to_string(set) + ", binding = " + std::to_string(firstBinding + offset) + ") ";
+    };
+
+    lvk::String glsl = k_ClusterStructsGLSL;
+    glsl += layout(0) + "readonly buffer ClusterParams\n{\n"
+        "    mat4  view;\n"
+        "    mat4  inverseProj;\n"
+        "    uvec4 gridSize;\n"
+        "    vec4  depthParams;\n"
+        "    vec4  screenSize;\n"
+        "    uvec4 lightCounts;\n"
+        "} clusterParams;\n";
+    glsl += layout(1) + "readonly buffer ClusterPointLights { ClusterPointLight lights[]; } clusterPointLights;\n";
+    glsl += layout(2) + "readonly buffer ClusterSpotLights { ClusterSpotLight lights[]; } clusterSpotLights;\n";
+    glsl += layout(3) + (shading ? "readonly" : "writeonly") + " buffer ClusterGrid { uvec4 clusters[]; } clusterGrid;\n";
+    glsl += layout(4) + (shading ? "readonly " : "") + "buffer ClusterLightIndices { uint count; uint indices[]; } clusterLightIndices;\n";
+    return glsl;
+}
+
+static const char* k_ClusterBufferNames[] = {
+    "clusterParams",
+    "clusterPointLights",
+    "clusterSpotLights",
+    "clusterGrid",
+    "clusterLightIndices"
+};
+
+lvk::ClusteredLighting lvk::ClusteredLighting::Create(VkState& vk, uint32_t maxPointLights, uint32_t maxSpotLights,
+    uint32_t gridX, uint32_t gridY, uint32_t gridZ, uint32_t averageLightsPerCluster)
+{
+    ClusteredLighting cl{};
+    cl.m_MaxPointLights = std::max(maxPointLights, 1u);
+    cl.m_MaxSpotLights = std::max(maxSpotLights, 1u);
+
+    uint32_t clusterCount = gridX * gridY * gridZ;
+    uint32_t indexCapacity = clusterCount * averageLightsPerCluster;
+    cl.m_Params.m_GridSize = glm::uvec4(gridX, gridY, gridZ, indexCapacity);
+
+    String source = "#version 450\n" + cluster_buffers_glsl(0, 0, false) + k_ClusterCullGLSL;
+    ShaderStage stage = ShaderStage::CreateFromSource(vk, source, ShaderStageType::Compute);
+    cl.m_Program = ShaderProgram::CreateCompute(vk, stage);
+    cl.m_Material = Material::Create(vk, cl.m_Program);
+    cl.m_Pipeline = pipelines::CreateComputePipeline(vk, stage.m_StageBinary, cl.m_Program.m_DescriptorSetLayout, cl.m_PipelineLayout);
+
+    cl.m_Material.CreateStorageBuffer(vk, "clusterPointLights", cl.m_MaxPointLights, Material::StorageBufferMemory::HostVisible);
+    cl.m_Material.CreateStorageBuffer(vk, "clusterSpotLights", cl.m_MaxSpotLights, Material::StorageBufferMemory::HostVisible);
+
+    VkDeviceSize gridSize = VkDeviceSize{ clusterCount } * sizeof(glm::uvec4);
+    VkDeviceSize indexSize = sizeof(uint32_t) + VkDeviceSize{ indexCapacity } * sizeof(uint32_t);
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        buffers::CreateBuffer(vk, gridSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            cl.m_GridBuffers[i], cl.m_GridAllocations[i]);
+        buffers::CreateBuffer(vk, indexSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, cl.m_IndexBuffers[i], cl.m_IndexAllocations[i]);
+
+        buffers::CreateMappedBuffer(vk, cl.m_CountReadback[i], VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(uint32_t));
+        memset(cl.m_CountReadback[i].m_MappedAddr, 0, sizeof(uint32_t));
+    }
+
+    cl.m_Material.SetStorageBuffer(vk, "clusterGrid", cl.m_GridBuffers, gridSize);
+    cl.m_Material.SetStorageBuffer(vk, "clusterLightIndices", cl.m_IndexBuffers, indexSize);
+
+    return cl;
+}
+
+void lvk::ClusteredLighting::SetLights(VkState& vk, uint32_t frameIndex, const ClusterPointLight* pointLights, uint32_t pointLightCount,
+    const ClusterSpotLight* spotLights, uint32_t spotLightCount)
+{
+    if (pointLightCount > m_MaxPointLights || spotLightCount > m_MaxSpotLights)
+    {
+        spdlog::warn("ClusteredLighting : {} point / {} spot lights exceed the capacity of {} / {}, clamping",
+            pointLightCount, spotLightCount, m_MaxPointLights, m_MaxSpotLights);
+    }
+
+    pointLightCount = std::min(pointLightCount, m_MaxPointLights);
+    spotLightCount = std::min(spotLightCount, m_MaxSpotLights);
+
+    // frameIndex's fence has been waited on, so its last dispatch has landed in the readback
+    uint32_t requested = *static_cast<const uint32_t*>(m_CountReadback[frameIndex].m_MappedAddr);
+    uint32_t dropped = requested > m_Params.m_GridSize.w ? requested - m_Params.m_GridSize.w : 0;
+    if (dropped != m_DroppedIndices)
+    {
+        if (dropped > 0)
+        {
+            spdlog::warn("ClusteredLighting : index list overflowed, {} of {} light indices dropped (capacity {})",
+                dropped, requested, m_Params.m_GridSize.w);
+        }
+        m_DroppedIndices = dropped;
+    }
+
+    if (pointLightCount > 0)
+    {
+        m_Material.WriteStorageBuffer(vk, frameIndex, "clusterPointLights", pointLights, sizeof(ClusterPointLight) * pointLightCount);
+    }
+    if (spotLightCount > 0)
+    {
+        m_Material.WriteStorageBuffer(vk, frameIndex, "clusterSpotLights", spotLights, sizeof(ClusterSpotLight) * spotLightCount);
+    }
+
+    m_Params.m_LightCounts = glm::uvec4(pointLightCount, spotLightCount, 0, 0);
+}
+
+void lvk::ClusteredLighting::Update(VkState& vk, uint32_t frameIndex, const glm::mat4& view, const glm::mat4& proj, VkExtent2D extent, float zNear, float zFar)
+{
+    float sliceCount = static_cast<float>(m_Params.m_GridSize.z);
+    float logRange = std::log(zFar / zNear);
+
+    m_Params.m_View = view;
+    m_Params.m_InverseProj = glm::inverse(proj);
+    m_Params.m_DepthParams = glm::vec4(zNear, zFar, sliceCount / logRange, -sliceCount * std::log(zNear) / logRange);
+    m_Params.m_ScreenSize = glm::vec4(static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 0.0f);
+
+    m_Material.WriteStorageBuffer(vk, frameIndex, "clusterParams", &m_Params, sizeof(Params));
+}
+
+void lvk::ClusteredLighting::Dispatch(VkCommandBuffer& commandBuffer, uint32_t frameIndex)
+{
+    // reset the index list counter
+    vkCmdFillBuffer(commandBuffer, m_IndexBuffers[frameIndex], 0, sizeof(uint32_t), 0);
+
+    VkBufferMemoryBarrier fillBarrier{};
+    fillBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    fillBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    fillBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    fillBarrier.buffer = m_IndexBuffers[frameIndex];
+    fillBarrier.offset = 0;
+    fillBarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 1, &fillBarrier, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1,
+        &m_Material.m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
+    vkCmdDispatch(commandBuffer, (GetClusterCount() + k_ClustersPerWorkgroup - 1) / k_ClustersPerWorkgroup, 1, 1);
+
+    Array<VkBufferMemoryBarrier, 2> resultBarriers{};
+    VkBuffer results[] = { m_GridBuffers[frameIndex], m_IndexBuffers[frameIndex] };
+    for (size_t i = 0; i < resultBarriers.size(); i++)
+    {
+        resultBarriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        resultBarriers[i].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        resultBarriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+        resultBarriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        resultBarriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        resultBarriers[i].buffer = results[i];
+        resultBarriers[i].offset = 0;
+        resultBarriers[i].size = VK_WHOLE_SIZE;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, static_cast<uint32_t>(resultBarriers.size()), resultBarriers.data(), 0, nullptr);
+
+    // the total requested by every cluster, read back by SetLights once this frame comes around again
+    VkBufferCopy countCopy{ 0, 0, sizeof(uint32_t) };
+    vkCmdCopyBuffer(commandBuffer, m_IndexBuffers[frameIndex], m_CountReadback[frameIndex].m_GpuBuffer, 1, &countCopy);
+
+    VkBufferMemoryBarrier readbackBarrier{};
+    readbackBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    readbackBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    readbackBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    readbackBarrier.buffer = m_CountReadback[frameIndex].m_GpuBuffer;
+    readbackBarrier.offset = 0;
+    readbackBarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+        0, 0, nullptr, 1, &readbackBarrier, 0, nullptr);
+}
+
+bool lvk::ClusteredLighting::BindShadingBuffers(VkState& vk, Material& material)
+{
+    bool bound = true;
+    for (const char* name : k_ClusterBufferNames)
+    {
+        auto it = m_Material.m_StorageBuffers.find(name);
+        if (it == m_Material.m_StorageBuffers.end())
+        {
+            continue;
+        }
+
+        if (!material.SetStorageBuffer(vk, name, it->second.m_Buffers, it->second.m_Size))
+        {
+            spdlog::error("ClusteredLighting : material does not declare {}, was the shader built with InsertShadingGLSL?", name);
+            bound = false;
+        }
+    }
+    return bound;
+}
+
+lvk::String lvk::ClusteredLighting::InsertShadingGLSL(const String& source, uint32_t set, uint32_t firstBinding)
+{
+    String shading = cluster_buffers_glsl(set, firstBinding, true) + k_ClusterShadingGLSL;
+
+    size_t version = source.find("#version");
+    if (version == String::npos)
+    {
+        return shading + source;
+    }
+
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == String::npos)
+    {
+        return source + "\n" + shading;
+    }
+    return source.substr(0, lineEnd + 1) + shading + source.substr(lineEnd + 1);
+}
+
+void lvk::ClusteredLighting::Free(VkState& vk)
+{
+    vkDestroyPipeline(vk.m_LogicalDevice, m_Pipeline, nullptr);
+    vkDestroyPipelineLayout(vk.m_LogicalDevice, m_PipelineLayout, nullptr);
+
+    m_Material.Free(vk);
+
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        vkDestroyBuffer(vk.m_LogicalDevice, m_GridBuffers[i], nullptr);
+        vmaFreeMemory(vk.m_Allocator, m_GridAllocations[i]);
+        vkDestroyBuffer(vk.m_LogicalDevice, m_IndexBuffers[i], nullptr);
+        vmaFreeMemory(vk.m_Allocator, m_IndexAllocations[i]);
+        m_CountReadback[i].Free(vk);
+    }
+
+    for (auto& stage : m_Program.m_Stages)
+    {
+        vkDestroyShaderModule(vk.m_LogicalDevice, stage.m_Module, nullptr);
+    }
+    m_Program.Free(vk);
+}
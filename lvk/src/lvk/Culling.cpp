@@ -0,0 +1,488 @@
+#include "lvk/Culling.h"
+#include "lvk/ThreadPool.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#define LVK_CULL_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LVK_CULL_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define LVK_CULL_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// plane components pre-split so the kernels only broadcast
+struct PreparedPlane
+{
+    float m_NX, m_NY, m_NZ, m_D;
+    float m_AbsNX, m_AbsNY, m_AbsNZ;
+};
+
+using PreparedFrustum = lvk::Array<PreparedPlane, lvk::culling::Frustum::PlaneCount>;
+
+static PreparedFrustum prepare_frustum(const lvk::culling::Frustum& frustum)
+{
+    PreparedFrustum prepared{};
+    for (size_t i = 0; i < prepared.size(); i++)
+    {
+        const glm::vec4& p = frustum.m_Planes[i];
+        prepared[i] = { p.x, p.y, p.z, p.w, std::fabs(p.x), std::fabs(p.y), std::fabs(p.z) };
+    }
+    return prepared;
+}
+
+static inline uint32_t count_trailing_zeros(uint32_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+}
+
+// appends base + set bit positions of mask to out
+static inline uint32_t emit_visible(uint32_t mask, uint32_t base, uint32_t* out, uint32_t written)
+{
+    while (mask != 0)
+    {
+        out[written++] = base + count_trailing_zeros(mask);
+        mask &= mask - 1;
+    }
+    return written;
+}
+
+// a box is outside when it lies entirely behind any plane :
+// dot(n, centre) + d + dot(|n|, extent) < 0
+static uint32_t cull_scalar(const PreparedFrustum& planes, const lvk::culling::BoundsSoA& bounds, uint32_t first, uint32_t end, uint32_t* out, uint32_t written)
+{
+    for (uint32_t i = first; i < end; i++)
+    {
+        bool visible = true;
+        for (const PreparedPlane& p : planes)
+        {
+            float dist = p.m_NX * bounds.m_CenterX[i] + p.m_NY * bounds.m_CenterY[i] + p.m_NZ * bounds.m_CenterZ[i] + p.m_D;
+            float radius = p.m_AbsNX * bounds.m_ExtentX[i] + p.m_AbsNY * bounds.m_ExtentY[i] + p.m_AbsNZ * bounds.m_ExtentZ[i];
+            if (dist + radius < 0.0f)
+            {
+                visible = false;
+                break;
+            }
+        }
+
+        if (visible)
+        {
+            out[written++] = i;
+        }
+    }
+    return written;
+}
+
+#if defined(LVK_CULL_AVX)
+static uint32_t cull_simd(const PreparedFrustum& planes, const lvk::culling::BoundsSoA& bounds, uint32_t first, uint32_t count, uint32_t* out)
+{
+    constexpr uint32_t k_Width = 8;
+    const uint32_t end = first + count;
+    const uint32_t simdEnd = first + (count / k_Width) * k_Width;
+    const __m256 zero = _mm256_setzero_ps();
+
+    uint32_t written = 0;
+    for (uint32_t i = first; i < simdEnd; i += k_Width)
+    {
+        __m256 cx = _mm256_loadu_ps(&bounds.m_CenterX[i]);
+        __m256 cy = _mm256_loadu_ps(&bounds.m_CenterY[i]);
+        __m256 cz = _mm256_loadu_ps(&bounds.m_CenterZ[i]);
+        __m256 ex = _mm256_loadu_ps(&bounds.m_ExtentX[i]);
+        __m256 ey = _mm256_loadu_ps(&bounds.m_ExtentY[i]);
+        __m256 ez = _mm256_loadu_ps(&bounds.m_ExtentZ[i]);
+
+        int mask = 0xFF;
+        for (const PreparedPlane& p : planes)
+        {
+            __m256 dist = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.m_NX), cx), _mm256_mul_ps(_mm256_set1_ps(p.m_NY), cy)),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.m_NZ), cz), _mm256_set1_ps(p.m_D)));
+            __m256 radius = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.m_AbsNX), ex), _mm256_mul_ps(_mm256_set1_ps(p.m_AbsNY), ey)),
+                _mm256_mul_ps(_mm256_set1_ps(p.m_AbsNZ), ez));
+
+            mask &= _mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_GE_OQ));
+            if (mask == 0)
+            {
+                break;
+            }
+        }
+
+        written = emit_visible(static_cast<uint32_t>(mask), i, out, written);
+    }
+
+    return cull_scalar(planes, bounds, simdEnd, end, out, written);
+}
+#elif defined(LVK_CULL_SSE)
+static uint32_t cull_simd(const PreparedFrustum& planes, const lvk::culling::BoundsSoA& bounds, uint32_t first, uint32_t count, uint32_t* out)
+{
+    constexpr uint32_t k_Width = 4;
+    const uint32_t end = first + count;
+    const uint32_t simdEnd = first + (count / k_Width) * k_Width;
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t written = 0;
+    for (uint32_t i = first; i < simdEnd; i += k_Width)
+    {
+        __m128 cx = _mm_loadu_ps(&bounds.m_CenterX[i]);
+        __m128 cy = _mm_loadu_ps(&bounds.m_CenterY[i]);
+        __m128 cz = _mm_loadu_ps(&bounds.m_CenterZ[i]);
+        __m128 ex = _mm_loadu_ps(&bounds.m_ExtentX[i]);
+        __m128 ey = _mm_loadu_ps(&bounds.m_ExtentY[i]);
+        __m128 ez = _mm_loadu_ps(&bounds.m_ExtentZ[i]);
+
+        int mask = 0xF;
+        for (const PreparedPlane& p : planes)
+        {
+            __m128 dist = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.m_NX), cx), _mm_mul_ps(_mm_set1_ps(p.m_NY), cy)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.m_NZ), cz), _mm_set1_ps(p.m_D)));
+            __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.m_AbsNX), ex), _mm_mul_ps(_mm_set1_ps(p.m_AbsNY), ey)),
+                _mm_mul_ps(_mm_set1_ps(p.m_AbsNZ), ez));
+
+            mask &= _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+            if (mask == 0)
+            {
+                break;
+            }
+        }
+
+        written = emit_visible(static_cast<uint32_t>(mask), i, out, written);
+    }
+
+    return cull_scalar(planes, bounds, simdEnd, end, out, written);
+}
+#elif defined(LVK_CULL_NEON)
+static uint32_t cull_simd(const PreparedFrustum& planes, const lvk::culling::BoundsSoA& bounds, uint32_t first, uint32_t count, uint32_t* out)
+{
+    constexpr uint32_t k_Width = 4;
+    const uint32_t end = first + count;
+    const uint32_t simdEnd = first + (count / k_Width) * k_Width;
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const uint32_t laneBitsData[4] = { 1, 2, 4, 8 };
+    const uint32x4_t laneBits = vld1q_u32(laneBitsData);
+
+    uint32_t written = 0;
+    for (uint32_t i = first; i < simdEnd; i += k_Width)
+    {
+        float32x4_t cx = vld1q_f32(&bounds.m_CenterX[i]);
+        float32x4_t cy = vld1q_f32(&bounds.m_CenterY[i]);
+        float32x4_t cz = vld1q_f32(&bounds.m_CenterZ[i]);
+        float32x4_t ex = vld1q_f32(&bounds.m_ExtentX[i]);
+        float32x4_t ey = vld1q_f32(&bounds.m_ExtentY[i]);
+        float32x4_t ez = vld1q_f32(&bounds.m_ExtentZ[i]);
+
+        uint32x4_t visible = vdupq_n_u32(0xFFFFFFFF);
+        for (const PreparedPlane& p : planes)
+        {
+            float32x4_t dist = vdupq_n_f32(p.m_D);
+            dist = vmlaq_n_f32(dist, cx, p.m_NX);
+            dist = vmlaq_n_f32(dist, cy, p.m_NY);
+            dist = vmlaq_n_f32(dist, cz, p.m_NZ);
+            dist = vmlaq_n_f32(dist, ex, p.m_AbsNX);
+            dist = vmlaq_n_f32(dist, ey, p.m_AbsNY);
+            dist = vmlaq_n_f32(dist, ez, p.m_AbsNZ);
+            visible = vandq_u32(visible, vcgeq_f32(dist, zero));
+        }
+
+        uint32x4_t bits = vandq_u32(visible, laneBits);
+        uint32x2_t pairs = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+        uint32_t mask = vget_lane_u32(vpadd_u32(pairs, pairs), 0);
+
+        written = emit_visible(mask, i, out, written);
+    }
+
+    return cull_scalar(planes, bounds, simdEnd, end, out, written);
+}
+#else
+static uint32_t cull_simd(const PreparedFrustum& planes, const lvk::culling::BoundsSoA& bounds, uint32_t first, uint32_t count, uint32_t* out)
+{
+    return cull_scalar(planes, bounds, first, first + count, out, 0);
+}
+#endif
+
+// below this many boxes a parallel transform costs more in wake ups than it saves
+static constexpr uint32_t k_ParallelTransformThreshold = 8192;
+static constexpr uint32_t k_TransformBatchSize = 2048;
+
+static void transform_scalar(const lvk::culling::BoundsSoA& local, const glm::mat4* transforms, uint32_t first, uint32_t end, lvk::culling::BoundsSoA& world)
+{
+    for (uint32_t i = first; i < end; i++)
+    {
+        const glm::mat4& m = transforms[i];
+        float cx = local.m_CenterX[i], cy = local.m_CenterY[i], cz = local.m_CenterZ[i];
+        float ex = local.m_ExtentX[i], ey = local.m_ExtentY[i], ez = local.m_ExtentZ[i];
+
+        world.m_CenterX[i] = m[0][0] * cx + m[1][0] * cy + m[2][0] * cz + m[3][0];
+        world.m_CenterY[i] = m[0][1] * cx + m[1][1] * cy + m[2][1] * cz + m[3][1];
+        world.m_CenterZ[i] = m[0][2] * cx + m[1][2] * cy + m[2][2] * cz + m[3][2];
+        world.m_ExtentX[i] = std::fabs(m[0][0]) * ex + std::fabs(m[1][0]) * ey + std::fabs(m[2][0]) * ez;
+        world.m_ExtentY[i] = std::fabs(m[0][1]) * ex + std::fabs(m[1][1]) * ey + std::fabs(m[2][1]) * ez;
+        world.m_ExtentZ[i] = std::fabs(m[0][2]) * ex + std::fabs(m[1][2]) * ey + std::fabs(m[2][2]) * ez;
+    }
+}
+
+#if defined(LVK_CULL_AVX) || defined(LVK_CULL_SSE)
+// 4 boxes per iteration, each matrix column of the 4 transforms is transposed so that
+// lane n of row r holds element r of that column for box n
+static void transform_simd(const lvk::culling::BoundsSoA& local, const glm::mat4* transforms, uint32_t first, uint32_t count, lvk::culling::BoundsSoA& world)
+{
+    const uint32_t end = first + count;
+    const uint32_t simdEnd = first + (count / 4) * 4;
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    for (uint32_t i = first; i < simdEnd; i += 4)
+    {
+        const float* m0 = &transforms[i + 0][0][0];
+        const float* m1 = &transforms[i + 1][0][0];
+        const float* m2 = &transforms[i + 2][0][0];
+        const float* m3 = &transforms[i + 3][0][0];
+
+        __m128 col[4][4];
+        for (int c = 0; c < 4; c++)
+        {
+            __m128 r0 = _mm_loadu_ps(m0 + c * 4);
+            __m128 r1 = _mm_loadu_ps(m1 + c * 4);
+            __m128 r2 = _mm_loadu_ps(m2 + c * 4);
+            __m128 r3 = _mm_loadu_ps(m3 + c * 4);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            col[c][0] = r0;
+            col[c][1] = r1;
+            col[c][2] = r2;
+            col[c][3] = r3;
+        }
+
+        __m128 cx = _mm_loadu_ps(&local.m_CenterX[i]);
+        __m128 cy = _mm_loadu_ps(&local.m_CenterY[i]);
+        __m128 cz = _mm_loadu_ps(&local.m_CenterZ[i]);
+        __m128 ex = _mm_loadu_ps(&local.m_ExtentX[i]);
+        __m128 ey = _mm_loadu_ps(&local.m_ExtentY[i]);
+        __m128 ez = _mm_loadu_ps(&local.m_ExtentZ[i]);
+
+        float* centres[3] = { &world.m_CenterX[i], &world.m_CenterY[i], &world.m_CenterZ[i] };
+        float* extents[3] = { &world.m_ExtentX[i], &world.m_ExtentY[i], &world.m_ExtentZ[i] };
+        for (int r = 0; r < 3; r++)
+        {
+            __m128 centre = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(col[0][r], cx), _mm_mul_ps(col[1][r], cy)),
+                _mm_add_ps(_mm_mul_ps(col[2][r], cz), col[3][r]));
+            __m128 extent = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_and_ps(col[0][r], absMask), ex), _mm_mul_ps(_mm_and_ps(col[1][r], absMask), ey)),
+                _mm_mul_ps(_mm_and_ps(col[2][r], absMask), ez));
+            _mm_storeu_ps(centres[r], centre);
+            _mm_storeu_ps(extents[r], extent);
+        }
+    }
+
+    transform_scalar(local, transforms, simdEnd, end, world);
+}
+#elif defined(LVK_CULL_NEON)
+static void transform_simd(const lvk::culling::BoundsSoA& local, const glm::mat4* transforms, uint32_t first, uint32_t count, lvk::culling::BoundsSoA& world)
+{
+    const uint32_t end = first + count;
+    const uint32_t simdEnd = first + (count / 4) * 4;
+
+    for (uint32_t i = first; i < simdEnd; i += 4)
+    {
+        float32x4_t col[4][4];
+        for (int c = 0; c < 4; c++)
+        {
+            float32x4x2_t t01 = vtrnq_f32(vld1q_f32(&transforms[i + 0][c][0]), vld1q_f32(&transforms[i + 1][c][0]));
+            float32x4x2_t t23 = vtrnq_f32(vld1q_f32(&transforms[i + 2][c][0]), vld1q_f32(&transforms[i + 3][c][0]));
+            col[c][0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+            col[c][1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+            col[c][2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+            col[c][3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+        }
+
+        float32x4_t cx = vld1q_f32(&local.m_CenterX[i]);
+        float32x4_t cy = vld1q_f32(&local.m_CenterY[i]);
+        float32x4_t cz = vld1q_f32(&local.m_CenterZ[i]);
+        float32x4_t ex = vld1q_f32(&local.m_ExtentX[i]);
+        float32x4_t ey = vld1q_f32(&local.m_ExtentY[i]);
+        float32x4_t ez = vld1q_f32(&local.m_ExtentZ[i]);
+
+        float* centres[3] = { &world.m_CenterX[i], &world.m_CenterY[i], &world.m_CenterZ[i] };
+        float* extents[3] = { &world.m_ExtentX[i], &world.m_ExtentY[i], &world.m_ExtentZ[i] };
+        for (int r = 0; r < 3; r++)
+        {
+            float32x4_t centre = col[3][r];
+            centre = vmlaq_f32(centre, col[0][r], cx);
+            centre = vmlaq_f32(centre, col[1][r], cy);
+            centre = vmlaq_f32(centre, col[2][r], cz);
+
+            float32x4_t extent = vmulq_f32(vabsq_f32(col[0][r]), ex);
+            extent = vmlaq_f32(extent, vabsq_f32(col[1][r]), ey);
+            extent = vmlaq_f32(extent, vabsq_f32(col[2][r]), ez);
+
+            vst1q_f32(centres[r], centre);
+            vst1q_f32(extents[r], extent);
+        }
+    }
+
+    transform_scalar(local, transforms, simdEnd, end, world);
+}
+#else
+static void transform_simd(const lvk::culling::BoundsSoA& local, const glm::mat4* transforms, uint32_t first, uint32_t count, lvk::culling::BoundsSoA& world)
+{
+    transform_scalar(local, transforms, first, first + count, world);
+}
+#endif
+
+lvk::culling::Frustum lvk::culling::Frustum::FromViewProj(const glm::mat4& viewProj)
+{
+    // glm is column major, row r is (m[0][r], m[1][r], m[2][r], m[3][r])
+    auto row = [&](int r) { return glm::vec4(viewProj[0][r], viewProj[1][r], viewProj[2][r], viewProj[3][r]); };
+    glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+    Frustum frustum{};
+    frustum.m_Planes[Left]      = r3 + r0;
+    frustum.m_Planes[Right]     = r3 - r0;
+    frustum.m_Planes[Bottom]    = r3 + r1;
+    frustum.m_Planes[Top]       = r3 - r1;
+    frustum.m_Planes[Near]      = r2;
+    frustum.m_Planes[Far]       = r3 - r2;
+
+    for (glm::vec4& plane : frustum.m_Planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+        {
+            plane /= length;
+        }
+    }
+    return frustum;
+}
+
+uint32_t lvk::culling::BoundsSoA::Add(const glm::vec3& min, const glm::vec3& max)
+{
+    uint32_t index = Size();
+    Resize(index + 1);
+    Set(index, min, max);
+    return index;
+}
+
+void lvk::culling::BoundsSoA::Set(uint32_t index, const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 centre = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    m_CenterX[index] = centre.x;
+    m_CenterY[index] = centre.y;
+    m_CenterZ[index] = centre.z;
+    m_ExtentX[index] = extent.x;
+    m_ExtentY[index] = extent.y;
+    m_ExtentZ[index] = extent.z;
+}
+
+void lvk::culling::BoundsSoA::Resize(uint32_t count)
+{
+    m_CenterX.resize(count);
+    m_CenterY.resize(count);
+    m_CenterZ.resize(count);
+    m_ExtentX.resize(count);
+    m_ExtentY.resize(count);
+    m_ExtentZ.resize(count);
+}
+
+void lvk::culling::BoundsSoA::Reserve(uint32_t count)
+{
+    m_CenterX.reserve(count);
+    m_CenterY.reserve(count);
+    m_CenterZ.reserve(count);
+    m_ExtentX.reserve(count);
+    m_ExtentY.reserve(count);
+    m_ExtentZ.reserve(count);
+}
+
+void lvk::culling::BoundsSoA::Clear()
+{
+    Resize(0);
+}
+
+void lvk::culling::TransformAABB(const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& transform, glm::vec3& worldMin, glm::vec3& worldMax)
+{
+    glm::vec3 centre = (localMin + localMax) * 0.5f;
+    glm::vec3 extent = (localMax - localMin) * 0.5f;
+
+    glm::vec3 worldCentre = glm::vec3(transform[3]);
+    glm::vec3 worldExtent = glm::vec3(0.0f);
+    for (int c = 0; c < 3; c++)
+    {
+        for (int r = 0; r < 3; r++)
+        {
+            worldCentre[r] += transform[c][r] * centre[c];
+            worldExtent[r] += std::fabs(transform[c][r]) * extent[c];
+        }
+    }
+
+    worldMin = worldCentre - worldExtent;
+    worldMax = worldCentre + worldExtent;
+}
+
+void lvk::culling::TransformAABBs(const BoundsSoA& local, const glm::mat4* transforms, uint32_t first, uint32_t count, BoundsSoA& world)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    transform_simd(local, transforms, first, count, world);
+}
+
+void lvk::culling::TransformAABBs(const BoundsSoA& local, const glm::mat4* transforms, BoundsSoA& world, ThreadPool* pool)
+{
+    uint32_t count = local.Size();
+    world.Resize(count);
+
+    if (pool == nullptr || count < k_ParallelTransformThreshold)
+    {
+        TransformAABBs(local, transforms, 0, count, world);
+        return;
+    }
+
+    pool->ParallelFor(count, k_TransformBatchSize, [&](uint32_t begin, uint32_t end) {
+        TransformAABBs(local, transforms, begin, end - begin, world);
+    });
+}
+
+uint32_t lvk::culling::CullAABBs(const Frustum& frustum, const BoundsSoA& bounds, uint32_t first, uint32_t count, uint32_t* outIndices)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    return cull_simd(prepare_frustum(frustum), bounds, first, count, outIndices);
+}
+
+uint32_t lvk::culling::CullAABBs(const Frustum& frustum, const BoundsSoA& bounds, Vector<uint32_t>& visibleIndices)
+{
+    visibleIndices.resize(bounds.Size());
+    uint32_t visibleCount = CullAABBs(frustum, bounds, 0, bounds.Size(), visibleIndices.data());
+    visibleIndices.resize(visibleCount);
+    return visibleCount;
+}
+
+const char* lvk::culling::GetCullKernelName()
+{
+#if defined(LVK_CULL_AVX)
+    return "AVX";
+#elif defined(LVK_CULL_SSE)
+    return "SSE";
+#elif defined(LVK_CULL_NEON)
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
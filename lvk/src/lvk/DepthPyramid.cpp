@@ -0,0 +1,424 @@
+#include "lvk/DepthPyramid.h"
+#include "lvk/Buffer.h"
+#include "lvk/Commands.h"
+#include "lvk/Pipeline.h"
+#include "lvk/Texture.h"
+#include "spdlog/spdlog.h"
+#include "volk.h"
+#include <algorithm>
+
+static const char* k_DepthPyramidDeclarationsGLSL = R"(
+layout(local_size_x = 256) in;
+
+layout(set = 0, binding = 0) uniform sampler2D depthTexture;
+layout(set = 0, binding = 1, r32f) uniform coherent image2D pyramidMips[PYRAMID_MAX_MIPS];
+layout(std430, set = 0, binding = 2) coherent buffer PyramidCounter { uint counter; } pyramidCounter;
+
+layout(push_constant) uniform PyramidConstants
+{
+    uvec2 depthSize;
+    uvec2 baseSize;
+    uint  mipCount;
+    uint  workgroupCount;
+} pyramidConstants;
+)";
+
+static const char* k_DepthPyramidMainGLSL = R"(
+shared float s_Depth[16][16];
+shared bool s_IsLastWorkgroup;
+
+uvec2 Pyramid_MipSize(uint mip)
+{
+    return max(pyramidConstants.baseSize >> mip, uvec2(1));
+}
+
+// farthest depth of the attachment texels covered by base texel, the base is at most
+// 2x smaller than the attachment so this reads up to 3x3 texels
+float Pyramid_LoadSource(uvec2 texel)
+{
+    vec2 scale = vec2(pyramidConstants.depthSize) / vec2(pyramidConstants.baseSize);
+    uvec2 first = uvec2(vec2(texel) * scale);
+    uvec2 last = min(uvec2(ceil(vec2(texel + 1u) * scale)) - 1u, pyramidConstants.depthSize - 1u);
+
+    float depth = 0.0;
+    for (uint y = first.y; y <= last.y; y++)
+    {
+        for (uint x = first.x; x <= last.x; x++)
+        {
+            depth = max(depth, texelFetch(depthTexture, ivec2(x, y), 0).r);
+        }
+    }
+    return depth;
+}
+
+void Pyramid_StoreChecked(uint mip, uvec2 texel, float depth)
+{
+    if (mip < pyramidConstants.mipCount && all(lessThan(texel, Pyramid_MipSize(mip))))
+    {
+        Pyramid_Store(mip, ivec2(texel), depth);
+    }
+}
+
+void main()
+{
+    uvec2 local = uvec2(gl_LocalInvocationIndex % 16, gl_LocalInvocationIndex / 16);
+
+    // mip 0 : 2x2 texels per thread, their max is this thread's mip 1 texel
+    uvec2 base = gl_WorkGroupID.xy * 32 + local * 2;
+    float depth = 0.0;
+    for (uint i = 0; i < 4; i++)
+    {
+        uvec2 texel = base + uvec2(i & 1, i >> 1);
+        if (all(lessThan(texel, pyramidConstants.baseSize)))
+        {
+            float d = Pyramid_LoadSource(texel);
+            Pyramid_Store(0, ivec2(texel), d);
+            depth = max(depth, d);
+        }
+    }
+    Pyramid_StoreChecked(1, gl_WorkGroupID.xy * 16 + local, depth);
+    s_Depth[local.y][local.x] = depth;
+    barrier();
+
+    // mips 2 - 5 stay in shared memory
+    uint size = 16;
+    for (uint mip = 2; mip < 6; mip++)
+    {
+        size /= 2;
+        bool active = local.x < size && local.y < size;
+        float reduced = 0.0;
+        if (active)
+        {
+            uvec2 s = local * 2;
+            reduced = max(max(s_Depth[s.y][s.x], s_Depth[s.y][s.x + 1]), max(s_Depth[s.y + 1][s.x], s_Depth[s.y + 1][s.x + 1]));
+        }
+        barrier();
+        if (active)
+        {
+            s_Depth[local.y][local.x] = reduced;
+            Pyramid_StoreChecked(mip, gl_WorkGroupID.xy * size + local, reduced);
+        }
+        barrier();
+    }
+
+    if (pyramidConstants.mipCount <= 6)
+    {
+        return;
+    }
+
+    // publish mip 5 and let the last workgroup to arrive finish the chain
+    memoryBarrierImage();
+    barrier();
+    if (gl_LocalInvocationIndex == 0)
+    {
+        s_IsLastWorkgroup = atomicAdd(pyramidCounter.counter, 1) == pyramidConstants.workgroupCount - 1;
+    }
+    barrier();
+    if (!s_IsLastWorkgroup)
+    {
+        return;
+    }
+
+    for (uint mip = 6; mip < pyramidConstants.mipCount; mip++)
+    {
+        uvec2 dstSize = Pyramid_MipSize(mip);
+        uvec2 srcSize = Pyramid_MipSize(mip - 1);
+        for (uint i = gl_LocalInvocationIndex; i < dstSize.x * dstSize.y; i += 256)
+        {
+            uvec2 texel = uvec2(i % dstSize.x, i / dstSize.x);
+            float reduced = 0.0;
+            for (uint j = 0; j < 4; j++)
+            {
+                uvec2 s = min(texel * 2 + uvec2(j & 1, j >> 1), srcSize - 1u);
+                reduced = max(reduced, Pyramid_Load(mip - 1, ivec2(s)));
+            }
+            Pyramid_Store(mip, ivec2(texel), reduced);
+        }
+        memoryBarrierImage();
+        barrier();
+    }
+}
+)";
+
+// the mips are indexed with constants so the shader does not need
+// shaderStorageImageArrayDynamicIndexing
+static lvk::String depth_pyramid_source()
+{
+    using lvk::String;
+    String store = "void Pyramid_Store(uint mip, ivec2 texel, float depth)\n{\n    switch (mip)\n    {\n";
+    String load = "float Pyramid_Load(uint mip, ivec2 texel)\n{\n    switch (mip)\n    {\n";
+    for (uint32_t i = 0; i < lvk::DepthPyramid::k_MaxMips; i++)
+    {
+        String index = std::to_string(i);
+        store += "    case " + index + ": imageStore(pyramidMips[" + index + "], texel, vec4(depth)); break;\n";
+        load += "    case " + index + ": return imageLoad(pyramidMips[" + index + "], texel).r;\n";
+    }
+    store += "    }\n}\n";
+    load += "    }\n    return 0.0;\n}\n";
+
+    return "#version 450\n#define PYRAMID_MAX_MIPS " + std::to_string(lvk::DepthPyramid::k_MaxMips) + "\n" +
+        k_DepthPyramidDeclarationsGLSL + store + load + k_DepthPyramidMainGLSL;
+}
+
+static uint32_t previous_power_of_two(uint32_t value)
+{
+    uint32_t result = 1;
+    while (result * 2 <= value)
+    {
+        result *= 2;
+    }
+    return result;
+}
+
+// matches the PyramidConstants push constant block
+struct PyramidConstants
+{
+    uint32_t m_DepthSize[2];
+    uint32_t m_BaseSize[2];
+    uint32_t m_MipCount;
+    uint32_t m_WorkgroupCount;
+};
+
+lvk::DepthPyramid lvk::DepthPyramid::Create(VkState& vk, VkExtent2D depthExtent, VkFormat depthFormat,
+    const Array<VkImage, MAX_FRAMES_IN_FLIGHT>& depthImages, const Array<VkImageView, MAX_FRAMES_IN_FLIGHT>& depthViews)
+{
+    DepthPyramid dp{};
+    dp.m_DepthImages = depthImages;
+    dp.m_DepthExtent = depthExtent;
+    dp.m_BaseExtent = { previous_power_of_two(depthExtent.width), previous_power_of_two(depthExtent.height) };
+    dp.m_DepthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT || depthFormat == VK_FORMAT_D16_UNORM_S8_UINT)
+    {
+        dp.m_DepthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    uint32_t largest = std::max(dp.m_BaseExtent.width, dp.m_BaseExtent.height);
+    while ((1u << dp.m_MipCount) <= largest)
+    {
+        dp.m_MipCount++;
+    }
+    if (dp.m_MipCount > k_MaxMips)
+    {
+        spdlog::warn("DepthPyramid : {}x{} needs {} mips, only the first {} are built", dp.m_BaseExtent.width, dp.m_BaseExtent.height, dp.m_MipCount, k_MaxMips);
+        dp.m_MipCount = k_MaxMips;
+    }
+
+    ShaderStage stage = ShaderStage::CreateFromSource(vk, depth_pyramid_source(), ShaderStageType::Compute);
+    dp.m_Program = ShaderProgram::CreateCompute(vk, stage);
+    dp.m_Pipeline = pipelines::CreateComputePipeline(vk, stage.m_StageBinary, dp.m_Program.m_DescriptorSetLayout, dp.m_PipelineLayout);
+
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        textures::CreateImage(vk, dp.m_BaseExtent.width, dp.m_BaseExtent.height, dp.m_MipCount, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32_SFLOAT,
+            VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dp.m_Images[i], dp.m_Memory[i]);
+        textures::CreateImageView(vk, dp.m_Images[i], VK_FORMAT_R32_SFLOAT, dp.m_MipCount, VK_IMAGE_ASPECT_COLOR_BIT, dp.m_ImageViews[i]);
+
+        for (uint32_t mip = 0; mip < dp.m_MipCount; mip++)
+        {
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = dp.m_Images[i];
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = VK_FORMAT_R32_SFLOAT;
+            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            viewInfo.subresourceRange.baseMipLevel = mip;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+            VK_CHECK(vkCreateImageView(vk.m_LogicalDevice, &viewInfo, nullptr, &dp.m_MipViews[i][mip]));
+        }
+
+        buffers::CreateBuffer(vk, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dp.m_CounterBuffers[i], dp.m_CounterAllocations[i]);
+    }
+
+    textures::CreateImageSampler(vk, dp.m_ImageViews[0], dp.m_MipCount, VK_FILTER_NEAREST, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, dp.m_Sampler);
+
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        dp.m_DescriptorSets[i] = vk.m_DescriptorSetAllocator.Allocate(vk.m_LogicalDevice, dp.m_Program.m_DescriptorSetLayout, nullptr);
+
+        VkDescriptorImageInfo depthInfo{};
+        depthInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        depthInfo.imageView = depthViews[i];
+        depthInfo.sampler = dp.m_Sampler;
+
+        // every element is written, the ones past the last mip alias it
+        Array<VkDescriptorImageInfo, k_MaxMips> mipInfos{};
+        for (uint32_t mip = 0; mip < k_MaxMips; mip++)
+        {
+            mipInfos[mip].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            mipInfos[mip].imageView = dp.m_MipViews[i][std::min(mip, dp.m_MipCount - 1)];
+            mipInfos[mip].sampler = VK_NULL_HANDLE;
+        }
+
+        VkDescriptorBufferInfo counterInfo{};
+        counterInfo.buffer = dp.m_CounterBuffers[i];
+        counterInfo.offset = 0;
+        counterInfo.range = sizeof(uint32_t);
+
+        Array<VkWriteDescriptorSet, 3> writes{};
+        for (auto& write : writes)
+        {
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = dp.m_DescriptorSets[i];
+            write.dstArrayElement = 0;
+        }
+        writes[0].dstBinding = 0;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].descriptorCount = 1;
+        writes[0].pImageInfo = &depthInfo;
+        writes[1].dstBinding = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].descriptorCount = k_MaxMips;
+        writes[1].pImageInfo = mipInfos.data();
+        writes[2].dstBinding = 2;
+        writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[2].descriptorCount = 1;
+        writes[2].pBufferInfo = &counterInfo;
+
+        vkUpdateDescriptorSets(vk.m_LogicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    // start in GENERAL and cleared to the far plane, so culling against a pyramid
+    // that has not been built yet rejects nothing
+    VkCommandBuffer commandBuffer = commands::BeginSingleTimeCommands(vk);
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = dp.m_Images[i];
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, dp.m_MipCount, 0, 1 };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkClearColorValue far{ { 1.0f, 1.0f, 1.0f, 1.0f } };
+        vkCmdClearColorImage(commandBuffer, dp.m_Images[i], VK_IMAGE_LAYOUT_GENERAL, &far, 1, &barrier.subresourceRange);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+    commands::EndSingleTimeCommands(vk, commandBuffer);
+
+    return dp;
+}
+
+lvk::DepthPyramid lvk::DepthPyramid::Create(VkState& vk, Framebuffer& framebuffer)
+{
+    Attachment& depth = framebuffer.m_DepthAttachments[0];
+    if (depth.m_SampleCount != VK_SAMPLE_COUNT_1_BIT)
+    {
+        spdlog::error("DepthPyramid : multisampled depth attachments are not supported, resolve the depth first");
+    }
+    Array<VkImage, MAX_FRAMES_IN_FLIGHT> images;
+    Array<VkImageView, MAX_FRAMES_IN_FLIGHT> views;
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        images[i] = depth.m_AttachmentSwapchainImages[i].m_Image;
+        views[i] = depth.m_AttachmentSwapchainImages[i].m_ImageView;
+    }
+    return Create(vk, framebuffer.m_Resolution, depth.m_Format, images, views);
+}
+
+void lvk::DepthPyramid::Build(VkCommandBuffer& commandBuffer, uint32_t frameIndex)
+{
+    vkCmdFillBuffer(commandBuffer, m_CounterBuffers[frameIndex], 0, sizeof(uint32_t), 0);
+
+    Array<VkImageMemoryBarrier, 2> imageBarriers{};
+    for (auto& barrier : imageBarriers)
+    {
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    }
+
+    // depth attachment -> sampled
+    imageBarriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    imageBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    imageBarriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    imageBarriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    imageBarriers[0].image = m_DepthImages[frameIndex];
+    imageBarriers[0].subresourceRange = { m_DepthAspect, 0, 1, 0, 1 };
+
+    // previous readers of this frame's pyramid (culling) -> rewritten
+    imageBarriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    imageBarriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    imageBarriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageBarriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageBarriers[1].image = m_Images[frameIndex];
+    imageBarriers[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_MipCount, 0, 1 };
+
+    VkMemoryBarrier counterBarrier{};
+    counterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    counterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 1, &counterBarrier, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+
+    uint32_t groupsX = (m_BaseExtent.width + k_TileSize - 1) / k_TileSize;
+    uint32_t groupsY = (m_BaseExtent.height + k_TileSize - 1) / k_TileSize;
+
+    PyramidConstants constants{};
+    constants.m_DepthSize[0] = m_DepthExtent.width;
+    constants.m_DepthSize[1] = m_DepthExtent.height;
+    constants.m_BaseSize[0] = m_BaseExtent.width;
+    constants.m_BaseSize[1] = m_BaseExtent.height;
+    constants.m_MipCount = m_MipCount;
+    constants.m_WorkgroupCount = groupsX * groupsY;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &m_DescriptorSets[frameIndex], 0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PyramidConstants), &constants);
+    vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+
+    // pyramid -> read by culling, depth -> back to an attachment
+    imageBarriers[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    imageBarriers[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    imageBarriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    imageBarriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    imageBarriers[1].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    imageBarriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+void lvk::DepthPyramid::Free(VkState& vk)
+{
+    vkDestroyPipeline(vk.m_LogicalDevice, m_Pipeline, nullptr);
+    vkDestroyPipelineLayout(vk.m_LogicalDevice, m_PipelineLayout, nullptr);
+    textures::FreeImageSampler(vk, m_Sampler);
+
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        for (uint32_t mip = 0; mip < m_MipCount; mip++)
+        {
+            vkDestroyImageView(vk.m_LogicalDevice, m_MipViews[i][mip], nullptr);
+        }
+        vkDestroyImageView(vk.m_LogicalDevice, m_ImageViews[i], nullptr);
+        vkDestroyImage(vk.m_LogicalDevice, m_Images[i], nullptr);
+        vkFreeMemory(vk.m_LogicalDevice, m_Memory[i], nullptr);
+
+        vkDestroyBuffer(vk.m_LogicalDevice, m_CounterBuffers[i], nullptr);
+        vmaFreeMemory(vk.m_Allocator, m_CounterAllocations[i]);
+    }
+
+    for (auto& stage : m_Program.m_Stages)
+    {
+        vkDestroyShaderModule(vk.m_LogicalDevice, stage.m_Module, nullptr);
+    }
+    m_Program.Free(vk);
+}
@@ -1,6 +1,7 @@
 #include "lvk/Descriptor.h"
 #include "lvk/Macros.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 
 namespace lvk
 {
@@ -19,23 +20,23 @@ std::vector<VkDescriptorSetLayoutBinding> CleanDescriptorSetLayout(std::vector<V
       continue;
     }
 
-    int start = static_cast<int>(clean.size() - 1);
-    for (int i = start; i >= 0; i--)
+    // a binding shared by several stages is merged into one entry with every stage's flag
+    bool merged = false;
+    for (auto& newLayoutSet : clean)
     {
-      auto& newLayoutSet = clean[i];
-      if (newLayoutSet.binding == layoutSetData.binding)
+      if (newLayoutSet.binding == layoutSetData.binding &&
+          newLayoutSet.descriptorCount == layoutSetData.descriptorCount &&
+          newLayoutSet.descriptorType == layoutSetData.descriptorType)
       {
-        if (newLayoutSet.descriptorCount == layoutSetData.descriptorCount &&
-            newLayoutSet.descriptorType == layoutSetData.descriptorType)
-        {
-          newLayoutSet.stageFlags = layoutSetData.stageFlags + newLayoutSet.stageFlags;
-          continue;
-        }
+        newLayoutSet.stageFlags |= layoutSetData.stageFlags;
+        merged = true;
+        break;
       }
+    }
 
+    if (!merged)
+    {
       clean.push_back(layoutSetData);
-      break;
-
     }
   }
 
@@ -52,6 +53,10 @@ ShaderBindingType GetBindingType(const SpvReflectDescriptorBinding& binding)
   {
     return ShaderBindingType::ShaderStorageBuffer;
   }
+  if (binding.descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+  {
+    return ShaderBindingType::StorageImage;
+  }
   if (binding.descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLER ||
       binding.descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
   {
@@ -269,27 +274,25 @@ ReflectDescriptorSetLayoutsRaw(VkState &vk, const char *stage_bin,
       layoutBinding.stageFlags = static_cast<VkShaderStageFlagBits>(shaderReflectModule.shader_stage);
 
       ShaderBindingType bufferType = GetBindingType(reflectedBinding);
-      DescriptorSetLayoutBindingData binding{ String(reflectedBinding.name), reflectedBinding.binding, reflectedBinding.block.size , bufferType};
+      DescriptorSetLayoutBindingData binding{ String(reflectedBinding.name), reflectedBinding.binding, reflectedBinding.block.size , bufferType, {}, 0};
 
       if (bufferType == ShaderBindingType::ShaderStorageBuffer)
       {
-        uint32_t requiredBufferSize = 0;
-        for (uint32_t i = 0; i < reflectedBinding.type_description->member_count; i++)
+        // a trailing runtime array has no size in the binary, record the fixed part
+        // and the element stride, the buffer is sized when the element count is known
+        uint32_t fixedSize = 0;
+        for (uint32_t i = 0; i < reflectedBinding.block.member_count; i++)
         {
-          auto* member = &reflectedBinding.type_description->members[i];
-          if (member->type_flags & SPV_REFLECT_TYPE_FLAG_ARRAY)
-          {
-            requiredBufferSize += member->traits.array.dims[0] * member->traits.array.stride; // todo: support more than 1D arrays
-          }
-
-          for (uint32_t j = 0; j < member->member_count; j++)
+          const auto& member = reflectedBinding.block.members[i];
+          if (member.array.dims_count > 0 && member.array.dims[0] == SPV_REFLECT_ARRAY_DIM_RUNTIME)
           {
-            auto* childMember = &member->members[i];
-            int jkj = 420;
+            binding.m_RuntimeArrayStride = member.array.stride;
+            fixedSize = member.offset;
+            break;
           }
+          fixedSize = std::max(fixedSize, member.offset + member.padded_size);
         }
-        binding.m_ExpectedBufferSize = requiredBufferSize;
-        continue;
+        binding.m_ExpectedBufferSize = fixedSize;
       }
 
       for (uint32_t i = 0; i < reflectedBinding.block.member_count; i++)
@@ -0,0 +1,293 @@
+#include "lvk/GeometryPool.h"
+#include "lvk/Buffer.h"
+#include "lvk/Commands.h"
+#include "volk.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+// widens or narrows while copying, for sources whose index size differs from the pool's
+static void write_indices(void* dst, uint32_t dstIndexSize, const void* src, uint32_t srcIndexSize, uint32_t count)
+{
+    if (dstIndexSize == srcIndexSize)
+    {
+        memcpy(dst, src, size_t{ dstIndexSize } * count);
+    }
+    else if (dstIndexSize == sizeof(uint16_t))
+    {
+        const uint32_t* in = static_cast<const uint32_t*>(src);
+        uint16_t* out = static_cast<uint16_t*>(dst);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            out[i] = static_cast<uint16_t>(in[i]);
+        }
+    }
+    else
+    {
+        const uint16_t* in = static_cast<const uint16_t*>(src);
+        uint32_t* out = static_cast<uint32_t*>(dst);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            out[i] = in[i];
+        }
+    }
+}
+
+void lvk::FreeListAllocator::Init(uint32_t capacity)
+{
+    m_FreeBlocks.clear();
+    m_Capacity = capacity;
+    m_FreeCount = capacity;
+    if (capacity > 0)
+    {
+        m_FreeBlocks[0] = capacity;
+    }
+}
+
+bool lvk::FreeListAllocator::Allocate(uint32_t count, uint32_t& offset)
+{
+    if (count == 0)
+    {
+        offset = 0;
+        return true;
+    }
+
+    for (auto it = m_FreeBlocks.begin(); it != m_FreeBlocks.end(); ++it)
+    {
+        if (it->second < count)
+        {
+            continue;
+        }
+
+        offset = it->first;
+        uint32_t remaining = it->second - count;
+        m_FreeBlocks.erase(it);
+        if (remaining > 0)
+        {
+            m_FreeBlocks[offset + count] = remaining;
+        }
+        m_FreeCount -= count;
+        return true;
+    }
+    return false;
+}
+
+void lvk::FreeListAllocator::Free(uint32_t offset, uint32_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto next = m_FreeBlocks.lower_bound(offset);
+    if (next != m_FreeBlocks.end() && next->first < offset + count)
+    {
+        spdlog::error("FreeListAllocator : block at {} ({} elements) overlaps a free block, was it freed twice?", offset, count);
+        return;
+    }
+
+    uint32_t blockOffset = offset;
+    uint32_t blockCount = count;
+
+    // merge with the block before
+    if (next != m_FreeBlocks.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            blockOffset = prev->first;
+            blockCount += prev->second;
+            m_FreeBlocks.erase(prev);
+        }
+    }
+
+    // and the block after
+    if (next != m_FreeBlocks.end() && next->first == offset + count)
+    {
+        blockCount += next->second;
+        m_FreeBlocks.erase(next);
+    }
+
+    m_FreeBlocks[blockOffset] = blockCount;
+    m_FreeCount += count;
+}
+
+uint32_t lvk::FreeListAllocator::GetLargestFreeBlock() const
+{
+    uint32_t largest = 0;
+    for (const auto& block : m_FreeBlocks)
+    {
+        largest = std::max(largest, block.second);
+    }
+    return largest;
+}
+
+lvk::GeometryPool lvk::GeometryPool::Create(VkState& vk, uint32_t vertexStride, uint32_t maxVertices, uint32_t maxIndices, VkIndexType indexType)
+{
+    GeometryPool pool{};
+    pool.m_VertexStride = vertexStride;
+    pool.m_IndexType = indexType;
+    pool.m_VertexAllocator.Init(maxVertices);
+    pool.m_IndexAllocator.Init(maxIndices);
+
+    buffers::CreateBuffer(vk, VkDeviceSize{ vertexStride } * maxVertices,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, pool.m_VertexBuffer, pool.m_VertexBufferMemory);
+    buffers::CreateBuffer(vk, VkDeviceSize{ buffers::GetIndexSize(indexType) } * maxIndices,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, pool.m_IndexBuffer, pool.m_IndexBufferMemory);
+
+    return pool;
+}
+
+bool lvk::GeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount, PooledMesh& mesh)
+{
+    if (m_IndexType == VK_INDEX_TYPE_UINT16 && buffers::SelectIndexType(vertexCount) != VK_INDEX_TYPE_UINT16)
+    {
+        spdlog::error("GeometryPool : {} vertices cannot be addressed by the pool's 16 bit indices", vertexCount);
+        return false;
+    }
+
+    uint32_t vertexOffset = 0;
+    if (!m_VertexAllocator.Allocate(vertexCount, vertexOffset))
+    {
+        spdlog::error("GeometryPool : no room for {} vertices, {} of {} free, largest block {}",
+            vertexCount, m_VertexAllocator.GetFreeCount(), m_VertexAllocator.GetCapacity(), m_VertexAllocator.GetLargestFreeBlock());
+        return false;
+    }
+
+    uint32_t firstIndex = 0;
+    if (!m_IndexAllocator.Allocate(indexCount, firstIndex))
+    {
+        spdlog::error("GeometryPool : no room for {} indices, {} of {} free, largest block {}",
+            indexCount, m_IndexAllocator.GetFreeCount(), m_IndexAllocator.GetCapacity(), m_IndexAllocator.GetLargestFreeBlock());
+        m_VertexAllocator.Free(vertexOffset, vertexCount);
+        return false;
+    }
+
+    mesh.m_VertexOffset = static_cast<int32_t>(vertexOffset);
+    mesh.m_VertexCount = vertexCount;
+    mesh.m_FirstIndex = firstIndex;
+    mesh.m_IndexCount = indexCount;
+    return true;
+}
+
+void lvk::GeometryPool::Upload(VkState& vk, const PooledMesh& mesh, const void* vertices, const uint32_t* indices)
+{
+    Vector<PoolUpload> uploads{ { mesh, vertices, indices, sizeof(uint32_t) } };
+    UploadBatch(vk, uploads);
+}
+
+void lvk::GeometryPool::UploadBatch(VkState& vk, const Vector<PoolUpload>& uploads)
+{
+    uint32_t indexSize = buffers::GetIndexSize(m_IndexType);
+
+    VkDeviceSize stagingSize = 0;
+    for (const PoolUpload& upload : uploads)
+    {
+        stagingSize += VkDeviceSize{ m_VertexStride } * upload.m_Mesh.m_VertexCount;
+        stagingSize += VkDeviceSize{ indexSize } * upload.m_Mesh.m_IndexCount;
+    }
+    if (stagingSize == 0)
+    {
+        return;
+    }
+
+    VkBuffer stagingBuffer;
+    VmaAllocation stagingBufferMemory;
+    buffers::CreateBuffer(vk, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer, stagingBufferMemory);
+
+    Vector<VkBufferCopy> vertexCopies;
+    Vector<VkBufferCopy> indexCopies;
+    vertexCopies.reserve(uploads.size());
+    indexCopies.reserve(uploads.size());
+
+    void* data;
+    vmaMapMemory(vk.m_Allocator, stagingBufferMemory, &data);
+    VkDeviceSize stagingOffset = 0;
+    for (const PoolUpload& upload : uploads)
+    {
+        const PooledMesh& mesh = upload.m_Mesh;
+        VkDeviceSize vertexSize = VkDeviceSize{ m_VertexStride } * mesh.m_VertexCount;
+        VkDeviceSize meshIndexSize = VkDeviceSize{ indexSize } * mesh.m_IndexCount;
+
+        if (vertexSize > 0)
+        {
+            memcpy(static_cast<char*>(data) + stagingOffset, upload.m_Vertices, vertexSize);
+
+            VkBufferCopy vertexCopy{};
+            vertexCopy.srcOffset = stagingOffset;
+            vertexCopy.dstOffset = VkDeviceSize{ m_VertexStride } * static_cast<uint32_t>(mesh.m_VertexOffset);
+            vertexCopy.size = vertexSize;
+            vertexCopies.push_back(vertexCopy);
+            stagingOffset += vertexSize;
+        }
+
+        if (meshIndexSize > 0)
+        {
+            write_indices(static_cast<char*>(data) + stagingOffset, indexSize, upload.m_Indices, upload.m_IndexSize, mesh.m_IndexCount);
+
+            VkBufferCopy indexCopy{};
+            indexCopy.srcOffset = stagingOffset;
+            indexCopy.dstOffset = VkDeviceSize{ indexSize } * mesh.m_FirstIndex;
+            indexCopy.size = meshIndexSize;
+            indexCopies.push_back(indexCopy);
+            stagingOffset += meshIndexSize;
+        }
+    }
+    vmaUnmapMemory(vk.m_Allocator, stagingBufferMemory);
+
+    VkCommandBuffer commandBuffer = commands::BeginSingleTimeCommands(vk);
+    if (!vertexCopies.empty())
+    {
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, m_VertexBuffer, static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+    }
+    if (!indexCopies.empty())
+    {
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, m_IndexBuffer, static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+    }
+    commands::EndSingleTimeCommands(vk, commandBuffer);
+
+    vkDestroyBuffer(vk.m_LogicalDevice, stagingBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, stagingBufferMemory);
+}
+
+bool lvk::GeometryPool::AddMesh(VkState& vk, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, PooledMesh& mesh)
+{
+    if (!Allocate(vertexCount, indexCount, mesh))
+    {
+        return false;
+    }
+    Upload(vk, mesh, vertices, indices);
+    return true;
+}
+
+void lvk::GeometryPool::FreeMesh(PooledMesh& mesh)
+{
+    m_VertexAllocator.Free(static_cast<uint32_t>(mesh.m_VertexOffset), mesh.m_VertexCount);
+    m_IndexAllocator.Free(mesh.m_FirstIndex, mesh.m_IndexCount);
+    mesh = PooledMesh{};
+}
+
+void lvk::GeometryPool::Bind(VkCommandBuffer& commandBuffer)
+{
+    VkBuffer vertexBuffers[]{ m_VertexBuffer };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer, 0, m_IndexType);
+}
+
+void lvk::GeometryPool::Draw(VkCommandBuffer& commandBuffer, const PooledMesh& mesh, uint32_t instanceCount, uint32_t firstInstance)
+{
+    vkCmdDrawIndexed(commandBuffer, mesh.m_IndexCount, instanceCount, mesh.m_FirstIndex, mesh.m_VertexOffset, firstInstance);
+}
+
+void lvk::GeometryPool::Free(VkState& vk)
+{
+    vkDestroyBuffer(vk.m_LogicalDevice, m_VertexBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, m_VertexBufferMemory);
+    vkDestroyBuffer(vk.m_LogicalDevice, m_IndexBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, m_IndexBufferMemory);
+}
@@ -0,0 +1,382 @@
+#include "lvk/GpuCulling.h"
+#include "lvk/Buffer.h"
+#include "lvk/DepthPyramid.h"
+#include "lvk/Pipeline.h"
+#include "spdlog/spdlog.h"
+#include "volk.h"
+#include <algorithm>
+
+static const char* k_CullInstanceGLSL = R"(
+struct CullInstance
+{
+    mat4 Model;
+    vec4 BoundsCentre;
+    vec4 BoundsExtent;
+    uint IndexCount;
+    uint FirstIndex;
+    int  VertexOffset;
+    uint DrawFirst;
+};
+)";
+
+static const char* k_GpuCullGLSL = R"(
+layout(local_size_x = 64) in;
+
+struct DrawIndexedCommand
+{
+    uint IndexCount;
+    uint InstanceCount;
+    uint FirstIndex;
+    int  VertexOffset;
+    uint FirstInstance;
+};
+
+layout(std430, set = 0, binding = 1) writeonly buffer CullDrawCommands { DrawIndexedCommand commands[]; } cullDrawCommands;
+// one counter per draw group, indexed by the group's first slot
+layout(std430, set = 0, binding = 2) buffer CullDrawCount { uint counts[]; } cullDrawCount;
+
+layout(push_constant) uniform CullConstants
+{
+    vec4 planes[6];
+    uint instanceCount;
+    uint compact;
+} cullConstants;
+
+#ifdef CULL_OCCLUSION
+layout(set = 0, binding = 3) uniform sampler2D depthPyramid;
+layout(std430, set = 0, binding = 4) readonly buffer CullOcclusion
+{
+    mat4 viewProj;
+    vec4 pyramidInfo;
+} cullOcclusion;
+
+// the box is hidden if its nearest depth is behind the farthest pyramid depth over its screen rect.
+// the mip is picked so the rect covers at most 2x2 texels
+bool Cull_IsOccluded(vec3 centre, vec3 extent)
+{
+    vec3 rectMin = vec3(1.0);
+    vec3 rectMax = vec3(0.0);
+    for (int i = 0; i < 8; i++)
+    {
+        vec3 corner = centre + extent * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = cullOcclusion.viewProj * vec4(corner, 1.0);
+        if (clip.w <= 0.0)
+        {
+            // crosses the camera plane, treat as visible
+            return false;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        vec3 p = vec3(ndc.xy * 0.5 + 0.5, ndc.z);
+        rectMin = min(rectMin, p);
+        rectMax = max(rectMax, p);
+    }
+    rectMin.xy = clamp(rectMin.xy, 0.0, 1.0);
+    rectMax.xy = clamp(rectMax.xy, 0.0, 1.0);
+
+    vec2 baseSize = cullOcclusion.pyramidInfo.xy;
+    vec2 footprint = (rectMax.xy - rectMin.xy) * baseSize;
+    int mip = int(min(ceil(log2(max(max(footprint.x, footprint.y), 1.0))), cullOcclusion.pyramidInfo.z - 1.0));
+
+    ivec2 mipSize = max(ivec2(baseSize) >> mip, ivec2(1));
+    ivec2 t0 = clamp(ivec2(rectMin.xy * vec2(mipSize)), ivec2(0), mipSize - 1);
+    ivec2 t1 = clamp(ivec2(rectMax.xy * vec2(mipSize)), ivec2(0), mipSize - 1);
+
+    float farthest = max(
+        max(texelFetch(depthPyramid, t0, mip).r, texelFetch(depthPyramid, ivec2(t1.x, t0.y), mip).r),
+        max(texelFetch(depthPyramid, ivec2(t0.x, t1.y), mip).r, texelFetch(depthPyramid, t1, mip).r));
+    return rectMin.z > farthest;
+}
+#endif
+
+void main()
+{
+    uint instanceIndex = gl_GlobalInvocationID.x;
+    if (instanceIndex >= cullConstants.instanceCount)
+    {
+        return;
+    }
+
+    CullInstance instance = cullInstances.instances[instanceIndex];
+
+    // world bounds with Arvo's method, centre by the full transform and extent by |upper 3x3|
+    vec3 centre = (instance.Model * vec4(instance.BoundsCentre.xyz, 1.0)).xyz;
+    mat3 absModel = mat3(abs(instance.Model[0].xyz), abs(instance.Model[1].xyz), abs(instance.Model[2].xyz));
+    vec3 extent = absModel * instance.BoundsExtent.xyz;
+
+    bool visible = true;
+    for (int i = 0; i < 6; i++)
+    {
+        vec4 plane = cullConstants.planes[i];
+        float dist = dot(plane.xyz, centre) + plane.w;
+        float radius = dot(abs(plane.xyz), extent);
+        visible = visible && dist + radius >= 0.0;
+    }
+
+#ifdef CULL_OCCLUSION
+    visible = visible && !Cull_IsOccluded(centre, extent);
+#endif
+
+    DrawIndexedCommand command;
+    command.IndexCount = instance.IndexCount;
+    command.InstanceCount = 1;
+    command.FirstIndex = instance.FirstIndex;
+    command.VertexOffset = instance.VertexOffset;
+    command.FirstInstance = instanceIndex;
+
+    if (cullConstants.compact != 0)
+    {
+        if (visible)
+        {
+            uint group = instance.DrawFirst;
+            cullDrawCommands.commands[group + atomicAdd(cullDrawCount.counts[group], 1)] = command;
+        }
+    }
+    else
+    {
+        command.InstanceCount = visible ? 1 : 0;
+        cullDrawCommands.commands[instanceIndex] = command;
+    }
+}
+)";
+
+// matches the CullConstants push constant block
+struct CullConstants
+{
+    glm::vec4   m_Planes[lvk::culling::Frustum::PlaneCount];
+    uint32_t    m_InstanceCount;
+    uint32_t    m_Compact;
+};
+
+// matches the CullOcclusion buffer
+struct CullOcclusion
+{
+    glm::mat4   m_ViewProj;
+    glm::vec4   m_PyramidInfo;
+};
+
+static lvk::String cull_instances_glsl(uint32_t set, uint32_t binding)
+{
+    return lvk::String(k_CullInstanceGLSL) +
+        "layout(std430, set = " + std::to_string(set) + ", binding = " + std::to_string(binding) + ") " +
+        "readonly buffer CullInstances { CullInstance instances[]; } cullInstances;\n";
+}
+
+lvk::GpuCulling lvk::GpuCulling::Create(VkState& vk, uint32_t maxInstances, DepthPyramid* depthPyramid)
+{
+    GpuCulling gc{};
+    gc.m_MaxInstances = std::max(maxInstances, 1u);
+    gc.m_UseDrawCount = vk.m_DeviceFeatures.m_DrawIndirectCount;
+    gc.m_UseMultiDraw = vk.m_DeviceFeatures.m_MultiDrawIndirect;
+
+    if (!vk.m_DeviceFeatures.m_DrawIndirectFirstInstance)
+    {
+        spdlog::warn("GpuCulling : drawIndirectFirstInstance is not supported, gl_InstanceIndex will not identify instances");
+    }
+
+    gc.m_UseOcclusion = depthPyramid != nullptr;
+    String source = "#version 450\n";
+    if (gc.m_UseOcclusion)
+    {
+        source += "#define CULL_OCCLUSION\n";
+    }
+    source += cull_instances_glsl(0, 0) + k_GpuCullGLSL;
+    ShaderStage stage = ShaderStage::CreateFromSource(vk, source, ShaderStageType::Compute);
+    gc.m_Program = ShaderProgram::CreateCompute(vk, stage);
+    gc.m_Material = Material::Create(vk, gc.m_Program);
+    gc.m_Pipeline = pipelines::CreateComputePipeline(vk, stage.m_StageBinary, gc.m_Program.m_DescriptorSetLayout, gc.m_PipelineLayout);
+
+    gc.m_Material.CreateStorageBuffer(vk, "cullInstances", gc.m_MaxInstances, Material::StorageBufferMemory::HostVisible);
+
+    VkDeviceSize commandsSize = VkDeviceSize{ gc.m_MaxInstances } * sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize countsSize = VkDeviceSize{ gc.m_MaxInstances } * sizeof(uint32_t);
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        buffers::CreateBuffer(vk, commandsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, gc.m_DrawCommandBuffers[i], gc.m_DrawCommandAllocations[i]);
+        buffers::CreateBuffer(vk, countsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, gc.m_DrawCountBuffers[i], gc.m_DrawCountAllocations[i]);
+    }
+
+    gc.m_Material.SetStorageBuffer(vk, "cullDrawCommands", gc.m_DrawCommandBuffers, commandsSize);
+    gc.m_Material.SetStorageBuffer(vk, "cullDrawCount", gc.m_DrawCountBuffers, countsSize);
+
+    if (gc.m_UseOcclusion)
+    {
+        // each frame reads the pyramid built by the frame before it
+        Array<VkImageView, MAX_FRAMES_IN_FLIGHT> previousPyramids;
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            previousPyramids[i] = depthPyramid->m_ImageViews[(i + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT];
+        }
+        gc.m_Material.SetSampler(vk, "depthPyramid", previousPyramids, depthPyramid->m_Sampler, VK_IMAGE_LAYOUT_GENERAL);
+
+        gc.m_PyramidInfo = glm::vec4(float(depthPyramid->m_BaseExtent.width), float(depthPyramid->m_BaseExtent.height), float(depthPyramid->m_MipCount), 0.0f);
+
+        // until a view projection is set every box lands behind the camera and passes
+        CullOcclusion occlusion{ glm::mat4(0.0f), gc.m_PyramidInfo };
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            gc.m_Material.WriteStorageBuffer(vk, i, "cullOcclusion", &occlusion, sizeof(CullOcclusion));
+        }
+    }
+
+    return gc;
+}
+
+void lvk::GpuCulling::SetInstances(VkState& vk, uint32_t frameIndex, const Instance* instances, uint32_t instanceCount)
+{
+    if (instanceCount > m_MaxInstances)
+    {
+        spdlog::warn("GpuCulling : {} instances exceed the capacity of {}, clamping", instanceCount, m_MaxInstances);
+        instanceCount = m_MaxInstances;
+    }
+
+    if (instanceCount > 0)
+    {
+        m_Material.WriteStorageBuffer(vk, frameIndex, "cullInstances", instances, sizeof(Instance) * instanceCount);
+    }
+    m_InstanceCounts[frameIndex] = instanceCount;
+}
+
+void lvk::GpuCulling::Dispatch(VkCommandBuffer& commandBuffer, uint32_t frameIndex, const culling::Frustum& frustum)
+{
+    uint32_t instanceCount = m_InstanceCounts[frameIndex];
+
+    vkCmdFillBuffer(commandBuffer, m_DrawCountBuffers[frameIndex], 0, VK_WHOLE_SIZE, 0);
+
+    // the previous use of these buffers was as indirect arguments
+    Array<VkBufferMemoryBarrier, 2> preBarriers{};
+    VkBuffer outputs[] = { m_DrawCountBuffers[frameIndex], m_DrawCommandBuffers[frameIndex] };
+    for (size_t i = 0; i < preBarriers.size(); i++)
+    {
+        preBarriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        preBarriers[i].srcAccessMask = i == 0 ? VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        preBarriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        preBarriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        preBarriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        preBarriers[i].buffer = outputs[i];
+        preBarriers[i].offset = 0;
+        preBarriers[i].size = VK_WHOLE_SIZE;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, static_cast<uint32_t>(preBarriers.size()), preBarriers.data(), 0, nullptr);
+
+    CullConstants constants{};
+    for (int i = 0; i < culling::Frustum::PlaneCount; i++)
+    {
+        constants.m_Planes[i] = frustum.m_Planes[i];
+    }
+    constants.m_InstanceCount = instanceCount;
+    constants.m_Compact = m_UseDrawCount ? 1 : 0;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1,
+        &m_Material.m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &constants);
+    vkCmdDispatch(commandBuffer, (instanceCount + k_InstancesPerWorkgroup - 1) / k_InstancesPerWorkgroup, 1, 1);
+
+    Array<VkBufferMemoryBarrier, 2> postBarriers = preBarriers;
+    for (auto& barrier : postBarriers)
+    {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0, 0, nullptr, static_cast<uint32_t>(postBarriers.size()), postBarriers.data(), 0, nullptr);
+}
+
+void lvk::GpuCulling::Draw(VkCommandBuffer& commandBuffer, uint32_t frameIndex)
+{
+    DrawGroup(commandBuffer, frameIndex, 0, m_InstanceCounts[frameIndex]);
+}
+
+void lvk::GpuCulling::DrawGroup(VkCommandBuffer& commandBuffer, uint32_t frameIndex, uint32_t firstInstance, uint32_t instanceCount)
+{
+    constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+    instanceCount = std::min(instanceCount, m_InstanceCounts[frameIndex] - std::min(firstInstance, m_InstanceCounts[frameIndex]));
+    if (instanceCount == 0)
+    {
+        return;
+    }
+
+    VkDeviceSize commandOffset = VkDeviceSize{ firstInstance } * stride;
+    if (m_UseDrawCount)
+    {
+        vkCmdDrawIndexedIndirectCount(commandBuffer, m_DrawCommandBuffers[frameIndex], commandOffset,
+            m_DrawCountBuffers[frameIndex], VkDeviceSize{ firstInstance } * sizeof(uint32_t), instanceCount, stride);
+    }
+    else if (m_UseMultiDraw)
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, m_DrawCommandBuffers[frameIndex], commandOffset, instanceCount, stride);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < instanceCount; i++)
+        {
+            vkCmdDrawIndexedIndirect(commandBuffer, m_DrawCommandBuffers[frameIndex], commandOffset + VkDeviceSize{ i } * stride, 1, stride);
+        }
+    }
+}
+
+void lvk::GpuCulling::SetOcclusionViewProj(VkState& vk, uint32_t frameIndex, const glm::mat4& viewProj)
+{
+    if (!m_UseOcclusion)
+    {
+        return;
+    }
+
+    CullOcclusion occlusion{ viewProj, m_PyramidInfo };
+    m_Material.WriteStorageBuffer(vk, frameIndex, "cullOcclusion", &occlusion, sizeof(CullOcclusion));
+}
+
+bool lvk::GpuCulling::BindInstanceBuffer(VkState& vk, Material& material)
+{
+    const auto& instances = m_Material.m_StorageBuffers.at("cullInstances");
+    if (!material.SetStorageBuffer(vk, "cullInstances", instances.m_Buffers, instances.m_Size))
+    {
+        spdlog::error("GpuCulling : material does not declare cullInstances, was the shader built with InsertInstanceGLSL?");
+        return false;
+    }
+    return true;
+}
+
+lvk::String lvk::GpuCulling::InsertInstanceGLSL(const String& source, uint32_t set, uint32_t binding)
+{
+    String declarations = cull_instances_glsl(set, binding);
+
+    size_t version = source.find("#version");
+    if (version == String::npos)
+    {
+        return declarations + source;
+    }
+
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == String::npos)
+    {
+        return source + "\n" + declarations;
+    }
+    return source.substr(0, lineEnd + 1) + declarations + source.substr(lineEnd + 1);
+}
+
+void lvk::GpuCulling::Free(VkState& vk)
+{
+    vkDestroyPipeline(vk.m_LogicalDevice, m_Pipeline, nullptr);
+    vkDestroyPipelineLayout(vk.m_LogicalDevice, m_PipelineLayout, nullptr);
+
+    m_Material.Free(vk);
+
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        vkDestroyBuffer(vk.m_LogicalDevice, m_DrawCommandBuffers[i], nullptr);
+        vmaFreeMemory(vk.m_Allocator, m_DrawCommandAllocations[i]);
+        vkDestroyBuffer(vk.m_LogicalDevice, m_DrawCountBuffers[i], nullptr);
+        vmaFreeMemory(vk.m_Allocator, m_DrawCountAllocations[i]);
+    }
+
+    for (auto& stage : m_Program.m_Stages)
+    {
+        vkDestroyShaderModule(vk.m_LogicalDevice, stage.m_Module, nullptr);
+    }
+    m_Program.Free(vk);
+}
@@ -2,8 +2,14 @@
 #define VMA_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #include "ThirdParty/stb_image.h"
+// images are decoded on worker threads (see TextureLoader), stb_image has to keep its error and
+// vertical flip state per thread for that
+#if defined(STBI_NO_THREAD_LOCALS) || !defined(STBI_THREAD_LOCAL)
+#error "stb_image needs thread local state, lvk decodes images concurrently"
+#endif
 #include "lvk/Init.h"
 #include "lvk/Macros.h"
+#include "lvk/MipGenerator.h"
 #include "lvk/RenderPass.h"
 #include "lvk/Texture.h"
 #include "lvk/Utils.h"
@@ -341,6 +347,8 @@ void lvk::init::CleanupVulkan(VkState& vk)
   CleanupSwapChain(vk);
 
   vk.m_DescriptorSetAllocator.Free(vk.m_LogicalDevice);
+  MipGenerator::FreeDefault(vk);
+  vk.m_SamplerCache.Free(vk.m_LogicalDevice);
 
   if (vk.m_UseValidation)
   {
@@ -527,14 +535,76 @@ void lvk::init::CreateLogicalDevice(VkState& vk)
   physicalDeviceFeatures.fillModeNonSolid = VK_TRUE;
   physicalDeviceFeatures.wideLines = VK_TRUE;
 
+  // indirect drawing features are optional, record what was enabled so callers can fall back
+  VkPhysicalDeviceProperties deviceProperties{};
+  vkGetPhysicalDeviceProperties(vk.m_PhysicalDevice, &deviceProperties);
+  VkPhysicalDeviceFeatures supportedFeatures{};
+  vkGetPhysicalDeviceFeatures(vk.m_PhysicalDevice, &supportedFeatures);
+
+  physicalDeviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+  physicalDeviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+  physicalDeviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+  physicalDeviceFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+
+  VkPhysicalDeviceVulkan12Features supportedVulkan12Features{};
+  supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  bool vulkan12 = deviceProperties.apiVersion >= VK_API_VERSION_1_2;
+  if (vulkan12)
+  {
+    VkPhysicalDeviceFeatures2 supportedFeatures2{};
+    supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures2.pNext = &supportedVulkan12Features;
+    vkGetPhysicalDeviceFeatures2(vk.m_PhysicalDevice, &supportedFeatures2);
+  }
+
+  VkPhysicalDeviceVulkan12Features vulkan12Features{};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vulkan12Features.drawIndirectCount = supportedVulkan12Features.drawIndirectCount;
+
+  vk.m_DeviceFeatures.m_DrawIndirectCount = vulkan12Features.drawIndirectCount == VK_TRUE;
+  vk.m_DeviceFeatures.m_MultiDrawIndirect = physicalDeviceFeatures.multiDrawIndirect == VK_TRUE;
+  vk.m_DeviceFeatures.m_DrawIndirectFirstInstance = physicalDeviceFeatures.drawIndirectFirstInstance == VK_TRUE;
+  vk.m_DeviceFeatures.m_TextureCompressionBC = physicalDeviceFeatures.textureCompressionBC == VK_TRUE;
+  vk.m_DeviceFeatures.m_TextureCompressionASTC = physicalDeviceFeatures.textureCompressionASTC_LDR == VK_TRUE;
+
+  // mesh shaders are optional as well, their SPIR-V 1.4 requirement is core from vulkan 1.2
+  std::vector<const char*> deviceExtensions = s_DeviceExtensions;
+  VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures{};
+  meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+  bool meshShaderExtension = false;
+  for (auto const& extension : GetDeviceAvailableExtensions(vk, vk.m_PhysicalDevice))
+  {
+    meshShaderExtension |= strcmp(extension.extensionName, VK_EXT_MESH_SHADER_EXTENSION_NAME) == 0;
+  }
+
+  if (vulkan12 && meshShaderExtension)
+  {
+    VkPhysicalDeviceMeshShaderFeaturesEXT supportedMeshShaderFeatures{};
+    supportedMeshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+    VkPhysicalDeviceFeatures2 supportedFeatures2{};
+    supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures2.pNext = &supportedMeshShaderFeatures;
+    vkGetPhysicalDeviceFeatures2(vk.m_PhysicalDevice, &supportedFeatures2);
+
+    if (supportedMeshShaderFeatures.taskShader && supportedMeshShaderFeatures.meshShader)
+    {
+      meshShaderFeatures.taskShader = VK_TRUE;
+      meshShaderFeatures.meshShader = VK_TRUE;
+      vulkan12Features.pNext = &meshShaderFeatures;
+      deviceExtensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+    }
+  }
+  vk.m_DeviceFeatures.m_MeshShader = meshShaderFeatures.meshShader == VK_TRUE;
+
   VkDeviceCreateInfo createInfo{};
   createInfo.sType                    = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext                    = vulkan12 ? &vulkan12Features : nullptr;
   createInfo.pQueueCreateInfos        = queueCreateInfos.data();
   createInfo.queueCreateInfoCount     = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pEnabledFeatures         = &physicalDeviceFeatures;
 
-  createInfo.enabledExtensionCount    = static_cast<uint32_t>(s_DeviceExtensions.size());
-  createInfo.ppEnabledExtensionNames  = s_DeviceExtensions.data();
+  createInfo.enabledExtensionCount    = static_cast<uint32_t>(deviceExtensions.size());
+  createInfo.ppEnabledExtensionNames  = deviceExtensions.data();
 
   if (vk.m_UseValidation)
   {
@@ -809,8 +879,10 @@ void lvk::init::CreateDescriptorSetAllocator(VkState& vk)
 {
   vk.m_DescriptorSetAllocator.Init(vk.m_LogicalDevice, MAX_FRAMES_IN_FLIGHT * 128, {
                                                                        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0.33f},
+                                                                       {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0.1f},
                                                                        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0.33f},
                                                                        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0.33f},
+                                                                       {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 0.15f},
                                                                    });
 }
 
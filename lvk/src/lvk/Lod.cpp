@@ -0,0 +1,575 @@
+#include "lvk/Lod.h"
+#include "lvk/MeshProcessing.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+// border edges pull harder than faces so open outlines keep their shape
+static constexpr double k_BorderWeight = 10.0;
+// below this a level is not worth its index range
+static constexpr size_t k_MinLodTriangles = 32;
+
+// symmetric 4x4 plane quadric, w is the accumulated weight so the error is a mean squared distance
+struct Quadric
+{
+    double a00 = 0.0, a11 = 0.0, a22 = 0.0;
+    double a10 = 0.0, a20 = 0.0, a21 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double w = 0.0;
+};
+
+// one collapse moving every vertex at position m_From onto position m_To
+struct Collapse
+{
+    uint32_t    m_From;
+    uint32_t    m_To;
+    uint32_t    m_FromVertex;   // any vertex at m_From, the start of its wedge ring
+    double      m_Cost;
+};
+
+enum class PositionKind : uint8_t
+{
+    Manifold,
+    Border,
+    Locked
+};
+
+static Quadric quadric_from_plane(const glm::vec3& normal, const glm::vec3& point, double weight)
+{
+    double nx = normal.x, ny = normal.y, nz = normal.z;
+    double d = -(nx * point.x + ny * point.y + nz * point.z);
+
+    Quadric q;
+    q.a00 = weight * nx * nx;
+    q.a11 = weight * ny * ny;
+    q.a22 = weight * nz * nz;
+    q.a10 = weight * ny * nx;
+    q.a20 = weight * nz * nx;
+    q.a21 = weight * nz * ny;
+    q.b0 = weight * nx * d;
+    q.b1 = weight * ny * d;
+    q.b2 = weight * nz * d;
+    q.c = weight * d * d;
+    q.w = weight;
+    return q;
+}
+
+static void quadric_add(Quadric& q, const Quadric& other)
+{
+    q.a00 += other.a00; q.a11 += other.a11; q.a22 += other.a22;
+    q.a10 += other.a10; q.a20 += other.a20; q.a21 += other.a21;
+    q.b0 += other.b0; q.b1 += other.b1; q.b2 += other.b2;
+    q.c += other.c;
+    q.w += other.w;
+}
+
+// squared distance of p to the planes of q and r, averaged by their weights
+static double quadric_error(const Quadric& q, const Quadric& r, const glm::vec3& p)
+{
+    double x = p.x, y = p.y, z = p.z;
+    double a00 = q.a00 + r.a00, a11 = q.a11 + r.a11, a22 = q.a22 + r.a22;
+    double a10 = q.a10 + r.a10, a20 = q.a20 + r.a20, a21 = q.a21 + r.a21;
+    double b0 = q.b0 + r.b0, b1 = q.b1 + r.b1, b2 = q.b2 + r.b2;
+    double w = q.w + r.w;
+
+    double error = a00 * x * x + a11 * y * y + a22 * z * z
+        + 2.0 * (a10 * x * y + a20 * x * z + a21 * y * z)
+        + 2.0 * (b0 * x + b1 * y + b2 * z)
+        + q.c + r.c;
+
+    return w > 0.0 ? std::fabs(error) / w : 0.0;
+}
+
+static glm::vec3 load_position(const float* positions, size_t positionStride, size_t vertex)
+{
+    const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * positionStride);
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+static uint64_t edge_key(uint32_t a, uint32_t b)
+{
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+// vertices with bitwise equal positions share a position id, wedgeNext links them into a ring
+static uint32_t weld_positions(const float* positions, size_t positionStride, size_t vertexCount,
+    lvk::Vector<uint32_t>& positionOf, lvk::Vector<glm::vec3>& points, lvk::Vector<uint32_t>& wedgeNext)
+{
+    lvk::Vector<glm::vec3> vertexPositions(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        vertexPositions[v] = load_position(positions, positionStride, v);
+    }
+
+    lvk::Vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    auto less = [&](uint32_t a, uint32_t b) {
+        const glm::vec3& pa = vertexPositions[a];
+        const glm::vec3& pb = vertexPositions[b];
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        return pa.z < pb.z;
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    positionOf.assign(vertexCount, 0);
+    wedgeNext.assign(vertexCount, 0);
+    points.clear();
+
+    size_t groupStart = 0;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        bool last = i + 1 == vertexCount || less(order[i], order[i + 1]);
+        if (!last)
+        {
+            continue;
+        }
+
+        uint32_t position = static_cast<uint32_t>(points.size());
+        points.push_back(vertexPositions[order[groupStart]]);
+        for (size_t j = groupStart; j <= i; j++)
+        {
+            positionOf[order[j]] = position;
+            wedgeNext[order[j]] = order[j == i ? groupStart : j + 1];
+        }
+        groupStart = i + 1;
+    }
+    return static_cast<uint32_t>(points.size());
+}
+
+// border positions sit on an edge used by one triangle, positions on edges used twice in the same
+// direction or by more than two triangles are non manifold and never move
+static void classify_positions(const lvk::Vector<uint32_t>& indices, const lvk::Vector<uint32_t>& positionOf,
+    uint32_t positionCount, lvk::Vector<PositionKind>& kinds)
+{
+    lvk::Vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        for (int e = 0; e < 3; e++)
+        {
+            uint32_t a = positionOf[indices[t + e]];
+            uint32_t b = positionOf[indices[t + (e + 1) % 3]];
+            edges.push_back(edge_key(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    kinds.assign(positionCount, PositionKind::Manifold);
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        uint32_t a = static_cast<uint32_t>(edges[i] >> 32);
+        uint32_t b = static_cast<uint32_t>(edges[i] & 0xffffffffu);
+
+        bool duplicate = (i > 0 && edges[i - 1] == edges[i]) || (i + 1 < edges.size() && edges[i + 1] == edges[i]);
+        if (duplicate)
+        {
+            kinds[a] = PositionKind::Locked;
+            kinds[b] = PositionKind::Locked;
+            continue;
+        }
+
+        if (!std::binary_search(edges.begin(), edges.end(), edge_key(b, a)))
+        {
+            if (kinds[a] != PositionKind::Locked) kinds[a] = PositionKind::Border;
+            if (kinds[b] != PositionKind::Locked) kinds[b] = PositionKind::Border;
+        }
+    }
+}
+
+static void fill_quadrics(const lvk::Vector<uint32_t>& indices, const lvk::Vector<uint32_t>& positionOf,
+    const lvk::Vector<glm::vec3>& points, lvk::Vector<Quadric>& quadrics)
+{
+    quadrics.assign(points.size(), Quadric{});
+
+    lvk::Vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        for (int e = 0; e < 3; e++)
+        {
+            edges.push_back(edge_key(positionOf[indices[t + e]], positionOf[indices[t + (e + 1) % 3]]));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        uint32_t p[3] = { positionOf[indices[t]], positionOf[indices[t + 1]], positionOf[indices[t + 2]] };
+        glm::vec3 normal = glm::cross(points[p[1]] - points[p[0]], points[p[2]] - points[p[0]]);
+        float doubleArea = glm::length(normal);
+        if (doubleArea == 0.0f)
+        {
+            continue;
+        }
+        normal = normal * (1.0f / doubleArea);
+
+        Quadric face = quadric_from_plane(normal, points[p[0]], doubleArea * 0.5);
+        for (int e = 0; e < 3; e++)
+        {
+            quadric_add(quadrics[p[e]], face);
+        }
+
+        for (int e = 0; e < 3; e++)
+        {
+            uint32_t a = p[e];
+            uint32_t b = p[(e + 1) % 3];
+            if (std::binary_search(edges.begin(), edges.end(), edge_key(b, a)))
+            {
+                continue;
+            }
+
+            // plane through the border edge, perpendicular to its triangle
+            glm::vec3 edge = points[b] - points[a];
+            glm::vec3 edgeNormal = glm::cross(edge, normal);
+            float edgeNormalLength = glm::length(edgeNormal);
+            if (edgeNormalLength == 0.0f)
+            {
+                continue;
+            }
+            edgeNormal = edgeNormal * (1.0f / edgeNormalLength);
+
+            Quadric border = quadric_from_plane(edgeNormal, points[a], glm::dot(edge, edge) * k_BorderWeight);
+            quadric_add(quadrics[a], border);
+            quadric_add(quadrics[b], border);
+        }
+    }
+}
+
+// vertex -> triangle lists in one flat array
+static void build_adjacency(const lvk::Vector<uint32_t>& indices, size_t vertexCount,
+    lvk::Vector<uint32_t>& offsets, lvk::Vector<uint32_t>& triangles)
+{
+    offsets.assign(vertexCount + 1, 0);
+    for (uint32_t index : indices)
+    {
+        offsets[index + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        offsets[v + 1] += offsets[v];
+    }
+
+    triangles.resize(indices.size());
+    lvk::Vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+}
+
+static bool is_degenerate(const uint32_t* triangle, const lvk::Vector<uint32_t>& positionOf)
+{
+    uint32_t a = positionOf[triangle[0]], b = positionOf[triangle[1]], c = positionOf[triangle[2]];
+    return a == b || b == c || a == c;
+}
+
+float lvk::lod::SimplifyMesh(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+    size_t vertexCount, size_t targetIndexCount, float targetError, Vector<uint32_t>& outIndices)
+{
+    outIndices.clear();
+    if (indices == nullptr || positions == nullptr || indexCount % 3 != 0)
+    {
+        return 0.0f;
+    }
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        if (indices[i] >= vertexCount)
+        {
+            outIndices.assign(indices, indices + indexCount);
+            return 0.0f;
+        }
+    }
+
+    Vector<uint32_t> positionOf;
+    Vector<glm::vec3> points;
+    Vector<uint32_t> wedgeNext;
+    uint32_t positionCount = weld_positions(positions, positionStride, vertexCount, positionOf, points, wedgeNext);
+
+    outIndices.reserve(indexCount);
+    for (size_t t = 0; t < indexCount; t += 3)
+    {
+        if (!is_degenerate(indices + t, positionOf))
+        {
+            outIndices.insert(outIndices.end(), indices + t, indices + t + 3);
+        }
+    }
+
+    Vector<PositionKind> kinds;
+    classify_positions(outIndices, positionOf, positionCount, kinds);
+
+    Vector<Quadric> quadrics;
+    fill_quadrics(outIndices, positionOf, points, quadrics);
+
+    double errorLimit = static_cast<double>(targetError) * static_cast<double>(targetError);
+    double maxError = 0.0;
+
+    Vector<uint32_t> adjacencyOffsets;
+    Vector<uint32_t> adjacencyTriangles;
+    Vector<Collapse> candidates;
+    Vector<uint8_t> positionLocked(positionCount);
+    Vector<uint32_t> vertexRemap(vertexCount);
+    Vector<uint32_t> wedgeTargets;
+
+    while (outIndices.size() > targetIndexCount)
+    {
+        build_adjacency(outIndices, vertexCount, adjacencyOffsets, adjacencyTriangles);
+
+        candidates.clear();
+        for (size_t t = 0; t < outIndices.size(); t += 3)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                uint32_t va = outIndices[t + e];
+                uint32_t vb = outIndices[t + (e + 1) % 3];
+                uint32_t a = positionOf[va];
+                uint32_t b = positionOf[vb];
+
+                // interior edges are seen from both of their triangles, keep one. border edges only have one
+                if (a > b && !(kinds[a] == PositionKind::Border && kinds[b] == PositionKind::Border))
+                {
+                    continue;
+                }
+
+                double cost = quadric_error(quadrics[a], quadrics[b], points[b]);
+                double reverseCost = quadric_error(quadrics[a], quadrics[b], points[a]);
+
+                bool forward = kinds[a] == PositionKind::Manifold || (kinds[a] == PositionKind::Border && kinds[b] == PositionKind::Border);
+                bool reverse = kinds[b] == PositionKind::Manifold || (kinds[b] == PositionKind::Border && kinds[a] == PositionKind::Border);
+                if (forward) candidates.push_back({ a, b, va, cost });
+                if (reverse) candidates.push_back({ b, a, vb, reverseCost });
+            }
+        }
+        if (candidates.empty())
+        {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& l, const Collapse& r) { return l.m_Cost < r.m_Cost; });
+
+        // cheap collapses first, costlier ones wait a pass so their cost reflects the cheap ones' result
+        double passLimit = candidates[candidates.size() / 3].m_Cost;
+
+        std::fill(positionLocked.begin(), positionLocked.end(), 0);
+        std::iota(vertexRemap.begin(), vertexRemap.end(), 0u);
+
+        size_t triangleCount = outIndices.size() / 3;
+        size_t targetTriangles = targetIndexCount / 3;
+        size_t collapses = 0;
+
+        for (const Collapse& collapse : candidates)
+        {
+            if (triangleCount <= targetTriangles || collapse.m_Cost > errorLimit)
+            {
+                break;
+            }
+            if (collapse.m_Cost > passLimit && collapses > 0)
+            {
+                break;
+            }
+            if (positionLocked[collapse.m_From] || positionLocked[collapse.m_To])
+            {
+                continue;
+            }
+
+            // every wedge of m_From needs an edge to a vertex at m_To so attribute seams move together,
+            // and no triangle left around m_From may flip
+            size_t shared = 0;
+            bool valid = true;
+            wedgeTargets.clear();
+
+            uint32_t wedge = collapse.m_FromVertex;
+            do
+            {
+                uint32_t target = UINT32_MAX;
+                for (uint32_t i = adjacencyOffsets[wedge]; valid && i < adjacencyOffsets[wedge + 1]; i++)
+                {
+                    const uint32_t* triangle = &outIndices[adjacencyTriangles[i] * 3];
+
+                    bool hasTarget = false;
+                    for (int e = 0; e < 3; e++)
+                    {
+                        if (positionOf[triangle[e]] == collapse.m_To)
+                        {
+                            target = target == UINT32_MAX ? triangle[e] : target;
+                            hasTarget = true;
+                        }
+                    }
+                    if (hasTarget)
+                    {
+                        shared++;
+                        continue;
+                    }
+
+                    glm::vec3 before[3];
+                    glm::vec3 after[3];
+                    for (int e = 0; e < 3; e++)
+                    {
+                        before[e] = points[positionOf[triangle[e]]];
+                        after[e] = triangle[e] == wedge ? points[collapse.m_To] : before[e];
+                    }
+                    glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    // rejects flips and triangles turning past ~75 degrees, which are usually about to fold
+                    valid = glm::dot(normalBefore, normalAfter) > 0.25f * glm::length(normalBefore) * glm::length(normalAfter);
+                }
+
+                bool referenced = adjacencyOffsets[wedge] != adjacencyOffsets[wedge + 1];
+                if (referenced && target == UINT32_MAX)
+                {
+                    valid = false;
+                }
+                wedgeTargets.push_back(target);
+                wedge = wedgeNext[wedge];
+            } while (valid && wedge != collapse.m_FromVertex);
+
+            // a border position may only slide along its border, over an edge with a single triangle
+            if (!valid || shared == 0 || shared > 2 || (kinds[collapse.m_From] == PositionKind::Border && shared != 1))
+            {
+                continue;
+            }
+
+            size_t target = 0;
+            wedge = collapse.m_FromVertex;
+            do
+            {
+                if (wedgeTargets[target] != UINT32_MAX)
+                {
+                    vertexRemap[wedge] = wedgeTargets[target];
+                }
+                for (uint32_t i = adjacencyOffsets[wedge]; i < adjacencyOffsets[wedge + 1]; i++)
+                {
+                    const uint32_t* triangle = &outIndices[adjacencyTriangles[i] * 3];
+                    for (int e = 0; e < 3; e++)
+                    {
+                        positionLocked[positionOf[triangle[e]]] = 1;
+                    }
+                }
+                target++;
+                wedge = wedgeNext[wedge];
+            } while (wedge != collapse.m_FromVertex);
+
+            positionLocked[collapse.m_From] = 1;
+            positionLocked[collapse.m_To] = 1;
+            quadric_add(quadrics[collapse.m_To], quadrics[collapse.m_From]);
+
+            maxError = std::max(maxError, collapse.m_Cost);
+            triangleCount -= shared;
+            collapses++;
+        }
+
+        if (collapses == 0)
+        {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t t = 0; t < outIndices.size(); t += 3)
+        {
+            uint32_t triangle[3] = { vertexRemap[outIndices[t]], vertexRemap[outIndices[t + 1]], vertexRemap[outIndices[t + 2]] };
+            if (!is_degenerate(triangle, positionOf))
+            {
+                outIndices[write++] = triangle[0];
+                outIndices[write++] = triangle[1];
+                outIndices[write++] = triangle[2];
+            }
+        }
+        outIndices.resize(write);
+    }
+
+    return static_cast<float>(std::sqrt(maxError));
+}
+
+void lvk::lod::BuildLodChain(Vector<uint32_t>& indices, const float* positions, size_t positionStride, size_t vertexCount,
+    Vector<LodLevel>& levels, uint32_t maxLevels, float reductionRatio)
+{
+    levels.clear();
+    levels.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+    if (positions == nullptr || indices.empty())
+    {
+        return;
+    }
+
+    Vector<uint32_t> source = indices;
+    Vector<uint32_t> simplified;
+    float error = 0.0f;
+
+    for (uint32_t level = 1; level < maxLevels; level++)
+    {
+        size_t targetIndexCount = static_cast<size_t>(static_cast<float>(source.size()) * reductionRatio) / 3 * 3;
+        if (targetIndexCount < k_MinLodTriangles * 3)
+        {
+            break;
+        }
+
+        // errors add up since every level is simplified from the one before
+        float levelError = SimplifyMesh(source.data(), source.size(), positions, positionStride, vertexCount,
+            targetIndexCount, FLT_MAX, simplified);
+        if (simplified.empty() || simplified.size() * 10 > source.size() * 9)
+        {
+            break;
+        }
+        error += levelError;
+
+        mesh_processing::OptimizeVertexCache(simplified.data(), simplified.size(), vertexCount);
+
+        levels.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error });
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        source.swap(simplified);
+    }
+}
+
+lvk::lod::LodSelector lvk::lod::LodSelector::Create(const glm::vec3& cameraPosition, float fovY, float viewportHeight, float maxPixelError)
+{
+    LodSelector selector{};
+    selector.m_CameraPosition = cameraPosition;
+    selector.m_ProjectionScale = viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+    selector.m_MaxPixelError = maxPixelError;
+    return selector;
+}
+
+uint32_t lvk::lod::LodSelector::Select(const Vector<LodLevel>& levels, const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& model) const
+{
+    if (levels.size() < 2)
+    {
+        return 0;
+    }
+
+    // bounding sphere of the box, scaled by the largest axis of the transform
+    float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    glm::vec3 centre = glm::vec3(model * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+    float radius = glm::length(localMax - localMin) * 0.5f * scale;
+
+    float distance = glm::length(centre - m_CameraPosition) - radius;
+    if (distance <= 0.0f)
+    {
+        return 0;
+    }
+
+    // pixels a local unit of error covers at the nearest point of the sphere
+    float pixelsPerUnit = scale * m_ProjectionScale / distance;
+    for (uint32_t level = static_cast<uint32_t>(levels.size()) - 1; level > 0; level--)
+    {
+        if (levels[level].m_Error * pixelsPerUnit <= m_MaxPixelError)
+        {
+            return level;
+        }
+    }
+    return 0;
+}
+
+float lvk::lod::LodSelector::ProjectedSize(const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& model) const
+{
+    float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    glm::vec3 centre = glm::vec3(model * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+    float radius = glm::length(localMax - localMin) * 0.5f * scale;
+
+    float distance = glm::length(centre - m_CameraPosition) - radius;
+    if (distance <= 0.0f)
+    {
+        return FLT_MAX;
+    }
+    return 2.0f * radius * m_ProjectionScale / distance;
+}
@@ -0,0 +1,133 @@
+#include "lvk/MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+lvk::MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+lvk::MappedFile& lvk::MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_Data = other.m_Data;
+        m_Size = other.m_Size;
+#ifdef _WIN32
+        m_FileHandle = other.m_FileHandle;
+        m_MappingHandle = other.m_MappingHandle;
+        other.m_FileHandle = nullptr;
+        other.m_MappingHandle = nullptr;
+#else
+        m_Descriptor = other.m_Descriptor;
+        other.m_Descriptor = -1;
+#endif
+        other.m_Data = nullptr;
+        other.m_Size = 0;
+    }
+    return *this;
+}
+
+lvk::MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool lvk::MappedFile::Open(const String& path)
+{
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_FileHandle = file;
+    m_MappingHandle = mapping;
+    m_Data = static_cast<const uint8_t*>(view);
+    m_Size = static_cast<size_t>(size.QuadPart);
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat info{};
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+    {
+        close(descriptor);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (view == MAP_FAILED)
+    {
+        close(descriptor);
+        return false;
+    }
+    // the streams are read front to back once, straight into staging memory
+    madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    madvise(view, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+
+    m_Descriptor = descriptor;
+    m_Data = static_cast<const uint8_t*>(view);
+    m_Size = static_cast<size_t>(info.st_size);
+#endif
+    return true;
+}
+
+void lvk::MappedFile::Close()
+{
+    if (m_Data == nullptr)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_Data);
+    CloseHandle(m_MappingHandle);
+    CloseHandle(m_FileHandle);
+    m_FileHandle = nullptr;
+    m_MappingHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(m_Data), m_Size);
+    close(m_Descriptor);
+    m_Descriptor = -1;
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+}
@@ -2,6 +2,8 @@
 #include "lvk/Shader.h"
 #include "lvk/Texture.h"
 #include "lvk/Buffer.h"
+#include "lvk/UniformRing.h"
+#include "spdlog/spdlog.h"
 #include "volk.h"
 
 static auto collect_uniform_data = [](lvk::ShaderStage& stage, lvk::Material &mat, lvk::VkState & vk)
@@ -29,8 +31,29 @@ static auto collect_uniform_data = [](lvk::ShaderStage& stage, lvk::Material &ma
                     continue;
                 }
 
+                if (bindingInfo.m_BufferType == ShaderBindingType::DynamicUniformBuffer)
+                {
+                    Material::DynamicBufferBindingData dbd{
+                        descriptorSetInfo.m_SetNumber,
+                        bindingInfo.m_BindingIndex,
+                        bindingInfo.m_ExpectedBufferSize
+                    };
+                    mat.m_DynamicUniformBuffers.emplace(bindingInfo.m_BindingName, dbd);
+                    continue;
+                }
+
                 if (bindingInfo.m_BufferType == ShaderBindingType::UniformBuffer)
                 {
+                    Material::SetBinding binding = {};
+                    binding.m_Set = descriptorSetInfo.m_SetNumber;
+                    binding.m_Binding = bindingInfo.m_BindingIndex;
+
+                    // block is shared with a previous stage
+                    if (mat.m_UniformBuffers.find(binding.m_Data) != mat.m_UniformBuffers.end())
+                    {
+                        continue;
+                    }
+
                     // if a uniform buffer
                     ShaderBufferFrameData uniform;
                     buffers::CreateUniformBuffers(vk, uniform, VkDeviceSize{ bindingInfo.m_ExpectedBufferSize });
@@ -39,20 +62,46 @@ static auto collect_uniform_data = [](lvk::ShaderStage& stage, lvk::Material &ma
                     {
                         String accessorName = bindingInfo.m_BindingName + "." + member.m_Name;
                         uint16_t arraySize = member.m_Stride > 0 ? (member.m_Size / member.m_Stride) : 0;
-                        Material::ShaderAccessorData data{ member.m_Size , member.m_Offset, member.m_Stride, arraySize, static_cast<uint32_t>(mat.m_UniformBuffers.size()) };
+                        Material::ShaderAccessorData data{ member.m_Size , member.m_Offset, member.m_Stride, arraySize, static_cast<uint32_t>(mat.m_MappedUniformBuffers.size()) };
                         mat.m_UniformBufferAccessors.emplace(accessorName, data);
                     }
 
-                    Material::SetBinding binding = {};
-                    binding.m_Set = descriptorSetInfo.m_SetNumber;
-                    binding.m_Binding = bindingInfo.m_BindingIndex;
+                    // flat table of mapped addresses, indexed by ShaderAccessorData::m_BufferIndex
+                    Array<uint8_t*, MAX_FRAMES_IN_FLIGHT> mapped{};
+                    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+                    {
+                        mapped[i] = static_cast<uint8_t*>(uniform.m_UniformBuffers[i].m_MappedAddr);
+                    }
+                    mat.m_MappedUniformBuffers.push_back(mapped);
+
+                    // everything starts dirty so the first flush uploads the whole block
+                    Material::UniformShadow shadow{};
+                    shadow.m_Data.resize(bindingInfo.m_ExpectedBufferSize, 0);
+                    uint32_t granuleCount = (bindingInfo.m_ExpectedBufferSize + Material::k_UniformGranuleSize - 1) / Material::k_UniformGranuleSize;
+                    for (auto& dirty : shadow.m_DirtyGranules)
+                    {
+                        dirty.resize((granuleCount + 63) / 64, 0);
+                    }
+                    mat.m_UniformShadows.push_back(shadow);
+                    mat.MarkUniformRangeDirty(static_cast<uint32_t>(mat.m_UniformShadows.size() - 1), 0, bindingInfo.m_ExpectedBufferSize);
 
                     mat.m_UniformBuffers.emplace(binding.m_Data,
-                        Material::ShaderBufferBindingData{ descriptorSetInfo.m_SetNumber, bindingInfo.m_BindingIndex, bindingInfo.m_ExpectedBufferSize,  uniform });
+                        Material::ShaderBufferBindingData{ descriptorSetInfo.m_SetNumber, bindingInfo.m_BindingIndex, bindingInfo.m_ExpectedBufferSize,  uniform, static_cast<uint32_t>(mat.m_MappedUniformBuffers.size() - 1) });
                 }
                 else if (bindingInfo.m_BufferType == ShaderBindingType::ShaderStorageBuffer)
                 {
-                    int k = 420; 
+                    if (mat.m_StorageBuffers.find(bindingInfo.m_BindingName) != mat.m_StorageBuffers.end())
+                    {
+                        continue;
+                    }
+
+                    Material::StorageBufferBindingData ssbo{};
+                    ssbo.m_SetNumber = descriptorSetInfo.m_SetNumber;
+                    ssbo.m_BindingNumber = bindingInfo.m_BindingIndex;
+                    ssbo.m_FixedSize = bindingInfo.m_ExpectedBufferSize;
+                    ssbo.m_ElementStride = bindingInfo.m_RuntimeArrayStride;
+                    ssbo.m_Memory = Material::StorageBufferMemory::HostVisible;
+                    mat.m_StorageBuffers.emplace(bindingInfo.m_BindingName, ssbo);
                 }
             }
         }
@@ -86,7 +135,7 @@ lvk::Material lvk::Material::Create(VkState & vk, ShaderProgram& shader)
         for (auto& [setBinding, bufferInfo] : mat.m_UniformBuffers)
         {
             VkDescriptorBufferInfo bufferWriteInfo{};
-            bufferWriteInfo.buffer = bufferInfo.m_Buffer.m_UniformBuffers[0].m_GpuBuffer;
+            bufferWriteInfo.buffer = bufferInfo.m_Buffer.m_UniformBuffers[i].m_GpuBuffer;
             bufferWriteInfo.offset = 0;
             bufferWriteInfo.range = bufferInfo.m_BufferSize;
             bufferWriteInfos.push_back(bufferWriteInfo);
@@ -135,9 +184,267 @@ lvk::Material lvk::Material::Create(VkState & vk, ShaderProgram& shader)
         vkUpdateDescriptorSets(vk.m_LogicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 
     }
+
+    // fixed size storage blocks can be allocated up front, runtime arrays wait for CreateStorageBuffer
+    for (auto& [name, ssbo] : mat.m_StorageBuffers)
+    {
+        if (ssbo.m_ElementStride == 0 && ssbo.m_FixedSize > 0)
+        {
+            mat.CreateStorageBuffer(vk, name, 0, StorageBufferMemory::HostVisible);
+        }
+    }
     return mat;
 }
 
+static void write_storage_buffer_descriptors(lvk::VkState & vk, lvk::Material& mat, lvk::Material::StorageBufferBindingData& ssbo)
+{
+    using namespace lvk;
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = ssbo.m_Buffers[i];
+        bufferInfo.offset = 0;
+        bufferInfo.range = ssbo.m_Size;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = mat.m_DescriptorSets[ssbo.m_SetNumber].m_Sets[i];
+        write.dstBinding = ssbo.m_BindingNumber;
+        write.dstArrayElement = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &bufferInfo;
+
+        vkUpdateDescriptorSets(vk.m_LogicalDevice, 1, &write, 0, nullptr);
+    }
+}
+
+static void free_storage_buffer(lvk::VkState & vk, lvk::Material::StorageBufferBindingData& ssbo)
+{
+    using namespace lvk;
+    if (ssbo.m_Owned)
+    {
+        bool hostVisible = ssbo.m_Memory == Material::StorageBufferMemory::HostVisible;
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            VmaAllocation mappedAllocation = hostVisible ? ssbo.m_Allocations[i] : ssbo.m_StagingAllocations[i];
+            if (ssbo.m_MappedAddrs[i] != nullptr)
+            {
+                vmaUnmapMemory(vk.m_Allocator, mappedAllocation);
+            }
+            vkDestroyBuffer(vk.m_LogicalDevice, ssbo.m_Buffers[i], nullptr);
+            vmaFreeMemory(vk.m_Allocator, ssbo.m_Allocations[i]);
+
+            if (!hostVisible)
+            {
+                vkDestroyBuffer(vk.m_LogicalDevice, ssbo.m_StagingBuffers[i], nullptr);
+                vmaFreeMemory(vk.m_Allocator, ssbo.m_StagingAllocations[i]);
+            }
+        }
+    }
+
+    ssbo.m_Buffers = {};
+    ssbo.m_Allocations = {};
+    ssbo.m_MappedAddrs = {};
+    ssbo.m_StagingBuffers = {};
+    ssbo.m_StagingAllocations = {};
+    ssbo.m_DirtyBegin = {};
+    ssbo.m_DirtyEnd = {};
+    ssbo.m_Owned = false;
+    ssbo.m_Size = 0;
+}
+
+bool lvk::Material::CreateStorageBuffer(VkState & vk, const String& name, uint32_t elementCount, StorageBufferMemory memory)
+{
+    if (m_StorageBuffers.find(name) == m_StorageBuffers.end())
+    {
+        return false;
+    }
+
+    StorageBufferBindingData& ssbo = m_StorageBuffers.at(name);
+    VkDeviceSize size = VkDeviceSize{ ssbo.m_FixedSize } + VkDeviceSize{ elementCount } * ssbo.m_ElementStride;
+    if (size == 0)
+    {
+        spdlog::error("Material : storage buffer {} would be empty", name);
+        return false;
+    }
+
+    // the previous buffers may still be referenced by in flight frames
+    if (ssbo.m_Owned)
+    {
+        vkDeviceWaitIdle(vk.m_LogicalDevice);
+    }
+    free_storage_buffer(vk, ssbo);
+
+    ssbo.m_Memory = memory;
+    ssbo.m_Size = size;
+    ssbo.m_Owned = true;
+
+    if (memory == StorageBufferMemory::HostVisible)
+    {
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            buffers::CreateBuffer(vk, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                ssbo.m_Buffers[i], ssbo.m_Allocations[i]);
+            VK_CHECK(vmaMapMemory(vk.m_Allocator, ssbo.m_Allocations[i], &ssbo.m_MappedAddrs[i]));
+            memset(ssbo.m_MappedAddrs[i], 0, size);
+        }
+    }
+    else
+    {
+        // each frame gets its own buffer and staging memory so a write for one frame
+        // never touches memory an in flight frame may still be reading
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            buffers::CreateBuffer(vk, size,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ssbo.m_Buffers[i], ssbo.m_Allocations[i]);
+            buffers::CreateBuffer(vk, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                ssbo.m_StagingBuffers[i], ssbo.m_StagingAllocations[i]);
+            VK_CHECK(vmaMapMemory(vk.m_Allocator, ssbo.m_StagingAllocations[i], &ssbo.m_MappedAddrs[i]));
+        }
+    }
+
+    write_storage_buffer_descriptors(vk, *this, ssbo);
+    return true;
+}
+
+bool lvk::Material::SetStorageBuffer(VkState & vk, const String& name, VkBuffer buffer, VkDeviceSize size)
+{
+    Array<VkBuffer, MAX_FRAMES_IN_FLIGHT> frameBuffers;
+    frameBuffers.fill(buffer);
+    return SetStorageBuffer(vk, name, frameBuffers, size);
+}
+
+bool lvk::Material::SetStorageBuffer(VkState & vk, const String& name, const Array<VkBuffer, MAX_FRAMES_IN_FLIGHT>& frameBuffers, VkDeviceSize size)
+{
+    if (m_StorageBuffers.find(name) == m_StorageBuffers.end())
+    {
+        return false;
+    }
+
+    StorageBufferBindingData& ssbo = m_StorageBuffers.at(name);
+    if (size < ssbo.m_FixedSize)
+    {
+        spdlog::error("Material : storage buffer {} needs at least {} bytes, got {}", name, ssbo.m_FixedSize, size);
+        return false;
+    }
+
+    if (ssbo.m_Owned)
+    {
+        vkDeviceWaitIdle(vk.m_LogicalDevice);
+    }
+    free_storage_buffer(vk, ssbo);
+
+    ssbo.m_Buffers = frameBuffers;
+    ssbo.m_Size = size;
+    ssbo.m_Owned = false;
+
+    write_storage_buffer_descriptors(vk, *this, ssbo);
+    return true;
+}
+
+bool lvk::Material::WriteStorageBuffer(VkState & vk, uint32_t frameIndex, const String& name, const void* data, VkDeviceSize size, VkDeviceSize offset)
+{
+    if (m_StorageBuffers.find(name) == m_StorageBuffers.end())
+    {
+        return false;
+    }
+
+    StorageBufferBindingData& ssbo = m_StorageBuffers.at(name);
+    if (offset + size > ssbo.m_Size)
+    {
+        spdlog::error("Material : write of {} bytes at offset {} overflows storage buffer {} ({} bytes)", size, offset, name, ssbo.m_Size);
+        return false;
+    }
+
+    if (!ssbo.m_Owned)
+    {
+        spdlog::error("Material : storage buffer {} is externally owned, write it through its owner", name);
+        return false;
+    }
+
+    memcpy(static_cast<uint8_t*>(ssbo.m_MappedAddrs[frameIndex]) + offset, data, size);
+
+    if (ssbo.m_Memory == StorageBufferMemory::DeviceLocal)
+    {
+        // grow the staged range, RecordStorageUploads copies it in with the frame's commands
+        VkDeviceSize& dirtyBegin = ssbo.m_DirtyBegin[frameIndex];
+        VkDeviceSize& dirtyEnd = ssbo.m_DirtyEnd[frameIndex];
+        if (dirtyBegin >= dirtyEnd)
+        {
+            dirtyBegin = offset;
+            dirtyEnd = offset + size;
+        }
+        else
+        {
+            dirtyBegin = std::min(dirtyBegin, offset);
+            dirtyEnd = std::max(dirtyEnd, offset + size);
+        }
+    }
+    return true;
+}
+
+void lvk::Material::RecordStorageUploads(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    Vector<VkBufferMemoryBarrier> barriers;
+    for (auto& [name, ssbo] : m_StorageBuffers)
+    {
+        if (!ssbo.m_Owned || ssbo.m_Memory != StorageBufferMemory::DeviceLocal)
+        {
+            continue;
+        }
+
+        VkDeviceSize& dirtyBegin = ssbo.m_DirtyBegin[frameIndex];
+        VkDeviceSize& dirtyEnd = ssbo.m_DirtyEnd[frameIndex];
+        if (dirtyBegin >= dirtyEnd)
+        {
+            continue;
+        }
+
+        VkBufferCopy region{};
+        region.srcOffset = dirtyBegin;
+        region.dstOffset = dirtyBegin;
+        region.size = dirtyEnd - dirtyBegin;
+        vkCmdCopyBuffer(commandBuffer, ssbo.m_StagingBuffers[frameIndex], ssbo.m_Buffers[frameIndex], 1, &region);
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = ssbo.m_Buffers[frameIndex];
+        barrier.offset = region.dstOffset;
+        barrier.size = region.size;
+        barriers.push_back(barrier);
+
+        dirtyBegin = 0;
+        dirtyEnd = 0;
+    }
+
+    if (barriers.empty())
+    {
+        return;
+    }
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+}
+
+VkBuffer lvk::Material::GetStorageBuffer(const String& name, uint32_t frameIndex) const
+{
+    auto it = m_StorageBuffers.find(name);
+    if (it == m_StorageBuffers.end())
+    {
+        return VK_NULL_HANDLE;
+    }
+    return it->second.m_Buffers[frameIndex];
+}
+
 bool lvk::Material::SetSampler(VkState & vk, const String& name, const VkImageView& imageView, const VkSampler& sampler, bool isAttachment)
 {
     if (m_Samplers.find(name) == m_Samplers.end())
@@ -169,6 +476,62 @@ bool lvk::Material::SetSampler(VkState & vk, const String& name, const VkImageVi
     return true;
 }
 
+bool lvk::Material::SetSampler(VkState & vk, uint32_t frameIndex, const String& name, const VkImageView& imageView, const VkSampler& sampler)
+{
+    if (m_Samplers.find(name) == m_Samplers.end())
+    {
+        return false;
+    }
+
+    SamplerBindingData& samplerBinding = m_Samplers.at(name);
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = imageView;
+    imageInfo.sampler = sampler;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_DescriptorSets[samplerBinding.m_SetNumber].m_Sets[frameIndex];
+    write.dstBinding = samplerBinding.m_BindingNumber;
+    write.dstArrayElement = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(vk.m_LogicalDevice, 1, &write, 0, nullptr);
+    return true;
+}
+
+bool lvk::Material::SetSampler(VkState & vk, const String& name, const Array<VkImageView, MAX_FRAMES_IN_FLIGHT>& imageViews, const VkSampler& sampler, VkImageLayout imageLayout)
+{
+    if (m_Samplers.find(name) == m_Samplers.end())
+    {
+        return false;
+    }
+
+    SamplerBindingData& samplerBinding = m_Samplers.at(name);
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageLayout = imageLayout;
+        imageInfo.imageView = imageViews[i];
+        imageInfo.sampler = sampler;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_DescriptorSets[samplerBinding.m_SetNumber].m_Sets[i];
+        write.dstBinding = samplerBinding.m_BindingNumber;
+        write.dstArrayElement = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.descriptorCount = 1;
+        write.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(vk.m_LogicalDevice, 1, &write, 0, nullptr);
+    }
+    return true;
+}
+
 bool lvk::Material::SetColourAttachment(VkState & vk, const String& name, Framebuffer& framebuffer, uint32_t colourAttachmentIndex)
 {
     if (m_Samplers.find(name) == m_Samplers.end())
@@ -233,6 +596,166 @@ bool lvk::Material::SetDepthAttachment(VkState & vk, const String& name, Framebu
     return true;
 }
 
+bool lvk::Material::SetDynamicUniformRing(VkState & vk, const String& name, UniformRing& ring)
+{
+    if (m_DynamicUniformBuffers.find(name) == m_DynamicUniformBuffers.end())
+    {
+        return false;
+    }
+
+    DynamicBufferBindingData& bufferBinding = m_DynamicUniformBuffers.at(name);
+    if (bufferBinding.m_BufferSize > ring.m_MaxRange)
+    {
+        spdlog::error("Material : {} expects {} bytes but the ring only binds {}", name, bufferBinding.m_BufferSize, ring.m_MaxRange);
+        return false;
+    }
+
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        VkDescriptorBufferInfo bufferInfo = ring.GetDescriptorBufferInfo(i);
+        bufferInfo.range = bufferBinding.m_BufferSize;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_DescriptorSets[bufferBinding.m_SetNumber].m_Sets[i];
+        write.dstBinding = bufferBinding.m_BindingNumber;
+        write.dstArrayElement = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &bufferInfo;
+
+        vkUpdateDescriptorSets(vk.m_LogicalDevice, 1, &write, 0, nullptr);
+    }
+    return true;
+}
+
+lvk::Material::MemberHandle lvk::Material::ResolveMember(const String& name) const
+{
+    auto it = m_UniformBufferAccessors.find(name);
+    if (it == m_UniformBufferAccessors.end())
+    {
+        return MemberHandle{};
+    }
+
+    const ShaderAccessorData& data = it->second;
+    return MemberHandle{ data.m_BufferIndex, data.m_Offset, data.m_ExpectedSize };
+}
+
+bool lvk::Material::WriteBufferRange(uint32_t frameIndex, uint32_t set, uint32_t binding, uint32_t offset, const void* data, uint32_t size)
+{
+    Material::SetBinding sb = {};
+    sb.m_Set = set;
+    sb.m_Binding = binding;
+
+    auto it = m_UniformBuffers.find(sb.m_Data);
+    if (it == m_UniformBuffers.end())
+    {
+        return false;
+    }
+
+    ShaderBufferBindingData& ubo = it->second;
+    if (offset + size > ubo.m_BufferSize)
+    {
+        spdlog::error("Material : write of {} bytes at offset {} overflows set {} binding {} ({} bytes)", size, offset, set, binding, ubo.m_BufferSize);
+        return false;
+    }
+
+    memcpy(m_MappedUniformBuffers[ubo.m_BufferIndex][frameIndex] + offset, data, size);
+
+    // keep the shadow in sync, this frame is already up to date
+    UniformShadow& shadow = m_UniformShadows[ubo.m_BufferIndex];
+    memcpy(shadow.m_Data.data() + offset, data, size);
+    MarkUniformRangeDirty(ubo.m_BufferIndex, offset, size);
+
+    // only granules fully covered by this write are clean, partially covered ones may hold other dirty data
+    uint32_t first = (offset + k_UniformGranuleSize - 1) / k_UniformGranuleSize;
+    uint32_t end = offset + size == ubo.m_BufferSize ? (ubo.m_BufferSize + k_UniformGranuleSize - 1) / k_UniformGranuleSize
+                                                     : (offset + size) / k_UniformGranuleSize;
+    for (uint32_t g = first; g < end; g++)
+    {
+        shadow.m_DirtyGranules[frameIndex][g / 64] &= ~(uint64_t{ 1 } << (g % 64));
+    }
+    return true;
+}
+
+uint32_t lvk::Material::FindUniformBufferIndex(uint32_t set, uint32_t binding) const
+{
+    Material::SetBinding sb = {};
+    sb.m_Set = set;
+    sb.m_Binding = binding;
+
+    auto it = m_UniformBuffers.find(sb.m_Data);
+    if (it == m_UniformBuffers.end())
+    {
+        return UINT32_MAX;
+    }
+    return it->second.m_BufferIndex;
+}
+
+void lvk::Material::MarkUniformRangeDirty(uint32_t bufferIndex, uint32_t offset, uint32_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    UniformShadow& shadow = m_UniformShadows[bufferIndex];
+    uint32_t first = offset / k_UniformGranuleSize;
+    uint32_t last = (offset + size - 1) / k_UniformGranuleSize;
+    for (auto& dirty : shadow.m_DirtyGranules)
+    {
+        for (uint32_t g = first; g <= last; g++)
+        {
+            dirty[g / 64] |= uint64_t{ 1 } << (g % 64);
+        }
+    }
+}
+
+void lvk::Material::FlushUniforms(uint32_t frameIndex)
+{
+    for (size_t b = 0; b < m_UniformShadows.size(); b++)
+    {
+        UniformShadow& shadow = m_UniformShadows[b];
+        Vector<uint64_t>& dirty = shadow.m_DirtyGranules[frameIndex];
+        uint8_t* dst = m_MappedUniformBuffers[b][frameIndex];
+        uint32_t bufferSize = static_cast<uint32_t>(shadow.m_Data.size());
+        uint32_t granuleCount = static_cast<uint32_t>(dirty.size() * 64);
+
+        // coalesce adjacent dirty granules into a single copy
+        uint32_t g = 0;
+        while (g < granuleCount)
+        {
+            uint64_t word = dirty[g / 64] >> (g % 64);
+            if (word == 0)
+            {
+                g = (g / 64 + 1) * 64;
+                continue;
+            }
+
+            if ((word & 1) == 0)
+            {
+                g++;
+                continue;
+            }
+
+            uint32_t runStart = g;
+            while (g < granuleCount && (dirty[g / 64] >> (g % 64)) & 1)
+            {
+                g++;
+            }
+
+            uint32_t start = runStart * k_UniformGranuleSize;
+            uint32_t end = std::min(g * k_UniformGranuleSize, bufferSize);
+            if (start < end)
+            {
+                memcpy(dst + start, shadow.m_Data.data() + start, end - start);
+            }
+        }
+
+        std::fill(dirty.begin(), dirty.end(), 0);
+    }
+}
+
 void lvk::Material::Free(VkState & vk)
 {
     m_UniformBufferAccessors.clear();
@@ -243,6 +766,15 @@ void lvk::Material::Free(VkState & vk)
     }
 
     m_UniformBuffers.clear();
+    m_MappedUniformBuffers.clear();
+    m_UniformShadows.clear();
+    m_DynamicUniformBuffers.clear();
+
+    for (auto& [name, ssbo] : m_StorageBuffers)
+    {
+        free_storage_buffer(vk, ssbo);
+    }
+    m_StorageBuffers.clear();
     m_Samplers.clear();
 
     /*for (auto& frameDescriptorSets : m_DescriptorSets)
@@ -21,10 +21,11 @@ void lvk::Mesh::InitBuiltInMeshes(lvk::VkState & vk)
     VmaAllocation vertexBufferMemory;
     VkBuffer indexBuffer;
     VmaAllocation indexBufferMemory;
+    VkIndexType indexType;
     buffers::CreateVertexBuffer<VertexDataPosUv>(vk, g_ScreenSpaceQuadVertexData, vertexBuffer, vertexBufferMemory);
-    buffers::CreateIndexBuffer(vk, g_ScreenSpaceQuadIndexData, indexBuffer, indexBufferMemory);
+    buffers::CreateIndexBuffer(vk, g_ScreenSpaceQuadIndexData, static_cast<uint32_t>(g_ScreenSpaceQuadVertexData.size()), indexBuffer, indexBufferMemory, indexType);
 
-    g_ScreenSpaceQuad = new Mesh { vertexBuffer, vertexBufferMemory, indexBuffer, indexBufferMemory, 6 };
+    g_ScreenSpaceQuad = new Mesh { vertexBuffer, vertexBufferMemory, indexBuffer, indexBufferMemory, 6, indexType };
 }
 
 void lvk::Mesh::FreeBuiltInMeshes(lvk::VkState & vk)
@@ -49,7 +50,7 @@ void lvk::Renderable::RecordGraphicsCommands(VkCommandBuffer& commandBuffer)
     VkDeviceSize sizes[] = { 0 };
 
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, sizes);
-    vkCmdBindIndexBuffer(commandBuffer, m_Mesh.m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindIndexBuffer(commandBuffer, m_Mesh.m_IndexBuffer, 0, m_Mesh.m_IndexType);
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
     vkCmdDrawIndexed(commandBuffer, m_Mesh.m_IndexCount, 1, 0, 0, 0);
 }
@@ -65,3 +66,12 @@ lvk::VertexDescription lvk::VertexDataPosUv::GetVertexDescription() {
 lvk::VertexDescription lvk::VertexDataPosNormalUv::GetVertexDescription() {
     return VertexDescription {{GetBindingDescription()}, GetAttributeDescriptions()};
 }
+lvk::VertexDescription lvk::VertexDataPackedPosUv::GetVertexDescription() {
+    return VertexDescription {{GetBindingDescription()}, GetAttributeDescriptions()};
+}
+lvk::VertexDescription lvk::VertexDataPackedPosColUv::GetVertexDescription() {
+    return VertexDescription {{GetBindingDescription()}, GetAttributeDescriptions()};
+}
+lvk::VertexDescription lvk::VertexDataPackedPosNormalUv::GetVertexDescription() {
+    return VertexDescription {{GetBindingDescription()}, GetAttributeDescriptions()};
+}
@@ -0,0 +1,257 @@
+#include "lvk/MeshFile.h"
+#include "spdlog/spdlog.h"
+#include <cstring>
+#include <fstream>
+
+uint32_t lvk::mesh_file::GetVertexStride(VertexLayout layout)
+{
+    switch (layout)
+    {
+    case VertexLayout::PosUv:       return sizeof(float) * 5;
+    case VertexLayout::PosNormalUv: return sizeof(float) * 8;
+    }
+    return 0;
+}
+
+static uint64_t align_offset(uint64_t offset)
+{
+    return (offset + lvk::mesh_file::k_StreamAlignment - 1) & ~(lvk::mesh_file::k_StreamAlignment - 1);
+}
+
+static void write_padding(std::ofstream& out, uint64_t& cursor, uint64_t offset)
+{
+    static const char k_Zeros[lvk::mesh_file::k_StreamAlignment]{};
+    out.write(k_Zeros, static_cast<std::streamsize>(offset - cursor));
+    cursor = offset;
+}
+
+bool lvk::mesh_file::Write(const String& path, VertexLayout layout, const Vector<CookedMesh>& meshes, const Vector<String>& diffusePaths)
+{
+    uint32_t stride = GetVertexStride(layout);
+
+    Header header{};
+    header.m_Magic = k_Magic;
+    header.m_Version = k_Version;
+    header.m_VertexLayout = static_cast<uint32_t>(layout);
+    header.m_VertexStride = stride;
+    header.m_MeshCount = static_cast<uint32_t>(meshes.size());
+    header.m_MaterialCount = static_cast<uint32_t>(diffusePaths.size());
+
+    Vector<MeshRecord> meshRecords(meshes.size());
+    Vector<lod::LodLevel> lods;
+    Vector<MaterialRecord> materialRecords(diffusePaths.size());
+    String strings;
+
+    for (size_t i = 0; i < diffusePaths.size(); i++)
+    {
+        materialRecords[i].m_DiffusePathOffset = static_cast<uint32_t>(strings.size());
+        materialRecords[i].m_DiffusePathLength = static_cast<uint32_t>(diffusePaths[i].size());
+        strings += diffusePaths[i];
+    }
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const CookedMesh& mesh = meshes[i];
+        if (mesh.m_Vertices.size() != size_t{ stride } * mesh.m_VertexCount)
+        {
+            spdlog::error("mesh_file::Write : mesh {} has {} bytes of vertices, expected {} x {}", i, mesh.m_Vertices.size(), mesh.m_VertexCount, stride);
+            return false;
+        }
+
+        MeshRecord& record = meshRecords[i];
+        record.m_VertexCount = mesh.m_VertexCount;
+        record.m_IndexCount = static_cast<uint32_t>(mesh.m_Indices.size());
+        // same rule as buffers::SelectIndexType, 0xFFFF is the 16 bit primitive restart index
+        record.m_IndexSize = mesh.m_VertexCount <= UINT16_MAX ? sizeof(uint16_t) : sizeof(uint32_t);
+        record.m_MaterialIndex = mesh.m_MaterialIndex;
+        record.m_FirstLod = static_cast<uint32_t>(lods.size());
+        record.m_LodCount = static_cast<uint32_t>(mesh.m_Lods.size());
+        memcpy(record.m_AABBMin, mesh.m_AABBMin, sizeof(record.m_AABBMin));
+        memcpy(record.m_AABBMax, mesh.m_AABBMax, sizeof(record.m_AABBMax));
+        lods.insert(lods.end(), mesh.m_Lods.begin(), mesh.m_Lods.end());
+    }
+    header.m_LodCount = static_cast<uint32_t>(lods.size());
+    header.m_StringTableSize = static_cast<uint32_t>(strings.size());
+
+    // tables first so a loader touches one contiguous range before the streams
+    uint64_t offset = sizeof(Header);
+    header.m_MeshTableOffset = offset;
+    offset += sizeof(MeshRecord) * meshRecords.size();
+    header.m_LodTableOffset = offset;
+    offset += sizeof(lod::LodLevel) * lods.size();
+    header.m_MaterialTableOffset = offset;
+    offset += sizeof(MaterialRecord) * materialRecords.size();
+    header.m_StringTableOffset = offset;
+    offset += strings.size();
+
+    for (MeshRecord& record : meshRecords)
+    {
+        record.m_VertexDataOffset = align_offset(offset);
+        offset = record.m_VertexDataOffset + uint64_t{ stride } * record.m_VertexCount;
+        record.m_IndexDataOffset = align_offset(offset);
+        offset = record.m_IndexDataOffset + uint64_t{ record.m_IndexSize } * record.m_IndexCount;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        spdlog::error("mesh_file::Write : failed to open {} for writing", path);
+        return false;
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    out.write(reinterpret_cast<const char*>(meshRecords.data()), static_cast<std::streamsize>(sizeof(MeshRecord) * meshRecords.size()));
+    out.write(reinterpret_cast<const char*>(lods.data()), static_cast<std::streamsize>(sizeof(lod::LodLevel) * lods.size()));
+    out.write(reinterpret_cast<const char*>(materialRecords.data()), static_cast<std::streamsize>(sizeof(MaterialRecord) * materialRecords.size()));
+    out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+    uint64_t cursor = header.m_StringTableOffset + strings.size();
+    Vector<uint16_t> narrowed;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const CookedMesh& mesh = meshes[i];
+        const MeshRecord& record = meshRecords[i];
+
+        write_padding(out, cursor, record.m_VertexDataOffset);
+        out.write(reinterpret_cast<const char*>(mesh.m_Vertices.data()), static_cast<std::streamsize>(mesh.m_Vertices.size()));
+        cursor += mesh.m_Vertices.size();
+
+        write_padding(out, cursor, record.m_IndexDataOffset);
+        if (record.m_IndexSize == sizeof(uint16_t))
+        {
+            narrowed.assign(mesh.m_Indices.begin(), mesh.m_Indices.end());
+            out.write(reinterpret_cast<const char*>(narrowed.data()), static_cast<std::streamsize>(sizeof(uint16_t) * narrowed.size()));
+        }
+        else
+        {
+            out.write(reinterpret_cast<const char*>(mesh.m_Indices.data()), static_cast<std::streamsize>(sizeof(uint32_t) * mesh.m_Indices.size()));
+        }
+        cursor += uint64_t{ record.m_IndexSize } * record.m_IndexCount;
+    }
+
+    if (!out.good())
+    {
+        spdlog::error("mesh_file::Write : failed writing {}", path);
+        return false;
+    }
+    return true;
+}
+
+static bool range_in_file(uint64_t offset, uint64_t size, size_t fileSize)
+{
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+bool lvk::MeshFile::Open(const String& path)
+{
+    Close();
+    if (!m_File.Open(path))
+    {
+        return false;
+    }
+
+    if (!Validate(path))
+    {
+        Close();
+        return false;
+    }
+
+    const uint8_t* data = m_File.GetData();
+    m_Header = reinterpret_cast<const mesh_file::Header*>(data);
+    m_Meshes = reinterpret_cast<const mesh_file::MeshRecord*>(data + m_Header->m_MeshTableOffset);
+    m_Lods = reinterpret_cast<const lod::LodLevel*>(data + m_Header->m_LodTableOffset);
+    m_Materials = reinterpret_cast<const mesh_file::MaterialRecord*>(data + m_Header->m_MaterialTableOffset);
+    m_Strings = reinterpret_cast<const char*>(data + m_Header->m_StringTableOffset);
+    return true;
+}
+
+bool lvk::MeshFile::Validate(const String& path) const
+{
+    using namespace mesh_file;
+    size_t size = m_File.GetSize();
+    const uint8_t* data = m_File.GetData();
+
+    if (size < sizeof(Header))
+    {
+        spdlog::error("MeshFile : {} is too small to be a mesh file", path);
+        return false;
+    }
+
+    const Header& header = *reinterpret_cast<const Header*>(data);
+    if (header.m_Magic != k_Magic || header.m_Version != k_Version)
+    {
+        spdlog::error("MeshFile : {} is not a version {} mesh file, re-cook it", path, k_Version);
+        return false;
+    }
+
+    if (header.m_VertexStride == 0 || header.m_VertexStride != GetVertexStride(static_cast<VertexLayout>(header.m_VertexLayout)))
+    {
+        spdlog::error("MeshFile : {} has an unknown vertex layout {}", path, header.m_VertexLayout);
+        return false;
+    }
+
+    bool tables = range_in_file(header.m_MeshTableOffset, uint64_t{ sizeof(MeshRecord) } * header.m_MeshCount, size)
+        && range_in_file(header.m_LodTableOffset, uint64_t{ sizeof(lod::LodLevel) } * header.m_LodCount, size)
+        && range_in_file(header.m_MaterialTableOffset, uint64_t{ sizeof(MaterialRecord) } * header.m_MaterialCount, size)
+        && range_in_file(header.m_StringTableOffset, header.m_StringTableSize, size);
+    if (!tables)
+    {
+        spdlog::error("MeshFile : {} is truncated", path);
+        return false;
+    }
+
+    const MeshRecord* meshes = reinterpret_cast<const MeshRecord*>(data + header.m_MeshTableOffset);
+    const lod::LodLevel* lods = reinterpret_cast<const lod::LodLevel*>(data + header.m_LodTableOffset);
+    for (uint32_t i = 0; i < header.m_MeshCount; i++)
+    {
+        const MeshRecord& mesh = meshes[i];
+        bool streams = (mesh.m_IndexSize == sizeof(uint16_t) || mesh.m_IndexSize == sizeof(uint32_t))
+            && mesh.m_VertexDataOffset % k_StreamAlignment == 0
+            && mesh.m_IndexDataOffset % k_StreamAlignment == 0
+            && range_in_file(mesh.m_VertexDataOffset, uint64_t{ header.m_VertexStride } * mesh.m_VertexCount, size)
+            && range_in_file(mesh.m_IndexDataOffset, uint64_t{ mesh.m_IndexSize } * mesh.m_IndexCount, size)
+            && uint64_t{ mesh.m_FirstLod } + mesh.m_LodCount <= header.m_LodCount;
+        if (!streams)
+        {
+            spdlog::error("MeshFile : {} mesh {} points outside the file", path, i);
+            return false;
+        }
+
+        for (uint32_t level = 0; level < mesh.m_LodCount; level++)
+        {
+            const lod::LodLevel& lod = lods[mesh.m_FirstLod + level];
+            if (uint64_t{ lod.m_FirstIndex } + lod.m_IndexCount > mesh.m_IndexCount)
+            {
+                spdlog::error("MeshFile : {} mesh {} lod {} points outside its indices", path, i, level);
+                return false;
+            }
+        }
+    }
+
+    const MaterialRecord* materials = reinterpret_cast<const MaterialRecord*>(data + header.m_MaterialTableOffset);
+    for (uint32_t i = 0; i < header.m_MaterialCount; i++)
+    {
+        if (uint64_t{ materials[i].m_DiffusePathOffset } + materials[i].m_DiffusePathLength > header.m_StringTableSize)
+        {
+            spdlog::error("MeshFile : {} material {} points outside the string table", path, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+void lvk::MeshFile::Close()
+{
+    m_File.Close();
+    m_Header = nullptr;
+    m_Meshes = nullptr;
+    m_Lods = nullptr;
+    m_Materials = nullptr;
+    m_Strings = nullptr;
+}
+
+lvk::String lvk::MeshFile::GetDiffusePath(uint32_t materialIndex) const
+{
+    const mesh_file::MaterialRecord& material = m_Materials[materialIndex];
+    return String(m_Strings + material.m_DiffusePathOffset, material.m_DiffusePathLength);
+}
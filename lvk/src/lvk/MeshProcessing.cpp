@@ -0,0 +1,316 @@
+#include "lvk/MeshProcessing.h"
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <cstring>
+
+// vertex -> triangle lists in one flat array
+struct TriangleAdjacency
+{
+    lvk::Vector<uint32_t> m_Counts;
+    lvk::Vector<uint32_t> m_Offsets;
+    lvk::Vector<uint32_t> m_Triangles;
+};
+
+static void build_adjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    adjacency.m_Counts.assign(vertexCount, 0);
+    adjacency.m_Offsets.assign(vertexCount, 0);
+    adjacency.m_Triangles.resize(indexCount);
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        adjacency.m_Counts[indices[i]]++;
+    }
+
+    uint32_t offset = 0;
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        adjacency.m_Offsets[v] = offset;
+        offset += adjacency.m_Counts[v];
+    }
+
+    lvk::Vector<uint32_t> fill = adjacency.m_Offsets;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        adjacency.m_Triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+}
+
+static bool indices_in_range(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        if (indices[i] >= vertexCount)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int64_t skip_dead_end(lvk::Vector<uint32_t>& deadEnds, const lvk::Vector<uint32_t>& liveTriangles, size_t& cursor)
+{
+    while (!deadEnds.empty())
+    {
+        uint32_t vertex = deadEnds.back();
+        deadEnds.pop_back();
+        if (liveTriangles[vertex] > 0)
+        {
+            return vertex;
+        }
+    }
+
+    while (cursor < liveTriangles.size())
+    {
+        if (liveTriangles[cursor] > 0)
+        {
+            return static_cast<int64_t>(cursor);
+        }
+        cursor++;
+    }
+    return -1;
+}
+
+void lvk::mesh_processing::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, Vector<uint32_t>* clusters, uint32_t cacheSize)
+{
+    if (clusters != nullptr)
+    {
+        clusters->clear();
+    }
+    if (indexCount < 3 || indexCount % 3 != 0 || !indices_in_range(indices, indexCount, vertexCount))
+    {
+        return;
+    }
+
+    TriangleAdjacency adjacency;
+    build_adjacency(adjacency, indices, indexCount, vertexCount);
+
+    size_t triangleCount = indexCount / 3;
+    Vector<uint32_t> liveTriangles = adjacency.m_Counts;
+    Vector<uint32_t> cacheTime(vertexCount, 0);
+    Vector<bool> emitted(triangleCount, false);
+    Vector<uint32_t> deadEnds;
+    Vector<uint32_t> candidates;
+    Vector<uint32_t> output;
+    output.reserve(indexCount);
+
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 1;
+    int64_t fanning = 0;
+
+    if (clusters != nullptr)
+    {
+        clusters->push_back(0);
+    }
+
+    while (fanning >= 0)
+    {
+        candidates.clear();
+
+        // emit every live triangle around the fanning vertex
+        uint32_t begin = adjacency.m_Offsets[fanning];
+        uint32_t end = begin + adjacency.m_Counts[fanning];
+        for (uint32_t a = begin; a < end; a++)
+        {
+            uint32_t triangle = adjacency.m_Triangles[a];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                if (time - cacheTime[vertex] > cacheSize)
+                {
+                    cacheTime[vertex] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // next fanning vertex, the candidate that stays in the cache longest while its fan is emitted
+        int64_t next = -1;
+        uint32_t best = 0;
+        for (uint32_t vertex : candidates)
+        {
+            if (liveTriangles[vertex] == 0)
+            {
+                continue;
+            }
+
+            uint32_t priority = 0;
+            if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+            {
+                priority = time - cacheTime[vertex];
+            }
+            if (priority > best)
+            {
+                best = priority;
+                next = vertex;
+            }
+        }
+
+        if (next < 0)
+        {
+            next = skip_dead_end(deadEnds, liveTriangles, cursor);
+            uint32_t triangle = static_cast<uint32_t>(output.size() / 3);
+            if (next >= 0 && clusters != nullptr && clusters->back() != triangle)
+            {
+                clusters->push_back(triangle);
+            }
+        }
+        fanning = next;
+    }
+
+    memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+void lvk::mesh_processing::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const Vector<uint32_t>& clusters,
+    const float* positions, size_t positionStride, size_t vertexCount)
+{
+    if (clusters.size() < 2 || indexCount % 3 != 0 || !indices_in_range(indices, indexCount, vertexCount))
+    {
+        return;
+    }
+
+    auto position = [&](uint32_t vertex) {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + positionStride * vertex);
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    size_t triangleCount = indexCount / 3;
+    size_t clusterCount = clusters.size();
+
+    struct Cluster
+    {
+        glm::vec3   m_Centroid{ 0.0f };
+        glm::vec3   m_Normal{ 0.0f };
+        float       m_Area = 0.0f;
+        float       m_Sort = 0.0f;
+        uint32_t    m_First = 0;
+        uint32_t    m_Last = 0;
+    };
+    Vector<Cluster> sorted(clusterCount);
+
+    // area weighted centroid and normal per cluster
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        Cluster& cluster = sorted[c];
+        cluster.m_First = clusters[c];
+        cluster.m_Last = c + 1 < clusterCount ? clusters[c + 1] : static_cast<uint32_t>(triangleCount);
+
+        for (uint32_t t = cluster.m_First; t < cluster.m_Last; t++)
+        {
+            glm::vec3 p0 = position(indices[t * 3 + 0]);
+            glm::vec3 p1 = position(indices[t * 3 + 1]);
+            glm::vec3 p2 = position(indices[t * 3 + 2]);
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+
+            cluster.m_Centroid += (p0 + p1 + p2) * (area / 3.0f);
+            cluster.m_Normal += normal;
+            cluster.m_Area += area;
+        }
+
+        meshCentroid += cluster.m_Centroid;
+        meshArea += cluster.m_Area;
+        if (cluster.m_Area > 0.0f)
+        {
+            cluster.m_Centroid /= cluster.m_Area;
+        }
+        float normalLength = glm::length(cluster.m_Normal);
+        if (normalLength > 0.0f)
+        {
+            cluster.m_Normal /= normalLength;
+        }
+    }
+    if (meshArea > 0.0f)
+    {
+        meshCentroid /= meshArea;
+    }
+
+    // clusters on the outside facing away from the centre occlude the rest, draw them first
+    for (Cluster& cluster : sorted)
+    {
+        cluster.m_Sort = glm::dot(cluster.m_Centroid - meshCentroid, cluster.m_Normal);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.m_Sort > b.m_Sort; });
+
+    Vector<uint32_t> output;
+    output.reserve(indexCount);
+    for (const Cluster& cluster : sorted)
+    {
+        output.insert(output.end(), indices + cluster.m_First * 3, indices + cluster.m_Last * 3);
+    }
+    memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+size_t lvk::mesh_processing::OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, Vector<uint32_t>& vertexOrder)
+{
+    vertexOrder.clear();
+    if (!indices_in_range(indices, indexCount, vertexCount))
+    {
+        // leave the mesh as it is
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            vertexOrder.push_back(static_cast<uint32_t>(v));
+        }
+        return vertexCount;
+    }
+
+    Vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    vertexOrder.reserve(vertexCount);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t& mapped = remap[indices[i]];
+        if (mapped == UINT32_MAX)
+        {
+            mapped = static_cast<uint32_t>(vertexOrder.size());
+            vertexOrder.push_back(indices[i]);
+        }
+        indices[i] = mapped;
+    }
+    return vertexOrder.size();
+}
+
+float lvk::mesh_processing::CalculateACMR(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    if (indexCount < 3)
+    {
+        return 0.0f;
+    }
+
+    // FIFO, a vertex is in the cache if it was transformed within the last cacheSize misses
+    Vector<uint32_t> missTime(vertexCount, 0);
+    uint32_t misses = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t vertex = indices[i];
+        if (vertex >= vertexCount)
+        {
+            continue;
+        }
+        if (missTime[vertex] == 0 || misses + 1 - missTime[vertex] > cacheSize)
+        {
+            misses++;
+            missTime[vertex] = misses;
+        }
+    }
+    return float(misses) / float(indexCount / 3);
+}
+
+void lvk::mesh_processing::OptimizeMesh(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+    size_t vertexCount, Vector<uint32_t>& vertexOrder)
+{
+    Vector<uint32_t> clusters;
+    OptimizeVertexCache(indices, indexCount, vertexCount, &clusters);
+    OptimizeOverdraw(indices, indexCount, clusters, positions, positionStride, vertexCount);
+    OptimizeVertexFetch(indices, indexCount, vertexCount, vertexOrder);
+}
@@ -0,0 +1,436 @@
+#include "lvk/MeshletCulling.h"
+#include "lvk/Buffer.h"
+#include "lvk/Culling.h"
+#include "lvk/Pipeline.h"
+#include "spdlog/spdlog.h"
+#include "volk.h"
+#include <algorithm>
+#include <cstring>
+
+static const char* k_MeshletGLSL = R"(
+struct Meshlet
+{
+    vec4 Sphere;
+    vec4 ConeApex;
+    vec4 ConeAxis;
+    uint VertexOffset;
+    uint TriangleOffset;
+    uint VertexCount;
+    uint TriangleCount;
+};
+)";
+
+static const char* k_MeshletFunctionsGLSL = R"(
+// index into the mesh's vertex buffer of the meshlet's local vertex
+uint Meshlet_GetVertex(Meshlet meshlet, uint localVertex)
+{
+    return uint(int(meshletVertices.vertices[meshlet.VertexOffset + localVertex]) + meshletView.vertexOffset);
+}
+
+// local vertices of triangle t, unpacked from 4 per word
+uvec3 Meshlet_GetTriangle(Meshlet meshlet, uint t)
+{
+    uvec3 triangle;
+    for (uint corner = 0; corner < 3; corner++)
+    {
+        uint byteIndex = meshlet.TriangleOffset + t * 3 + corner;
+        triangle[corner] = (meshletTriangles.triangles[byteIndex >> 2] >> ((byteIndex & 3u) * 8u)) & 0xffu;
+    }
+    return triangle;
+}
+
+bool Meshlet_IsVisible(Meshlet meshlet)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        vec4 plane = meshletView.planes[i];
+        if (dot(plane.xyz, meshlet.Sphere.xyz) + plane.w < -meshlet.Sphere.w)
+        {
+            return false;
+        }
+    }
+
+    // every triangle faces away when the view direction is inside the cone,
+    // written so a camera on the apex (nan) keeps the meshlet
+    vec3 view = normalize(meshlet.ConeApex.xyz - meshletView.cameraPosition.xyz);
+    return !(dot(view, meshlet.ConeAxis.xyz) >= meshlet.ConeApex.w);
+}
+)";
+
+static const char* k_MeshletPayloadGLSL = R"(
+struct MeshletPayload
+{
+    uint meshletIndices[32];
+};
+taskPayloadSharedEXT MeshletPayload meshletPayload;
+)";
+
+static const char* k_MeshletTaskGLSL = R"(
+layout(local_size_x = 32) in;
+
+shared uint visibleCount;
+
+void main()
+{
+    if (gl_LocalInvocationIndex == 0)
+    {
+        visibleCount = 0;
+    }
+    barrier();
+
+    uint meshletIndex = gl_GlobalInvocationID.x;
+    if (meshletIndex < meshletView.meshletCount && Meshlet_IsVisible(meshletData.meshlets[meshletIndex]))
+    {
+        meshletPayload.meshletIndices[atomicAdd(visibleCount, 1)] = meshletIndex;
+    }
+    barrier();
+
+    EmitMeshTasksEXT(visibleCount, 1, 1);
+}
+)";
+
+static const char* k_MeshletExpandGLSL = R"(
+layout(local_size_x = 32) in;
+
+layout(std430, set = 0, binding = 4) writeonly buffer MeshletIndices { uint indices[]; } meshletIndices;
+layout(std430, set = 0, binding = 5) buffer MeshletDraw
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int  vertexOffset;
+    uint firstInstance;
+} meshletDraw;
+
+shared bool visible;
+shared uint firstIndex;
+
+// one workgroup per meshlet, the first invocation culls and reserves room for the triangles
+void main()
+{
+    uint meshletIndex = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (meshletIndex >= meshletView.meshletCount)
+    {
+        return;
+    }
+
+    Meshlet meshlet = meshletData.meshlets[meshletIndex];
+    if (gl_LocalInvocationIndex == 0)
+    {
+        visible = Meshlet_IsVisible(meshlet);
+        firstIndex = visible ? atomicAdd(meshletDraw.indexCount, meshlet.TriangleCount * 3) : 0;
+    }
+    barrier();
+
+    if (!visible)
+    {
+        return;
+    }
+
+    for (uint t = gl_LocalInvocationIndex; t < meshlet.TriangleCount; t += gl_WorkGroupSize.x)
+    {
+        uvec3 triangle = Meshlet_GetTriangle(meshlet, t);
+        uint index = firstIndex + t * 3;
+        meshletIndices.indices[index + 0] = Meshlet_GetVertex(meshlet, triangle.x);
+        meshletIndices.indices[index + 1] = Meshlet_GetVertex(meshlet, triangle.y);
+        meshletIndices.indices[index + 2] = Meshlet_GetVertex(meshlet, triangle.z);
+    }
+}
+)";
+
+// matches the MeshletView buffer
+struct MeshletView
+{
+    glm::vec4   m_Planes[lvk::culling::Frustum::PlaneCount];
+    glm::vec4   m_CameraPosition;
+    uint32_t    m_MeshletCount;
+    int32_t     m_VertexOffset;
+    uint32_t    m_Padding[2];
+};
+
+// vkCmdDispatch only guarantees 65535 workgroups per dimension
+static constexpr uint32_t k_MaxWorkgroupsX = 65535;
+
+static lvk::String meshlet_glsl(uint32_t set, uint32_t firstBinding)
+{
+    auto layout = [&](uint32_t offset) {
+        return "layout(std430, set = " + std::to_string(set) + ", binding = " + std::to_string(firstBinding + offset) + ") ";
+    };
+
+    return lvk::String(k_MeshletGLSL) +
+        layout(0) + "readonly buffer MeshletData { Meshlet meshlets[]; } meshletData;\n" +
+        layout(1) + "readonly buffer MeshletVertices { uint vertices[]; } meshletVertices;\n" +
+        layout(2) + "readonly buffer MeshletTriangles { uint triangles[]; } meshletTriangles;\n" +
+        layout(3) + "readonly buffer MeshletView { vec4 planes[6]; vec4 cameraPosition; uint meshletCount; int vertexOffset; } meshletView;\n" +
+        k_MeshletFunctionsGLSL;
+}
+
+static lvk::String insert_after_version(const lvk::String& source, const lvk::String& declarations)
+{
+    size_t version = source.find("#version");
+    if (version == lvk::String::npos)
+    {
+        return declarations + source;
+    }
+
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == lvk::String::npos)
+    {
+        return source + "\n" + declarations;
+    }
+    return source.substr(0, lineEnd + 1) + declarations + source.substr(lineEnd + 1);
+}
+
+static void create_static_buffer(lvk::VkState& vk, const void* data, VkDeviceSize size, VkBuffer& buffer, VmaAllocation& allocation)
+{
+    // empty meshes still get a buffer to bind
+    VkDeviceSize allocationSize = std::max<VkDeviceSize>(size, 16);
+    lvk::buffers::CreateBuffer(vk, allocationSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, allocation);
+    if (size == 0)
+    {
+        return;
+    }
+
+    VkBuffer stagingBuffer;
+    VmaAllocation stagingBufferMemory;
+    lvk::buffers::CreateBuffer(vk, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+    void* mapped;
+    vmaMapMemory(vk.m_Allocator, stagingBufferMemory, &mapped);
+    memcpy(mapped, data, size);
+    vmaUnmapMemory(vk.m_Allocator, stagingBufferMemory);
+
+    lvk::buffers::CopyBuffer(vk, stagingBuffer, buffer, size);
+
+    vkDestroyBuffer(vk.m_LogicalDevice, stagingBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, stagingBufferMemory);
+}
+
+lvk::MeshletCulling lvk::MeshletCulling::Create(VkState& vk, const meshlets::MeshletMesh& mesh, int32_t vertexOffset, bool allowMeshShader)
+{
+    MeshletCulling mc{};
+    mc.m_MeshletCount = static_cast<uint32_t>(mesh.m_Meshlets.size());
+    mc.m_TriangleCount = mesh.GetTriangleCount();
+    mc.m_VertexOffset = vertexOffset;
+    mc.m_UseMeshShader = allowMeshShader && vk.m_DeviceFeatures.m_MeshShader;
+
+    Vector<GpuMeshlet> gpuMeshlets(mesh.m_Meshlets.size());
+    for (size_t i = 0; i < mesh.m_Meshlets.size(); i++)
+    {
+        const meshlets::Meshlet& meshlet = mesh.m_Meshlets[i];
+        const meshlets::MeshletBounds& bounds = mesh.m_Bounds[i];
+        gpuMeshlets[i].m_Sphere = glm::vec4(bounds.m_Centre, bounds.m_Radius);
+        gpuMeshlets[i].m_ConeApex = glm::vec4(bounds.m_ConeApex, bounds.m_ConeCutoff);
+        gpuMeshlets[i].m_ConeAxis = glm::vec4(bounds.m_ConeAxis, 0.0f);
+        gpuMeshlets[i].m_VertexOffset = meshlet.m_VertexOffset;
+        gpuMeshlets[i].m_TriangleOffset = meshlet.m_TriangleOffset;
+        gpuMeshlets[i].m_VertexCount = meshlet.m_VertexCount;
+        gpuMeshlets[i].m_TriangleCount = meshlet.m_TriangleCount;
+    }
+
+    mc.m_MeshletBufferSize = VkDeviceSize{ sizeof(GpuMeshlet) } * gpuMeshlets.size();
+    mc.m_VertexMapSize = VkDeviceSize{ sizeof(uint32_t) } * mesh.m_Vertices.size();
+    mc.m_TriangleBufferSize = mesh.m_Triangles.size();
+    create_static_buffer(vk, gpuMeshlets.data(), mc.m_MeshletBufferSize, mc.m_MeshletBuffer, mc.m_MeshletAllocation);
+    create_static_buffer(vk, mesh.m_Vertices.data(), mc.m_VertexMapSize, mc.m_VertexMapBuffer, mc.m_VertexMapAllocation);
+    create_static_buffer(vk, mesh.m_Triangles.data(), mc.m_TriangleBufferSize, mc.m_TriangleBuffer, mc.m_TriangleAllocation);
+
+    // until SetView is called every plane passes everything
+    MeshletView view{};
+    view.m_MeshletCount = mc.m_MeshletCount;
+    view.m_VertexOffset = vertexOffset;
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        buffers::CreateMappedBuffer(vk, mc.m_ViewBuffers[i], VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(MeshletView));
+        memcpy(mc.m_ViewBuffers[i].m_MappedAddr, &view, sizeof(MeshletView));
+    }
+
+    if (mc.m_UseMeshShader)
+    {
+        return mc;
+    }
+
+    String source = "#version 450\n" + meshlet_glsl(0, 0) + k_MeshletExpandGLSL;
+    ShaderStage stage = ShaderStage::CreateFromSource(vk, source, ShaderStageType::Compute);
+    mc.m_Program = ShaderProgram::CreateCompute(vk, stage);
+    mc.m_Material = Material::Create(vk, mc.m_Program);
+    mc.m_Pipeline = pipelines::CreateComputePipeline(vk, stage.m_StageBinary, mc.m_Program.m_DescriptorSetLayout, mc.m_PipelineLayout);
+
+    VkDeviceSize indicesSize = std::max<VkDeviceSize>(VkDeviceSize{ mc.m_TriangleCount } * 3 * sizeof(uint32_t), 16);
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        buffers::CreateBuffer(vk, indicesSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mc.m_IndexBuffers[i], mc.m_IndexAllocations[i]);
+        buffers::CreateBuffer(vk, sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mc.m_DrawCommandBuffers[i], mc.m_DrawCommandAllocations[i]);
+    }
+
+    mc.BindMeshletBuffers(vk, mc.m_Material);
+    mc.m_Material.SetStorageBuffer(vk, "meshletIndices", mc.m_IndexBuffers, indicesSize);
+    mc.m_Material.SetStorageBuffer(vk, "meshletDraw", mc.m_DrawCommandBuffers, sizeof(VkDrawIndexedIndirectCommand));
+
+    return mc;
+}
+
+void lvk::MeshletCulling::SetView(uint32_t frameIndex, const glm::mat4& viewProj, const glm::mat4& model, const glm::vec3& cameraPosition)
+{
+    // planes and camera are taken into the mesh's space instead of moving every meshlet out of it
+    culling::Frustum frustum = culling::Frustum::FromViewProj(viewProj * model);
+
+    MeshletView view{};
+    for (int i = 0; i < culling::Frustum::PlaneCount; i++)
+    {
+        view.m_Planes[i] = frustum.m_Planes[i];
+    }
+    view.m_CameraPosition = glm::inverse(model) * glm::vec4(cameraPosition, 1.0f);
+    view.m_MeshletCount = m_MeshletCount;
+    view.m_VertexOffset = m_VertexOffset;
+
+    memcpy(m_ViewBuffers[frameIndex].m_MappedAddr, &view, sizeof(MeshletView));
+}
+
+void lvk::MeshletCulling::Dispatch(VkCommandBuffer& commandBuffer, uint32_t frameIndex)
+{
+    if (m_UseMeshShader)
+    {
+        spdlog::error("MeshletCulling : Dispatch is the compute fallback, this mesh draws with DrawMeshTasks");
+        return;
+    }
+
+    VkDrawIndexedIndirectCommand command{};
+    command.indexCount = 0;
+    command.instanceCount = 1;
+    vkCmdUpdateBuffer(commandBuffer, m_DrawCommandBuffers[frameIndex], 0, sizeof(VkDrawIndexedIndirectCommand), &command);
+
+    // the previous use of these buffers was as draw arguments and indices
+    Array<VkBufferMemoryBarrier, 2> preBarriers{};
+    VkBuffer outputs[] = { m_DrawCommandBuffers[frameIndex], m_IndexBuffers[frameIndex] };
+    for (size_t i = 0; i < preBarriers.size(); i++)
+    {
+        preBarriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        preBarriers[i].srcAccessMask = i == 0 ? VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_INDEX_READ_BIT;
+        preBarriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        preBarriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        preBarriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        preBarriers[i].buffer = outputs[i];
+        preBarriers[i].offset = 0;
+        preBarriers[i].size = VK_WHOLE_SIZE;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, static_cast<uint32_t>(preBarriers.size()), preBarriers.data(), 0, nullptr);
+
+    if (m_MeshletCount > 0)
+    {
+        uint32_t groupsX = std::min(m_MeshletCount, k_MaxWorkgroupsX);
+        uint32_t groupsY = (m_MeshletCount + groupsX - 1) / groupsX;
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1,
+            &m_Material.m_DescriptorSets[0].m_Sets[frameIndex], 0, nullptr);
+        vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+    }
+
+    Array<VkBufferMemoryBarrier, 2> postBarriers = preBarriers;
+    postBarriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    postBarriers[0].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    postBarriers[1].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    postBarriers[1].dstAccessMask = VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0, 0, nullptr, static_cast<uint32_t>(postBarriers.size()), postBarriers.data(), 0, nullptr);
+}
+
+void lvk::MeshletCulling::Draw(VkCommandBuffer& commandBuffer, uint32_t frameIndex)
+{
+    if (m_UseMeshShader)
+    {
+        spdlog::error("MeshletCulling : Draw is the compute fallback, this mesh draws with DrawMeshTasks");
+        return;
+    }
+
+    vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffers[frameIndex], 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexedIndirect(commandBuffer, m_DrawCommandBuffers[frameIndex], 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void lvk::MeshletCulling::DrawMeshTasks(VkCommandBuffer& commandBuffer)
+{
+    if (!m_UseMeshShader || m_MeshletCount == 0)
+    {
+        return;
+    }
+
+    uint32_t taskGroups = (m_MeshletCount + k_MeshletsPerTaskWorkgroup - 1) / k_MeshletsPerTaskWorkgroup;
+    vkCmdDrawMeshTasksEXT(commandBuffer, taskGroups, 1, 1);
+}
+
+bool lvk::MeshletCulling::BindMeshletBuffers(VkState& vk, Material& material)
+{
+    Array<VkBuffer, MAX_FRAMES_IN_FLIGHT> viewBuffers;
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        viewBuffers[i] = m_ViewBuffers[i].m_GpuBuffer;
+    }
+
+    // a shader may leave some of these unused, only none of them being declared is an error
+    bool bound = material.SetStorageBuffer(vk, "meshletData", m_MeshletBuffer, std::max<VkDeviceSize>(m_MeshletBufferSize, 16));
+    bound |= material.SetStorageBuffer(vk, "meshletVertices", m_VertexMapBuffer, std::max<VkDeviceSize>(m_VertexMapSize, 16));
+    bound |= material.SetStorageBuffer(vk, "meshletTriangles", m_TriangleBuffer, std::max<VkDeviceSize>(m_TriangleBufferSize, 16));
+    bound |= material.SetStorageBuffer(vk, "meshletView", viewBuffers, sizeof(MeshletView));
+    if (!bound)
+    {
+        spdlog::error("MeshletCulling : material declares no meshlet buffers, was the shader built with InsertMeshShaderGLSL?");
+    }
+    return bound;
+}
+
+lvk::ShaderStage lvk::MeshletCulling::CreateTaskStage(VkState& vk, uint32_t set, uint32_t firstBinding)
+{
+    String source = "#version 450\n#extension GL_EXT_mesh_shader : require\n" +
+        meshlet_glsl(set, firstBinding) + k_MeshletPayloadGLSL + k_MeshletTaskGLSL;
+    return ShaderStage::CreateFromSource(vk, source, ShaderStageType::Task);
+}
+
+lvk::String lvk::MeshletCulling::InsertMeshShaderGLSL(const String& source, uint32_t set, uint32_t firstBinding)
+{
+    return insert_after_version(source, "#extension GL_EXT_mesh_shader : require\n" + meshlet_glsl(set, firstBinding) + k_MeshletPayloadGLSL);
+}
+
+void lvk::MeshletCulling::Free(VkState& vk)
+{
+    if (!m_UseMeshShader)
+    {
+        vkDestroyPipeline(vk.m_LogicalDevice, m_Pipeline, nullptr);
+        vkDestroyPipelineLayout(vk.m_LogicalDevice, m_PipelineLayout, nullptr);
+
+        m_Material.Free(vk);
+
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            vkDestroyBuffer(vk.m_LogicalDevice, m_IndexBuffers[i], nullptr);
+            vmaFreeMemory(vk.m_Allocator, m_IndexAllocations[i]);
+            vkDestroyBuffer(vk.m_LogicalDevice, m_DrawCommandBuffers[i], nullptr);
+            vmaFreeMemory(vk.m_Allocator, m_DrawCommandAllocations[i]);
+        }
+
+        for (auto& stage : m_Program.m_Stages)
+        {
+            vkDestroyShaderModule(vk.m_LogicalDevice, stage.m_Module, nullptr);
+        }
+        m_Program.Free(vk);
+    }
+
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        m_ViewBuffers[i].Free(vk);
+    }
+
+    vkDestroyBuffer(vk.m_LogicalDevice, m_MeshletBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, m_MeshletAllocation);
+    vkDestroyBuffer(vk.m_LogicalDevice, m_VertexMapBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, m_VertexMapAllocation);
+    vkDestroyBuffer(vk.m_LogicalDevice, m_TriangleBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, m_TriangleAllocation);
+}
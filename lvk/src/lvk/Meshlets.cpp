@@ -0,0 +1,295 @@
+#include "lvk/Meshlets.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr uint32_t k_NotInMeshlet = UINT32_MAX;
+
+static glm::vec3 get_position(const float* positions, size_t positionStride, uint32_t vertex)
+{
+    const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + positionStride * vertex);
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+// Ritter's bounding sphere, seeded with the most distant pair of axis extremes
+static void compute_sphere(const lvk::Vector<glm::vec3>& points, glm::vec3& centre, float& radius)
+{
+    size_t minIndex[3] = { 0, 0, 0 };
+    size_t maxIndex[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            minIndex[axis] = points[i][axis] < points[minIndex[axis]][axis] ? i : minIndex[axis];
+            maxIndex[axis] = points[i][axis] > points[maxIndex[axis]][axis] ? i : maxIndex[axis];
+        }
+    }
+
+    int widest = 0;
+    float widestDistance = -1.0f;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float distance = glm::length(points[maxIndex[axis]] - points[minIndex[axis]]);
+        if (distance > widestDistance)
+        {
+            widestDistance = distance;
+            widest = axis;
+        }
+    }
+
+    centre = (points[minIndex[widest]] + points[maxIndex[widest]]) * 0.5f;
+    radius = widestDistance * 0.5f;
+
+    for (const glm::vec3& point : points)
+    {
+        float distance = glm::length(point - centre);
+        if (distance > radius)
+        {
+            float grown = (radius + distance) * 0.5f;
+            centre += (point - centre) * ((grown - radius) / distance);
+            radius = grown;
+        }
+    }
+}
+
+static void compute_bounds(const lvk::meshlets::MeshletMesh& mesh, const lvk::meshlets::Meshlet& meshlet,
+    const float* positions, size_t positionStride, lvk::meshlets::MeshletBounds& bounds)
+{
+    lvk::Vector<glm::vec3> points(meshlet.m_VertexCount);
+    for (uint32_t v = 0; v < meshlet.m_VertexCount; v++)
+    {
+        points[v] = get_position(positions, positionStride, mesh.m_Vertices[meshlet.m_VertexOffset + v]);
+    }
+    compute_sphere(points, bounds.m_Centre, bounds.m_Radius);
+
+    lvk::Vector<glm::vec3> corners;
+    lvk::Vector<glm::vec3> normals;
+    for (uint32_t t = 0; t < meshlet.m_TriangleCount; t++)
+    {
+        const uint8_t* triangle = &mesh.m_Triangles[meshlet.m_TriangleOffset + t * 3];
+        glm::vec3 p0 = points[triangle[0]];
+        glm::vec3 normal = glm::cross(points[triangle[1]] - p0, points[triangle[2]] - p0);
+        float area = glm::length(normal);
+        if (area > 0.0f)
+        {
+            corners.push_back(p0);
+            normals.push_back(normal / area);
+        }
+    }
+
+    glm::vec3 axis(0.0f);
+    for (const glm::vec3& normal : normals)
+    {
+        axis += normal;
+    }
+
+    // no usable cone, the cluster is never backface culled
+    bounds.m_ConeApex = bounds.m_Centre;
+    bounds.m_ConeAxis = glm::vec3(0.0f);
+    bounds.m_ConeCutoff = 2.0f;
+
+    float axisLength = glm::length(axis);
+    if (axisLength <= 0.0f)
+    {
+        return;
+    }
+    axis /= axisLength;
+
+    float minDot = 1.0f;
+    for (const glm::vec3& normal : normals)
+    {
+        minDot = std::min(minDot, glm::dot(normal, axis));
+    }
+
+    // past ~84 degrees of spread the apex runs off towards infinity
+    if (minDot <= 0.1f)
+    {
+        return;
+    }
+
+    // the apex is the point along -axis that is behind every triangle's plane
+    float maxT = 0.0f;
+    for (size_t i = 0; i < normals.size(); i++)
+    {
+        float t = glm::dot(bounds.m_Centre - corners[i], normals[i]) / glm::dot(axis, normals[i]);
+        maxT = std::max(maxT, t);
+    }
+
+    bounds.m_ConeApex = bounds.m_Centre - axis * maxT;
+    bounds.m_ConeAxis = axis;
+    bounds.m_ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+uint32_t lvk::meshlets::MeshletMesh::GetTriangleCount() const
+{
+    uint32_t count = 0;
+    for (const Meshlet& meshlet : m_Meshlets)
+    {
+        count += meshlet.m_TriangleCount;
+    }
+    return count;
+}
+
+bool lvk::meshlets::BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+    size_t vertexCount, MeshletMesh& mesh, uint32_t maxVertices, uint32_t maxTriangles)
+{
+    mesh = MeshletMesh{};
+    maxVertices = std::min(maxVertices, 256u);
+
+    if (indexCount % 3 != 0 || maxVertices < 3 || maxTriangles == 0)
+    {
+        spdlog::error("BuildMeshlets : {} indices, {} max vertices and {} max triangles do not make a valid triangle list",
+            indexCount, maxVertices, maxTriangles);
+        return false;
+    }
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        if (indices[i] >= vertexCount)
+        {
+            spdlog::error("BuildMeshlets : index {} is out of range of {} vertices", indices[i], vertexCount);
+            return false;
+        }
+    }
+
+    size_t triangleCount = indexCount / 3;
+
+    // vertex -> triangles
+    Vector<uint32_t> adjacencyCounts(vertexCount, 0);
+    Vector<uint32_t> adjacencyOffsets(vertexCount, 0);
+    Vector<uint32_t> adjacency(indexCount);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        adjacencyCounts[indices[i]]++;
+    }
+    for (size_t v = 1; v < vertexCount; v++)
+    {
+        adjacencyOffsets[v] = adjacencyOffsets[v - 1] + adjacencyCounts[v - 1];
+    }
+    Vector<uint32_t> fill = adjacencyOffsets;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    Vector<bool> emitted(triangleCount, false);
+    Vector<uint32_t> localIndex(vertexCount, k_NotInMeshlet);
+    Vector<uint32_t> queuedFor(triangleCount, k_NotInMeshlet);
+    Vector<uint32_t> candidates;
+    Meshlet current{};
+
+    auto new_vertices = [&](uint32_t triangle) {
+        uint32_t a = indices[triangle * 3 + 0];
+        uint32_t b = indices[triangle * 3 + 1];
+        uint32_t c = indices[triangle * 3 + 2];
+        uint32_t count = localIndex[a] == k_NotInMeshlet ? 1 : 0;
+        count += (b != a && localIndex[b] == k_NotInMeshlet) ? 1 : 0;
+        count += (c != a && c != b && localIndex[c] == k_NotInMeshlet) ? 1 : 0;
+        return count;
+    };
+
+    auto flush = [&]() {
+        if (current.m_TriangleCount == 0)
+        {
+            return;
+        }
+        for (uint32_t v = 0; v < current.m_VertexCount; v++)
+        {
+            localIndex[mesh.m_Vertices[current.m_VertexOffset + v]] = k_NotInMeshlet;
+        }
+        mesh.m_Meshlets.push_back(current);
+        current = Meshlet{ static_cast<uint32_t>(mesh.m_Vertices.size()), static_cast<uint32_t>(mesh.m_Triangles.size()), 0, 0 };
+        candidates.clear();
+    };
+
+    auto add = [&](uint32_t triangle) {
+        uint32_t meshletIndex = static_cast<uint32_t>(mesh.m_Meshlets.size());
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            if (localIndex[vertex] == k_NotInMeshlet)
+            {
+                localIndex[vertex] = current.m_VertexCount++;
+                mesh.m_Vertices.push_back(vertex);
+            }
+            mesh.m_Triangles.push_back(static_cast<uint8_t>(localIndex[vertex]));
+        }
+        current.m_TriangleCount++;
+        emitted[triangle] = true;
+
+        // triangles sharing a vertex with the meshlet are the ones worth growing into
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            uint32_t begin = adjacencyOffsets[vertex];
+            uint32_t end = begin + adjacencyCounts[vertex];
+            for (uint32_t a = begin; a < end; a++)
+            {
+                uint32_t neighbour = adjacency[a];
+                if (!emitted[neighbour] && queuedFor[neighbour] != meshletIndex)
+                {
+                    queuedFor[neighbour] = meshletIndex;
+                    candidates.push_back(neighbour);
+                }
+            }
+        }
+    };
+
+    size_t cursor = 0;
+    for (size_t added = 0; added < triangleCount; added++)
+    {
+        // the candidate adding the fewest vertices, earlier triangles first to keep the index order's locality
+        int64_t best = -1;
+        uint32_t bestCost = 4;
+        size_t kept = 0;
+        for (uint32_t candidate : candidates)
+        {
+            if (emitted[candidate])
+            {
+                continue;
+            }
+            candidates[kept++] = candidate;
+
+            uint32_t cost = new_vertices(candidate);
+            if (current.m_VertexCount + cost > maxVertices)
+            {
+                continue;
+            }
+            if (cost < bestCost || (cost == bestCost && candidate < best))
+            {
+                best = candidate;
+                bestCost = cost;
+            }
+        }
+        candidates.resize(kept);
+
+        // nothing connected fits, start the next meshlet from the first triangle left
+        if (best < 0)
+        {
+            flush();
+            while (emitted[cursor])
+            {
+                cursor++;
+            }
+            best = static_cast<int64_t>(cursor);
+        }
+
+        add(static_cast<uint32_t>(best));
+        if (current.m_TriangleCount == maxTriangles)
+        {
+            flush();
+        }
+    }
+    flush();
+
+    while (mesh.m_Triangles.size() % 4 != 0)
+    {
+        mesh.m_Triangles.push_back(0);
+    }
+
+    mesh.m_Bounds.resize(mesh.m_Meshlets.size());
+    for (size_t i = 0; i < mesh.m_Meshlets.size(); i++)
+    {
+        compute_bounds(mesh, mesh.m_Meshlets[i], positions, positionStride, mesh.m_Bounds[i]);
+    }
+    return true;
+}
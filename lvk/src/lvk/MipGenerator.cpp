@@ -0,0 +1,497 @@
+#include "lvk/MipGenerator.h"
+#include "lvk/Macros.h"
+#include "lvk/Pipeline.h"
+#include "spdlog/spdlog.h"
+#include "volk.h"
+#include <algorithm>
+
+static const char* k_MipGeneratorDeclarationsGLSL = R"(
+layout(local_size_x = 256) in;
+
+layout(set = 0, binding = 0, MIP_FORMAT) uniform readonly image2D srcMip;
+layout(set = 0, binding = 1, MIP_FORMAT) uniform writeonly image2D dstMips[4];
+
+layout(push_constant) uniform MipConstants
+{
+    uvec2 srcSize;
+    uint  mipCount;
+    uint  flags;
+} mipConstants;
+
+#define MIP_FLAG_SRGB       1u
+#define MIP_FLAG_NORMAL_MAP 2u
+#define MIP_FLAG_UNORM      4u
+
+shared vec4 s_Texels[16][16];
+
+bool Mip_HasFlag(uint flag)
+{
+    return (mipConstants.flags & flag) != 0u;
+}
+
+// texel as stored -> the space it is averaged in
+vec4 Mip_Decode(vec4 texel)
+{
+    if (Mip_HasFlag(MIP_FLAG_NORMAL_MAP))
+    {
+        if (Mip_HasFlag(MIP_FLAG_UNORM))
+        {
+            texel.xyz = texel.xyz * 2.0 - 1.0;
+        }
+    }
+    else if (Mip_HasFlag(MIP_FLAG_SRGB))
+    {
+        texel.rgb = mix(texel.rgb / 12.92, pow((texel.rgb + 0.055) / 1.055, vec3(2.4)), greaterThan(texel.rgb, vec3(0.04045)));
+    }
+    return texel;
+}
+
+vec4 Mip_Encode(vec4 texel)
+{
+    if (Mip_HasFlag(MIP_FLAG_NORMAL_MAP))
+    {
+        if (Mip_HasFlag(MIP_FLAG_UNORM))
+        {
+            texel.xyz = texel.xyz * 0.5 + 0.5;
+        }
+    }
+    else if (Mip_HasFlag(MIP_FLAG_SRGB))
+    {
+        vec3 c = clamp(texel.rgb, 0.0, 1.0);
+        texel.rgb = mix(c * 12.92, 1.055 * pow(c, vec3(1.0 / 2.4)) - 0.055, greaterThan(c, vec3(0.0031308)));
+    }
+    return texel;
+}
+
+// averaged normals shorten, the next level is built from the renormalised ones
+vec4 Mip_Resolve(vec4 texel)
+{
+    if (Mip_HasFlag(MIP_FLAG_NORMAL_MAP))
+    {
+        float length2 = dot(texel.xyz, texel.xyz);
+        texel.xyz = length2 > 1e-12 ? texel.xyz * inversesqrt(length2) : vec3(0.0, 0.0, 1.0);
+    }
+    return texel;
+}
+
+// area weighted average of the source texels dst texel covers, 2x2 for even sizes and up to 4x4
+// partially covered texels when the source is odd
+vec4 Mip_LoadFootprint(uvec2 texel, uvec2 dstSize)
+{
+    vec2 scale = vec2(mipConstants.srcSize) / vec2(dstSize);
+    vec2 begin = vec2(texel) * scale;
+    vec2 end = begin + scale;
+    uvec2 last = min(uvec2(ceil(end)), mipConstants.srcSize) - 1u;
+
+    vec4 sum = vec4(0.0);
+    for (uint y = uint(begin.y); y <= last.y; y++)
+    {
+        float wy = min(end.y, float(y + 1u)) - max(begin.y, float(y));
+        for (uint x = uint(begin.x); x <= last.x; x++)
+        {
+            float wx = min(end.x, float(x + 1u)) - max(begin.x, float(x));
+            sum += Mip_Decode(imageLoad(srcMip, ivec2(x, y))) * (wx * wy);
+        }
+    }
+    return sum / (scale.x * scale.y);
+}
+)";
+
+static const char* k_MipGeneratorMainGLSL = R"(
+void Mip_StoreChecked(uint mip, uvec2 texel, uvec2 size, vec4 value)
+{
+    if (all(lessThan(texel, size)))
+    {
+        Mip_Store(mip, ivec2(texel), Mip_Encode(value));
+    }
+}
+
+void main()
+{
+    uvec2 local = uvec2(gl_LocalInvocationIndex % 16, gl_LocalInvocationIndex / 16);
+
+    // first level : one texel per thread straight from the source level
+    uvec2 dstSize = max(mipConstants.srcSize >> 1, uvec2(1));
+    uvec2 texel = gl_WorkGroupID.xy * 16 + local;
+    vec4 value = vec4(0.0);
+    if (all(lessThan(texel, dstSize)))
+    {
+        value = Mip_Resolve(Mip_LoadFootprint(texel, dstSize));
+    }
+    Mip_StoreChecked(0, texel, dstSize, value);
+    s_Texels[local.y][local.x] = value;
+    barrier();
+
+    // the host only asks for more levels while every size halves exactly or is already 1
+    uvec2 tile = uvec2(16);
+    for (uint mip = 1; mip < mipConstants.mipCount; mip++)
+    {
+        uvec2 step = uvec2(greaterThan(dstSize, uvec2(1))) + 1u;
+        dstSize = max(dstSize >> 1, uvec2(1));
+        tile = max(tile / step, uvec2(1));
+
+        bool active = all(lessThan(local, tile));
+        vec4 reduced = vec4(0.0);
+        if (active)
+        {
+            uvec2 s = local * step;
+            for (uint y = 0u; y < step.y; y++)
+            {
+                for (uint x = 0u; x < step.x; x++)
+                {
+                    reduced += s_Texels[s.y + y][s.x + x];
+                }
+            }
+            reduced = Mip_Resolve(reduced / float(step.x * step.y));
+        }
+        barrier();
+        if (active)
+        {
+            s_Texels[local.y][local.x] = reduced;
+            Mip_StoreChecked(mip, gl_WorkGroupID.xy * tile + local, dstSize, reduced);
+        }
+        barrier();
+    }
+}
+)";
+
+// the destination mips are indexed with constants so the shader does not need
+// shaderStorageImageArrayDynamicIndexing
+static lvk::String mip_generator_source(const char* formatQualifier)
+{
+    using lvk::String;
+    String store = "void Mip_Store(uint mip, ivec2 texel, vec4 value)\n{\n    switch (mip)\n    {\n";
+    for (uint32_t i = 0; i < lvk::MipGenerator::k_MipsPerDispatch; i++)
+    {
+        String index = std::to_string(i);
+        store += "    case " + index + ": imageStore(dstMips[" + index + "], texel, value); break;\n";
+    }
+    store += "    }\n}\n";
+
+    return "#version 450\n#define MIP_FORMAT " + String(formatQualifier) + "\n" +
+        k_MipGeneratorDeclarationsGLSL + store + k_MipGeneratorMainGLSL;
+}
+
+// the UNORM alias written in place of an sRGB format
+static VkFormat storage_format(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R8_SRGB:         return VK_FORMAT_R8_UNORM;
+    case VK_FORMAT_R8G8_SRGB:       return VK_FORMAT_R8G8_UNORM;
+    case VK_FORMAT_R8G8B8A8_SRGB:   return VK_FORMAT_R8G8B8A8_UNORM;
+    default:                        return format;
+    }
+}
+
+static const char* format_qualifier(VkFormat storageFormat)
+{
+    switch (storageFormat)
+    {
+    case VK_FORMAT_R8_UNORM:                    return "r8";
+    case VK_FORMAT_R8G8_UNORM:                  return "rg8";
+    case VK_FORMAT_R8G8B8A8_UNORM:              return "rgba8";
+    case VK_FORMAT_R16G16B16A16_UNORM:          return "rgba16";
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:    return "rgb10_a2";
+    case VK_FORMAT_R16_SFLOAT:                  return "r16f";
+    case VK_FORMAT_R16G16_SFLOAT:               return "rg16f";
+    case VK_FORMAT_R16G16B16A16_SFLOAT:         return "rgba16f";
+    case VK_FORMAT_R32_SFLOAT:                  return "r32f";
+    case VK_FORMAT_R32G32_SFLOAT:               return "rg32f";
+    case VK_FORMAT_R32G32B32A32_SFLOAT:         return "rgba32f";
+    case VK_FORMAT_B10G11R11_UFLOAT_PACK32:     return "r11f_g11f_b10f";
+    default:                                    return nullptr;
+    }
+}
+
+static bool is_unorm(VkFormat storageFormat)
+{
+    return storageFormat == VK_FORMAT_R8_UNORM || storageFormat == VK_FORMAT_R8G8_UNORM || storageFormat == VK_FORMAT_R8G8B8A8_UNORM
+        || storageFormat == VK_FORMAT_R16G16B16A16_UNORM || storageFormat == VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+}
+
+static VkExtent2D mip_extent(VkExtent2D extent, uint32_t mip)
+{
+    return { std::max(extent.width >> mip, 1u), std::max(extent.height >> mip, 1u) };
+}
+
+// a level can be halved inside a workgroup's tile when each side is even or already 1
+static bool halves_exactly(VkExtent2D extent)
+{
+    return (extent.width % 2 == 0 || extent.width == 1) && (extent.height % 2 == 0 || extent.height == 1);
+}
+
+// matches the MipConstants push constant block
+struct MipConstants
+{
+    uint32_t m_SrcSize[2];
+    uint32_t m_MipCount;
+    uint32_t m_Flags;
+};
+
+static constexpr uint32_t k_FlagUnorm = 1 << 2;
+
+static lvk::Unique<lvk::MipGenerator> s_DefaultGenerator;
+
+lvk::MipGenerator lvk::MipGenerator::Create(VkState& vk)
+{
+    MipGenerator generator{};
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSize.descriptorCount = k_MaxChainSets * (1 + k_MipsPerDispatch);
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.maxSets = k_MaxChainSets;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    VK_CHECK(vkCreateDescriptorPool(vk.m_LogicalDevice, &poolInfo, nullptr, &generator.m_DescriptorPool));
+
+    return generator;
+}
+
+lvk::MipGenerator& lvk::MipGenerator::Default(VkState& vk)
+{
+    if (!s_DefaultGenerator)
+    {
+        s_DefaultGenerator = std::make_unique<MipGenerator>(Create(vk));
+    }
+    return *s_DefaultGenerator;
+}
+
+void lvk::MipGenerator::FreeDefault(VkState& vk)
+{
+    if (s_DefaultGenerator)
+    {
+        s_DefaultGenerator->Free(vk);
+        s_DefaultGenerator.reset();
+    }
+}
+
+bool lvk::MipGenerator::Supports(VkState& vk, VkFormat format)
+{
+    VkFormat storageFormat = storage_format(format);
+    if (format_qualifier(storageFormat) == nullptr)
+    {
+        return false;
+    }
+
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(vk.m_PhysicalDevice, storageFormat, &formatProperties);
+    return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0;
+}
+
+VkFormat lvk::MipGenerator::GetStorageFormat(VkFormat format)
+{
+    return storage_format(format);
+}
+
+bool lvk::MipGenerator::CreateChain(VkState& vk, VkImage image, VkFormat format, VkExtent2D extent, uint32_t mipCount, uint32_t flags, Chain& chain)
+{
+    if (!Supports(vk, format))
+    {
+        spdlog::error("MipGenerator : format {} cannot be written from compute", static_cast<uint32_t>(format));
+        return false;
+    }
+
+    chain = {};
+    chain.m_Image = image;
+    chain.m_Extent = extent;
+    chain.m_MipCount = mipCount;
+    chain.m_StorageFormat = storage_format(format);
+    chain.m_Flags = flags;
+    if (chain.m_StorageFormat != format)
+    {
+        chain.m_Flags |= Srgb;
+    }
+    if (is_unorm(chain.m_StorageFormat))
+    {
+        chain.m_Flags |= k_FlagUnorm;
+    }
+
+    auto pipeline = m_Pipelines.find(chain.m_StorageFormat);
+    if (pipeline == m_Pipelines.end())
+    {
+        Pipeline created;
+        ShaderStage stage = ShaderStage::CreateFromSource(vk, mip_generator_source(format_qualifier(chain.m_StorageFormat)), ShaderStageType::Compute);
+        created.m_Program = ShaderProgram::CreateCompute(vk, stage);
+        created.m_Pipeline = pipelines::CreateComputePipeline(vk, stage.m_StageBinary, created.m_Program.m_DescriptorSetLayout, created.m_PipelineLayout);
+        pipeline = m_Pipelines.emplace(chain.m_StorageFormat, created).first;
+    }
+
+    chain.m_MipViews.resize(mipCount);
+    for (uint32_t mip = 0; mip < mipCount; mip++)
+    {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = chain.m_StorageFormat;
+        viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, 0, 1 };
+        VK_CHECK(vkCreateImageView(vk.m_LogicalDevice, &viewInfo, nullptr, &chain.m_MipViews[mip]));
+    }
+
+    // each dispatch goes as far as it can from its source, see halves_exactly
+    uint32_t sourceMip = 0;
+    while (sourceMip + 1 < mipCount)
+    {
+        Dispatch dispatch{ sourceMip, 1, VK_NULL_HANDLE };
+        while (dispatch.m_MipCount < k_MipsPerDispatch && sourceMip + dispatch.m_MipCount + 1 < mipCount
+            && halves_exactly(mip_extent(extent, sourceMip + dispatch.m_MipCount)))
+        {
+            dispatch.m_MipCount++;
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_DescriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &pipeline->second.m_Program.m_DescriptorSetLayout;
+        if (vkAllocateDescriptorSets(vk.m_LogicalDevice, &allocInfo, &dispatch.m_DescriptorSet) != VK_SUCCESS)
+        {
+            spdlog::error("MipGenerator : out of descriptor sets, free unused chains");
+            FreeChain(vk, chain);
+            return false;
+        }
+
+        VkDescriptorImageInfo srcInfo{ VK_NULL_HANDLE, chain.m_MipViews[sourceMip], VK_IMAGE_LAYOUT_GENERAL };
+
+        // every element is written, the ones past the dispatch's last level alias it
+        Array<VkDescriptorImageInfo, k_MipsPerDispatch> dstInfos{};
+        for (uint32_t i = 0; i < k_MipsPerDispatch; i++)
+        {
+            dstInfos[i] = { VK_NULL_HANDLE, chain.m_MipViews[sourceMip + 1 + std::min(i, dispatch.m_MipCount - 1)], VK_IMAGE_LAYOUT_GENERAL };
+        }
+
+        Array<VkWriteDescriptorSet, 2> writes{};
+        for (auto& write : writes)
+        {
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = dispatch.m_DescriptorSet;
+            write.dstArrayElement = 0;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        }
+        writes[0].dstBinding = 0;
+        writes[0].descriptorCount = 1;
+        writes[0].pImageInfo = &srcInfo;
+        writes[1].dstBinding = 1;
+        writes[1].descriptorCount = k_MipsPerDispatch;
+        writes[1].pImageInfo = dstInfos.data();
+        vkUpdateDescriptorSets(vk.m_LogicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        chain.m_Dispatches.push_back(dispatch);
+        sourceMip += dispatch.m_MipCount;
+    }
+    return true;
+}
+
+void lvk::MipGenerator::FreeChain(VkState& vk, Chain& chain)
+{
+    for (const Dispatch& dispatch : chain.m_Dispatches)
+    {
+        if (dispatch.m_DescriptorSet != VK_NULL_HANDLE)
+        {
+            vkFreeDescriptorSets(vk.m_LogicalDevice, m_DescriptorPool, 1, &dispatch.m_DescriptorSet);
+        }
+    }
+    for (VkImageView view : chain.m_MipViews)
+    {
+        vkDestroyImageView(vk.m_LogicalDevice, view, nullptr);
+    }
+    chain = {};
+}
+
+void lvk::MipGenerator::Record(VkCommandBuffer commandBuffer, const Chain& chain, VkImageLayout oldLayout, VkImageLayout newLayout) const
+{
+    if (chain.m_MipCount == 0)
+    {
+        return;
+    }
+
+    Array<VkImageMemoryBarrier, 2> barriers{};
+    for (auto& barrier : barriers)
+    {
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = chain.m_Image;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    }
+
+    // level 0 from whatever wrote it, the rest are about to be overwritten
+    barriers[0].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barriers[0].oldLayout = oldLayout;
+    barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    barriers[1].srcAccessMask = 0;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 1, chain.m_MipCount - 1, 0, 1 };
+
+    const uint32_t barrierCount = chain.m_MipCount > 1 ? 2 : 1;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, barrierCount, barriers.data());
+
+    if (!chain.m_Dispatches.empty())
+    {
+        const Pipeline& pipeline = m_Pipelines.at(chain.m_StorageFormat);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.m_Pipeline);
+
+        for (size_t i = 0; i < chain.m_Dispatches.size(); i++)
+        {
+            const Dispatch& dispatch = chain.m_Dispatches[i];
+            if (i > 0)
+            {
+                // the previous dispatch's last level is this one's source
+                VkMemoryBarrier memoryBarrier{};
+                memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+            }
+
+            VkExtent2D source = mip_extent(chain.m_Extent, dispatch.m_SourceMip);
+            VkExtent2D first = mip_extent(chain.m_Extent, dispatch.m_SourceMip + 1);
+
+            MipConstants constants{};
+            constants.m_SrcSize[0] = source.width;
+            constants.m_SrcSize[1] = source.height;
+            constants.m_MipCount = dispatch.m_MipCount;
+            constants.m_Flags = chain.m_Flags;
+
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.m_PipelineLayout, 0, 1, &dispatch.m_DescriptorSet, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, pipeline.m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MipConstants), &constants);
+            vkCmdDispatch(commandBuffer, (first.width + k_TileSize - 1) / k_TileSize, (first.height + k_TileSize - 1) / k_TileSize, 1);
+        }
+    }
+
+    VkImageMemoryBarrier done = barriers[0];
+    done.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    done.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    done.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    done.newLayout = newLayout;
+    done.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, chain.m_MipCount, 0, 1 };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &done);
+}
+
+void lvk::MipGenerator::Free(VkState& vk)
+{
+    for (auto& [format, pipeline] : m_Pipelines)
+    {
+        vkDestroyPipeline(vk.m_LogicalDevice, pipeline.m_Pipeline, nullptr);
+        vkDestroyPipelineLayout(vk.m_LogicalDevice, pipeline.m_PipelineLayout, nullptr);
+        for (auto& stage : pipeline.m_Program.m_Stages)
+        {
+            vkDestroyShaderModule(vk.m_LogicalDevice, stage.m_Module, nullptr);
+        }
+        pipeline.m_Program.Free(vk);
+    }
+    m_Pipelines.clear();
+
+    vkDestroyDescriptorPool(vk.m_LogicalDevice, m_DescriptorPool, nullptr);
+    m_DescriptorPool = VK_NULL_HANDLE;
+}
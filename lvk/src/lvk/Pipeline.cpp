@@ -3,6 +3,21 @@
 
 namespace lvk::pipelines {
 
+static VkShaderStageFlagBits get_stage_flag(ShaderStageType type) {
+  switch (type) {
+  case ShaderStageType::Vertex:
+    return VK_SHADER_STAGE_VERTEX_BIT;
+  case ShaderStageType::Fragment:
+    return VK_SHADER_STAGE_FRAGMENT_BIT;
+  case ShaderStageType::Task:
+    return VK_SHADER_STAGE_TASK_BIT_EXT;
+  case ShaderStageType::Mesh:
+    return VK_SHADER_STAGE_MESH_BIT_EXT;
+  default:
+    return VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+}
+
 VkPipeline CreateRasterPipeline(
     VkState &vk, ShaderProgram &shader,
     VertexDescription& vertexDescription,
@@ -11,30 +26,23 @@ VkPipeline CreateRasterPipeline(
     VkRenderPass &pipelineRenderPass, VkExtent2D resolution,
     VkPipelineLayout &pipelineLayout, uint32_t colorAttachmentCount) {
 
-  VkShaderModule vertShaderModule =
-      CreateShaderModule(vk, shader.m_Stages[0].m_StageBinary);
-  VkShaderModule fragShaderModule =
-      CreateShaderModule(vk, shader.m_Stages[1].m_StageBinary);
-
-  spdlog::info("Loaded vertex and fragment shaders & created shader modules");
-
-  // ..
-  VkPipelineShaderStageCreateInfo vertexShaderStageInfo{};
-  vertexShaderStageInfo.sType =
-      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-  vertexShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-  vertexShaderStageInfo.module = vertShaderModule;
-  vertexShaderStageInfo.pName = "main";
-
-  VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-  fragShaderStageInfo.sType =
-      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-  fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-  fragShaderStageInfo.module = fragShaderModule;
-  fragShaderStageInfo.pName = "main";
+  // a program with a mesh stage generates its own geometry and has no vertex input
+  bool meshPipeline = false;
+  Vector<VkShaderModule> shaderModules;
+  std::vector<VkPipelineShaderStageCreateInfo> shaderStageCreateInfos;
+  for (auto &stage : shader.m_Stages) {
+    VkPipelineShaderStageCreateInfo stageInfo{};
+    stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stageInfo.stage = get_stage_flag(stage.m_Type);
+    stageInfo.module = CreateShaderModule(vk, stage.m_StageBinary);
+    stageInfo.pName = "main";
+
+    shaderModules.push_back(stageInfo.module);
+    shaderStageCreateInfos.push_back(stageInfo);
+    meshPipeline |= stage.m_Type == ShaderStageType::Mesh;
+  }
 
-  std::vector<VkPipelineShaderStageCreateInfo> shaderStageCreateInfos = {
-      vertexShaderStageInfo, fragShaderStageInfo};
+  spdlog::info("Loaded {} shader stages & created shader modules", shaderModules.size());
 
   VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
   vertexInputInfo.sType =
@@ -222,11 +230,11 @@ VkPipeline CreateRasterPipeline(
 
   VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
   pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-  pipelineCreateInfo.stageCount = 2;
+  pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStageCreateInfos.size());
   pipelineCreateInfo.pStages = shaderStageCreateInfos.data();
 
-  pipelineCreateInfo.pVertexInputState = &vertexInputInfo;
-  pipelineCreateInfo.pInputAssemblyState = &inputAssemblyInfo;
+  pipelineCreateInfo.pVertexInputState = meshPipeline ? nullptr : &vertexInputInfo;
+  pipelineCreateInfo.pInputAssemblyState = meshPipeline ? nullptr : &inputAssemblyInfo;
   pipelineCreateInfo.pViewportState = &viewportInfo;
   pipelineCreateInfo.pRasterizationState = &rasterizerInfo;
   pipelineCreateInfo.pMultisampleState = &multisampleInfo;
@@ -244,19 +252,60 @@ VkPipeline CreateRasterPipeline(
   VK_CHECK(vkCreateGraphicsPipelines(vk.m_LogicalDevice, VK_NULL_HANDLE, 1,
                                      &pipelineCreateInfo, nullptr, &pipeline))
 
-  vkDestroyShaderModule(vk.m_LogicalDevice, vertShaderModule, nullptr);
-  vkDestroyShaderModule(vk.m_LogicalDevice, fragShaderModule, nullptr);
+  for (auto module : shaderModules) {
+    vkDestroyShaderModule(vk.m_LogicalDevice, module, nullptr);
+  }
 
-  spdlog::info("Destroyed vertex and fragment shader modules");
+  spdlog::info("Destroyed shader modules");
 
   return pipeline;
 }
 
+VkPipeline CreateMeshPipeline(
+    VkState &vk, ShaderProgram &shader,
+    RasterizationState & rasterState,
+    RasterPipelineState& pipelineState,
+    VkRenderPass &pipelineRenderPass, VkExtent2D resolution,
+    VkPipelineLayout &pipelineLayout, uint32_t colorAttachmentCount) {
+  if (!vk.m_DeviceFeatures.m_MeshShader) {
+    spdlog::error("VulkanAPI : CreateMeshPipeline : VK_EXT_mesh_shader is not enabled on this device.");
+    return VK_NULL_HANDLE;
+  }
+
+  VertexDescription noVertexInput{};
+  return CreateRasterPipeline(vk, shader, noVertexInput, rasterState, pipelineState,
+                              pipelineRenderPass, resolution, pipelineLayout,
+                              colorAttachmentCount);
+}
+
 VkPipeline
 CreateComputePipeline(VkState &vk, StageBinary &comp,
                            VkDescriptorSetLayout &descriptorSetLayout,
                            VkPipelineLayout &pipelineLayout) {
 
+  Vector<PushConstantBlock> pushConstants = descriptor::ReflectPushConstants(vk, comp);
+  if (pushConstants.size() > 1) {
+    spdlog::error(
+        "VulkanAPI : CreateComputePipeline : Supplied stage has more than 1 push constant block, this is not allowed.");
+  }
+
+  VkPushConstantRange pushConstantRange{};
+  if (!pushConstants.empty()) {
+    pushConstantRange.offset = pushConstants[0].m_Offset;
+    pushConstantRange.size = pushConstants[0].m_Size;
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = pushConstants.empty() ? 0 : 1;
+  pipelineLayoutInfo.pPushConstantRanges = pushConstants.empty() ? nullptr : &pushConstantRange;
+
+  VK_CHECK(vkCreatePipelineLayout(vk.m_LogicalDevice, &pipelineLayoutInfo,
+                                  nullptr, &pipelineLayout))
+
   auto compStage = CreateShaderModule(vk, comp);
 
   VkPipelineShaderStageCreateInfo compShaderStageInfo{};
@@ -271,15 +320,15 @@ CreateComputePipeline(VkState &vk, StageBinary &comp,
   pipelineInfo.layout = pipelineLayout;
   pipelineInfo.stage = compShaderStageInfo;
 
-  VkPipeline pipeline;
+  VkPipeline pipeline = VK_NULL_HANDLE;
 
   if (vkCreateComputePipelines(vk.m_LogicalDevice, VK_NULL_HANDLE, 1,
                                &pipelineInfo, nullptr,
                                &pipeline) != VK_SUCCESS) {
     spdlog::error("failed to create compute pipeline!");
-    return pipeline;
   }
 
-  return VK_NULL_HANDLE;
+  vkDestroyShaderModule(vk.m_LogicalDevice, compStage, nullptr);
+  return pipeline;
 }
 }
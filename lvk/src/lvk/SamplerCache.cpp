@@ -0,0 +1,147 @@
+#include "volk.h"
+#include "lvk/SamplerCache.h"
+#include "lvk/Macros.h"
+#include "spdlog/spdlog.h"
+#include <cstring>
+
+static void hash_combine(size_t& hash, size_t value)
+{
+    hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+}
+
+static size_t hash_float(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+VkSampler lvk::SamplerCache::Acquire(VkDevice device, const VkSamplerCreateInfo& info)
+{
+    if (info.pNext != nullptr)
+    {
+        VkSampler sampler;
+        VK_CHECK(vkCreateSampler(device, &info, nullptr, &sampler))
+        return sampler;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const size_t hash = Hash(info);
+    Vector<Entry>& bucket = m_Buckets[hash];
+    for (Entry& entry : bucket)
+    {
+        if (Equal(entry.m_Info, info))
+        {
+            entry.m_RefCount++;
+            return entry.m_Sampler;
+        }
+    }
+
+    VkSampler sampler;
+    VK_CHECK(vkCreateSampler(device, &info, nullptr, &sampler))
+    bucket.push_back({ info, sampler, 1 });
+    m_SamplerHashes[sampler] = hash;
+    return sampler;
+}
+
+void lvk::SamplerCache::Release(VkDevice device, VkSampler sampler)
+{
+    if (sampler == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto hash = m_SamplerHashes.find(sampler);
+    if (hash == m_SamplerHashes.end())
+    {
+        // created for a pNext chained info
+        vkDestroySampler(device, sampler, nullptr);
+        return;
+    }
+
+    Vector<Entry>& bucket = m_Buckets[hash->second];
+    for (size_t i = 0; i < bucket.size(); i++)
+    {
+        if (bucket[i].m_Sampler != sampler)
+        {
+            continue;
+        }
+        if (--bucket[i].m_RefCount == 0)
+        {
+            vkDestroySampler(device, sampler, nullptr);
+            bucket.erase(bucket.begin() + i);
+            if (bucket.empty())
+            {
+                m_Buckets.erase(hash->second);
+            }
+            m_SamplerHashes.erase(hash);
+        }
+        return;
+    }
+}
+
+void lvk::SamplerCache::Free(VkDevice device)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_SamplerHashes.empty())
+    {
+        spdlog::warn("SamplerCache : {} samplers still referenced at shutdown", m_SamplerHashes.size());
+    }
+    for (auto& [hash, bucket] : m_Buckets)
+    {
+        for (Entry& entry : bucket)
+        {
+            vkDestroySampler(device, entry.m_Sampler, nullptr);
+        }
+    }
+    m_Buckets.clear();
+    m_SamplerHashes.clear();
+}
+
+uint32_t lvk::SamplerCache::GetSamplerCount() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return static_cast<uint32_t>(m_SamplerHashes.size());
+}
+
+size_t lvk::SamplerCache::Hash(const VkSamplerCreateInfo& info)
+{
+    size_t hash = info.flags;
+    hash_combine(hash, info.magFilter);
+    hash_combine(hash, info.minFilter);
+    hash_combine(hash, info.mipmapMode);
+    hash_combine(hash, info.addressModeU);
+    hash_combine(hash, info.addressModeV);
+    hash_combine(hash, info.addressModeW);
+    hash_combine(hash, hash_float(info.mipLodBias));
+    hash_combine(hash, info.anisotropyEnable);
+    hash_combine(hash, hash_float(info.maxAnisotropy));
+    hash_combine(hash, info.compareEnable);
+    hash_combine(hash, info.compareOp);
+    hash_combine(hash, hash_float(info.minLod));
+    hash_combine(hash, hash_float(info.maxLod));
+    hash_combine(hash, info.borderColor);
+    hash_combine(hash, info.unnormalizedCoordinates);
+    return hash;
+}
+
+bool lvk::SamplerCache::Equal(const VkSamplerCreateInfo& a, const VkSamplerCreateInfo& b)
+{
+    return a.flags == b.flags
+        && a.magFilter == b.magFilter
+        && a.minFilter == b.minFilter
+        && a.mipmapMode == b.mipmapMode
+        && a.addressModeU == b.addressModeU
+        && a.addressModeV == b.addressModeV
+        && a.addressModeW == b.addressModeW
+        && a.mipLodBias == b.mipLodBias
+        && a.anisotropyEnable == b.anisotropyEnable
+        && a.maxAnisotropy == b.maxAnisotropy
+        && a.compareEnable == b.compareEnable
+        && a.compareOp == b.compareOp
+        && a.minLod == b.minLod
+        && a.maxLod == b.maxLod
+        && a.borderColor == b.borderColor
+        && a.unnormalizedCoordinates == b.unnormalizedCoordinates;
+}
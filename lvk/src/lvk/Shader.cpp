@@ -30,6 +30,45 @@ ShaderProgram ShaderProgram::CreateCompute(VkState &vk, ShaderStage &compute) {
   return {Vector<ShaderStage>{compute}, layout};
 }
 
+ShaderProgram ShaderProgram::CreateMesh(VkState &vk, ShaderStage &task,
+                                        ShaderStage &mesh, ShaderStage &frag) {
+  // task and mesh bindings are merged like a vertex stage's
+  Vector<DescriptorSetLayoutData> geometryLayoutDatas = task.m_LayoutDatas;
+  geometryLayoutDatas.insert(geometryLayoutDatas.end(),
+                             mesh.m_LayoutDatas.begin(),
+                             mesh.m_LayoutDatas.end());
+
+  VkDescriptorSetLayout layout;
+  descriptor::CreateDescriptorSetLayout(vk, geometryLayoutDatas,
+                                        frag.m_LayoutDatas, layout);
+
+  return {Vector<ShaderStage>{task, mesh, frag}, layout};
+}
+
+bool ShaderStage::SetDynamicUniformBuffer(const String &bindingName) {
+  for (auto &layoutData : m_LayoutDatas) {
+    for (auto &bindingData : layoutData.m_BindingDatas) {
+      if (bindingData.m_BindingName != bindingName) {
+        continue;
+      }
+
+      if (bindingData.m_BufferType != ShaderBindingType::UniformBuffer) {
+        spdlog::error("ShaderStage : {} is not a uniform buffer, cannot make it dynamic", bindingName);
+        return false;
+      }
+
+      bindingData.m_BufferType = ShaderBindingType::DynamicUniformBuffer;
+      for (auto &binding : layoutData.m_Bindings) {
+        if (binding.binding == bindingData.m_BindingIndex) {
+          binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
 VkShaderModule CreateShaderModule(VkState &vk, const StageBinary &data) {
   VkShaderModuleCreateInfo createInfo{};
   createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -72,6 +111,10 @@ shaderc_shader_kind get_shaderc_type_from_lvk(lvk::ShaderStageType type)
       return shaderc_shader_kind ::shaderc_glsl_fragment_shader;
     case lvk::ShaderStageType::Compute:
       return shaderc_shader_kind ::shaderc_glsl_compute_shader;
+    case lvk::ShaderStageType::Task:
+      return shaderc_shader_kind ::shaderc_glsl_task_shader;
+    case lvk::ShaderStageType::Mesh:
+      return shaderc_shader_kind ::shaderc_glsl_mesh_shader;
     default:
       return shaderc_shader_kind ::shaderc_compute_shader;
   }
@@ -82,6 +125,14 @@ StageBinary CreateStageBinaryFromSource(VkState &vk, ShaderStageType type,
   shaderc_compiler* c = shaderc_compiler_initialize();
   shaderc_compile_options_t opt {};
 
+  // GL_EXT_mesh_shader needs SPIR-V 1.4, the default vulkan 1.0 target stops at 1.0
+  bool meshStage = type == ShaderStageType::Task || type == ShaderStageType::Mesh;
+  if (meshStage) {
+    opt = shaderc_compile_options_initialize();
+    shaderc_compile_options_set_target_env(opt, shaderc_target_env_vulkan,
+                                           shaderc_env_version_vulkan_1_2);
+  }
+
   auto result = shaderc_compile_into_spv(c,
                           source.c_str(),
                           source.size(),
@@ -102,6 +153,9 @@ StageBinary CreateStageBinaryFromSource(VkState &vk, ShaderStageType type,
 
   shaderc_result_release(result);
   shaderc_compiler_release(c);
+  if (opt != nullptr) {
+    shaderc_compile_options_release(opt);
+  }
 
   return bin;
 }
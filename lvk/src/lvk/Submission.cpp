@@ -6,6 +6,11 @@
 #include "spdlog/spdlog.h"
 #include "ImGui/imgui_impl_vulkan.h"
 
+void lvk::submission::WaitForFrame(VkState& vk)
+{
+  vkWaitForFences(vk.m_LogicalDevice, 1, &vk.m_FrameInFlightFences[vk.m_CurrentFrameIndex], VK_TRUE, UINT64_MAX);
+}
+
 void lvk::submission::SubmitFrame(VkState& vk)
 {
   if(vk.m_RunComputeCommands)
@@ -2,8 +2,11 @@
 #include "ThirdParty/stb_image.h"
 #include "lvk/Buffer.h"
 #include "lvk/Commands.h"
+#include "lvk/MipGenerator.h"
 #include "lvk/Utils.h"
 #include "volk.h"
+#include <algorithm>
+#include <cmath>
 
 lvk::Texture* lvk::Texture::g_DefaultTexture = nullptr;
 
@@ -263,6 +266,114 @@ static unsigned char p_DefaultTextureBytesPNG[] = {
   0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82
 };
 
+static VkImageMemoryBarrier image_barrier(VkImage image, uint32_t baseMip, uint32_t mipCount, uint32_t layerCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = baseMip;
+    barrier.subresourceRange.levelCount = mipCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = layerCount;
+    return barrier;
+}
+
+// far corner of a level, for blit offsets
+static VkOffset3D mip_extent(VkExtent3D extent, uint32_t mip)
+{
+    return { std::max(1, static_cast<int32_t>(extent.width >> mip)),
+             std::max(1, static_cast<int32_t>(extent.height >> mip)),
+             std::max(1, static_cast<int32_t>(extent.depth >> mip)) };
+}
+
+// staging copy, level 0 upload, mip chain and final transition in one submission
+static void create_texture(lvk::VkState& vk, const unsigned char* pixels, VkExtent3D extent, VkFormat format, VkImageViewType viewType, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips)
+{
+    using namespace lvk;
+
+    // formats that cannot be blitted linearly are mipped with compute when they are storage capable
+    uint32_t mips = 1;
+    bool computeMips = false;
+    if (numMips != nullptr)
+    {
+        if (textures::SupportsLinearBlit(vk, format))
+        {
+            mips = textures::GetMipCount(extent);
+        }
+        else if (extent.depth == 1 && MipGenerator::Supports(vk, format))
+        {
+            mips = textures::GetMipCount(extent);
+            computeMips = true;
+        }
+        else
+        {
+            spdlog::error("CreateTexture : No support for linear blitting, the texture has no mips");
+        }
+        *numMips = mips;
+    }
+
+    // create staging buffer to copy texture to gpu
+    VkDeviceSize imageSize = VkDeviceSize{ extent.width } * extent.height * extent.depth * 4;
+    VkBuffer stagingBuffer;
+    VmaAllocation stagingBufferMemory;
+    constexpr VkBufferUsageFlags bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    constexpr VkMemoryPropertyFlags memoryPropertiesFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    buffers::CreateBuffer(vk, imageSize, bufferUsageFlags, memoryPropertiesFlags, stagingBuffer, stagingBufferMemory);
+
+    void* data;
+    vmaMapMemory(vk.m_Allocator, stagingBufferMemory, &data);
+    memcpy(data, pixels, static_cast<size_t>(imageSize));
+    vmaUnmapMemory(vk.m_Allocator, stagingBufferMemory);
+
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    VkImageCreateFlags createFlags = 0;
+    if (computeMips)
+    {
+        usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+        createFlags |= MipGenerator::GetStorageFormat(format) != format ? VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT : 0;
+    }
+    textures::CreateImage(vk, extent.width, extent.height, mips, VK_SAMPLE_COUNT_1_BIT,
+                format, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                image, imageMemory, extent.depth, 1, createFlags);
+    textures::CreateImageView(vk, image, format, mips, VK_IMAGE_ASPECT_COLOR_BIT, imageView, viewType);
+
+    // with compute mips only level 0 goes through the upload, the generator then writes the rest
+    textures::ImageUpload upload;
+    upload.m_Image = image;
+    upload.m_Extent = extent;
+    upload.m_MipCount = computeMips ? 1 : mips;
+    upload.m_Staging = stagingBuffer;
+
+    MipGenerator::Chain chain;
+    if (computeMips && !MipGenerator::Default(vk).CreateChain(vk, image, format, { extent.width, extent.height }, mips, MipGenerator::None, chain))
+    {
+        computeMips = false;
+    }
+
+    VkCommandBuffer cmd = commands::BeginSingleTimeCommands(vk);
+    textures::RecordImageUploads(cmd, { upload });
+    if (computeMips)
+    {
+        MipGenerator::Default(vk).Record(cmd, chain, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    commands::EndSingleTimeCommands(vk, cmd);
+
+    if (computeMips)
+    {
+        MipGenerator::Default(vk).FreeChain(vk, chain);
+    }
+
+    vkDestroyBuffer(vk.m_LogicalDevice, stagingBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, stagingBufferMemory);
+}
+
 void lvk::Texture::InitDefaultTexture(lvk::VkState & vk)
 {
 	g_DefaultTexture = new Texture(Texture::CreateTextureFromMemory(vk, &p_DefaultTextureBytesPNG[0], p_DefaultTextureBytesPNG_Length, VK_FORMAT_R8G8B8A8_UNORM));
@@ -276,7 +387,7 @@ void lvk::Texture::FreeDefaultTexture(lvk::VkState & vk)
 
 void lvk::Texture::Free(lvk::VkState & vk)
 {
-    vkDestroySampler(vk.m_LogicalDevice, m_Sampler, nullptr);
+    textures::FreeImageSampler(vk, m_Sampler);
     vkDestroyImageView(vk.m_LogicalDevice, m_ImageView, nullptr);
     vkDestroyImage(vk.m_LogicalDevice, m_Image, nullptr);
     vkFreeMemory(vk.m_LogicalDevice, m_Memory, nullptr);
@@ -289,16 +400,17 @@ void lvk::Texture::Free(lvk::VkState & vk)
 
 
 
-void lvk::textures::CreateImage(VkState& vk, uint32_t width, uint32_t height, uint32_t numMips, VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t depth)
+void lvk::textures::CreateImage(VkState& vk, uint32_t width, uint32_t height, uint32_t numMips, VkSampleCountFlagBits sampleCount, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t depth, uint32_t arrayLayers, VkImageCreateFlags flags)
 {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.flags = flags;
+    imageInfo.imageType = depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth = depth;
     imageInfo.mipLevels = numMips;
-    imageInfo.arrayLayers = 1;
+    imageInfo.arrayLayers = arrayLayers;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -323,7 +435,7 @@ void lvk::textures::CreateImage(VkState& vk, uint32_t width, uint32_t height, ui
     vkBindImageMemory(vk.m_LogicalDevice, image, imageMemory, 0);
 }
 
-void lvk::textures::CreateImageView(VkState& vk, VkImage& image, VkFormat format, uint32_t numMips, VkImageAspectFlags aspectFlags, VkImageView& imageView, VkImageViewType imageViewType)
+void lvk::textures::CreateImageView(VkState& vk, VkImage& image, VkFormat format, uint32_t numMips, VkImageAspectFlags aspectFlags, VkImageView& imageView, VkImageViewType imageViewType, uint32_t layerCount)
 {
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -334,7 +446,7 @@ void lvk::textures::CreateImageView(VkState& vk, VkImage& image, VkFormat format
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = numMips;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = layerCount;
 
     VK_CHECK(vkCreateImageView(vk.m_LogicalDevice, &viewInfo, nullptr, &imageView))
 }
@@ -365,239 +477,226 @@ void lvk::textures::CreateImageSampler(VkState& vk, VkImageView& imageView, uint
     samplerInfo.minLod = 0.0f; // static_cast<float>(numMips / 2); to test mips are working
     samplerInfo.maxLod = static_cast<float>(numMips);
 
-    VK_CHECK(vkCreateSampler(vk.m_LogicalDevice, &samplerInfo, nullptr, &sampler))
+    sampler = vk.m_SamplerCache.Acquire(vk.m_LogicalDevice, samplerInfo);
 }
 
-void lvk::textures::CreateTexture(VkState& vk, const String& path, VkFormat format, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips)
+void lvk::textures::FreeImageSampler(VkState& vk, VkSampler sampler)
 {
-    bool generateMips = numMips != nullptr;
+    vk.m_SamplerCache.Release(vk.m_LogicalDevice, sampler);
+}
 
+bool lvk::textures::DecodeImage(const String& path, DecodedImage& image)
+{
     int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-    if (!pixels)
+    image.m_Pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    if (!image.m_Pixels)
     {
-        spdlog::error("Failed to load texture image at path {}", path);
-        return;
+        spdlog::error("Failed to load texture image at path {} : {}", path, stbi_failure_reason());
+        return false;
     }
+    image.m_Width = static_cast<uint32_t>(texWidth);
+    image.m_Height = static_cast<uint32_t>(texHeight);
+    return true;
+}
 
-    uint32_t mips = 1;
-    if (generateMips)
+void lvk::textures::FreeDecodedImage(DecodedImage& image)
+{
+    stbi_image_free(image.m_Pixels);
+    image = {};
+}
+
+void lvk::textures::CreateTexture(VkState& vk, const String& path, VkFormat format, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips)
+{
+    DecodedImage decoded;
+    if (!DecodeImage(path, decoded))
     {
-        mips = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-        *numMips = mips;
+        return;
     }
-    
-    // create staging buffer to copy texture to gpu
-    VkBuffer stagingBuffer;
-    VmaAllocation stagingBufferMemory;
-    constexpr VkBufferUsageFlags bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    constexpr VkMemoryPropertyFlags memoryPropertiesFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    buffers::CreateBuffer(vk,imageSize, bufferUsageFlags, memoryPropertiesFlags, stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vmaMapMemory(vk.m_Allocator, stagingBufferMemory, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vmaUnmapMemory(vk.m_Allocator, stagingBufferMemory);
-    stbi_image_free(pixels);
-
-    CreateImage(vk, texWidth, texHeight, mips, VK_SAMPLE_COUNT_1_BIT,
-                format, VK_IMAGE_TILING_OPTIMAL,
-                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                image, imageMemory);
-    CreateImageView(vk, image, format, mips, VK_IMAGE_ASPECT_COLOR_BIT, imageView);
-
-    TransitionImageLayout(vk, image, format, mips, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    CopyBufferToImage(vk, stagingBuffer, image, texWidth, texHeight);
-    
-    GenerateMips(vk, image, format, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texWidth), mips, VK_FILTER_LINEAR);
-    
-    TransitionImageLayout(vk, image, format, mips, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    CreateTextureFromPixels(vk, decoded.m_Pixels, decoded.m_Width, decoded.m_Height, format, image, imageView, imageMemory, numMips);
+    FreeDecodedImage(decoded);
+}
 
-    vkDestroyBuffer(vk.m_LogicalDevice, stagingBuffer, nullptr);
-    vmaFreeMemory(vk.m_Allocator, stagingBufferMemory);
+void lvk::textures::CreateTextureFromPixels(VkState& vk, const unsigned char* pixels, uint32_t width, uint32_t height, VkFormat format, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips)
+{
+    create_texture(vk, pixels, { width, height, 1 }, format, VK_IMAGE_VIEW_TYPE_2D, image, imageView, imageMemory, numMips);
 }
 
 void lvk::textures::CreateTextureFromMemory(VkState& vk, unsigned char* tex_data, uint32_t dataSize, VkFormat format, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips)
 {
-    bool generateMips = numMips != nullptr;
-
     int texWidth, texHeight, texChannels;
     stbi_uc* pixels = stbi_load_from_memory(tex_data, dataSize, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
-
     if (!pixels)
     {
         spdlog::error("Failed to load texture image from memory");
         return;
     }
 
-    uint32_t mips = 1;
-    if (generateMips)
-    {
-        mips = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-        *numMips = mips;
-    }
-
-    // create staging buffer to copy texture to gpu
-    VkBuffer stagingBuffer;
-    VmaAllocation stagingBufferMemory;
-    constexpr VkBufferUsageFlags bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    constexpr VkMemoryPropertyFlags memoryPropertiesFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    buffers::CreateBuffer(vk,imageSize, bufferUsageFlags, memoryPropertiesFlags, stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vmaMapMemory(vk.m_Allocator, stagingBufferMemory, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vmaUnmapMemory(vk.m_Allocator, stagingBufferMemory);
+    CreateTextureFromPixels(vk, pixels, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), format, image, imageView, imageMemory, numMips);
     stbi_image_free(pixels);
-
-    CreateImage(vk, texWidth, texHeight, mips, VK_SAMPLE_COUNT_1_BIT,
-                format, VK_IMAGE_TILING_OPTIMAL,
-                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                image, imageMemory);
-    CreateImageView(vk, image, format, mips, VK_IMAGE_ASPECT_COLOR_BIT, imageView);
-
-    TransitionImageLayout(vk, image, format, mips, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    CopyBufferToImage(vk, stagingBuffer, image, texWidth, texHeight);
-
-    GenerateMips(vk, image, format, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texWidth), mips, VK_FILTER_LINEAR);
-
-    TransitionImageLayout(vk, image, format, mips, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    vkDestroyBuffer(vk.m_LogicalDevice, stagingBuffer, nullptr);
-    vmaFreeMemory(vk.m_Allocator, stagingBufferMemory);
 }
 
 void lvk::textures::CreateTexture3DFromMemory(VkState& vk, unsigned char* tex_data, VkExtent3D extent, uint32_t dataSize, VkFormat format, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips)
 {
-    bool generateMips = numMips != nullptr;
-
     int texWidth, texHeight, texChannels;
     stbi_uc* pixels = stbi_load_from_memory(tex_data, dataSize, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
-
     if (!pixels)
     {
         spdlog::error("Failed to load texture image from memory");
         return;
     }
 
-    uint32_t mips = 1;
-    if (generateMips)
+    // slices stacked vertically are already laid out as the 3D image's tightly packed level 0
+    if (static_cast<uint32_t>(texWidth) != extent.width || static_cast<uint32_t>(texHeight) != extent.height * extent.depth)
     {
-        mips = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-        *numMips = mips;
+        spdlog::error("CreateTexture3DFromMemory : a {}x{} image does not hold {} slices of {}x{}", texWidth, texHeight, extent.depth, extent.width, extent.height);
+        stbi_image_free(pixels);
+        return;
     }
 
-    // create staging buffer to copy texture to gpu
-    VkBuffer stagingBuffer;
-    VmaAllocation stagingBufferMemory;
-    constexpr VkBufferUsageFlags bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    constexpr VkMemoryPropertyFlags memoryPropertiesFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    buffers::CreateBuffer(vk,imageSize, bufferUsageFlags, memoryPropertiesFlags, stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vmaMapMemory(vk.m_Allocator, stagingBufferMemory, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vmaUnmapMemory(vk.m_Allocator, stagingBufferMemory);
+    create_texture(vk, pixels, extent, format, VK_IMAGE_VIEW_TYPE_3D, image, imageView, imageMemory, numMips);
     stbi_image_free(pixels);
-
-    CreateImage(vk, texWidth, texHeight, mips, VK_SAMPLE_COUNT_1_BIT,
-                format, VK_IMAGE_TILING_OPTIMAL,
-                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                image, imageMemory);
-    CreateImageView(vk, image, format, mips, VK_IMAGE_ASPECT_COLOR_BIT, imageView);
-
-    TransitionImageLayout(vk, image, format, mips, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    CopyBufferToImage(vk, stagingBuffer, image, texWidth, texHeight);
-
-    GenerateMips(vk, image, format, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texWidth), mips, VK_FILTER_LINEAR);
-
-    TransitionImageLayout(vk, image, format, mips, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    vkDestroyBuffer(vk.m_LogicalDevice, stagingBuffer, nullptr);
-    vmaFreeMemory(vk.m_Allocator, stagingBufferMemory);
 }
 
-
-void lvk::textures::GenerateMips(VkState& vk, VkImage image, VkFormat format, uint32_t imageWidth, uint32_t imageHeight, uint32_t numMips, VkFilter filterMethod)
+bool lvk::textures::SupportsLinearBlit(VkState& vk, VkFormat format)
 {
     VkFormatProperties formatProperties;
     vkGetPhysicalDeviceFormatProperties(vk.m_PhysicalDevice, format, &formatProperties);
+    return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+}
 
-    auto supportsLinearSampling = formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+uint32_t lvk::textures::GetMipCount(VkExtent3D extent)
+{
+    return static_cast<uint32_t>(std::floor(std::log2(std::max({ extent.width, extent.height, extent.depth })))) + 1;
+}
 
-    if (supportsLinearSampling <= 0)
+void lvk::textures::RecordImageUploads(VkCommandBuffer cmd, const Vector<ImageUpload>& uploads, VkFilter mipFilter)
+{
+    if (uploads.empty())
     {
-        spdlog::error("GenerateMips : No support for linear blitting!");
         return;
     }
 
-    VkCommandBuffer cmd = commands::BeginSingleTimeCommands(vk);
+    Vector<VkImageMemoryBarrier> barriers;
+    barriers.reserve(uploads.size());
+    for (const ImageUpload& upload : uploads)
+    {
+        barriers.push_back(image_barrier(upload.m_Image, 0, upload.m_MipCount, upload.m_LayerCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            0, VK_ACCESS_TRANSFER_WRITE_BIT));
+    }
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(barriers.size()), barriers.data());
 
-    VkImageMemoryBarrier barrier{ };
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.image = image;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    barrier.subresourceRange.levelCount = 1;
+    for (const ImageUpload& upload : uploads)
+    {
+        VkBufferImageCopy region{};
+        region.bufferOffset = upload.m_StagingOffset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = upload.m_LayerCount;
+        region.imageExtent = upload.m_Extent;
+        vkCmdCopyBufferToImage(cmd, upload.m_Staging, upload.m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
 
-    int32_t mipWidth = imageWidth;
-    int32_t mipHeight = imageHeight;
+    RecordGenerateMips(cmd, uploads, mipFilter);
+}
 
-    for (uint32_t i = 1; i < numMips; i++) {
-        barrier.subresourceRange.baseMipLevel = i - 1;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &barrier);
-
-        VkImageBlit imageBlit{};
-        imageBlit.srcOffsets[0] = { 0, 0, 0 };
-        imageBlit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
-        imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageBlit.srcSubresource.mipLevel = i - 1;
-        imageBlit.srcSubresource.baseArrayLayer = 0;
-        imageBlit.srcSubresource.layerCount = 1;
-        imageBlit.dstOffsets[0] = { 0, 0, 0 };
-        imageBlit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
-        imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageBlit.dstSubresource.mipLevel = i;
-        imageBlit.dstSubresource.baseArrayLayer = 0;
-        imageBlit.dstSubresource.layerCount = 1;
-
-        vkCmdBlitImage(cmd,
-                       image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                       image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                       1, &imageBlit, filterMethod);
-
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+void lvk::textures::RecordGenerateMips(VkCommandBuffer cmd, const Vector<ImageUpload>& images, VkFilter filterMethod)
+{
+    uint32_t maxMips = 0;
+    for (const ImageUpload& image : images)
+    {
+        maxMips = std::max(maxMips, image.m_MipCount);
+    }
 
-        vkCmdPipelineBarrier(cmd,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &barrier);
+    // level by level across every image, each step waits on one barrier however many images are in flight.
+    // sources stay in TRANSFER_SRC_OPTIMAL until the end so the final transition is a single barrier too
+    Vector<VkImageMemoryBarrier> barriers;
+    for (uint32_t mip = 1; mip < maxMips; mip++)
+    {
+        barriers.clear();
+        for (const ImageUpload& image : images)
+        {
+            if (image.m_MipCount > mip)
+            {
+                barriers.push_back(image_barrier(image.m_Image, mip - 1, 1, image.m_LayerCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+            }
+        }
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                             static_cast<uint32_t>(barriers.size()), barriers.data());
+
+        for (const ImageUpload& image : images)
+        {
+            if (image.m_MipCount <= mip)
+            {
+                continue;
+            }
+
+            VkImageBlit imageBlit{};
+            imageBlit.srcOffsets[0] = { 0, 0, 0 };
+            imageBlit.srcOffsets[1] = mip_extent(image.m_Extent, mip - 1);
+            imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            imageBlit.srcSubresource.mipLevel = mip - 1;
+            imageBlit.srcSubresource.baseArrayLayer = 0;
+            imageBlit.srcSubresource.layerCount = image.m_LayerCount;
+            imageBlit.dstOffsets[0] = { 0, 0, 0 };
+            imageBlit.dstOffsets[1] = mip_extent(image.m_Extent, mip);
+            imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            imageBlit.dstSubresource.mipLevel = mip;
+            imageBlit.dstSubresource.baseArrayLayer = 0;
+            imageBlit.dstSubresource.layerCount = image.m_LayerCount;
+
+            vkCmdBlitImage(cmd,
+                           image.m_Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           image.m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           1, &imageBlit, filterMethod);
+        }
+    }
 
-        if (mipWidth > 1) mipWidth /= 2;
-        if (mipHeight > 1) mipHeight /= 2;
+    barriers.clear();
+    for (const ImageUpload& image : images)
+    {
+        if (image.m_MipCount > 1)
+        {
+            barriers.push_back(image_barrier(image.m_Image, 0, image.m_MipCount - 1, image.m_LayerCount, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT));
+        }
+        barriers.push_back(image_barrier(image.m_Image, image.m_MipCount - 1, 1, image.m_LayerCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
     }
+    if (!barriers.empty())
+    {
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                             static_cast<uint32_t>(barriers.size()), barriers.data());
+    }
+}
 
+void lvk::textures::GenerateMips(VkState& vk, VkImage image, VkFormat format, uint32_t imageWidth, uint32_t imageHeight, uint32_t numMips, VkFilter filterMethod)
+{
+    if (!SupportsLinearBlit(vk, format))
+    {
+        MipGenerator::Chain chain;
+        if (!MipGenerator::Supports(vk, format) || !MipGenerator::Default(vk).CreateChain(vk, image, format, { imageWidth, imageHeight }, numMips, MipGenerator::None, chain))
+        {
+            spdlog::error("GenerateMips : No support for linear blitting or compute mips!");
+            return;
+        }
+
+        VkCommandBuffer cmd = commands::BeginSingleTimeCommands(vk);
+        MipGenerator::Default(vk).Record(cmd, chain, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        commands::EndSingleTimeCommands(vk, cmd);
+        MipGenerator::Default(vk).FreeChain(vk, chain);
+        return;
+    }
+
+    ImageUpload mipped;
+    mipped.m_Image = image;
+    mipped.m_Extent = { imageWidth, imageHeight, 1 };
+    mipped.m_MipCount = numMips;
+
+    VkCommandBuffer cmd = commands::BeginSingleTimeCommands(vk);
+    RecordGenerateMips(cmd, { mipped }, filterMethod);
     commands::EndSingleTimeCommands(vk, cmd);
 }
 
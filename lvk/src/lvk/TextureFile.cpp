@@ -0,0 +1,477 @@
+#include "lvk/TextureFile.h"
+#include "lvk/Buffer.h"
+#include "lvk/Commands.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstring>
+
+static constexpr uint8_t k_Ktx2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static constexpr size_t k_Ktx2HeaderSize = 80;          // identifier, header and index, the level index follows
+static constexpr size_t k_Ktx2LevelIndexEntrySize = 24;
+
+static constexpr uint32_t k_DdsMagic = 0x20534444;      // "DDS "
+static constexpr size_t k_DdsHeaderSize = 128;          // magic and DDS_HEADER
+static constexpr size_t k_DdsDx10HeaderSize = 20;
+static constexpr uint32_t k_DdsFlagMipMapCount = 0x20000;
+static constexpr uint32_t k_DdsPixelFormatFourCC = 0x4;
+static constexpr uint32_t k_DdsCaps2CubeMap = 0x200;
+static constexpr uint32_t k_DdsCaps2Volume = 0x200000;
+static constexpr uint32_t k_DdsDx10Texture2D = 3;
+static constexpr uint32_t k_DdsDx10MiscTextureCube = 0x4;
+
+static constexpr VkDeviceSize k_StagingAlignment = 16;
+
+static uint32_t read_u32(const uint8_t* data, size_t offset)
+{
+    uint32_t value;
+    memcpy(&value, data + offset, sizeof(value));
+    return value;
+}
+
+static uint64_t read_u64(const uint8_t* data, size_t offset)
+{
+    uint64_t value;
+    memcpy(&value, data + offset, sizeof(value));
+    return value;
+}
+
+static constexpr uint32_t four_cc(char a, char b, char c, char d)
+{
+    return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+static VkFormat dds_four_cc_format(uint32_t fourCC)
+{
+    switch (fourCC)
+    {
+    case four_cc('D', 'X', 'T', '1'): return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case four_cc('D', 'X', 'T', '3'): return VK_FORMAT_BC2_UNORM_BLOCK;
+    case four_cc('D', 'X', 'T', '5'): return VK_FORMAT_BC3_UNORM_BLOCK;
+    case four_cc('A', 'T', 'I', '1'):
+    case four_cc('B', 'C', '4', 'U'): return VK_FORMAT_BC4_UNORM_BLOCK;
+    case four_cc('A', 'T', 'I', '2'):
+    case four_cc('B', 'C', '5', 'U'): return VK_FORMAT_BC5_UNORM_BLOCK;
+    default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+static VkFormat dds_dxgi_format(uint32_t dxgiFormat)
+{
+    switch (dxgiFormat)
+    {
+    case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+    case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+    case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+    case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+    case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+    case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+    case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+    case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+    case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+    case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+    case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+    case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+    case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+    case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+    case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+    case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+    case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+    default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+bool lvk::texture_file::GetFormatInfo(VkFormat format, FormatInfo& info)
+{
+    // ASTC formats come in UNORM / SRGB pairs, ordered by block size
+    static constexpr uint32_t k_AstcBlocks[][2] = {
+        { 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+        { 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 } };
+
+    if (IsAstc(format))
+    {
+        uint32_t block = (format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2;
+        info = { k_AstcBlocks[block][0], k_AstcBlocks[block][1], 16 };
+        return true;
+    }
+
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        info = { 1, 1, 4 };
+        return true;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+        info = { 4, 4, 8 };
+        return true;
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        info = { 4, 4, 16 };
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool lvk::texture_file::IsAstc(VkFormat format)
+{
+    return format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK;
+}
+
+uint64_t lvk::texture_file::GetLevelSize(VkFormat format, uint32_t width, uint32_t height)
+{
+    FormatInfo info;
+    if (!GetFormatInfo(format, info))
+    {
+        return 0;
+    }
+    uint64_t blocksX = (width + info.m_BlockWidth - 1) / info.m_BlockWidth;
+    uint64_t blocksY = (height + info.m_BlockHeight - 1) / info.m_BlockHeight;
+    return blocksX * blocksY * info.m_BlockBytes;
+}
+
+lvk::texture_file::Container lvk::texture_file::DetectContainer(const uint8_t* data, size_t size)
+{
+    if (size >= sizeof(k_Ktx2Identifier) && memcmp(data, k_Ktx2Identifier, sizeof(k_Ktx2Identifier)) == 0)
+    {
+        return Container::Ktx2;
+    }
+    if (size >= sizeof(uint32_t) && read_u32(data, 0) == k_DdsMagic)
+    {
+        return Container::Dds;
+    }
+    return Container::Unknown;
+}
+
+bool lvk::TextureFile::Open(const String& path)
+{
+    Close();
+    if (!m_File.Open(path))
+    {
+        return false;
+    }
+
+    bool parsed = false;
+    switch (texture_file::DetectContainer(m_File.GetData(), m_File.GetSize()))
+    {
+    case texture_file::Container::Ktx2:
+        parsed = ParseKtx2(path);
+        break;
+    case texture_file::Container::Dds:
+        parsed = ParseDds(path);
+        break;
+    default:
+        spdlog::error("TextureFile : {} is neither a KTX2 nor a DDS file", path);
+        break;
+    }
+
+    if (!parsed || !ValidateMips(path))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void lvk::TextureFile::Close()
+{
+    m_File.Close();
+    m_Format = VK_FORMAT_UNDEFINED;
+    m_Width = 0;
+    m_Height = 0;
+    m_Mips.clear();
+}
+
+bool lvk::TextureFile::ParseKtx2(const String& path)
+{
+    const uint8_t* data = m_File.GetData();
+    if (m_File.GetSize() < k_Ktx2HeaderSize)
+    {
+        spdlog::error("TextureFile : {} is truncated", path);
+        return false;
+    }
+
+    VkFormat format = static_cast<VkFormat>(read_u32(data, 12));
+    uint32_t width = read_u32(data, 20);
+    uint32_t height = read_u32(data, 24);
+    uint32_t depth = read_u32(data, 28);
+    uint32_t layerCount = read_u32(data, 32);
+    uint32_t faceCount = read_u32(data, 36);
+    uint32_t levelCount = std::max(read_u32(data, 40), 1u);
+    uint32_t supercompression = read_u32(data, 44);
+
+    if (format == VK_FORMAT_UNDEFINED || supercompression != 0)
+    {
+        spdlog::error("TextureFile : {} is supercompressed or needs transcoding, which is not supported", path);
+        return false;
+    }
+    if (height == 0 || depth > 1 || layerCount > 1 || faceCount != 1)
+    {
+        spdlog::error("TextureFile : {} is not a single 2D image", path);
+        return false;
+    }
+    if (m_File.GetSize() < k_Ktx2HeaderSize + size_t{ levelCount } * k_Ktx2LevelIndexEntrySize)
+    {
+        spdlog::error("TextureFile : {} is truncated", path);
+        return false;
+    }
+
+    m_Format = format;
+    m_Width = width;
+    m_Height = height;
+    m_Mips.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        size_t entry = k_Ktx2HeaderSize + size_t{ level } * k_Ktx2LevelIndexEntrySize;
+        m_Mips[level].m_Offset = read_u64(data, entry);
+        m_Mips[level].m_Size = read_u64(data, entry + 8);
+    }
+    return true;
+}
+
+bool lvk::TextureFile::ParseDds(const String& path)
+{
+    const uint8_t* data = m_File.GetData();
+    if (m_File.GetSize() < k_DdsHeaderSize)
+    {
+        spdlog::error("TextureFile : {} is truncated", path);
+        return false;
+    }
+
+    uint32_t flags = read_u32(data, 8);
+    uint32_t height = read_u32(data, 12);
+    uint32_t width = read_u32(data, 16);
+    uint32_t mipCount = read_u32(data, 28);
+    uint32_t pixelFormatFlags = read_u32(data, 80);
+    uint32_t fourCC = read_u32(data, 84);
+    uint32_t caps2 = read_u32(data, 112);
+
+    if ((caps2 & (k_DdsCaps2CubeMap | k_DdsCaps2Volume)) != 0)
+    {
+        spdlog::error("TextureFile : {} is not a single 2D image", path);
+        return false;
+    }
+    if ((pixelFormatFlags & k_DdsPixelFormatFourCC) == 0)
+    {
+        spdlog::error("TextureFile : {} stores an uncompressed legacy pixel format, which is not supported", path);
+        return false;
+    }
+
+    uint64_t dataOffset = k_DdsHeaderSize;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    if (fourCC == four_cc('D', 'X', '1', '0'))
+    {
+        if (m_File.GetSize() < k_DdsHeaderSize + k_DdsDx10HeaderSize)
+        {
+            spdlog::error("TextureFile : {} is truncated", path);
+            return false;
+        }
+        uint32_t dimension = read_u32(data, k_DdsHeaderSize + 4);
+        uint32_t miscFlags = read_u32(data, k_DdsHeaderSize + 8);
+        uint32_t arraySize = read_u32(data, k_DdsHeaderSize + 12);
+        if (dimension != k_DdsDx10Texture2D || (miscFlags & k_DdsDx10MiscTextureCube) != 0 || arraySize > 1)
+        {
+            spdlog::error("TextureFile : {} is not a single 2D image", path);
+            return false;
+        }
+        format = dds_dxgi_format(read_u32(data, k_DdsHeaderSize));
+        dataOffset += k_DdsDx10HeaderSize;
+    }
+    else
+    {
+        format = dds_four_cc_format(fourCC);
+    }
+
+    if (format == VK_FORMAT_UNDEFINED)
+    {
+        spdlog::error("TextureFile : {} stores a pixel format that is not supported", path);
+        return false;
+    }
+
+    // dds levels follow each other without padding
+    m_Format = format;
+    m_Width = width;
+    m_Height = height;
+    m_Mips.resize((flags & k_DdsFlagMipMapCount) != 0 ? std::max(mipCount, 1u) : 1u);
+    for (uint32_t level = 0; level < m_Mips.size(); level++)
+    {
+        m_Mips[level].m_Offset = dataOffset;
+        m_Mips[level].m_Size = texture_file::GetLevelSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u));
+        dataOffset += m_Mips[level].m_Size;
+    }
+    return true;
+}
+
+bool lvk::TextureFile::ValidateMips(const String& path)
+{
+    texture_file::FormatInfo info;
+    if (!texture_file::GetFormatInfo(m_Format, info))
+    {
+        spdlog::error("TextureFile : {} stores format {}, which is not supported", path, static_cast<uint32_t>(m_Format));
+        return false;
+    }
+    if (m_Width == 0 || m_Height == 0 || m_Mips.size() > 32 || (std::max(m_Width, m_Height) >> (m_Mips.size() - 1)) == 0)
+    {
+        spdlog::error("TextureFile : {} has a {}x{} image with {} levels", path, m_Width, m_Height, m_Mips.size());
+        return false;
+    }
+
+    for (uint32_t level = 0; level < m_Mips.size(); level++)
+    {
+        texture_file::MipLevel& mip = m_Mips[level];
+        mip.m_Width = std::max(m_Width >> level, 1u);
+        mip.m_Height = std::max(m_Height >> level, 1u);
+        if (mip.m_Size != texture_file::GetLevelSize(m_Format, mip.m_Width, mip.m_Height) ||
+            mip.m_Offset > m_File.GetSize() || mip.m_Size > m_File.GetSize() - mip.m_Offset)
+        {
+            spdlog::error("TextureFile : level {} of {} does not match its size or lies outside the file", level, path);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool lvk::TextureFile::IsSupported(VkState& vk) const
+{
+    bool astc = texture_file::IsAstc(m_Format);
+    bool bc = m_Format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && m_Format <= VK_FORMAT_BC7_SRGB_BLOCK;
+    if ((astc && !vk.m_DeviceFeatures.m_TextureCompressionASTC) || (bc && !vk.m_DeviceFeatures.m_TextureCompressionBC))
+    {
+        return false;
+    }
+
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(vk.m_PhysicalDevice, m_Format, &formatProperties);
+    constexpr VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    return (formatProperties.optimalTilingFeatures & required) == required;
+}
+
+bool lvk::textures::CreateTextureFromFile(VkState& vk, const TextureFile& file, VkImage& image, VkImageView& imageView, VkDeviceMemory& imageMemory, uint32_t* numMips)
+{
+    if (!file.IsSupported(vk))
+    {
+        spdlog::error("CreateTextureFromFile : the device cannot sample format {}", static_cast<uint32_t>(file.GetFormat()));
+        return false;
+    }
+
+    uint32_t mips = file.GetMipCount();
+    Vector<VkBufferImageCopy> regions(mips);
+    VkDeviceSize stagingSize = 0;
+    for (uint32_t level = 0; level < mips; level++)
+    {
+        stagingSize = (stagingSize + k_StagingAlignment - 1) & ~(k_StagingAlignment - 1);
+
+        VkBufferImageCopy& region = regions[level];
+        region = {};
+        region.bufferOffset = stagingSize;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { file.GetMip(level).m_Width, file.GetMip(level).m_Height, 1 };
+        stagingSize += file.GetMip(level).m_Size;
+    }
+
+    VkBuffer stagingBuffer;
+    VmaAllocation stagingBufferMemory;
+    buffers::CreateBuffer(vk, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer, stagingBufferMemory);
+
+    void* data;
+    vmaMapMemory(vk.m_Allocator, stagingBufferMemory, &data);
+    for (uint32_t level = 0; level < mips; level++)
+    {
+        memcpy(static_cast<char*>(data) + regions[level].bufferOffset, file.GetMipData(level), static_cast<size_t>(file.GetMip(level).m_Size));
+    }
+    vmaUnmapMemory(vk.m_Allocator, stagingBufferMemory);
+
+    CreateImage(vk, file.GetWidth(), file.GetHeight(), mips, VK_SAMPLE_COUNT_1_BIT,
+                file.GetFormat(), VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                image, imageMemory);
+    CreateImageView(vk, image, file.GetFormat(), mips, VK_IMAGE_ASPECT_COLOR_BIT, imageView);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mips;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    VkCommandBuffer cmd = commands::BeginSingleTimeCommands(vk);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkCmdCopyBufferToImage(cmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mips, regions.data());
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    commands::EndSingleTimeCommands(vk, cmd);
+
+    vkDestroyBuffer(vk.m_LogicalDevice, stagingBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, stagingBufferMemory);
+
+    if (numMips != nullptr)
+    {
+        *numMips = mips;
+    }
+    return true;
+}
+
+lvk::Optional<lvk::Texture> lvk::textures::LoadTextureFile(VkState& vk, const TextureFile& file, VkFilter samplerFilter, VkSamplerAddressMode samplerAddressMode)
+{
+    VkImage image;
+    VkImageView imageView;
+    VkDeviceMemory memory;
+    uint32_t mipLevels;
+    if (!CreateTextureFromFile(vk, file, image, imageView, memory, &mipLevels))
+    {
+        return {};
+    }
+
+    VkSampler sampler;
+    CreateImageSampler(vk, imageView, mipLevels, samplerFilter, samplerAddressMode, sampler);
+
+    VkDescriptorSet imguiTextureHandle = VK_NULL_HANDLE;
+    if (vk.m_UseImGui)
+    {
+        imguiTextureHandle = ImGui_ImplVulkan_AddTexture(sampler, imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    return Texture(image, imageView, memory, sampler, file.GetFormat(), VK_SAMPLE_COUNT_1_BIT, imguiTextureHandle);
+}
+
+lvk::Optional<lvk::Texture> lvk::textures::LoadTextureFile(VkState& vk, const String& path, VkFilter samplerFilter, VkSamplerAddressMode samplerAddressMode)
+{
+    TextureFile file;
+    if (!file.Open(path))
+    {
+        return {};
+    }
+    return LoadTextureFile(vk, file, samplerFilter, samplerAddressMode);
+}
@@ -0,0 +1,133 @@
+#include "lvk/TextureLoader.h"
+#include "lvk/Buffer.h"
+#include "lvk/Commands.h"
+#include "lvk/ThreadPool.h"
+#include "spdlog/spdlog.h"
+#include "volk.h"
+#include <cstring>
+
+static constexpr VkDeviceSize k_StagingAlignment = 16;
+
+uint32_t lvk::TextureUploadBatch::Add(const unsigned char* pixels, uint32_t width, uint32_t height, VkFormat format, bool generateMips)
+{
+    return Add(pixels, { width, height, 1 }, 1, format, generateMips);
+}
+
+uint32_t lvk::TextureUploadBatch::Add(const unsigned char* pixels, VkExtent3D extent, uint32_t layerCount, VkFormat format, bool generateMips)
+{
+    size_t size = size_t{ extent.width } * extent.height * extent.depth * layerCount * 4;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    VkDeviceSize offset = (m_Pixels.size() + k_StagingAlignment - 1) & ~(k_StagingAlignment - 1);
+    m_Pixels.resize(static_cast<size_t>(offset) + size);
+    memcpy(m_Pixels.data() + offset, pixels, size);
+    m_Entries.push_back({ offset, extent, layerCount, format, generateMips });
+    return static_cast<uint32_t>(m_Entries.size() - 1);
+}
+
+void lvk::TextureUploadBatch::Upload(VkState& vk, Vector<Texture>& textures, VkFilter samplerFilter, VkSamplerAddressMode samplerAddressMode)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_Entries.empty())
+    {
+        return;
+    }
+
+    VkBuffer stagingBuffer;
+    VmaAllocation stagingBufferMemory;
+    buffers::CreateBuffer(vk, m_Pixels.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer, stagingBufferMemory);
+
+    void* data;
+    vmaMapMemory(vk.m_Allocator, stagingBufferMemory, &data);
+    memcpy(data, m_Pixels.data(), m_Pixels.size());
+    vmaUnmapMemory(vk.m_Allocator, stagingBufferMemory);
+
+    size_t count = m_Entries.size();
+    Vector<textures::ImageUpload> uploads(count);
+    Vector<VkImageView> imageViews(count);
+    Vector<VkDeviceMemory> memories(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Entry& entry = m_Entries[i];
+        textures::ImageUpload& upload = uploads[i];
+        upload.m_Extent = entry.m_Extent;
+        upload.m_LayerCount = entry.m_LayerCount;
+        upload.m_Staging = stagingBuffer;
+        upload.m_StagingOffset = entry.m_Offset;
+        if (entry.m_GenerateMips && textures::SupportsLinearBlit(vk, entry.m_Format))
+        {
+            upload.m_MipCount = textures::GetMipCount(entry.m_Extent);
+        }
+
+        const VkImageViewType viewType = entry.m_Extent.depth > 1 ? VK_IMAGE_VIEW_TYPE_3D
+                                       : entry.m_LayerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY
+                                       : VK_IMAGE_VIEW_TYPE_2D;
+        textures::CreateImage(vk, entry.m_Extent.width, entry.m_Extent.height, upload.m_MipCount, VK_SAMPLE_COUNT_1_BIT,
+                              entry.m_Format, VK_IMAGE_TILING_OPTIMAL,
+                              VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                              upload.m_Image, memories[i], entry.m_Extent.depth, entry.m_LayerCount);
+        textures::CreateImageView(vk, upload.m_Image, entry.m_Format, upload.m_MipCount, VK_IMAGE_ASPECT_COLOR_BIT, imageViews[i], viewType, entry.m_LayerCount);
+    }
+
+    VkCommandBuffer cmd = commands::BeginSingleTimeCommands(vk);
+    textures::RecordImageUploads(cmd, uploads);
+    commands::EndSingleTimeCommands(vk, cmd);
+
+    vkDestroyBuffer(vk.m_LogicalDevice, stagingBuffer, nullptr);
+    vmaFreeMemory(vk.m_Allocator, stagingBufferMemory);
+
+    textures.reserve(textures.size() + count);
+    for (size_t i = 0; i < count; i++)
+    {
+        VkSampler sampler;
+        textures::CreateImageSampler(vk, imageViews[i], uploads[i].m_MipCount, samplerFilter, samplerAddressMode, sampler);
+
+        // ImGui draws 2D views only
+        VkDescriptorSet imguiTextureHandle = VK_NULL_HANDLE;
+        if (vk.m_UseImGui && m_Entries[i].m_Extent.depth == 1 && m_Entries[i].m_LayerCount == 1)
+        {
+            imguiTextureHandle = ImGui_ImplVulkan_AddTexture(sampler, imageViews[i], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+        textures.push_back(Texture(uploads[i].m_Image, imageViews[i], memories[i], sampler, m_Entries[i].m_Format, VK_SAMPLE_COUNT_1_BIT, imguiTextureHandle));
+    }
+
+    m_Entries.clear();
+    m_Pixels.clear();
+    m_Pixels.shrink_to_fit();
+}
+
+void lvk::textures::LoadTextures(VkState& vk, const Vector<String>& paths, VkFormat format, Vector<Texture>& textures, VkFilter samplerFilter, VkSamplerAddressMode samplerAddressMode)
+{
+    TextureUploadBatch batch;
+    Vector<int32_t> batchIndices(paths.size(), -1);
+
+    // one task per file rather than a ParallelFor, decode times vary too much for even batches
+    Vector<std::future<void>> decodes;
+    decodes.reserve(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        decodes.push_back(ThreadPool::Default().Submit([&paths, &batch, &batchIndices, format, i]() {
+            DecodedImage image;
+            if (DecodeImage(paths[i], image))
+            {
+                batchIndices[i] = static_cast<int32_t>(batch.Add(image.m_Pixels, image.m_Width, image.m_Height, format));
+                FreeDecodedImage(image);
+            }
+        }));
+    }
+    for (std::future<void>& decode : decodes)
+    {
+        decode.wait();
+    }
+
+    Vector<Texture> uploaded;
+    batch.Upload(vk, uploaded, samplerFilter, samplerAddressMode);
+
+    textures.reserve(textures.size() + paths.size());
+    for (int32_t index : batchIndices)
+    {
+        textures.push_back(index >= 0 ? uploaded[index] : *Texture::g_DefaultTexture);
+    }
+}
@@ -0,0 +1,499 @@
+#include "lvk/TextureStreaming.h"
+#include "lvk/Buffer.h"
+#include "lvk/Commands.h"
+#include "lvk/Macros.h"
+#include "lvk/ThreadPool.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+static constexpr VkDeviceSize k_StagingAlignment = 16;
+
+static void transition(VkCommandBuffer cmd, VkImage image, uint32_t mipCount, VkImageLayout oldLayout, VkImageLayout newLayout,
+    VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mipCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+// fills newImage (file levels newMip and below) from the staging regions and from oldImage (file levels
+// oldMip and below), leaving both shader readable. all submissions share the graphics queue, so the
+// barriers on oldImage also order against the frames still sampling it
+static void record_levels(VkCommandBuffer cmd, const lvk::TextureFile& file, VkImage oldImage, uint32_t oldMip,
+    VkImage newImage, uint32_t newMip, VkBuffer staging, const lvk::Vector<VkBufferImageCopy>& regions)
+{
+    const uint32_t mipCount = file.GetMipCount();
+    transition(cmd, newImage, mipCount - newMip, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    if (!regions.empty())
+    {
+        vkCmdCopyBufferToImage(cmd, staging, newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+    }
+
+    if (oldImage != VK_NULL_HANDLE)
+    {
+        transition(cmd, oldImage, mipCount - oldMip, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        lvk::Vector<VkImageCopy> copies;
+        for (uint32_t level = std::max(oldMip, newMip); level < mipCount; level++)
+        {
+            VkImageCopy copy{};
+            copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - oldMip, 0, 1 };
+            copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - newMip, 0, 1 };
+            copy.extent = { file.GetMip(level).m_Width, file.GetMip(level).m_Height, 1 };
+            copies.push_back(copy);
+        }
+        vkCmdCopyImage(cmd, oldImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(copies.size()), copies.data());
+
+        transition(cmd, oldImage, mipCount - oldMip, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+
+    transition(cmd, newImage, mipCount - newMip, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+static void destroy_staging(lvk::VkState& vk, VkBuffer& buffer, VmaAllocation& memory)
+{
+    if (buffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(vk.m_LogicalDevice, buffer, nullptr);
+        vmaFreeMemory(vk.m_Allocator, memory);
+        buffer = VK_NULL_HANDLE;
+        memory = VK_NULL_HANDLE;
+    }
+}
+
+void lvk::TextureStreamer::Init(const Config& config, ViewChangedFn onViewChanged)
+{
+    m_Config = config;
+    m_OnViewChanged = std::move(onViewChanged);
+}
+
+uint32_t lvk::TextureStreamer::Add(VkState& vk, const String& path, VkFilter samplerFilter, VkSamplerAddressMode samplerAddressMode)
+{
+    TextureFile file;
+    if (!file.Open(path))
+    {
+        return k_InvalidHandle;
+    }
+    return Add(vk, std::move(file), samplerFilter, samplerAddressMode);
+}
+
+uint32_t lvk::TextureStreamer::Add(VkState& vk, TextureFile&& file, VkFilter samplerFilter, VkSamplerAddressMode samplerAddressMode)
+{
+    if (!file.IsSupported(vk))
+    {
+        spdlog::error("TextureStreamer : the device cannot sample format {}", static_cast<uint32_t>(file.GetFormat()));
+        return k_InvalidHandle;
+    }
+
+    uint32_t tailMip = 0;
+    while (tailMip + 1 < file.GetMipCount() && std::max(file.GetMip(tailMip).m_Width, file.GetMip(tailMip).m_Height) > m_Config.m_TailSize)
+    {
+        tailMip++;
+    }
+
+    const uint32_t handle = static_cast<uint32_t>(m_Textures.size());
+    m_Textures.push_back(StreamedTexture{ std::move(file), Texture(VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_FORMAT_UNDEFINED, VK_SAMPLE_COUNT_1_BIT) });
+    StreamedTexture& texture = m_Textures.back();
+    texture.m_ResidentMip = tailMip;
+    texture.m_TailMip = tailMip;
+    texture.m_RequestedMip = tailMip;
+
+    Transfer tail;
+    tail.m_Handle = handle;
+    tail.m_NewMip = tailMip;
+    CreateLevels(vk, texture, tailMip, tail);
+
+    // tails are small, they are written here and uploaded together by FlushTails
+    void* data;
+    vmaMapMemory(vk.m_Allocator, tail.m_StagingMemory, &data);
+    for (const VkBufferImageCopy& region : tail.m_Regions)
+    {
+        uint32_t level = tail.m_NewMip + region.imageSubresource.mipLevel;
+        memcpy(static_cast<char*>(data) + region.bufferOffset, texture.m_File.GetMipData(level), static_cast<size_t>(texture.m_File.GetMip(level).m_Size));
+    }
+    vmaUnmapMemory(vk.m_Allocator, tail.m_StagingMemory);
+
+    // the sampler covers the whole chain, views over fewer levels clamp to what they hold
+    VkSampler sampler;
+    textures::CreateImageSampler(vk, tail.m_NewImageView, texture.m_File.GetMipCount(), samplerFilter, samplerAddressMode, sampler);
+    texture.m_Texture = Texture(tail.m_NewImage, tail.m_NewImageView, tail.m_NewMemory, sampler, texture.m_File.GetFormat(), VK_SAMPLE_COUNT_1_BIT);
+    texture.m_Busy = true;
+    m_ResidentBytes += GetLevelBytes(texture, tailMip, texture.m_File.GetMipCount());
+    m_TailTransfers.push_back(std::move(tail));
+    return handle;
+}
+
+void lvk::TextureStreamer::Request(uint32_t handle, float pixels)
+{
+    StreamedTexture& texture = m_Textures[handle];
+    if (pixels <= texture.m_RequestedPixels)
+    {
+        return;
+    }
+    texture.m_RequestedPixels = pixels;
+    texture.m_LastRequest = m_UpdateIndex;
+
+    // the smallest level still covering the requested pixels, anything finer would be minified away
+    const texture_file::MipLevel& top = texture.m_File.GetMip(0);
+    float ratio = static_cast<float>(std::max(top.m_Width, top.m_Height)) / std::max(pixels, 1.0f);
+    uint32_t mip = ratio > 1.0f ? static_cast<uint32_t>(std::floor(std::log2(ratio))) : 0;
+    texture.m_RequestedMip = std::min(mip, texture.m_TailMip);
+}
+
+void lvk::TextureStreamer::Update(VkState& vk)
+{
+    m_UpdateIndex++;
+    FlushTails(vk);
+    ReleaseRetired(vk, false);
+
+    for (size_t i = 0; i < m_Transfers.size();)
+    {
+        Transfer& transfer = m_Transfers[i];
+        if (transfer.m_CommandBuffer == VK_NULL_HANDLE)
+        {
+            if (transfer.m_Fill.valid() && transfer.m_Fill.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                i++;
+                continue;
+            }
+            SubmitTransfer(vk, transfer);
+        }
+        if (vkGetFenceStatus(vk.m_LogicalDevice, transfer.m_Fence) == VK_SUCCESS)
+        {
+            CompleteTransfer(vk, transfer);
+            m_Transfers.erase(m_Transfers.begin() + i);
+            continue;
+        }
+        i++;
+    }
+
+    StartUploads(vk);
+
+    for (StreamedTexture& texture : m_Textures)
+    {
+        texture.m_RequestedMip = texture.m_TailMip;
+        texture.m_RequestedPixels = 0.0f;
+    }
+}
+
+void lvk::TextureStreamer::Free(VkState& vk)
+{
+    for (Transfer& transfer : m_Transfers)
+    {
+        if (transfer.m_Fill.valid())
+        {
+            transfer.m_Fill.wait();
+        }
+        if (transfer.m_Fence != VK_NULL_HANDLE)
+        {
+            vkWaitForFences(vk.m_LogicalDevice, 1, &transfer.m_Fence, VK_TRUE, UINT64_MAX);
+            vkDestroyFence(vk.m_LogicalDevice, transfer.m_Fence, nullptr);
+            vkFreeCommandBuffers(vk.m_LogicalDevice, vk.m_GraphicsComputeQueueCommandPool, 1, &transfer.m_CommandBuffer);
+        }
+        else if (transfer.m_Staging != VK_NULL_HANDLE)
+        {
+            vmaUnmapMemory(vk.m_Allocator, transfer.m_StagingMemory);
+        }
+        destroy_staging(vk, transfer.m_Staging, transfer.m_StagingMemory);
+        vkDestroyImageView(vk.m_LogicalDevice, transfer.m_NewImageView, nullptr);
+        vkDestroyImage(vk.m_LogicalDevice, transfer.m_NewImage, nullptr);
+        vkFreeMemory(vk.m_LogicalDevice, transfer.m_NewMemory, nullptr);
+    }
+    for (Transfer& tail : m_TailTransfers)
+    {
+        destroy_staging(vk, tail.m_Staging, tail.m_StagingMemory);
+    }
+
+    // retired images may still be sampled by the last frames
+    vkDeviceWaitIdle(vk.m_LogicalDevice);
+    ReleaseRetired(vk, true);
+    for (StreamedTexture& texture : m_Textures)
+    {
+        texture.m_Texture.Free(vk);
+    }
+
+    m_Transfers.clear();
+    m_TailTransfers.clear();
+    m_Textures.clear();
+    m_ResidentBytes = 0;
+}
+
+VkDeviceSize lvk::TextureStreamer::GetLevelBytes(const StreamedTexture& texture, uint32_t firstMip, uint32_t endMip) const
+{
+    VkDeviceSize bytes = 0;
+    for (uint32_t level = firstMip; level < endMip; level++)
+    {
+        bytes += texture.m_File.GetMip(level).m_Size;
+    }
+    return bytes;
+}
+
+// creates the image and view for levels topMip and below, plus a staging buffer and copy regions for the
+// levels the texture does not hold yet
+void lvk::TextureStreamer::CreateLevels(VkState& vk, const StreamedTexture& texture, uint32_t topMip, Transfer& transfer)
+{
+    const TextureFile& file = texture.m_File;
+    const uint32_t mipCount = file.GetMipCount() - topMip;
+    const texture_file::MipLevel& top = file.GetMip(topMip);
+
+    textures::CreateImage(vk, top.m_Width, top.m_Height, mipCount, VK_SAMPLE_COUNT_1_BIT, file.GetFormat(), VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        transfer.m_NewImage, transfer.m_NewMemory);
+    textures::CreateImageView(vk, transfer.m_NewImage, file.GetFormat(), mipCount, VK_IMAGE_ASPECT_COLOR_BIT, transfer.m_NewImageView);
+
+    // a texture being added has no image, every level comes from the file
+    const uint32_t uploadEnd = texture.m_Texture.m_Image == VK_NULL_HANDLE ? file.GetMipCount() : texture.m_ResidentMip;
+    VkDeviceSize stagingSize = 0;
+    for (uint32_t level = topMip; level < uploadEnd; level++)
+    {
+        stagingSize = (stagingSize + k_StagingAlignment - 1) & ~(k_StagingAlignment - 1);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = stagingSize;
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - topMip, 0, 1 };
+        region.imageExtent = { file.GetMip(level).m_Width, file.GetMip(level).m_Height, 1 };
+        transfer.m_Regions.push_back(region);
+        stagingSize += file.GetMip(level).m_Size;
+    }
+
+    if (stagingSize > 0)
+    {
+        buffers::CreateBuffer(vk, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            transfer.m_Staging, transfer.m_StagingMemory);
+    }
+}
+
+// growing reads the new levels out of the mapped file on a worker, shrinking only copies on the gpu
+void lvk::TextureStreamer::BeginTransfer(VkState& vk, uint32_t handle, uint32_t newMip)
+{
+    StreamedTexture& texture = m_Textures[handle];
+    texture.m_Busy = true;
+
+    Transfer transfer;
+    transfer.m_Handle = handle;
+    transfer.m_NewMip = newMip;
+    CreateLevels(vk, texture, newMip, transfer);
+
+    if (transfer.m_Staging != VK_NULL_HANDLE)
+    {
+        void* data;
+        vmaMapMemory(vk.m_Allocator, transfer.m_StagingMemory, &data);
+
+        // mapped file pointers stay put when m_Textures grows, the task must not touch the texture itself
+        struct Source
+        {
+            const uint8_t*  m_Data;
+            size_t          m_Size;
+            VkDeviceSize    m_Offset;
+        };
+        Vector<Source> sources;
+        for (const VkBufferImageCopy& region : transfer.m_Regions)
+        {
+            uint32_t level = newMip + region.imageSubresource.mipLevel;
+            sources.push_back({ texture.m_File.GetMipData(level), static_cast<size_t>(texture.m_File.GetMip(level).m_Size), region.bufferOffset });
+        }
+        transfer.m_Fill = ThreadPool::Default().Submit([sources = std::move(sources), data]() {
+            for (const Source& source : sources)
+            {
+                memcpy(static_cast<char*>(data) + source.m_Offset, source.m_Data, source.m_Size);
+            }
+        });
+    }
+
+    m_Transfers.push_back(std::move(transfer));
+}
+
+void lvk::TextureStreamer::SubmitTransfer(VkState& vk, Transfer& transfer)
+{
+    if (transfer.m_Staging != VK_NULL_HANDLE)
+    {
+        vmaUnmapMemory(vk.m_Allocator, transfer.m_StagingMemory);
+    }
+
+    const StreamedTexture& texture = m_Textures[transfer.m_Handle];
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = vk.m_GraphicsComputeQueueCommandPool;
+    allocInfo.commandBufferCount = 1;
+    VK_CHECK(vkAllocateCommandBuffers(vk.m_LogicalDevice, &allocInfo, &transfer.m_CommandBuffer))
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(transfer.m_CommandBuffer, &beginInfo);
+    record_levels(transfer.m_CommandBuffer, texture.m_File, texture.m_Texture.m_Image, texture.m_ResidentMip,
+        transfer.m_NewImage, transfer.m_NewMip, transfer.m_Staging, transfer.m_Regions);
+    vkEndCommandBuffer(transfer.m_CommandBuffer);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VK_CHECK(vkCreateFence(vk.m_LogicalDevice, &fenceInfo, nullptr, &transfer.m_Fence))
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &transfer.m_CommandBuffer;
+    VK_CHECK(vkQueueSubmit(vk.m_GraphicsQueue, 1, &submitInfo, transfer.m_Fence))
+}
+
+// swaps the new image in, the old one is kept until the frames that may still sample it have retired
+void lvk::TextureStreamer::CompleteTransfer(VkState& vk, Transfer& transfer)
+{
+    StreamedTexture& texture = m_Textures[transfer.m_Handle];
+    m_Retired.push_back({ texture.m_Texture.m_Image, texture.m_Texture.m_ImageView, texture.m_Texture.m_Memory, m_UpdateIndex });
+
+    texture.m_Texture.m_Image = transfer.m_NewImage;
+    texture.m_Texture.m_ImageView = transfer.m_NewImageView;
+    texture.m_Texture.m_Memory = transfer.m_NewMemory;
+    texture.m_ResidentMip = transfer.m_NewMip;
+    texture.m_Busy = false;
+
+    vkDestroyFence(vk.m_LogicalDevice, transfer.m_Fence, nullptr);
+    vkFreeCommandBuffers(vk.m_LogicalDevice, vk.m_GraphicsComputeQueueCommandPool, 1, &transfer.m_CommandBuffer);
+    destroy_staging(vk, transfer.m_Staging, transfer.m_StagingMemory);
+
+    if (m_OnViewChanged)
+    {
+        m_OnViewChanged(transfer.m_Handle, texture.m_Texture);
+    }
+}
+
+// every tail added since the last Update in one command buffer, waited on so they are sampleable
+// before the first frame that uses them
+void lvk::TextureStreamer::FlushTails(VkState& vk)
+{
+    if (m_TailTransfers.empty())
+    {
+        return;
+    }
+
+    VkCommandBuffer cmd = commands::BeginSingleTimeCommands(vk);
+    for (const Transfer& tail : m_TailTransfers)
+    {
+        record_levels(cmd, m_Textures[tail.m_Handle].m_File, VK_NULL_HANDLE, 0, tail.m_NewImage, tail.m_NewMip, tail.m_Staging, tail.m_Regions);
+    }
+    commands::EndSingleTimeCommands(vk, cmd);
+
+    for (Transfer& tail : m_TailTransfers)
+    {
+        destroy_staging(vk, tail.m_Staging, tail.m_StagingMemory);
+        m_Textures[tail.m_Handle].m_Busy = false;
+    }
+    m_TailTransfers.clear();
+}
+
+void lvk::TextureStreamer::ReleaseRetired(VkState& vk, bool all)
+{
+    auto released = std::remove_if(m_Retired.begin(), m_Retired.end(), [&](const RetiredImage& retired) {
+        if (!all && retired.m_RetiredAt + MAX_FRAMES_IN_FLIGHT >= m_UpdateIndex)
+        {
+            return false;
+        }
+        vkDestroyImageView(vk.m_LogicalDevice, retired.m_ImageView, nullptr);
+        vkDestroyImage(vk.m_LogicalDevice, retired.m_Image, nullptr);
+        vkFreeMemory(vk.m_LogicalDevice, retired.m_Memory, nullptr);
+        return true;
+    });
+    m_Retired.erase(released, m_Retired.end());
+}
+
+// shrinks the least recently requested textures that hold more than this update asked for, until
+// bytesNeeded fits the budget. returns false when it cannot
+bool lvk::TextureStreamer::Evict(VkState& vk, VkDeviceSize bytesNeeded)
+{
+    Vector<uint32_t> candidates;
+    for (uint32_t handle = 0; handle < m_Textures.size(); handle++)
+    {
+        const StreamedTexture& texture = m_Textures[handle];
+        if (!texture.m_Busy && texture.m_ResidentMip < texture.m_RequestedMip)
+        {
+            candidates.push_back(handle);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+        return m_Textures[a].m_LastRequest < m_Textures[b].m_LastRequest;
+    });
+
+    for (uint32_t handle : candidates)
+    {
+        if (m_ResidentBytes + bytesNeeded <= m_Config.m_MemoryBudget)
+        {
+            break;
+        }
+        const StreamedTexture& texture = m_Textures[handle];
+        m_ResidentBytes -= GetLevelBytes(texture, texture.m_ResidentMip, texture.m_RequestedMip);
+        BeginTransfer(vk, handle, texture.m_RequestedMip);
+    }
+    return m_ResidentBytes + bytesNeeded <= m_Config.m_MemoryBudget;
+}
+
+void lvk::TextureStreamer::StartUploads(VkState& vk)
+{
+    // largest shortfall first, then the largest on screen
+    Vector<uint32_t> candidates;
+    for (uint32_t handle = 0; handle < m_Textures.size(); handle++)
+    {
+        const StreamedTexture& texture = m_Textures[handle];
+        if (!texture.m_Busy && texture.m_RequestedMip < texture.m_ResidentMip)
+        {
+            candidates.push_back(handle);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+        const StreamedTexture& ta = m_Textures[a];
+        const StreamedTexture& tb = m_Textures[b];
+        uint32_t shortfallA = ta.m_ResidentMip - ta.m_RequestedMip;
+        uint32_t shortfallB = tb.m_ResidentMip - tb.m_RequestedMip;
+        return shortfallA != shortfallB ? shortfallA > shortfallB : ta.m_RequestedPixels > tb.m_RequestedPixels;
+    });
+
+    VkDeviceSize uploadBudget = m_Config.m_UploadBytesPerUpdate;
+    for (uint32_t handle : candidates)
+    {
+        const StreamedTexture& texture = m_Textures[handle];
+
+        // as many levels towards the request as the remaining upload budget allows, at least one
+        uint32_t newMip = texture.m_RequestedMip;
+        while (newMip + 1 < texture.m_ResidentMip && GetLevelBytes(texture, newMip, texture.m_ResidentMip) > uploadBudget)
+        {
+            newMip++;
+        }
+        VkDeviceSize bytes = GetLevelBytes(texture, newMip, texture.m_ResidentMip);
+        if (bytes > uploadBudget && uploadBudget < m_Config.m_UploadBytesPerUpdate)
+        {
+            break;
+        }
+        if (m_ResidentBytes + bytes > m_Config.m_MemoryBudget && !Evict(vk, bytes))
+        {
+            continue;
+        }
+
+        m_ResidentBytes += bytes;
+        uploadBudget -= std::min(bytes, uploadBudget);
+        BeginTransfer(vk, handle, newMip);
+    }
+}
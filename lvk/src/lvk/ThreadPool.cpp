@@ -0,0 +1,129 @@
+#include "lvk/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+
+lvk::ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    m_Workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        m_Workers.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+lvk::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_all();
+
+    for (auto& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+lvk::ThreadPool& lvk::ThreadPool::Default()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void lvk::ThreadPool::Enqueue(std::function<void()> task)
+{
+    if (m_Workers.empty())
+    {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.push(std::move(task));
+    }
+    m_Condition.notify_one();
+}
+
+void lvk::ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+            if (m_Stopping && m_Tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+        task();
+    }
+}
+
+void lvk::ThreadPool::ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    uint32_t threads = GetWorkerCount() + 1;
+    uint32_t batchSize = std::max(std::max(minBatchSize, 1u), (count + threads - 1) / threads);
+    uint32_t batchCount = (count + batchSize - 1) / batchSize;
+
+    if (batchCount == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    // batches are claimed from a shared counter by the helpers and the caller alike,
+    // so the caller never sleeps waiting on a queue that is busy with other work
+    struct ParallelForState
+    {
+        std::atomic<uint32_t>   m_NextBatch{ 0 };
+        std::atomic<uint32_t>   m_Remaining{ 0 };
+        std::mutex              m_Mutex;
+        std::condition_variable m_Done;
+    };
+
+    auto state = std::make_shared<ParallelForState>();
+    state->m_Remaining = batchCount;
+
+    auto runBatches = [state, count, batchSize, batchCount, &fn]()
+    {
+        uint32_t batch;
+        while ((batch = state->m_NextBatch.fetch_add(1)) < batchCount)
+        {
+            uint32_t begin = batch * batchSize;
+            fn(begin, std::min(begin + batchSize, count));
+
+            if (state->m_Remaining.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(state->m_Mutex);
+                state->m_Done.notify_all();
+            }
+        }
+    };
+
+    uint32_t helpers = std::min(batchCount - 1, GetWorkerCount());
+    for (uint32_t i = 0; i < helpers; i++)
+    {
+        Enqueue(runBatches);
+    }
+    runBatches();
+
+    std::unique_lock<std::mutex> lock(state->m_Mutex);
+    state->m_Done.wait(lock, [&]() { return state->m_Remaining.load() == 0; });
+}
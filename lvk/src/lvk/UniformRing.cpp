@@ -0,0 +1,86 @@
+#include "lvk/UniformRing.h"
+#include "lvk/Buffer.h"
+#include "spdlog/spdlog.h"
+#include "volk.h"
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    if (alignment == 0)
+    {
+        return value;
+    }
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+lvk::UniformRing lvk::UniformRing::Create(VkState& vk, VkDeviceSize capacityPerFrame, uint32_t maxRange)
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(vk.m_PhysicalDevice, &properties);
+
+    UniformRing ring{};
+    ring.m_Alignment = properties.limits.minUniformBufferOffsetAlignment;
+    ring.m_MaxRange = std::min(maxRange, properties.limits.maxUniformBufferRange);
+    ring.m_Capacity = align_up(std::max(capacityPerFrame, VkDeviceSize{ ring.m_MaxRange }), ring.m_Alignment);
+
+    if (ring.m_MaxRange < maxRange)
+    {
+        spdlog::warn("UniformRing : requested range {} exceeds maxUniformBufferRange, clamping to {}", maxRange, ring.m_MaxRange);
+    }
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        buffers::CreateMappedBuffer(vk, ring.m_FrameBuffers[i], VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            static_cast<uint32_t>(ring.m_Capacity));
+    }
+
+    return ring;
+}
+
+void lvk::UniformRing::BeginFrame(uint32_t frameIndex)
+{
+    m_FrameIndex = frameIndex;
+    m_Head = 0;
+}
+
+bool lvk::UniformRing::Allocate(uint32_t size, uint32_t& dynamicOffset, void*& mappedAddr)
+{
+    if (size > m_MaxRange)
+    {
+        spdlog::error("UniformRing : allocation of {} bytes is larger than the bound range {}", size, m_MaxRange);
+        return false;
+    }
+
+    VkDeviceSize offset = align_up(m_Head, m_Alignment);
+
+    // the descriptor always reads m_MaxRange bytes from the dynamic offset
+    if (offset + m_MaxRange > m_Capacity)
+    {
+        spdlog::error("UniformRing : out of space for frame {} ({} bytes used)", m_FrameIndex, m_Head);
+        return false;
+    }
+
+    m_Head = offset + size;
+    dynamicOffset = static_cast<uint32_t>(offset);
+    mappedAddr = static_cast<uint8_t*>(m_FrameBuffers[m_FrameIndex].m_MappedAddr) + offset;
+    return true;
+}
+
+VkDescriptorBufferInfo lvk::UniformRing::GetDescriptorBufferInfo(uint32_t frameIndex) const
+{
+    VkDescriptorBufferInfo info{};
+    info.buffer = m_FrameBuffers[frameIndex].m_GpuBuffer;
+    info.offset = 0;
+    info.range = m_MaxRange;
+    return info;
+}
+
+void lvk::UniformRing::Free(VkState& vk)
+{
+    for (auto& buffer : m_FrameBuffers)
+    {
+        buffer.Free(vk);
+    }
+    m_Capacity = 0;
+    m_Head = 0;
+}
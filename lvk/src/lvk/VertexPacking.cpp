@@ -0,0 +1,193 @@
+#include "lvk/VertexPacking.h"
+#include "glm/gtc/packing.hpp"
+#include <cmath>
+
+static const char* k_UnpackGLSL = R"(
+vec3 Unpack_OctNormal(vec2 encoded)
+{
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+)";
+
+static int16_t to_snorm16(float value)
+{
+    return static_cast<int16_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static float from_snorm16(int16_t value)
+{
+    return glm::max(float(value) / 32767.0f, -1.0f);
+}
+
+static glm::vec2 oct_encode(const glm::vec3& n)
+{
+    glm::vec2 p = glm::vec2(n.x, n.y) * (1.0f / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z)));
+    if (n.z < 0.0f)
+    {
+        glm::vec2 folded(1.0f - std::abs(p.y), 1.0f - std::abs(p.x));
+        p.x = p.x >= 0.0f ? folded.x : -folded.x;
+        p.y = p.y >= 0.0f ? folded.y : -folded.y;
+    }
+    return p;
+}
+
+static glm::vec3 oct_decode(const glm::vec2& e)
+{
+    glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    float t = glm::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+glm::mat4 lvk::vertex_packing::QuantizationParams::GetDequantizeMatrix() const
+{
+    glm::mat4 m(1.0f);
+    m[0][0] = m_Scale.x;
+    m[1][1] = m_Scale.y;
+    m[2][2] = m_Scale.z;
+    m[3] = glm::vec4(m_Offset, 1.0f);
+    return m;
+}
+
+lvk::vertex_packing::QuantizationParams lvk::vertex_packing::CalculateQuantization(const glm::vec3& min, const glm::vec3& max)
+{
+    QuantizationParams params{};
+    params.m_Offset = (min + max) * 0.5f;
+    // flat meshes keep a usable scale on their collapsed axis
+    params.m_Scale = glm::max((max - min) * 0.5f, glm::vec3(1e-6f));
+    return params;
+}
+
+void lvk::vertex_packing::PackPosition(const glm::vec3& position, const QuantizationParams& params, int16_t packed[4])
+{
+    glm::vec3 normalised = (position - params.m_Offset) / params.m_Scale;
+    packed[0] = to_snorm16(normalised.x);
+    packed[1] = to_snorm16(normalised.y);
+    packed[2] = to_snorm16(normalised.z);
+    packed[3] = 0;
+}
+
+glm::vec3 lvk::vertex_packing::UnpackPosition(const int16_t packed[4], const QuantizationParams& params)
+{
+    glm::vec3 normalised(from_snorm16(packed[0]), from_snorm16(packed[1]), from_snorm16(packed[2]));
+    return normalised * params.m_Scale + params.m_Offset;
+}
+
+void lvk::vertex_packing::PackNormal(const glm::vec3& normal, int16_t packed[2])
+{
+    float length = glm::length(normal);
+    if (length == 0.0f)
+    {
+        packed[0] = 0;
+        packed[1] = to_snorm16(1.0f);
+        return;
+    }
+
+    glm::vec3 n = normal / length;
+    glm::vec2 encoded = oct_encode(n);
+
+    // rounding each component to nearest is not always the closest direction, try all four
+    float best = -2.0f;
+    for (int i = 0; i < 4; i++)
+    {
+        float x = (i & 1) ? std::ceil(encoded.x * 32767.0f) : std::floor(encoded.x * 32767.0f);
+        float y = (i & 2) ? std::ceil(encoded.y * 32767.0f) : std::floor(encoded.y * 32767.0f);
+        int16_t candidate[2] = {
+            static_cast<int16_t>(glm::clamp(x, -32767.0f, 32767.0f)),
+            static_cast<int16_t>(glm::clamp(y, -32767.0f, 32767.0f)) };
+
+        float similarity = glm::dot(UnpackNormal(candidate), n);
+        if (similarity > best)
+        {
+            best = similarity;
+            packed[0] = candidate[0];
+            packed[1] = candidate[1];
+        }
+    }
+}
+
+glm::vec3 lvk::vertex_packing::UnpackNormal(const int16_t packed[2])
+{
+    return oct_decode(glm::vec2(from_snorm16(packed[0]), from_snorm16(packed[1])));
+}
+
+uint16_t lvk::vertex_packing::PackHalf(float value)
+{
+    return glm::packHalf1x16(value);
+}
+
+float lvk::vertex_packing::UnpackHalf(uint16_t value)
+{
+    return glm::unpackHalf1x16(value);
+}
+
+lvk::vertex_packing::QuantizationParams lvk::vertex_packing::PackVertices(const Vector<VertexDataPosUv>& vertices, Vector<VertexDataPackedPosUv>& packed)
+{
+    QuantizationParams params = CalculateQuantization(vertices);
+    packed.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        PackPosition(vertices[i].Position, params, packed[i].Position);
+        packed[i].UV[0] = PackHalf(vertices[i].UV.x);
+        packed[i].UV[1] = PackHalf(vertices[i].UV.y);
+    }
+    return params;
+}
+
+lvk::vertex_packing::QuantizationParams lvk::vertex_packing::PackVertices(const Vector<VertexDataPosColUv>& vertices, Vector<VertexDataPackedPosColUv>& packed)
+{
+    QuantizationParams params = CalculateQuantization(vertices);
+    packed.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        PackPosition(vertices[i].Position, params, packed[i].Position);
+        for (int c = 0; c < 3; c++)
+        {
+            packed[i].Colour[c] = static_cast<uint8_t>(std::round(glm::clamp(vertices[i].Colour[c], 0.0f, 1.0f) * 255.0f));
+        }
+        packed[i].Colour[3] = 255;
+        packed[i].UV[0] = PackHalf(vertices[i].UV.x);
+        packed[i].UV[1] = PackHalf(vertices[i].UV.y);
+    }
+    return params;
+}
+
+lvk::vertex_packing::QuantizationParams lvk::vertex_packing::PackVertices(const Vector<VertexDataPosNormalUv>& vertices, Vector<VertexDataPackedPosNormalUv>& packed)
+{
+    QuantizationParams params = CalculateQuantization(vertices);
+    packed.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        PackPosition(vertices[i].Position, params, packed[i].Position);
+        PackNormal(vertices[i].Normal, packed[i].Normal);
+        packed[i].UV[0] = PackHalf(vertices[i].UV.x);
+        packed[i].UV[1] = PackHalf(vertices[i].UV.y);
+    }
+    return params;
+}
+
+const char* lvk::vertex_packing::GetUnpackGLSL()
+{
+    return k_UnpackGLSL;
+}
+
+lvk::String lvk::vertex_packing::InsertUnpackGLSL(const String& source)
+{
+    size_t version = source.find("#version");
+    if (version == String::npos)
+    {
+        return k_UnpackGLSL + source;
+    }
+
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == String::npos)
+    {
+        return source + "\n" + k_UnpackGLSL;
+    }
+    return source.substr(0, lineEnd + 1) + k_UnpackGLSL + source.substr(lineEnd + 1);
+}
@@ -0,0 +1,223 @@
+// lvk-mesh-cook
+// imports a model with assimp once, offline, and writes it as a .lvkm mesh file (lvk/MeshFile.h).
+// meshes go through the same processing as the examples' runtime import : vertex cache / overdraw /
+// fetch optimisation and a LOD chain, so loading the cooked file is a copy into a GeometryPool.
+//
+// usage : lvk-mesh-cook <model> <output.lvkm> [--no-normals] [--no-lods]
+
+#include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
+#include "assimp/scene.h"
+#include "lvk/Lod.h"
+#include "lvk/MeshFile.h"
+#include "lvk/MeshProcessing.h"
+#include "lvk/ThreadPool.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// same layouts as lvk::VertexDataPosUv / VertexDataPosNormalUv, which need vulkan headers
+struct CookVertexPosUv
+{
+    glm::vec3 Position;
+    glm::vec2 UV;
+};
+static_assert(sizeof(CookVertexPosUv) == sizeof(float) * 5, "CookVertexPosUv must match lvk::VertexDataPosUv");
+
+struct CookVertexPosNormalUv
+{
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 UV;
+};
+static_assert(sizeof(CookVertexPosNormalUv) == sizeof(float) * 8, "CookVertexPosNormalUv must match lvk::VertexDataPosNormalUv");
+
+static glm::vec3 to_glm(const aiVector3D& v)
+{
+    return glm::vec3(v.x, v.y, v.z);
+}
+
+static void build_vertices(const aiMesh* mesh, std::vector<CookVertexPosUv>& vertices)
+{
+    vertices.resize(mesh->mNumVertices);
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+    {
+        vertices[i].Position = to_glm(mesh->mVertices[i]);
+        vertices[i].UV = glm::vec2(mesh->mTextureCoords[0][i].x, 1.0f - mesh->mTextureCoords[0][i].y);
+    }
+}
+
+static void build_vertices(const aiMesh* mesh, std::vector<CookVertexPosNormalUv>& vertices)
+{
+    vertices.resize(mesh->mNumVertices);
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+    {
+        vertices[i].Position = to_glm(mesh->mVertices[i]);
+        vertices[i].Normal = to_glm(mesh->mNormals[i]);
+        vertices[i].UV = glm::vec2(mesh->mTextureCoords[0][i].x, 1.0f - mesh->mTextureCoords[0][i].y);
+    }
+}
+
+static bool build_indices(const aiMesh* mesh, std::vector<uint32_t>& indices)
+{
+    indices.reserve(size_t{ mesh->mNumFaces } * 3);
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+    {
+        const aiFace& face = mesh->mFaces[i];
+        if (face.mNumIndices != 3)
+        {
+            return false;
+        }
+        indices.insert(indices.end(), face.mIndices, face.mIndices + 3);
+    }
+    return true;
+}
+
+template<typename _Ty>
+static bool cook_mesh(const aiMesh* mesh, bool withLods, lvk::mesh_file::CookedMesh& cooked)
+{
+    if (!mesh->HasPositions() || !mesh->HasTextureCoords(0))
+    {
+        return false;
+    }
+
+    std::vector<_Ty> vertices;
+    build_vertices(mesh, vertices);
+    if (!build_indices(mesh, cooked.m_Indices))
+    {
+        return false;
+    }
+
+    lvk::mesh_processing::OptimizeMesh(vertices, cooked.m_Indices);
+    if (withLods)
+    {
+        lvk::lod::BuildLodChain(vertices, cooked.m_Indices, cooked.m_Lods);
+    }
+
+    cooked.m_VertexCount = static_cast<uint32_t>(vertices.size());
+    cooked.m_Vertices.resize(sizeof(_Ty) * vertices.size());
+    memcpy(cooked.m_Vertices.data(), vertices.data(), cooked.m_Vertices.size());
+    cooked.m_MaterialIndex = mesh->mMaterialIndex;
+    cooked.m_AABBMin[0] = mesh->mAABB.mMin.x;
+    cooked.m_AABBMin[1] = mesh->mAABB.mMin.y;
+    cooked.m_AABBMin[2] = mesh->mAABB.mMin.z;
+    cooked.m_AABBMax[0] = mesh->mAABB.mMax.x;
+    cooked.m_AABBMax[1] = mesh->mAABB.mMax.y;
+    cooked.m_AABBMax[2] = mesh->mAABB.mMax.z;
+    return true;
+}
+
+static void collect_meshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes)
+{
+    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+    {
+        meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+    }
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+    {
+        collect_meshes(node->mChildren[i], scene, meshes);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage : lvk-mesh-cook <model> <output.lvkm> [--no-normals] [--no-lods]" << std::endl;
+        return 1;
+    }
+
+    const std::string inputPath = argv[1];
+    const std::string outputPath = argv[2];
+    bool withNormals = true;
+    bool withLods = true;
+    for (int a = 3; a < argc; a++)
+    {
+        if (strcmp(argv[a], "--no-normals") == 0)
+        {
+            withNormals = false;
+        }
+        else if (strcmp(argv[a], "--no-lods") == 0)
+        {
+            withLods = false;
+        }
+        else
+        {
+            std::cerr << "lvk-mesh-cook : unknown option " << argv[a] << std::endl;
+            return 1;
+        }
+    }
+
+    // keep in step with LoadModelAssimp in examples/example-common.h
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(inputPath.c_str(),
+        aiProcess_Triangulate |
+        aiProcess_JoinIdenticalVertices |
+        aiProcess_CalcTangentSpace |
+        aiProcess_OptimizeMeshes |
+        aiProcess_GenSmoothNormals |
+        aiProcess_OptimizeGraph |
+        aiProcess_FixInfacingNormals |
+        aiProcess_FindInvalidData |
+        aiProcess_GenBoundingBoxes);
+    if (scene == nullptr)
+    {
+        std::cerr << "lvk-mesh-cook : failed to import " << inputPath << " : " << importer.GetErrorString() << std::endl;
+        return 1;
+    }
+
+    std::vector<const aiMesh*> meshes;
+    collect_meshes(scene->mRootNode, scene, meshes);
+
+    std::vector<lvk::mesh_file::CookedMesh> cooked(meshes.size());
+    std::vector<uint8_t> valid(meshes.size(), 0);
+    lvk::ThreadPool::Default().ParallelFor(static_cast<uint32_t>(meshes.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            valid[i] = withNormals && meshes[i]->HasNormals()
+                ? cook_mesh<CookVertexPosNormalUv>(meshes[i], withLods, cooked[i])
+                : !withNormals && cook_mesh<CookVertexPosUv>(meshes[i], withLods, cooked[i]);
+        }
+    });
+
+    std::vector<lvk::mesh_file::CookedMesh> written;
+    written.reserve(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (!valid[i])
+        {
+            std::cerr << "lvk-mesh-cook : skipping mesh " << i << " (" << meshes[i]->mName.C_Str() << "), it lacks uvs"
+                      << (withNormals ? " or normals" : "") << " or has non triangular faces" << std::endl;
+            continue;
+        }
+        written.push_back(std::move(cooked[i]));
+    }
+
+    // texture paths stay relative to the model, the loader resolves them against the .lvkm's directory
+    std::vector<std::string> diffusePaths(scene->mNumMaterials);
+    for (unsigned int i = 0; i < scene->mNumMaterials; i++)
+    {
+        aiString path;
+        if (scene->mMaterials[i]->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS)
+        {
+            diffusePaths[i] = path.C_Str();
+        }
+    }
+
+    lvk::mesh_file::VertexLayout layout = withNormals ? lvk::mesh_file::VertexLayout::PosNormalUv : lvk::mesh_file::VertexLayout::PosUv;
+    if (!lvk::mesh_file::Write(outputPath, layout, written, diffusePaths))
+    {
+        std::cerr << "lvk-mesh-cook : failed to write " << outputPath << std::endl;
+        return 1;
+    }
+
+    size_t triangleCount = 0;
+    for (const auto& mesh : written)
+    {
+        triangleCount += (mesh.m_Lods.empty() ? mesh.m_Indices.size() : mesh.m_Lods[0].m_IndexCount) / 3;
+    }
+    std::cout << "lvk-mesh-cook : " << outputPath << " : " << written.size() << " meshes, " << triangleCount
+              << " triangles, " << diffusePaths.size() << " materials" << std::endl;
+    return 0;
+}
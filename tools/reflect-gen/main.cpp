@@ -0,0 +1,457 @@
+// lvk-reflect-gen
+// reads SPIR-V stages with spirv_reflect and writes a C++ header containing one struct per
+// uniform / storage block. members are laid out at the reflected std140 / std430 offsets with
+// explicit padding, and every offset and size is checked with a static_assert so a shader change
+// that breaks the layout fails to compile instead of corrupting gpu data.
+//
+// usage : lvk-reflect-gen <output.h> <namespace> <stage.spv> [stage.spv ...]
+
+#include "ThirdParty/spirv_reflect.h"
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct ReflectedBlock
+{
+    std::string m_TypeName;
+    std::string m_BindingName;
+    uint32_t    m_Set;
+    uint32_t    m_Binding;
+    bool        m_IsStorage;
+    std::string m_Source;
+};
+
+// first declaration of a set / binding, later stages must agree with it
+struct SeenBlock
+{
+    std::string m_TypeName;
+    uint32_t    m_Size;
+    std::string m_Source;
+};
+
+struct MemberDecl
+{
+    std::string m_Type;
+    std::string m_Extent;   // array suffix, e.g. "[4]"
+    uint32_t    m_Size;
+};
+
+class HeaderWriter
+{
+public:
+    std::ostringstream      m_Structs;
+    std::set<std::string>   m_EmittedTypes;
+    bool                    m_Failed = false;
+
+    void EmitBlock(const ReflectedBlock& block, const SpvReflectBlockVariable& var)
+    {
+        std::ostringstream body;
+        std::ostringstream asserts;
+        const std::string typeName = UniqueTypeName(block.m_TypeName);
+
+        uint32_t runtimeArrayOffset = UINT32_MAX;
+        uint32_t cursor = EmitMembers(typeName, var, body, asserts, runtimeArrayOffset);
+
+        const uint32_t size = runtimeArrayOffset != UINT32_MAX ? runtimeArrayOffset : var.size;
+        if (size > cursor)
+        {
+            body << "        uint8_t _pad" << cursor << "[" << (size - cursor) << "];\n";
+        }
+
+        m_Structs << "    // " << (block.m_IsStorage ? "std430" : "std140") << " " << block.m_BindingName
+                  << " (set " << block.m_Set << ", binding " << block.m_Binding << ") from " << block.m_Source << "\n";
+        m_Structs << "    struct " << typeName << "\n    {\n";
+        m_Structs << "        static constexpr uint32_t k_Set = " << block.m_Set << ";\n";
+        m_Structs << "        static constexpr uint32_t k_Binding = " << block.m_Binding << ";\n";
+        m_Structs << "        static constexpr uint32_t k_Size = " << size << ";\n";
+        m_Structs << "        static constexpr bool k_IsStorageBuffer = " << (block.m_IsStorage ? "true" : "false") << ";\n";
+        m_Structs << "        static constexpr const char* k_Name = \"" << block.m_BindingName << "\";\n\n";
+        m_Structs << body.str();
+        m_Structs << "    };\n";
+        if (size > 0)
+        {
+            m_Structs << "    static_assert(sizeof(" << typeName << ") == " << size << ", \"" << typeName << " size does not match the shader\");\n";
+        }
+        m_Structs << asserts.str() << "\n";
+    }
+
+private:
+    std::set<std::string> m_UsedNames;
+
+    std::string UniqueTypeName(const std::string& name)
+    {
+        std::string candidate = name;
+        uint32_t suffix = 1;
+        while (m_UsedNames.count(candidate) > 0)
+        {
+            candidate = name + std::to_string(suffix++);
+        }
+        m_UsedNames.insert(candidate);
+        return candidate;
+    }
+
+    static std::string Identifier(const char* name)
+    {
+        static const std::set<std::string> keywords = {
+            "auto", "bool", "case", "char", "class", "const", "default", "delete", "do", "double", "else",
+            "enum", "explicit", "float", "for", "friend", "if", "int", "long", "namespace", "new", "operator",
+            "private", "protected", "public", "register", "return", "short", "signed", "sizeof", "static",
+            "struct", "switch", "template", "this", "typedef", "union", "unsigned", "using", "virtual", "void",
+            "volatile", "while"
+        };
+
+        std::string id = name != nullptr ? name : "";
+        if (id.empty())
+        {
+            return "unnamed";
+        }
+        if (keywords.count(id) > 0)
+        {
+            id += "_";
+        }
+        return id;
+    }
+
+    static std::string ScalarType(const SpvReflectTypeDescription& type, std::string& glmPrefix)
+    {
+        const uint32_t width = type.traits.numeric.scalar.width;
+        if (type.type_flags & SPV_REFLECT_TYPE_FLAG_FLOAT)
+        {
+            glmPrefix = width == 64 ? "d" : "";
+            return width == 64 ? "double" : "float";
+        }
+        if (type.type_flags & SPV_REFLECT_TYPE_FLAG_INT)
+        {
+            bool isSigned = type.traits.numeric.scalar.signedness != 0;
+            glmPrefix = isSigned ? "i" : "u";
+            if (width == 64)
+            {
+                return isSigned ? "int64_t" : "uint64_t";
+            }
+            return isSigned ? "int32_t" : "uint32_t";
+        }
+        // glsl bools are 32 bit in buffers
+        glmPrefix = "u";
+        return "uint32_t";
+    }
+
+    // declaration of a single, non-array element
+    bool ElementDecl(const std::string& owner, const SpvReflectBlockVariable& member, MemberDecl& decl)
+    {
+        const SpvReflectTypeDescription& type = *member.type_description;
+
+        if (type.type_flags & SPV_REFLECT_TYPE_FLAG_STRUCT)
+        {
+            const std::string nested = UniqueTypeName(owner + "_" + Identifier(type.type_name));
+            std::ostringstream body;
+            std::ostringstream asserts;
+            uint32_t runtimeArrayOffset = UINT32_MAX;
+            uint32_t elementSize = member.array.dims_count > 0 ? member.array.stride : member.size;
+            uint32_t cursor = EmitMembers(nested, member, body, asserts, runtimeArrayOffset);
+            if (elementSize > cursor)
+            {
+                body << "        uint8_t _pad" << cursor << "[" << (elementSize - cursor) << "];\n";
+            }
+
+            m_Structs << "    struct " << nested << "\n    {\n" << body.str() << "    };\n";
+            m_Structs << "    static_assert(sizeof(" << nested << ") == " << elementSize << ", \"" << nested << " size does not match the shader\");\n";
+            m_Structs << asserts.str() << "\n";
+
+            decl.m_Type = nested;
+            decl.m_Size = elementSize;
+            return true;
+        }
+
+        std::string glmPrefix;
+        const std::string scalar = ScalarType(type, glmPrefix);
+        const uint32_t scalarSize = type.traits.numeric.scalar.width / 8;
+
+        if (type.type_flags & SPV_REFLECT_TYPE_FLAG_MATRIX)
+        {
+            const SpvReflectNumericTraits::Matrix& matrix = type.traits.numeric.matrix;
+            const bool rowMajor = (member.decoration_flags & SPV_REFLECT_DECORATION_ROW_MAJOR) != 0;
+            const uint32_t vectorCount = rowMajor ? matrix.row_count : matrix.column_count;
+            const uint32_t vectorSize = rowMajor ? matrix.column_count : matrix.row_count;
+
+            if (!rowMajor && matrix.stride == vectorSize * scalarSize)
+            {
+                decl.m_Type = "glm::" + glmPrefix + "mat" + std::to_string(matrix.column_count);
+                if (matrix.column_count != matrix.row_count)
+                {
+                    decl.m_Type += "x" + std::to_string(matrix.row_count);
+                }
+                decl.m_Size = matrix.column_count * matrix.stride;
+                return true;
+            }
+
+            // padded columns (std140 mat3) or row major storage, expose the raw vectors
+            if (matrix.stride % scalarSize != 0 || matrix.stride / scalarSize > 4)
+            {
+                std::cerr << "lvk-reflect-gen : unsupported matrix stride " << matrix.stride << " on " << member.name << std::endl;
+                m_Failed = true;
+                return false;
+            }
+            decl.m_Type = "glm::" + glmPrefix + "vec" + std::to_string(matrix.stride / scalarSize);
+            decl.m_Extent = "[" + std::to_string(vectorCount) + "]";
+            decl.m_Size = vectorCount * matrix.stride;
+            return true;
+        }
+
+        if (type.type_flags & SPV_REFLECT_TYPE_FLAG_VECTOR)
+        {
+            const uint32_t count = type.traits.numeric.vector.component_count;
+            decl.m_Type = "glm::" + glmPrefix + "vec" + std::to_string(count);
+            decl.m_Size = count * scalarSize;
+            return true;
+        }
+
+        decl.m_Type = scalar;
+        decl.m_Size = scalarSize;
+        return true;
+    }
+
+    uint32_t EmitMembers(const std::string& owner, const SpvReflectBlockVariable& var, std::ostringstream& body,
+                         std::ostringstream& asserts, uint32_t& runtimeArrayOffset)
+    {
+        uint32_t cursor = 0;
+        for (uint32_t i = 0; i < var.member_count; i++)
+        {
+            const SpvReflectBlockVariable& member = var.members[i];
+            const std::string name = Identifier(member.name);
+
+            if (member.offset < cursor)
+            {
+                std::cerr << "lvk-reflect-gen : " << owner << "." << name << " overlaps the previous member" << std::endl;
+                m_Failed = true;
+                return cursor;
+            }
+            if (member.offset > cursor)
+            {
+                body << "        uint8_t _pad" << cursor << "[" << (member.offset - cursor) << "];\n";
+            }
+
+            MemberDecl decl{};
+            if (!ElementDecl(owner, member, decl))
+            {
+                return cursor;
+            }
+
+            if (member.array.dims_count > 0)
+            {
+                const uint32_t stride = member.array.stride;
+                std::string elementType = decl.m_Type + decl.m_Extent;
+                if (stride != decl.m_Size)
+                {
+                    // std140 rounds array elements up to 16 bytes, wrap the element with its padding
+                    const std::string wrapper = UniqueTypeName(owner + "_" + name + "_Element");
+                    m_Structs << "    struct " << wrapper << "\n    {\n";
+                    m_Structs << "        " << decl.m_Type << " m_Value" << decl.m_Extent << ";\n";
+                    m_Structs << "        uint8_t _pad[" << (stride - decl.m_Size) << "];\n";
+                    m_Structs << "    };\n";
+                    m_Structs << "    static_assert(sizeof(" << wrapper << ") == " << stride << ", \"" << wrapper << " stride does not match the shader\");\n\n";
+                    elementType = wrapper;
+                }
+
+                // runtime sized arrays can't be members, expose the element layout instead
+                if (member.array.dims[0] == 0)
+                {
+                    body << "        using " << name << "_Element = " << (stride != decl.m_Size ? elementType : decl.m_Type) << ";\n";
+                    body << "        static constexpr uint32_t k_" << name << "_Offset = " << member.offset << ";\n";
+                    body << "        static constexpr uint32_t k_" << name << "_Stride = " << stride << ";\n";
+                    runtimeArrayOffset = member.offset;
+                    return member.offset;
+                }
+
+                std::string extent;
+                uint32_t count = 1;
+                for (uint32_t d = 0; d < member.array.dims_count; d++)
+                {
+                    extent += "[" + std::to_string(member.array.dims[d]) + "]";
+                    count *= member.array.dims[d];
+                }
+
+                if (stride != decl.m_Size)
+                {
+                    body << "        " << elementType << " " << name << extent << ";\n";
+                }
+                else
+                {
+                    body << "        " << decl.m_Type << " " << name << extent << decl.m_Extent << ";\n";
+                }
+                cursor = member.offset + count * stride;
+            }
+            else
+            {
+                body << "        " << decl.m_Type << " " << name << decl.m_Extent << ";\n";
+                cursor = member.offset + decl.m_Size;
+            }
+
+            asserts << "    static_assert(offsetof(" << owner << ", " << name << ") == " << member.offset
+                    << ", \"" << owner << "::" << name << " offset does not match the shader\");\n";
+        }
+        return cursor;
+    }
+};
+
+// owns the reflected modules so every return path releases them
+struct ModuleList
+{
+    std::vector<SpvReflectShaderModule> m_Modules;
+
+    ~ModuleList()
+    {
+        for (auto& module : m_Modules)
+        {
+            spvReflectDestroyShaderModule(&module);
+        }
+    }
+};
+
+static bool load_file(const std::string& path, std::vector<char>& out)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    out.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(out.data(), static_cast<std::streamsize>(out.size()));
+    return true;
+}
+
+static std::string file_name(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "usage : lvk-reflect-gen <output.h> <namespace> <stage.spv> [stage.spv ...]" << std::endl;
+        return 1;
+    }
+
+    const std::string outputPath = argv[1];
+    const std::string ns = argv[2];
+
+    // modules must outlive the writer, block variables point into them
+    ModuleList modules;
+    std::vector<std::vector<char>> binaries;
+    modules.m_Modules.reserve(argc - 3);
+    binaries.reserve(argc - 3);
+
+    HeaderWriter writer{};
+    std::map<uint64_t, SeenBlock> seenBlocks;
+    std::string sources;
+
+    for (int a = 3; a < argc; a++)
+    {
+        const std::string path = argv[a];
+        binaries.emplace_back();
+        if (!load_file(path, binaries.back()))
+        {
+            std::cerr << "lvk-reflect-gen : failed to open " << path << std::endl;
+            return 1;
+        }
+
+        SpvReflectShaderModule created{};
+        if (spvReflectCreateShaderModule(binaries.back().size(), binaries.back().data(), &created) != SPV_REFLECT_RESULT_SUCCESS)
+        {
+            std::cerr << "lvk-reflect-gen : failed to reflect " << path << std::endl;
+            return 1;
+        }
+        modules.m_Modules.push_back(created);
+        SpvReflectShaderModule& module = modules.m_Modules.back();
+        sources += " " + file_name(path);
+
+        uint32_t bindingCount = 0;
+        spvReflectEnumerateDescriptorBindings(&module, &bindingCount, nullptr);
+        std::vector<SpvReflectDescriptorBinding*> bindings(bindingCount);
+        spvReflectEnumerateDescriptorBindings(&module, &bindingCount, bindings.data());
+
+        for (SpvReflectDescriptorBinding* binding : bindings)
+        {
+            const bool isUniform = binding->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            const bool isStorage = binding->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            if (!isUniform && !isStorage)
+            {
+                continue;
+            }
+
+            // the same block is usually declared in several stages, but stages from different
+            // programs may put unrelated blocks at one set / binding, which one header can't describe
+            const char* typeName = binding->type_description != nullptr ? binding->type_description->type_name : nullptr;
+            const std::string blockTypeName = typeName != nullptr && typeName[0] != '\0' ? typeName : binding->name;
+            const uint64_t key = (uint64_t{ binding->set } << 32) | binding->binding;
+            auto seen = seenBlocks.find(key);
+            if (seen != seenBlocks.end())
+            {
+                if (seen->second.m_TypeName != blockTypeName)
+                {
+                    std::cerr << "lvk-reflect-gen : set " << binding->set << " binding " << binding->binding
+                              << " is " << seen->second.m_TypeName << " in " << seen->second.m_Source
+                              << " but " << blockTypeName << " in " << file_name(path)
+                              << ", generate one header per program" << std::endl;
+                    return 1;
+                }
+                if (seen->second.m_Size != binding->block.size)
+                {
+                    std::cerr << "lvk-reflect-gen : " << blockTypeName << " (set " << binding->set << ", binding " << binding->binding
+                              << ") has a different size in " << file_name(path) << " than in " << seen->second.m_Source << std::endl;
+                    return 1;
+                }
+                continue;
+            }
+            seenBlocks.emplace(key, SeenBlock{ blockTypeName, binding->block.size, file_name(path) });
+
+            ReflectedBlock block{};
+            block.m_TypeName = blockTypeName;
+            block.m_BindingName = binding->name;
+            block.m_Set = binding->set;
+            block.m_Binding = binding->binding;
+            block.m_IsStorage = isStorage;
+            block.m_Source = file_name(path);
+            writer.EmitBlock(block, binding->block);
+        }
+    }
+
+    if (writer.m_Failed)
+    {
+        return 1;
+    }
+
+    std::ostringstream header;
+    header << "// generated by lvk-reflect-gen from" << sources << ", do not edit.\n";
+    header << "#pragma once\n";
+    header << "#include <cstddef>\n";
+    header << "#include <cstdint>\n";
+    header << "#include \"glm/glm.hpp\"\n\n";
+    header << "namespace " << ns << "\n{\n";
+    header << writer.m_Structs.str();
+    header << "}\n";
+
+    // leave the file untouched when nothing changed so dependents don't rebuild
+    std::vector<char> existing;
+    const std::string contents = header.str();
+    if (load_file(outputPath, existing) && std::string(existing.begin(), existing.end()) == contents)
+    {
+        return 0;
+    }
+
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "lvk-reflect-gen : failed to write " << outputPath << std::endl;
+        return 1;
+    }
+    out << contents;
+    return 0;
+}
@@ -0,0 +1,497 @@
+#include "BcEncoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static constexpr int k_Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// principal axis of the block's texels through their mean, by power iteration on the covariance.
+// the axis is left zero when the block is a single colour
+template<int _Channels>
+static void principal_axis(const float (*texels)[4], float* mean, float* axis)
+{
+    for (int c = 0; c < _Channels; c++)
+    {
+        mean[c] = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            mean[c] += texels[i][c];
+        }
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[_Channels][_Channels] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < _Channels; c++)
+        {
+            for (int d = 0; d < _Channels; d++)
+            {
+                covariance[c][d] += (texels[i][c] - mean[c]) * (texels[i][d] - mean[d]);
+            }
+        }
+    }
+
+    // start from the channel that varies most, it is never orthogonal to the principal axis
+    int largest = 0;
+    for (int c = 1; c < _Channels; c++)
+    {
+        largest = covariance[c][c] > covariance[largest][largest] ? c : largest;
+    }
+    for (int c = 0; c < _Channels; c++)
+    {
+        axis[c] = covariance[largest][c];
+    }
+
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[_Channels] = {};
+        float length = 0.0f;
+        for (int c = 0; c < _Channels; c++)
+        {
+            for (int d = 0; d < _Channels; d++)
+            {
+                next[c] += covariance[c][d] * axis[d];
+            }
+            length += next[c] * next[c];
+        }
+        length = std::sqrt(length);
+        for (int c = 0; c < _Channels; c++)
+        {
+            axis[c] = length > 1e-6f ? next[c] / length : 0.0f;
+        }
+    }
+}
+
+// endpoints at the extremes of the texels' projection onto the principal axis
+template<int _Channels>
+static void axis_endpoints(const float (*texels)[4], float* e0, float* e1)
+{
+    float mean[4];
+    float axis[4];
+    principal_axis<_Channels>(texels, mean, axis);
+
+    float minProjection = 0.0f;
+    float maxProjection = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        float projection = 0.0f;
+        for (int c = 0; c < _Channels; c++)
+        {
+            projection += (texels[i][c] - mean[c]) * axis[c];
+        }
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    for (int c = 0; c < _Channels; c++)
+    {
+        e0[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+        e1[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+    }
+}
+
+// endpoints minimising the squared error for fixed interpolation weights (0 at e0, 1 at e1).
+// returns false when every texel uses the same weight and the system is singular
+template<int _Channels>
+static bool least_squares_endpoints(const float (*texels)[4], const float* weights, float* e0, float* e1)
+{
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[4] = {}, bx[4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        float a = 1.0f - weights[i];
+        float b = weights[i];
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < _Channels; c++)
+        {
+            ax[c] += a * texels[i][c];
+            bx[c] += b * texels[i][c];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (std::fabs(determinant) < 1e-6f)
+    {
+        return false;
+    }
+    for (int c = 0; c < _Channels; c++)
+    {
+        e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+        e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+static void load_texels(const uint8_t* rgba, float (*texels)[4])
+{
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            texels[i][c] = rgba[i * 4 + c];
+        }
+    }
+}
+
+// ---- BC1 ----
+
+static uint16_t pack_565(const float* colour)
+{
+    int r = static_cast<int>(std::lround(colour[0] * 31.0f / 255.0f));
+    int g = static_cast<int>(std::lround(colour[1] * 63.0f / 255.0f));
+    int b = static_cast<int>(std::lround(colour[2] * 31.0f / 255.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(uint16_t packed, int* colour)
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    colour[0] = (r << 3) | (r >> 2);
+    colour[1] = (g << 2) | (g >> 4);
+    colour[2] = (b << 3) | (b >> 2);
+}
+
+// four colour mode palette, c0 > c1 is up to the caller
+static int bc1_assign(const float (*texels)[4], uint16_t c0, uint16_t c1, uint8_t* indices)
+{
+    int palette[4][3];
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    int error = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0;
+        int bestError = INT32_MAX;
+        for (int p = 0; p < 4; p++)
+        {
+            int e = 0;
+            for (int c = 0; c < 3; c++)
+            {
+                int d = static_cast<int>(texels[i][c]) - palette[p][c];
+                e += d * d;
+            }
+            if (e < bestError)
+            {
+                best = p;
+                bestError = e;
+            }
+        }
+        indices[i] = static_cast<uint8_t>(best);
+        error += bestError;
+    }
+    return error;
+}
+
+// quantises both endpoints and assigns indices, c0 ends up greater than c1 unless they are equal
+static int bc1_evaluate(const float (*texels)[4], const float* e0, const float* e1, uint16_t& c0, uint16_t& c1, uint8_t* indices)
+{
+    c0 = pack_565(e0);
+    c1 = pack_565(e1);
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+    }
+    if (c0 == c1)
+    {
+        // three colour mode, index 0 decodes to c0 exactly
+        memset(indices, 0, 16);
+        int colour[3];
+        unpack_565(c0, colour);
+        int error = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                int d = static_cast<int>(texels[i][c]) - colour[c];
+                error += d * d;
+            }
+        }
+        return error;
+    }
+    return bc1_assign(texels, c0, c1, indices);
+}
+
+void bc::EncodeBC1(const uint8_t* rgba, uint8_t* block)
+{
+    float texels[16][4];
+    load_texels(rgba, texels);
+
+    float e0[4], e1[4];
+    axis_endpoints<3>(texels, e0, e1);
+
+    uint16_t c0, c1;
+    uint8_t indices[16];
+    int error = bc1_evaluate(texels, e0, e1, c0, c1, indices);
+
+    static constexpr float k_Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    for (int iteration = 0; iteration < 2 && error > 0 && c0 != c1; iteration++)
+    {
+        float weights[16];
+        for (int i = 0; i < 16; i++)
+        {
+            weights[i] = k_Weights[indices[i]];
+        }
+        if (!least_squares_endpoints<3>(texels, weights, e0, e1))
+        {
+            break;
+        }
+
+        uint16_t refined0, refined1;
+        uint8_t refinedIndices[16];
+        int refinedError = bc1_evaluate(texels, e0, e1, refined0, refined1, refinedIndices);
+        if (refinedError >= error)
+        {
+            break;
+        }
+        c0 = refined0;
+        c1 = refined1;
+        memcpy(indices, refinedIndices, 16);
+        error = refinedError;
+    }
+
+    uint32_t packedIndices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        packedIndices |= static_cast<uint32_t>(indices[i]) << (i * 2);
+    }
+    block[0] = static_cast<uint8_t>(c0);
+    block[1] = static_cast<uint8_t>(c0 >> 8);
+    block[2] = static_cast<uint8_t>(c1);
+    block[3] = static_cast<uint8_t>(c1 >> 8);
+    memcpy(block + 4, &packedIndices, 4);
+}
+
+// ---- BC4 / BC5 ----
+
+// eight value mode, e0 = max and e1 = min
+static void encode_bc4(const uint8_t* values, uint8_t* block)
+{
+    int maxValue = *std::max_element(values, values + 16);
+    int minValue = *std::min_element(values, values + 16);
+
+    int palette[8];
+    palette[0] = maxValue;
+    palette[1] = minValue;
+    for (int i = 2; i < 8; i++)
+    {
+        palette[i] = ((8 - i) * maxValue + (i - 1) * minValue) / 7;
+    }
+
+    uint64_t packedIndices = 0;
+    if (maxValue != minValue)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0;
+            int bestError = INT32_MAX;
+            for (int p = 0; p < 8; p++)
+            {
+                int e = std::abs(values[i] - palette[p]);
+                if (e < bestError)
+                {
+                    best = p;
+                    bestError = e;
+                }
+            }
+            packedIndices |= static_cast<uint64_t>(best) << (i * 3);
+        }
+    }
+
+    block[0] = static_cast<uint8_t>(maxValue);
+    block[1] = static_cast<uint8_t>(minValue);
+    for (int b = 0; b < 6; b++)
+    {
+        block[2 + b] = static_cast<uint8_t>(packedIndices >> (b * 8));
+    }
+}
+
+void bc::EncodeBC5(const uint8_t* rgba, uint8_t* block)
+{
+    uint8_t red[16], green[16];
+    for (int i = 0; i < 16; i++)
+    {
+        red[i] = rgba[i * 4 + 0];
+        green[i] = rgba[i * 4 + 1];
+    }
+    encode_bc4(red, block);
+    encode_bc4(green, block + 8);
+}
+
+// ---- BC7 mode 6 ----
+
+struct Bc7Endpoints
+{
+    int m_Quantised[2][4];      // 7 bits per channel
+    int m_PBits[2];
+};
+
+static void bc7_quantise(const float* e0, const float* e1, int p0, int p1, Bc7Endpoints& endpoints)
+{
+    const float* source[2] = { e0, e1 };
+    endpoints.m_PBits[0] = p0;
+    endpoints.m_PBits[1] = p1;
+    for (int e = 0; e < 2; e++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            int q = static_cast<int>(std::lround((source[e][c] - endpoints.m_PBits[e]) * 0.5f));
+            endpoints.m_Quantised[e][c] = std::clamp(q, 0, 127);
+        }
+    }
+}
+
+static int bc7_assign(const float (*texels)[4], const Bc7Endpoints& endpoints, uint8_t* indices)
+{
+    int e0[4], e1[4];
+    for (int c = 0; c < 4; c++)
+    {
+        e0[c] = (endpoints.m_Quantised[0][c] << 1) | endpoints.m_PBits[0];
+        e1[c] = (endpoints.m_Quantised[1][c] << 1) | endpoints.m_PBits[1];
+    }
+
+    int palette[16][4];
+    for (int p = 0; p < 16; p++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            palette[p][c] = ((64 - k_Bc7Weights[p]) * e0[c] + k_Bc7Weights[p] * e1[c] + 32) >> 6;
+        }
+    }
+
+    int error = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0;
+        int bestError = INT32_MAX;
+        for (int p = 0; p < 16; p++)
+        {
+            int e = 0;
+            for (int c = 0; c < 4; c++)
+            {
+                int d = static_cast<int>(texels[i][c]) - palette[p][c];
+                e += d * d;
+            }
+            if (e < bestError)
+            {
+                best = p;
+                bestError = e;
+            }
+        }
+        indices[i] = static_cast<uint8_t>(best);
+        error += bestError;
+    }
+    return error;
+}
+
+// best of the four p-bit combinations for the given endpoints
+static int bc7_evaluate(const float (*texels)[4], const float* e0, const float* e1, Bc7Endpoints& endpoints, uint8_t* indices)
+{
+    int bestError = INT32_MAX;
+    for (int pBits = 0; pBits < 4; pBits++)
+    {
+        Bc7Endpoints candidate;
+        uint8_t candidateIndices[16];
+        bc7_quantise(e0, e1, pBits & 1, pBits >> 1, candidate);
+        int error = bc7_assign(texels, candidate, candidateIndices);
+        if (error < bestError)
+        {
+            bestError = error;
+            endpoints = candidate;
+            memcpy(indices, candidateIndices, 16);
+        }
+    }
+    return bestError;
+}
+
+class BitWriter
+{
+public:
+    explicit BitWriter(uint8_t* block) : m_Block(block) { memset(m_Block, 0, 16); }
+
+    void Write(uint32_t value, int bits)
+    {
+        for (int b = 0; b < bits; b++, m_Position++)
+        {
+            m_Block[m_Position >> 3] |= static_cast<uint8_t>(((value >> b) & 1) << (m_Position & 7));
+        }
+    }
+
+private:
+    uint8_t*    m_Block;
+    int         m_Position = 0;
+};
+
+void bc::EncodeBC7(const uint8_t* rgba, uint8_t* block)
+{
+    float texels[16][4];
+    load_texels(rgba, texels);
+
+    float e0[4], e1[4];
+    axis_endpoints<4>(texels, e0, e1);
+
+    Bc7Endpoints endpoints;
+    uint8_t indices[16];
+    int error = bc7_evaluate(texels, e0, e1, endpoints, indices);
+
+    for (int iteration = 0; iteration < 2 && error > 0; iteration++)
+    {
+        float weights[16];
+        for (int i = 0; i < 16; i++)
+        {
+            weights[i] = k_Bc7Weights[indices[i]] / 64.0f;
+        }
+        if (!least_squares_endpoints<4>(texels, weights, e0, e1))
+        {
+            break;
+        }
+
+        Bc7Endpoints refined;
+        uint8_t refinedIndices[16];
+        int refinedError = bc7_evaluate(texels, e0, e1, refined, refinedIndices);
+        if (refinedError >= error)
+        {
+            break;
+        }
+        endpoints = refined;
+        memcpy(indices, refinedIndices, 16);
+        error = refinedError;
+    }
+
+    // the first texel's index has an implicit zero top bit, the weights are symmetric so swapping the
+    // endpoints and mirroring every index decodes to the same colours
+    if (indices[0] & 8)
+    {
+        std::swap(endpoints.m_Quantised[0], endpoints.m_Quantised[1]);
+        std::swap(endpoints.m_PBits[0], endpoints.m_PBits[1]);
+        for (int i = 0; i < 16; i++)
+        {
+            indices[i] = static_cast<uint8_t>(15 - indices[i]);
+        }
+    }
+
+    BitWriter writer(block);
+    writer.Write(1 << 6, 7);    // mode 6
+    for (int c = 0; c < 4; c++)
+    {
+        writer.Write(endpoints.m_Quantised[0][c], 7);
+        writer.Write(endpoints.m_Quantised[1][c], 7);
+    }
+    writer.Write(endpoints.m_PBits[0], 1);
+    writer.Write(endpoints.m_PBits[1], 1);
+    writer.Write(indices[0], 3);
+    for (int i = 1; i < 16; i++)
+    {
+        writer.Write(indices[i], 4);
+    }
+}
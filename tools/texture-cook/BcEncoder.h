@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+// Block compression encoders for lvk-texture-cook. each call encodes one 4x4 block given as 16 rgba8
+// texels in row order, edge blocks are expected to be padded by the caller.
+//
+//  BC1 : rgb, 8 bytes, endpoints from the block's principal axis refined by a least squares fit
+//  BC5 : two independent BC4 channels (red / green), 16 bytes, for normal maps and other two channel data
+//  BC7 : mode 6 only, one rgba subset with 4 bit indices, 16 bytes. every p-bit combination is tried,
+//        which gets most of BC7's quality at a fraction of a full mode search
+namespace bc
+{
+    void EncodeBC1(const uint8_t* rgba, uint8_t* block);
+    void EncodeBC5(const uint8_t* rgba, uint8_t* block);
+    void EncodeBC7(const uint8_t* rgba, uint8_t* block);
+}
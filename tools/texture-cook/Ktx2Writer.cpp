@@ -0,0 +1,262 @@
+#include "Ktx2Writer.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static constexpr uint8_t k_Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static constexpr size_t k_HeaderSize = 80;
+static constexpr size_t k_LevelIndexEntrySize = 24;
+static constexpr char k_CookHashKey[] = "lvk.cookhash";
+static constexpr char k_WriterKey[] = "KTXwriter";
+static constexpr char k_WriterValue[] = "lvk-texture-cook";
+
+// khronos data format descriptor values
+static constexpr uint32_t k_DfdVersion = 2;
+static constexpr uint32_t k_DfdBasicBlockSize = 24;
+static constexpr uint32_t k_DfdSampleSize = 16;
+static constexpr uint32_t k_DfdModelRgbsda = 1;
+static constexpr uint32_t k_DfdModelBc1a = 128;
+static constexpr uint32_t k_DfdModelBc5 = 132;
+static constexpr uint32_t k_DfdModelBc7 = 134;
+static constexpr uint32_t k_DfdPrimariesBt709 = 1;
+static constexpr uint32_t k_DfdTransferLinear = 1;
+static constexpr uint32_t k_DfdTransferSrgb = 2;
+static constexpr uint32_t k_DfdChannelRed = 0;
+static constexpr uint32_t k_DfdChannelGreen = 1;
+static constexpr uint32_t k_DfdChannelBlue = 2;
+static constexpr uint32_t k_DfdChannelAlpha = 15;
+static constexpr uint32_t k_DfdQualifierLinear = 0x10;
+
+struct DfdSample
+{
+    uint32_t    m_Channel;
+    uint32_t    m_BitOffset;
+    uint32_t    m_BitLength;
+    uint32_t    m_Qualifiers;
+    uint32_t    m_Upper;
+};
+
+static void append_u32(std::vector<uint8_t>& bytes, uint32_t value)
+{
+    uint8_t le[4];
+    memcpy(le, &value, sizeof(value));
+    bytes.insert(bytes.end(), le, le + 4);
+}
+
+static void write_u32(std::vector<uint8_t>& bytes, size_t offset, uint32_t value)
+{
+    memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+static void write_u64(std::vector<uint8_t>& bytes, size_t offset, uint64_t value)
+{
+    memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+static size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32_t vk_format(const ktx2::Description& description)
+{
+    switch (description.m_Format)
+    {
+    case ktx2::Format::BC1: return description.m_Srgb ? 132 : 131;     // VK_FORMAT_BC1_RGB_SRGB_BLOCK / UNORM
+    case ktx2::Format::BC5: return 141;                                 // VK_FORMAT_BC5_UNORM_BLOCK
+    case ktx2::Format::BC7: return description.m_Srgb ? 146 : 145;     // VK_FORMAT_BC7_SRGB_BLOCK / UNORM
+    default: return description.m_Srgb ? 43 : 37;                      // VK_FORMAT_R8G8B8A8_SRGB / UNORM
+    }
+}
+
+static std::vector<uint8_t> build_dfd(const ktx2::Description& description)
+{
+    uint32_t model = k_DfdModelRgbsda;
+    std::vector<DfdSample> samples;
+    switch (description.m_Format)
+    {
+    case ktx2::Format::BC1:
+        model = k_DfdModelBc1a;
+        samples.push_back({ k_DfdChannelRed, 0, 64, 0, UINT32_MAX });
+        break;
+    case ktx2::Format::BC5:
+        model = k_DfdModelBc5;
+        samples.push_back({ k_DfdChannelRed, 0, 64, 0, UINT32_MAX });
+        samples.push_back({ k_DfdChannelGreen, 64, 64, 0, UINT32_MAX });
+        break;
+    case ktx2::Format::BC7:
+        model = k_DfdModelBc7;
+        samples.push_back({ k_DfdChannelRed, 0, 128, 0, UINT32_MAX });
+        break;
+    case ktx2::Format::RGBA8:
+        samples.push_back({ k_DfdChannelRed, 0, 8, 0, 255 });
+        samples.push_back({ k_DfdChannelGreen, 8, 8, 0, 255 });
+        samples.push_back({ k_DfdChannelBlue, 16, 8, 0, 255 });
+        samples.push_back({ k_DfdChannelAlpha, 24, 8, description.m_Srgb ? k_DfdQualifierLinear : 0, 255 });
+        break;
+    }
+
+    const bool blockCompressed = ktx2::IsBlockCompressed(description.m_Format);
+    const uint32_t blockSize = k_DfdBasicBlockSize + k_DfdSampleSize * static_cast<uint32_t>(samples.size());
+    const uint32_t blockDimension = blockCompressed ? (3 | (3 << 8)) : 0;      // stored as size - 1
+
+    std::vector<uint8_t> dfd;
+    append_u32(dfd, 4 + blockSize);
+    append_u32(dfd, 0);                                 // khronos vendor, basic descriptor type
+    append_u32(dfd, k_DfdVersion | (blockSize << 16));
+    append_u32(dfd, model | (k_DfdPrimariesBt709 << 8) | ((description.m_Srgb ? k_DfdTransferSrgb : k_DfdTransferLinear) << 16));
+    append_u32(dfd, blockDimension);
+    append_u32(dfd, ktx2::GetBlockBytes(description.m_Format));     // bytesPlane0, planes 1-7 unused
+    append_u32(dfd, 0);
+    for (const DfdSample& sample : samples)
+    {
+        append_u32(dfd, sample.m_BitOffset | ((sample.m_BitLength - 1) << 16) | ((sample.m_Channel | sample.m_Qualifiers) << 24));
+        append_u32(dfd, 0);                             // sample position
+        append_u32(dfd, 0);
+        append_u32(dfd, sample.m_Upper);
+    }
+    return dfd;
+}
+
+// entries sorted by key, each padded to 4 bytes
+static std::vector<uint8_t> build_kvd(const std::string& cookHash)
+{
+    std::vector<uint8_t> kvd;
+    auto appendEntry = [&kvd](const char* key, const std::string& value)
+    {
+        size_t keyLength = strlen(key) + 1;
+        append_u32(kvd, static_cast<uint32_t>(keyLength + value.size() + 1));
+        kvd.insert(kvd.end(), key, key + keyLength);
+        kvd.insert(kvd.end(), value.c_str(), value.c_str() + value.size() + 1);
+        kvd.resize(align_up(kvd.size(), 4), 0);
+    };
+    appendEntry(k_WriterKey, k_WriterValue);
+    appendEntry(k_CookHashKey, cookHash);
+    return kvd;
+}
+
+uint32_t ktx2::GetBlockBytes(Format format)
+{
+    switch (format)
+    {
+    case Format::BC1: return 8;
+    case Format::BC5:
+    case Format::BC7: return 16;
+    default: return 4;
+    }
+}
+
+bool ktx2::IsBlockCompressed(Format format)
+{
+    return format != Format::RGBA8;
+}
+
+bool ktx2::Write(const std::string& path, const Description& description, const std::vector<std::vector<uint8_t>>& levels, const std::string& cookHash)
+{
+    const std::vector<uint8_t> dfd = build_dfd(description);
+    const std::vector<uint8_t> kvd = build_kvd(cookHash);
+    const size_t levelCount = levels.size();
+    const size_t dfdOffset = k_HeaderSize + levelCount * k_LevelIndexEntrySize;
+    const size_t kvdOffset = align_up(dfdOffset + dfd.size(), 4);
+
+    std::vector<uint8_t> header(kvdOffset + kvd.size(), 0);
+    memcpy(header.data(), k_Identifier, sizeof(k_Identifier));
+    write_u32(header, 12, vk_format(description));
+    write_u32(header, 16, 1);                                   // typeSize
+    write_u32(header, 20, description.m_Width);
+    write_u32(header, 24, description.m_Height);
+    write_u32(header, 28, 0);                                   // depth, layers : a single 2D image
+    write_u32(header, 32, 0);
+    write_u32(header, 36, 1);                                   // faces
+    write_u32(header, 40, static_cast<uint32_t>(levelCount));
+    write_u32(header, 44, 0);                                   // no supercompression
+    write_u32(header, 48, static_cast<uint32_t>(dfdOffset));
+    write_u32(header, 52, static_cast<uint32_t>(dfd.size()));
+    write_u32(header, 56, static_cast<uint32_t>(kvdOffset));
+    write_u32(header, 60, static_cast<uint32_t>(kvd.size()));
+    memcpy(header.data() + dfdOffset, dfd.data(), dfd.size());
+    memcpy(header.data() + kvdOffset, kvd.data(), kvd.size());
+
+    // level data is stored smallest first, each level aligned to lcm(block size, 4)
+    const size_t alignment = GetBlockBytes(description.m_Format) % 4 == 0 ? GetBlockBytes(description.m_Format) : 4;
+    std::vector<size_t> offsets(levelCount);
+    size_t offset = header.size();
+    for (size_t level = levelCount; level-- > 0;)
+    {
+        offset = align_up(offset, alignment);
+        offsets[level] = offset;
+        offset += levels[level].size();
+
+        size_t entry = k_HeaderSize + level * k_LevelIndexEntrySize;
+        write_u64(header, entry, offsets[level]);
+        write_u64(header, entry + 8, levels[level].size());
+        write_u64(header, entry + 16, levels[level].size());
+    }
+
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(header.data()), header.size());
+        size_t written = header.size();
+        for (size_t level = levelCount; level-- > 0;)
+        {
+            static constexpr char k_Padding[16] = {};
+            file.write(k_Padding, offsets[level] - written);
+            file.write(reinterpret_cast<const char*>(levels[level].data()), levels[level].size());
+            written = offsets[level] + levels[level].size();
+        }
+        if (!file)
+        {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    return !error;
+}
+
+bool ktx2::ReadCookHash(const std::string& path, std::string& cookHash)
+{
+    std::ifstream file(path, std::ios::binary);
+    uint8_t header[k_HeaderSize];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || memcmp(header, k_Identifier, sizeof(k_Identifier)) != 0)
+    {
+        return false;
+    }
+
+    uint32_t kvdOffset, kvdLength;
+    memcpy(&kvdOffset, header + 56, sizeof(kvdOffset));
+    memcpy(&kvdLength, header + 60, sizeof(kvdLength));
+    std::vector<char> kvd(kvdLength);
+    if (!file.seekg(kvdOffset) || !file.read(kvd.data(), kvd.size()))
+    {
+        return false;
+    }
+
+    size_t position = 0;
+    while (position + 4 <= kvd.size())
+    {
+        uint32_t entryLength;
+        memcpy(&entryLength, kvd.data() + position, sizeof(entryLength));
+        const char* entry = kvd.data() + position + 4;
+        if (entryLength > kvd.size() - position - 4)
+        {
+            return false;
+        }
+
+        size_t keyLength = strnlen(entry, entryLength);
+        if (keyLength < entryLength && strcmp(entry, k_CookHashKey) == 0)
+        {
+            const char* value = entry + keyLength + 1;
+            cookHash.assign(value, strnlen(value, entryLength - keyLength - 1));
+            return true;
+        }
+        position = align_up(position + 4 + entryLength, 4);
+    }
+    return false;
+}
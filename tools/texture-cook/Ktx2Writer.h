@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal KTX2 writer for lvk-texture-cook : one 2D image, no supercompression, a data format
+// descriptor for the four formats the cooker produces and a "lvk.cookhash" key / value entry that
+// lets a later cook skip inputs that have not changed. the result loads with lvk::TextureFile.
+namespace ktx2
+{
+    enum class Format
+    {
+        BC1,
+        BC5,
+        BC7,
+        RGBA8
+    };
+
+    struct Description
+    {
+        Format      m_Format = Format::BC7;
+        bool        m_Srgb = false;         // sRGB vkFormat and transfer function, not available for BC5
+        uint32_t    m_Width = 0;
+        uint32_t    m_Height = 0;
+    };
+
+    // bytes per 4x4 block, or per texel for RGBA8
+    uint32_t GetBlockBytes(Format format);
+    bool IsBlockCompressed(Format format);
+
+    // levels[0] is the full size image, written through a temporary file and renamed into place
+    bool Write(const std::string& path, const Description& description, const std::vector<std::vector<uint8_t>>& levels, const std::string& cookHash);
+
+    // the cook hash stored by Write, false when the file is missing, not KTX2 or has no hash
+    bool ReadCookHash(const std::string& path, std::string& cookHash);
+}
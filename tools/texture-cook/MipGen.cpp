@@ -0,0 +1,279 @@
+#include "MipGen.h"
+#include "lvk/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define LVK_COOK_SSE 1
+#endif
+
+static constexpr uint32_t k_EncodeTableSize = 16384;
+static constexpr uint32_t k_KaiserTaps = 6;
+static constexpr uint32_t k_MinRowsPerBatch = 16;
+
+// one rgba texel, four lanes of an SSE register where available
+#if LVK_COOK_SSE
+using Texel = __m128;
+static inline Texel load_texel(const float* p) { return _mm_loadu_ps(p); }
+static inline void store_texel(float* p, Texel t) { _mm_storeu_ps(p, t); }
+static inline Texel add(Texel a, Texel b) { return _mm_add_ps(a, b); }
+static inline Texel scale(Texel t, float s) { return _mm_mul_ps(t, _mm_set1_ps(s)); }
+static inline Texel zero_texel() { return _mm_setzero_ps(); }
+#else
+struct Texel { float m_Values[4]; };
+static inline Texel load_texel(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+static inline void store_texel(float* p, Texel t) { for (int c = 0; c < 4; c++) p[c] = t.m_Values[c]; }
+static inline Texel add(Texel a, Texel b) { for (int c = 0; c < 4; c++) a.m_Values[c] += b.m_Values[c]; return a; }
+static inline Texel scale(Texel t, float s) { for (int c = 0; c < 4; c++) t.m_Values[c] *= s; return t; }
+static inline Texel zero_texel() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+#endif
+
+static float srgb_to_linear(float v)
+{
+    return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linear_to_srgb(float v)
+{
+    return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+}
+
+struct SrgbTables
+{
+    float   m_Decode[256];
+    uint8_t m_Encode[k_EncodeTableSize];
+
+    SrgbTables()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            m_Decode[i] = srgb_to_linear(i / 255.0f);
+        }
+        for (uint32_t i = 0; i < k_EncodeTableSize; i++)
+        {
+            float srgb = linear_to_srgb(i / float(k_EncodeTableSize - 1));
+            m_Encode[i] = static_cast<uint8_t>(std::lround(srgb * 255.0f));
+        }
+    }
+};
+
+static const SrgbTables& srgb_tables()
+{
+    static const SrgbTables tables;
+    return tables;
+}
+
+static uint8_t encode_linear(float v)
+{
+    return static_cast<uint8_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+}
+
+static uint8_t encode_srgb(const SrgbTables& tables, float v)
+{
+    return tables.m_Encode[static_cast<uint32_t>(std::clamp(v, 0.0f, 1.0f) * (k_EncodeTableSize - 1) + 0.5f)];
+}
+
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++)
+    {
+        double f = x / (2.0 * k);
+        term *= f * f;
+        sum += term;
+    }
+    return sum;
+}
+
+// weights of the 6 source texels around a destination texel when halving, the taps sit at
+// -2.5 .. 2.5 source texels from the destination centre
+static const float* kaiser_weights()
+{
+    struct Weights
+    {
+        float m_Values[k_KaiserTaps];
+
+        Weights()
+        {
+            constexpr double k_Pi = 3.14159265358979323846;
+            constexpr double k_Alpha = 4.0;
+            constexpr double k_Radius = 3.0;
+
+            double total = 0.0;
+            for (uint32_t t = 0; t < k_KaiserTaps; t++)
+            {
+                double distance = t - 2.5;
+                double x = distance * 0.5;                  // in destination texels
+                double sinc = std::sin(k_Pi * x) / (k_Pi * x);
+                double r = distance / k_Radius;
+                double window = bessel_i0(k_Alpha * std::sqrt(std::max(0.0, 1.0 - r * r))) / bessel_i0(k_Alpha);
+                m_Values[t] = static_cast<float>(sinc * window);
+                total += m_Values[t];
+            }
+            for (uint32_t t = 0; t < k_KaiserTaps; t++)
+            {
+                m_Values[t] = static_cast<float>(m_Values[t] / total);
+            }
+        }
+    };
+    static const Weights weights;
+    return weights.m_Values;
+}
+
+static void for_each_row_batch(uint32_t rows, const std::function<void(uint32_t, uint32_t)>& fn)
+{
+    lvk::ThreadPool::Default().ParallelFor(rows, k_MinRowsPerBatch, fn);
+}
+
+static void downsample_box(const mipgen::Image& source, mipgen::Image& destination)
+{
+    const uint32_t stepX = source.m_Width > 1 ? 2 : 1;
+    const uint32_t stepY = source.m_Height > 1 ? 2 : 1;
+
+    for_each_row_batch(destination.m_Height, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            uint32_t y0 = y * stepY;
+            uint32_t y1 = std::min(y0 + 1, source.m_Height - 1);
+            const float* row0 = source.m_Texels.data() + size_t{ y0 } * source.m_Width * 4;
+            const float* row1 = source.m_Texels.data() + size_t{ y1 } * source.m_Width * 4;
+            float* out = destination.m_Texels.data() + size_t{ y } * destination.m_Width * 4;
+
+            for (uint32_t x = 0; x < destination.m_Width; x++)
+            {
+                uint32_t x0 = x * stepX;
+                uint32_t x1 = std::min(x0 + 1, source.m_Width - 1);
+                Texel sum = add(add(load_texel(row0 + x0 * 4), load_texel(row0 + x1 * 4)),
+                                add(load_texel(row1 + x0 * 4), load_texel(row1 + x1 * 4)));
+                store_texel(out + x * 4, scale(sum, 0.25f));
+            }
+        }
+    });
+}
+
+// separable, horizontal into an intermediate of destination width then vertical.
+// an axis of size 1 is passed through, edges clamp
+static void downsample_kaiser(const mipgen::Image& source, mipgen::Image& destination)
+{
+    const float* weights = kaiser_weights();
+
+    std::vector<float> horizontal(size_t{ destination.m_Width } * source.m_Height * 4);
+    for_each_row_batch(source.m_Height, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const float* row = source.m_Texels.data() + size_t{ y } * source.m_Width * 4;
+            float* out = horizontal.data() + size_t{ y } * destination.m_Width * 4;
+            if (source.m_Width == 1)
+            {
+                store_texel(out, load_texel(row));
+                continue;
+            }
+            for (uint32_t x = 0; x < destination.m_Width; x++)
+            {
+                Texel sum = zero_texel();
+                for (uint32_t t = 0; t < k_KaiserTaps; t++)
+                {
+                    int32_t sx = std::clamp(static_cast<int32_t>(x * 2 + t) - 2, 0, static_cast<int32_t>(source.m_Width) - 1);
+                    sum = add(sum, scale(load_texel(row + sx * 4), weights[t]));
+                }
+                store_texel(out + x * 4, sum);
+            }
+        }
+    });
+
+    for_each_row_batch(destination.m_Height, [&](uint32_t begin, uint32_t end) {
+        const size_t rowFloats = size_t{ destination.m_Width } * 4;
+        for (uint32_t y = begin; y < end; y++)
+        {
+            float* out = destination.m_Texels.data() + y * rowFloats;
+            if (source.m_Height == 1)
+            {
+                std::copy(horizontal.begin(), horizontal.begin() + rowFloats, out);
+                continue;
+            }
+
+            const float* rows[k_KaiserTaps];
+            for (uint32_t t = 0; t < k_KaiserTaps; t++)
+            {
+                int32_t sy = std::clamp(static_cast<int32_t>(y * 2 + t) - 2, 0, static_cast<int32_t>(source.m_Height) - 1);
+                rows[t] = horizontal.data() + sy * rowFloats;
+            }
+            for (uint32_t x = 0; x < destination.m_Width; x++)
+            {
+                Texel sum = zero_texel();
+                for (uint32_t t = 0; t < k_KaiserTaps; t++)
+                {
+                    sum = add(sum, scale(load_texel(rows[t] + x * 4), weights[t]));
+                }
+                store_texel(out + x * 4, sum);
+            }
+        }
+    });
+}
+
+uint32_t mipgen::GetMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+        count++;
+    }
+    return count;
+}
+
+void mipgen::ToLinear(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb, Image& image)
+{
+    const SrgbTables& tables = srgb_tables();
+    image.m_Width = width;
+    image.m_Height = height;
+    image.m_Texels.resize(size_t{ width } * height * 4);
+
+    for_each_row_batch(height, [&](uint32_t begin, uint32_t end) {
+        for (size_t i = size_t{ begin } * width * 4; i < size_t{ end } * width * 4; i += 4)
+        {
+            for (size_t c = 0; c < 3; c++)
+            {
+                image.m_Texels[i + c] = srgb ? tables.m_Decode[rgba[i + c]] : rgba[i + c] / 255.0f;
+            }
+            image.m_Texels[i + 3] = rgba[i + 3] / 255.0f;
+        }
+    });
+}
+
+void mipgen::FromLinear(const Image& image, bool srgb, std::vector<uint8_t>& rgba)
+{
+    const SrgbTables& tables = srgb_tables();
+    rgba.resize(image.m_Texels.size());
+
+    for_each_row_batch(image.m_Height, [&](uint32_t begin, uint32_t end) {
+        for (size_t i = size_t{ begin } * image.m_Width * 4; i < size_t{ end } * image.m_Width * 4; i += 4)
+        {
+            for (size_t c = 0; c < 3; c++)
+            {
+                rgba[i + c] = srgb ? encode_srgb(tables, image.m_Texels[i + c]) : encode_linear(image.m_Texels[i + c]);
+            }
+            rgba[i + 3] = encode_linear(image.m_Texels[i + 3]);
+        }
+    });
+}
+
+void mipgen::Downsample(const Image& source, Filter filter, Image& destination)
+{
+    destination.m_Width = std::max(source.m_Width / 2, 1u);
+    destination.m_Height = std::max(source.m_Height / 2, 1u);
+    destination.m_Texels.resize(size_t{ destination.m_Width } * destination.m_Height * 4);
+
+    if (filter == Filter::Kaiser)
+    {
+        downsample_kaiser(source, destination);
+    }
+    else
+    {
+        downsample_box(source, destination);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Mip chain generation for lvk-texture-cook. levels are filtered as linear light rgba floats, colour
+// textures are decoded from sRGB first so dark / bright detail averages the way the eye sees it
+// rather than darkening towards the smaller mips. alpha is always treated as linear.
+namespace mipgen
+{
+    enum class Filter
+    {
+        Box,        // 2x2 average, fast and sharp enough for most content
+        Kaiser      // 6 tap Kaiser windowed sinc, keeps more detail in the smaller mips
+    };
+
+    struct Image
+    {
+        uint32_t            m_Width = 0;
+        uint32_t            m_Height = 0;
+        std::vector<float>  m_Texels;       // 4 floats per texel, row order
+    };
+
+    // full chain down to 1x1
+    uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+    void ToLinear(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb, Image& image);
+    void FromLinear(const Image& image, bool srgb, std::vector<uint8_t>& rgba);
+
+    // halves each dimension that is larger than 1, rows are spread over lvk::ThreadPool::Default()
+    void Downsample(const Image& source, Filter filter, Image& destination);
+}
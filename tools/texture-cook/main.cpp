@@ -0,0 +1,322 @@
+// lvk-texture-cook
+// turns png / jpeg sources into .ktx2 files (lvk/TextureFile.h) offline : a gamma correct mip chain,
+// every level block compressed, so the runtime loader uploads the file as stored with no decode and
+// no GenerateMips. inputs are cooked in parallel and each output records a hash of its source and
+// options, unchanged inputs are skipped, so rerunning the cook over a whole asset folder is cheap.
+//
+// usage : lvk-texture-cook <output dir> <image>... [--format bc7|bc5|bc1|rgba8] [--filter box|kaiser]
+//                          [--linear] [--srgb] [--force]
+//
+//  --format    : bc7 (default, rgba), bc1 (rgb, half the size of bc7), bc5 (two channel, for normal maps)
+//                or uncompressed rgba8
+//  --filter    : mip filter, box (default) or kaiser
+//  --linear    : the source stores linear data (normal maps, masks), filter it without the sRGB decode
+//  --srgb      : write the sRGB vkFormat so sampling linearises the texels. the examples sample colour
+//                textures through UNORM views, matching their runtime upload, so this is off by default
+//  --force     : cook every input even when its output is up to date
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "ThirdParty/stb_image.h"
+#include "BcEncoder.h"
+#include "Ktx2Writer.h"
+#include "MipGen.h"
+#include "lvk/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// bump whenever the encoders or the mip filters change, so existing outputs are cooked again
+static constexpr uint32_t k_CookVersion = 1;
+static constexpr uint64_t k_FnvOffset = 0xcbf29ce484222325ull;
+static constexpr uint64_t k_FnvPrime = 0x100000001b3ull;
+static constexpr uint32_t k_MinBlockRowsPerBatch = 4;
+
+struct CookOptions
+{
+    ktx2::Format    m_Format = ktx2::Format::BC7;
+    mipgen::Filter  m_Filter = mipgen::Filter::Box;
+    bool            m_Linear = false;
+    bool            m_Srgb = false;
+    bool            m_Force = false;
+};
+
+enum class CookResult
+{
+    Cooked,
+    Skipped,
+    Failed
+};
+
+static std::mutex s_OutputMutex;
+
+static void report_error(const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(s_OutputMutex);
+    std::cerr << "lvk-texture-cook : " << message << std::endl;
+}
+
+static uint64_t fnv1a(const void* data, size_t size, uint64_t hash = k_FnvOffset)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * k_FnvPrime;
+    }
+    return hash;
+}
+
+// everything that changes the output besides the source bytes
+static std::string option_key(const CookOptions& options)
+{
+    static const char* k_FormatNames[] = { "bc1", "bc5", "bc7", "rgba8" };
+    return std::string(k_FormatNames[static_cast<int>(options.m_Format)])
+        + (options.m_Filter == mipgen::Filter::Kaiser ? " kaiser" : " box")
+        + (options.m_Linear ? " linear" : " gamma")
+        + (options.m_Srgb ? " srgb" : " unorm")
+        + " v" + std::to_string(k_CookVersion);
+}
+
+static std::string cook_hash(const std::vector<uint8_t>& source, const CookOptions& options)
+{
+    std::string key = option_key(options);
+    uint64_t hash = fnv1a(key.data(), key.size(), fnv1a(source.data(), source.size()));
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+static bool read_file(const std::string& path, std::vector<uint8_t>& bytes)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return false;
+    }
+    bytes.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(bytes.data()), bytes.size()));
+}
+
+// edge blocks repeat the last row / column, block rows are spread over the thread pool
+static void encode_level(const uint8_t* rgba, uint32_t width, uint32_t height, ktx2::Format format, std::vector<uint8_t>& encoded)
+{
+    if (!ktx2::IsBlockCompressed(format))
+    {
+        encoded.assign(rgba, rgba + size_t{ width } * height * 4);
+        return;
+    }
+
+    void (*encodeBlock)(const uint8_t*, uint8_t*) = format == ktx2::Format::BC1 ? bc::EncodeBC1
+                                                  : format == ktx2::Format::BC5 ? bc::EncodeBC5
+                                                  : bc::EncodeBC7;
+    const uint32_t blockBytes = ktx2::GetBlockBytes(format);
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    encoded.resize(size_t{ blocksX } * blocksY * blockBytes);
+
+    lvk::ThreadPool::Default().ParallelFor(blocksY, k_MinBlockRowsPerBatch, [&](uint32_t begin, uint32_t end) {
+        uint8_t texels[16 * 4];
+        for (uint32_t by = begin; by < end; by++)
+        {
+            for (uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    uint32_t x = std::min(bx * 4 + i % 4, width - 1);
+                    uint32_t y = std::min(by * 4 + i / 4, height - 1);
+                    memcpy(texels + i * 4, rgba + (size_t{ y } * width + x) * 4, 4);
+                }
+                encodeBlock(texels, encoded.data() + (size_t{ by } * blocksX + bx) * blockBytes);
+            }
+        }
+    });
+}
+
+static CookResult cook_texture(const std::string& inputPath, const std::string& outputPath, const CookOptions& options)
+{
+    std::vector<uint8_t> source;
+    if (!read_file(inputPath, source))
+    {
+        report_error("failed to read " + inputPath);
+        return CookResult::Failed;
+    }
+
+    std::string hash = cook_hash(source, options);
+    std::string existingHash;
+    if (!options.m_Force && ktx2::ReadCookHash(outputPath, existingHash) && existingHash == hash)
+    {
+        return CookResult::Skipped;
+    }
+
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load_from_memory(source.data(), static_cast<int>(source.size()), &width, &height, &channels, STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        report_error("failed to decode " + inputPath + " : " + stbi_failure_reason());
+        return CookResult::Failed;
+    }
+    source.clear();
+    source.shrink_to_fit();
+
+    ktx2::Description description;
+    description.m_Format = options.m_Format;
+    description.m_Srgb = options.m_Srgb;
+    description.m_Width = static_cast<uint32_t>(width);
+    description.m_Height = static_cast<uint32_t>(height);
+
+    // level 0 is encoded straight from the source, the rest are filtered in linear light and encoded
+    // as they are produced so only two float levels are alive at once
+    std::vector<std::vector<uint8_t>> levels(mipgen::GetMipCount(description.m_Width, description.m_Height));
+    encode_level(pixels, description.m_Width, description.m_Height, options.m_Format, levels[0]);
+
+    if (levels.size() > 1)
+    {
+        const bool gammaCorrect = !options.m_Linear;
+        mipgen::Image current, next;
+        mipgen::ToLinear(pixels, description.m_Width, description.m_Height, gammaCorrect, current);
+        stbi_image_free(pixels);
+        pixels = nullptr;
+
+        std::vector<uint8_t> rgba;
+        for (size_t level = 1; level < levels.size(); level++)
+        {
+            mipgen::Downsample(current, options.m_Filter, next);
+            mipgen::FromLinear(next, gammaCorrect, rgba);
+            encode_level(rgba.data(), next.m_Width, next.m_Height, options.m_Format, levels[level]);
+            std::swap(current, next);
+        }
+    }
+    stbi_image_free(pixels);
+
+    if (!ktx2::Write(outputPath, description, levels, hash))
+    {
+        report_error("failed to write " + outputPath);
+        return CookResult::Failed;
+    }
+    return CookResult::Cooked;
+}
+
+static bool parse_format(const char* name, ktx2::Format& format)
+{
+    static const std::pair<const char*, ktx2::Format> k_Formats[] = {
+        { "bc1", ktx2::Format::BC1 }, { "bc5", ktx2::Format::BC5 }, { "bc7", ktx2::Format::BC7 }, { "rgba8", ktx2::Format::RGBA8 } };
+    for (const auto& [formatName, value] : k_Formats)
+    {
+        if (strcmp(name, formatName) == 0)
+        {
+            format = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage : lvk-texture-cook <output dir> <image>... [--format bc7|bc5|bc1|rgba8] [--filter box|kaiser] [--linear] [--srgb] [--force]" << std::endl;
+        return 1;
+    }
+
+    const std::filesystem::path outputDirectory = argv[1];
+    std::vector<std::string> inputs;
+    CookOptions options;
+    for (int a = 2; a < argc; a++)
+    {
+        if (strcmp(argv[a], "--format") == 0 && a + 1 < argc)
+        {
+            if (!parse_format(argv[++a], options.m_Format))
+            {
+                std::cerr << "lvk-texture-cook : unknown format " << argv[a] << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[a], "--filter") == 0 && a + 1 < argc)
+        {
+            a++;
+            if (strcmp(argv[a], "box") == 0)
+            {
+                options.m_Filter = mipgen::Filter::Box;
+            }
+            else if (strcmp(argv[a], "kaiser") == 0)
+            {
+                options.m_Filter = mipgen::Filter::Kaiser;
+            }
+            else
+            {
+                std::cerr << "lvk-texture-cook : unknown filter " << argv[a] << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[a], "--linear") == 0)
+        {
+            options.m_Linear = true;
+        }
+        else if (strcmp(argv[a], "--srgb") == 0)
+        {
+            options.m_Srgb = true;
+        }
+        else if (strcmp(argv[a], "--force") == 0)
+        {
+            options.m_Force = true;
+        }
+        else if (strncmp(argv[a], "--", 2) == 0)
+        {
+            std::cerr << "lvk-texture-cook : unknown option " << argv[a] << std::endl;
+            return 1;
+        }
+        else
+        {
+            inputs.push_back(argv[a]);
+        }
+    }
+
+    if (options.m_Srgb && options.m_Format == ktx2::Format::BC5)
+    {
+        std::cerr << "lvk-texture-cook : bc5 has no sRGB format" << std::endl;
+        return 1;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(outputDirectory, error);
+    if (error)
+    {
+        std::cerr << "lvk-texture-cook : failed to create " << outputDirectory.string() << " : " << error.message() << std::endl;
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // inputs are claimed one at a time so large and small textures balance across the threads,
+    // each cook spreads its block rows over the pool too for when few large inputs remain
+    lvk::ThreadPool& pool = lvk::ThreadPool::Default();
+    std::atomic<uint32_t> nextInput{ 0 };
+    std::atomic<uint32_t> results[3] = {};
+    pool.ParallelFor(pool.GetWorkerCount() + 1, 1, [&](uint32_t, uint32_t) {
+        uint32_t i;
+        while ((i = nextInput.fetch_add(1)) < inputs.size())
+        {
+            std::filesystem::path outputPath = outputDirectory / std::filesystem::path(inputs[i]).stem();
+            outputPath += ".ktx2";
+            results[static_cast<int>(cook_texture(inputs[i], outputPath.string(), options))]++;
+        }
+    });
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint32_t failed = results[static_cast<int>(CookResult::Failed)];
+    std::cout << "lvk-texture-cook : " << outputDirectory.string() << " : "
+              << results[static_cast<int>(CookResult::Cooked)] << " cooked, "
+              << results[static_cast<int>(CookResult::Skipped)] << " up to date, "
+              << failed << " failed in " << seconds << "s" << std::endl;
+    return failed == 0 ? 0 : 1;
+}